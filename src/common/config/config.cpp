@@ -230,7 +230,18 @@ const Config::ConfigEntry Config::entries[MAX_CONFIG_KEY] =
 	{TYPE_INTEGER,		"TipCacheBlockSize",		(ConfigValue) 4194304}, // bytes
 	{TYPE_BOOLEAN,		"ReadConsistency",			(ConfigValue) true},
 	{TYPE_BOOLEAN,		"ClearGTTAtRetaining",		(ConfigValue) false},
-	{TYPE_STRING,		"DataTypeCompatibility",	(ConfigValue) NULL}
+	{TYPE_STRING,		"DataTypeCompatibility",	(ConfigValue) NULL},
+	{TYPE_STRING,		"PageCachePolicy",			(ConfigValue) "LRU"},		// page buffers replacement policy
+	{TYPE_INTEGER,		"ReadAheadPages",			(ConfigValue) 32},			// pages
+	{TYPE_INTEGER,		"CacheWriters",				(ConfigValue) 2},			// threads
+	{TYPE_STRING,		"PageCacheHugePages",		(ConfigValue) "None"},		// memory pages for page buffers
+	{TYPE_STRING,		"PageCacheNumaPolicy",		(ConfigValue) "None"},		// page buffers placement
+	{TYPE_INTEGER,		"PageCacheWarmup",			(ConfigValue) 0},			// seconds
+	{TYPE_STRING,		"IoBackend",				(ConfigValue) "Sync"},		// page I/O implementation
+	{TYPE_BOOLEAN,		"LocalLockTable",			(ConfigValue) true},
+	{TYPE_INTEGER,		"LockHashMaxChain",			(ConfigValue) 8},			// locks per hash slot
+	{TYPE_INTEGER,		"SortWorkers",				(ConfigValue) 1},			// threads
+	{TYPE_INTEGER,		"ParallelWorkers",			(ConfigValue) 1}			// threads
 };
 
 /******************************************************************************
@@ -936,3 +947,114 @@ const char* Config::getDataTypeCompatibility() const
 {
 	return get<const char*>(KEY_DATA_TYPE_COMPATIBILITY);
 }
+
+int Config::getPageCachePolicy() const
+{
+	const char* policy = get<const char*>(KEY_PAGE_CACHE_POLICY);
+	if (policy)
+	{
+		Firebird::NoCaseString pagePolicy(policy);
+		if (pagePolicy == "2Q")
+			return PAGE_CACHE_2Q;
+	}
+
+	return PAGE_CACHE_LRU;
+}
+
+ULONG Config::getReadAheadPages() const
+{
+	SINT64 rc = get<SINT64>(KEY_READ_AHEAD_PAGES);
+	if (rc < 0)
+		rc = 0;
+	else if (rc > MAX_READ_AHEAD_PAGES)
+		rc = MAX_READ_AHEAD_PAGES;
+	return rc;
+}
+
+ULONG Config::getCacheWriters() const
+{
+	SINT64 rc = get<SINT64>(KEY_CACHE_WRITERS);
+	if (rc < 1)
+		rc = 1;
+	else if (rc > MAX_CACHE_WRITERS)
+		rc = MAX_CACHE_WRITERS;
+	return rc;
+}
+
+int Config::getPageCacheHugePages() const
+{
+	const char* pages = get<const char*>(KEY_PAGE_CACHE_HUGE_PAGES);
+	if (pages)
+	{
+		Firebird::NoCaseString hugePages(pages);
+		if (hugePages == "Transparent")
+			return HUGE_PAGES_TRANSPARENT;
+		if (hugePages == "2M")
+			return HUGE_PAGES_2M;
+		if (hugePages == "1G")
+			return HUGE_PAGES_1G;
+	}
+
+	return HUGE_PAGES_NONE;
+}
+
+int Config::getPageCacheNumaPolicy() const
+{
+	const char* policy = get<const char*>(KEY_PAGE_CACHE_NUMA_POLICY);
+	if (policy)
+	{
+		Firebird::NoCaseString numaPolicy(policy);
+		if (numaPolicy == "Interleave")
+			return NUMA_POLICY_INTERLEAVE;
+		if (numaPolicy == "Bind")
+			return NUMA_POLICY_BIND;
+	}
+
+	return NUMA_POLICY_NONE;
+}
+
+ULONG Config::getPageCacheWarmup() const
+{
+	SINT64 rc = get<SINT64>(KEY_PAGE_CACHE_WARMUP);
+	if (rc < 0)
+		rc = 0;
+	else if (rc > MAX_ULONG)
+		rc = MAX_ULONG;
+	return rc;
+}
+
+int Config::getIoBackend() const
+{
+	const char* backend = get<const char*>(KEY_IO_BACKEND);
+	if (backend)
+	{
+		Firebird::NoCaseString ioBackend(backend);
+		if (ioBackend == "IoUring")
+			return IO_BACKEND_IO_URING;
+	}
+
+	return IO_BACKEND_SYNC;
+}
+
+bool Config::getLocalLockTable() const
+{
+	return get<bool>(KEY_LOCAL_LOCK_TABLE);
+}
+
+int Config::getLockHashMaxChain() const
+{
+	int rc = get<int>(KEY_LOCK_HASH_MAX_CHAIN);
+	return rc < 0 ? 0 : rc;
+}
+
+int Config::getSortWorkers() const
+{
+	int rc = get<int>(KEY_SORT_WORKERS);
+	return rc < 1 ? 1 : rc;
+}
+
+int Config::getParallelWorkers() const
+{
+	int rc = get<int>(KEY_PARALLEL_WORKERS);
+	return rc < 1 ? 1 : rc;
+}
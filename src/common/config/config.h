@@ -75,6 +75,24 @@ const int WIRE_CRYPT_REQUIRED = 2;
 
 enum WireCryptMode {WC_CLIENT, WC_SERVER};		// Have different defaults
 
+const int PAGE_CACHE_LRU = 0;
+const int PAGE_CACHE_2Q = 1;
+
+const ULONG MAX_READ_AHEAD_PAGES = 256;
+const ULONG MAX_CACHE_WRITERS = 16;
+
+const int HUGE_PAGES_NONE = 0;
+const int HUGE_PAGES_TRANSPARENT = 1;
+const int HUGE_PAGES_2M = 2;
+const int HUGE_PAGES_1G = 3;
+
+const int NUMA_POLICY_NONE = 0;
+const int NUMA_POLICY_INTERLEAVE = 1;
+const int NUMA_POLICY_BIND = 2;
+
+const int IO_BACKEND_SYNC = 0;
+const int IO_BACKEND_IO_URING = 1;
+
 const int MODE_SUPER = 0;
 const int MODE_SUPERCLASSIC = 1;
 const int MODE_CLASSIC = 2;
@@ -156,6 +174,17 @@ public:
 		KEY_READ_CONSISTENCY,
 		KEY_CLEAR_GTT_RETAINING,
 		KEY_DATA_TYPE_COMPATIBILITY,
+		KEY_PAGE_CACHE_POLICY,
+		KEY_READ_AHEAD_PAGES,
+		KEY_CACHE_WRITERS,
+		KEY_PAGE_CACHE_HUGE_PAGES,
+		KEY_PAGE_CACHE_NUMA_POLICY,
+		KEY_PAGE_CACHE_WARMUP,
+		KEY_IO_BACKEND,
+		KEY_LOCAL_LOCK_TABLE,
+		KEY_LOCK_HASH_MAX_CHAIN,
+		KEY_SORT_WORKERS,
+		KEY_PARALLEL_WORKERS,
 		MAX_CONFIG_KEY		// keep it last
 	};
 
@@ -393,6 +422,39 @@ public:
 	bool getClearGTTAtRetaining() const;
 
 	const char* getDataTypeCompatibility() const;
+
+	// Page buffers replacement policy
+	int getPageCachePolicy() const;
+
+	// Number of pages read ahead by sequential and bitmap scans, 0 disables read-ahead
+	ULONG getReadAheadPages() const;
+
+	// Number of background cache writer threads
+	ULONG getCacheWriters() const;
+
+	// Kind of memory pages backing page cache buffers
+	int getPageCacheHugePages() const;
+
+	// Placement of page cache buffers on NUMA nodes
+	int getPageCacheNumaPolicy() const;
+
+	// Seconds between saves of hot pages list used to warm up page cache, 0 disables warm-up
+	ULONG getPageCacheWarmup() const;
+
+	// Way database pages are read and written
+	int getIoBackend() const;
+
+	// Keep lock table in process memory when database is opened exclusively
+	bool getLocalLockTable() const;
+
+	// Average length of lock hash chains which makes the hash table grow
+	int getLockHashMaxChain() const;
+
+	// Threads sorting one in-memory sort buffer
+	int getSortWorkers() const;
+
+	// Threads scanning one table for a parallel aggregation
+	int getParallelWorkers() const;
 };
 
 // Implementation of interface to access master configuration file
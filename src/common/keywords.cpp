@@ -67,6 +67,7 @@ static const TOK tokens[] =
 	{TOK_ALL, "ALL", false},
 	{TOK_ALTER, "ALTER", false},
 	{TOK_ALWAYS, "ALWAYS", true},
+	{TOK_ANALYZE, "ANALYZE", true},
 	{TOK_AND, "AND", false},
 	{TOK_ANY, "ANY", false},
 	{TOK_AS, "AS", false},
@@ -105,6 +106,7 @@ static const TOK tokens[] =
 	{TOK_BOOLEAN, "BOOLEAN", false},
 	{TOK_BOTH, "BOTH", false},
 	{TOK_BREAK, "BREAK", true},
+	{TOK_BUFFERS, "BUFFERS", true},
 	{TOK_BY, "BY", false},
 	{TOK_CALLER, "CALLER", true},
 	{TOK_CASCADE, "CASCADE", true},
@@ -204,6 +206,7 @@ static const TOK tokens[] =
 	{TOK_EXISTS, "EXISTS", false},
 	{TOK_EXIT, "EXIT", true},
 	{TOK_EXP, "EXP", true},
+	{TOK_EXPLAIN, "EXPLAIN", true},
 	{TOK_EXTERNAL, "EXTERNAL", false},
 	{TOK_EXTRACT, "EXTRACT", false},
 	{TOK_FALSE, "FALSE", false},
@@ -325,6 +328,7 @@ static const TOK tokens[] =
 	{TOK_NUMERIC, "NUMERIC", false},
 	{TOK_OCTET_LENGTH, "OCTET_LENGTH", false},
 	{TOK_OF, "OF", false},
+	{TOK_OFF, "OFF", true},
 	{TOK_OFFSET, "OFFSET", false},
 	{TOK_OLDEST, "OLDEST", true},
 	{TOK_ON, "ON", false},
@@ -346,6 +350,7 @@ static const TOK tokens[] =
 	{TOK_PAGE, "PAGE", true},
 	{TOK_PAGES, "PAGES", true},
 	{TOK_PAGE_SIZE, "PAGE_SIZE", true},
+	{TOK_PARALLEL, "PARALLEL", true},
 	{TOK_PARAMETER, "PARAMETER", false},
 	{TOK_PARTITION, "PARTITION", true},
 	{TOK_PASSWORD, "PASSWORD", true},
@@ -528,6 +533,7 @@ static const TOK tokens[] =
 	{TOK_WITH, "WITH", false},
 	{TOK_WITHOUT, "WITHOUT", false},
 	{TOK_WORK, "WORK", true},
+	{TOK_WORKERS, "WORKERS", true},
 	{TOK_WRITE, "WRITE", true},
 	{TOK_YEAR, "YEAR", false},
 	{TOK_YEARDAY, "YEARDAY", true},
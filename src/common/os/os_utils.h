@@ -47,6 +47,9 @@
 #include <dirent.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #define DEFAULT_OPEN_MODE (0666)
 #endif
@@ -91,6 +94,20 @@ namespace os_utils
 	void getUniqueFileId(const char* name, Firebird::UCharBuffer& id);
 #endif
 
+	// Large memory blocks (page cache buffers) allocated directly from OS.
+	// Explicit huge pages of hugePageSize are tried first if it's not zero,
+	// then normal pages, marked as candidates for transparent huge pages when
+	// transparent is true. On return pageSize contains the size of explicit
+	// huge pages used, or zero. Size should be a multiple of hugePageSize.
+	void* allocLargeMemory(size_t size, size_t hugePageSize, bool transparent, size_t* pageSize);
+	void releaseLargeMemory(void* block, size_t size);
+
+	// NUMA placement of large memory blocks, should be set before memory is touched.
+	// Node is an index of NUMA node available to the process, negative value
+	// interleaves block over all available nodes.
+	unsigned getNumaNodes();	// zero when placement is not supported
+	bool setNumaPolicy(void* block, size_t size, int node);
+
 
 	inline off_t lseek(int fd, off_t offset, int whence)
 	{
@@ -228,6 +245,30 @@ namespace os_utils
 #endif
 	}
 
+#ifdef HAVE_PREADV
+	inline ssize_t preadv(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return preadv64(fd, iov, iovcnt, offset);
+#else
+		return ::preadv(fd, iov, iovcnt, offset);
+#endif
+	}
+#endif
+
+#ifdef HAVE_PWRITEV
+	inline ssize_t pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return pwritev64(fd, iov, iovcnt, offset);
+#else
+		return ::pwritev(fd, iov, iovcnt, offset);
+#endif
+	}
+#endif
+
 	inline struct dirent* readdir(DIR* dirp)
 	{
 		struct dirent* rc;
@@ -84,6 +84,14 @@
 
 #include <stdio.h>
 
+#ifdef LINUX
+#include <sys/syscall.h>
+#endif
+
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
 using namespace Firebird;
 
 namespace os_utils
@@ -411,6 +419,153 @@ void getUniqueFileId(const char* name, UCharBuffer& id)
 	makeUniqueFileId(statistics, id);
 }
 
+// Large memory blocks
+
+void* allocLargeMemory(size_t size, size_t hugePageSize, bool transparent, size_t* pageSize)
+{
+	*pageSize = 0;
+
+#ifdef MAP_ANONYMOUS
+	void* result;
+
+#ifdef MAP_HUGETLB
+	if (hugePageSize)
+	{
+		// Encode size of huge pages for kernels supporting more than one size,
+		// older kernels use default huge page size and ignore these bits
+
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+		int shift = 0;
+		while (((size_t) 1 << shift) < hugePageSize)
+			shift++;
+		flags |= shift << 26;	// MAP_HUGE_SHIFT
+
+		result = os_utils::mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (result != MAP_FAILED)
+		{
+			*pageSize = hugePageSize;
+			return result;
+		}
+	}
+#endif // MAP_HUGETLB
+
+	result = os_utils::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (result == MAP_FAILED)
+		return NULL;
+
+#ifdef MADV_HUGEPAGE
+	if (transparent)
+		madvise(result, size, MADV_HUGEPAGE);
+#endif
+
+	return result;
+#else // MAP_ANONYMOUS
+	return NULL;
+#endif // MAP_ANONYMOUS
+}
+
+void releaseLargeMemory(void* block, size_t size)
+{
+	munmap(block, size);
+}
+
+
+#if defined(LINUX) && defined(SYS_mbind)
+
+// Set of NUMA nodes the process is allowed to use
+const unsigned NUMA_MAX_NODES = 1024;
+const unsigned NUMA_MASK_BITS = 8 * sizeof(unsigned long);
+typedef unsigned long NumaMask[NUMA_MAX_NODES / NUMA_MASK_BITS];
+
+static unsigned getNumaMask(NumaMask& mask)
+{
+	memset(mask, 0, sizeof(NumaMask));
+
+	FILE* const file = os_utils::fopen("/sys/devices/system/node/online", "r");
+	if (!file)
+		return 0;
+
+	// Format is a list of ranges, for example 0-1,4
+
+	unsigned count = 0, low, high;
+	int c = ',';
+	while (c == ',' && fscanf(file, "%u", &low) == 1)
+	{
+		high = low;
+		c = fgetc(file);
+		if (c == '-')
+		{
+			if (fscanf(file, "%u", &high) != 1)
+				break;
+			c = fgetc(file);
+		}
+
+		for (unsigned node = low; node <= high && node < NUMA_MAX_NODES; node++)
+		{
+			mask[node / NUMA_MASK_BITS] |= 1UL << (node % NUMA_MASK_BITS);
+			count++;
+		}
+	}
+
+	fclose(file);
+	return count;
+}
+
+unsigned getNumaNodes()
+{
+	NumaMask mask;
+	return getNumaMask(mask);
+}
+
+bool setNumaPolicy(void* block, size_t size, int node)
+{
+	const int MPOL_PREFERRED_MODE = 1;
+	const int MPOL_INTERLEAVE_MODE = 3;
+
+	NumaMask mask;
+	const unsigned count = getNumaMask(mask);
+	if (!count)
+		return false;
+
+	int mode = MPOL_INTERLEAVE_MODE;
+
+	if (node >= 0)
+	{
+		// Find node with given index and leave only it in the mask.
+		// Preferred policy allows kernel to use other nodes when
+		// the chosen node is out of memory.
+
+		unsigned index = (unsigned) node % count;
+		for (unsigned n = 0; n < NUMA_MAX_NODES; n++)
+		{
+			unsigned long& word = mask[n / NUMA_MASK_BITS];
+			const unsigned long bit = 1UL << (n % NUMA_MASK_BITS);
+
+			if ((word & bit) && index-- != 0)
+				word &= ~bit;
+		}
+
+		mode = MPOL_PREFERRED_MODE;
+	}
+
+	return syscall(SYS_mbind, block, size, mode, mask, NUMA_MAX_NODES + 1, 0) == 0;
+}
+
+#else // LINUX && SYS_mbind
+
+unsigned getNumaNodes()
+{
+	return 0;
+}
+
+bool setNumaPolicy(void*, size_t, int)
+{
+	return false;
+}
+
+#endif // LINUX && SYS_mbind
+
+
 /// class CtrlCHandler
 
 bool CtrlCHandler::terminated = false;
@@ -336,6 +336,49 @@ void getUniqueFileId(HANDLE fd, Firebird::UCharBuffer& id)
 }
 
 
+// Large memory blocks
+
+void* allocLargeMemory(size_t size, size_t hugePageSize, bool /*transparent*/, size_t* pageSize)
+{
+	*pageSize = 0;
+
+	// Large pages require SeLockMemoryPrivilege, without it allocation fails
+	// and we fall back to normal pages. Windows has no transparent huge pages.
+
+	const size_t largePage = GetLargePageMinimum();
+	if (hugePageSize && largePage && size % largePage == 0)
+	{
+		void* const result = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+			PAGE_READWRITE);
+
+		if (result)
+		{
+			*pageSize = largePage;
+			return result;
+		}
+	}
+
+	return VirtualAlloc(NULL, size, MEM_COMMIT, PAGE_READWRITE);
+}
+
+void releaseLargeMemory(void* block, size_t /*size*/)
+{
+	VirtualFree(block, 0, MEM_RELEASE);
+}
+
+// NUMA placement of already allocated memory is not supported on Windows
+
+unsigned getNumaNodes()
+{
+	return 0;
+}
+
+bool setNumaPolicy(void* /*block*/, size_t /*size*/, int /*node*/)
+{
+	return false;
+}
+
+
 /// class CtrlCHandler
 
 bool CtrlCHandler::terminated = false;
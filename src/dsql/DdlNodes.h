@@ -1814,6 +1814,31 @@ public:
 };
 
 
+class AnalyzeTableNode : public DdlNode
+{
+public:
+	AnalyzeTableNode(MemoryPool& p, const Firebird::MetaName& aName)
+		: DdlNode(p),
+		  name(p, aName)
+	{
+	}
+
+public:
+	virtual Firebird::string internalPrint(NodePrinter& printer) const;
+	virtual bool checkPermission(thread_db* tdbb, jrd_tra* transaction);
+	virtual void execute(thread_db* tdbb, DsqlCompilerScratch* dsqlScratch, jrd_tra* transaction);
+
+protected:
+	virtual void putErrorPrefix(Firebird::Arg::StatusVector& statusVector)
+	{
+		statusVector << Firebird::Arg::Gds(isc_dsql_analyze_table_failed) << name;
+	}
+
+public:
+	Firebird::MetaName name;
+};
+
+
 class DropIndexNode : public DdlNode
 {
 public:
@@ -2390,6 +2415,7 @@ public:
 		  create(false),
 		  createLength(0),
 		  linger(-1),
+		  pageBuffers(-1),
 		  clauses(0),
 		  differenceFile(p),
 		  setDefaultCharSet(p),
@@ -2430,7 +2456,7 @@ private:
 
 public:
 	bool create;	// Is the node created with a CREATE DATABASE command?
-	SLONG createLength, linger;
+	SLONG createLength, linger, pageBuffers;
 	unsigned clauses;
 	Firebird::string differenceFile;
 	Firebird::MetaName setDefaultCharSet;
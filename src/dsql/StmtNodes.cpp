@@ -8396,6 +8396,14 @@ SetSessionNode::SetSessionNode(MemoryPool& pool, Type aType, ULONG aVal, UCHAR b
 {
 	// TYPE_IDLE_TIMEOUT should be set in seconds
 	// TYPE_STMT_TIMEOUT should be set in milliseconds
+	// TYPE_PARALLEL_WORKERS is a number of threads
+	// TYPE_EXPLAIN_ANALYZE is a boolean
+
+	if (aType == TYPE_PARALLEL_WORKERS || aType == TYPE_EXPLAIN_ANALYZE)
+	{
+		m_value = aVal;
+		return;
+	}
 
 	ULONG mult = 1;
 
@@ -8450,6 +8458,17 @@ void SetSessionNode::execute(thread_db* tdbb, dsql_req* request, jrd_tra** /*tra
 	case TYPE_STMT_TIMEOUT:
 		att->setStatementTimeout(m_value);
 		break;
+
+	case TYPE_PARALLEL_WORKERS:
+		att->setParallelWorkers(m_value);
+		break;
+
+	case TYPE_EXPLAIN_ANALYZE:
+		if (m_value)
+			att->att_flags |= ATT_explain_analyze;
+		else
+			att->att_flags &= ~ATT_explain_analyze;
+		break;
 	}
 }
 
@@ -1685,7 +1685,7 @@ public:
 class SetSessionNode : public SessionManagementNode
 {
 public:
-	enum Type { TYPE_IDLE_TIMEOUT, TYPE_STMT_TIMEOUT };
+	enum Type { TYPE_IDLE_TIMEOUT, TYPE_STMT_TIMEOUT, TYPE_PARALLEL_WORKERS, TYPE_EXPLAIN_ANALYZE };
 
 	SetSessionNode(MemoryPool& pool, Type aType, ULONG aVal, UCHAR blr_timepart);
 
@@ -596,6 +596,8 @@ using namespace Firebird;
 %token <metaNamePtr> BASE64_ENCODE
 %token <metaNamePtr> BINARY
 %token <metaNamePtr> BIND
+%token <metaNamePtr> BUFFERS
+%token <metaNamePtr> ANALYZE
 %token <metaNamePtr> COMPARE_DECFLOAT
 %token <metaNamePtr> CONSISTENCY
 %token <metaNamePtr> COUNTER
@@ -607,6 +609,7 @@ using namespace Firebird;
 %token <metaNamePtr> DEFINER
 %token <metaNamePtr> EXCESS
 %token <metaNamePtr> EXCLUDE
+%token <metaNamePtr> EXPLAIN
 %token <metaNamePtr> FIRST_DAY
 %token <metaNamePtr> FOLLOWING
 %token <metaNamePtr> HEX_DECODE
@@ -627,8 +630,10 @@ using namespace Firebird;
 %token <metaNamePtr> NORMALIZE_DECFLOAT
 %token <metaNamePtr> NTILE
 %token <metaNamePtr> NUMBER
+%token <metaNamePtr> OFF
 %token <metaNamePtr> OTHERS
 %token <metaNamePtr> OVERRIDING
+%token <metaNamePtr> PARALLEL
 %token <metaNamePtr> PERCENT_RANK
 %token <metaNamePtr> PRECEDING
 %token <metaNamePtr> PRIVILEGE
@@ -660,6 +665,7 @@ using namespace Firebird;
 %token <metaNamePtr> VARBINARY
 %token <metaNamePtr> WINDOW
 %token <metaNamePtr> WITHOUT
+%token <metaNamePtr> WORKERS
 %token <metaNamePtr> ZONE
 
 // external connections pool management
@@ -856,6 +862,7 @@ dml_statement
 %type <ddlNode> ddl_statement
 ddl_statement
 	: alter										{ $$ = $1; }
+	| analyze_table								{ $$ = $1; }
 	| comment									{ $$ = $1; }
 	| create									{ $$ = $1; }
 	| create_or_alter							{ $$ = $1; }
@@ -4385,6 +4392,8 @@ db_alter_clause($alterDatabaseNode)
 		{ $alterDatabaseNode->linger = $4; }
 	| DROP LINGER
 		{ $alterDatabaseNode->linger = 0; }
+	| SET PAGE BUFFERS TO long_integer
+		{ $alterDatabaseNode->pageBuffers = $5; }
 	| SET DEFAULT sql_security_clause
 		{ $alterDatabaseNode->ssDefiner = $3; }
 	;
@@ -5360,6 +5369,12 @@ session_statement
 		{ $$ = newNode<SetSessionNode>(SetSessionNode::TYPE_IDLE_TIMEOUT, $5, $6); }
 	| SET STATEMENT TIMEOUT long_integer timepart_ses_stmt_tout
 		{ $$ = newNode<SetSessionNode>(SetSessionNode::TYPE_STMT_TIMEOUT, $4, $5); }
+	| SET PARALLEL WORKERS long_integer
+		{ $$ = newNode<SetSessionNode>(SetSessionNode::TYPE_PARALLEL_WORKERS, $4, 0); }
+	| SET EXPLAIN ANALYZE ON
+		{ $$ = newNode<SetSessionNode>(SetSessionNode::TYPE_EXPLAIN_ANALYZE, 1, 0); }
+	| SET EXPLAIN ANALYZE OFF
+		{ $$ = newNode<SetSessionNode>(SetSessionNode::TYPE_EXPLAIN_ANALYZE, 0, 0); }
 	;
 
 %type <blrOp> timepart_sesion_idle_tout
@@ -5533,6 +5548,12 @@ set_statistics
 		{ $$ = newNode<SetStatisticsNode>(*$4); }
 	;
 
+%type <ddlNode>	analyze_table
+analyze_table
+	: ANALYZE TABLE symbol_table_name
+		{ $$ = newNode<AnalyzeTableNode>(*$3); }
+	;
+
 %type <ddlNode> comment
 comment
 	: COMMENT ON ddl_type0 IS ddl_desc
@@ -8844,7 +8865,9 @@ non_reserved_word
 	| TRUSTED
 	| BASE64_DECODE		// added in FB 4.0
 	| BASE64_ENCODE
+	| ANALYZE
 	| BIND
+	| BUFFERS
 	| CLEAR
 	| COUNTER
 	| COMPARE_DECFLOAT
@@ -8858,6 +8881,7 @@ non_reserved_word
 	| DEFINER
 	| EXCESS
 	| EXCLUDE
+	| EXPLAIN
 	| FIRST_DAY
 	| FOLLOWING
 	| HEX_DECODE
@@ -8875,9 +8899,11 @@ non_reserved_word
 	| NORMALIZE_DECFLOAT
 	| NTILE
 	| NUMBER
+	| OFF
 	| OLDEST
 	| OTHERS
 	| OVERRIDING
+	| PARALLEL
 	| PERCENT_RANK
 	| POOL
 	| PRECEDING
@@ -8900,6 +8926,7 @@ non_reserved_word
 	| TIES
 	| TOTALORDER
 	| TRAPS
+	| WORKERS
 	| ZONE
 	;
 
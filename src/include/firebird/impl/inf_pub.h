@@ -160,6 +160,16 @@ enum db_info_types
 
 	fb_info_creation_timestamp_tz = 139,
 
+	fb_info_page_cache_hot_hits = 140,
+	fb_info_page_cache_cold_hits = 141,
+	fb_info_page_cache_ghost_hits = 142,
+	fb_info_page_cache_misses = 143,
+
+	fb_info_page_cache_writer_pages = 144,
+	fb_info_page_cache_vectored_writes = 145,
+	fb_info_page_cache_vectored_pages = 146,
+	fb_info_page_cache_writer_rate = 147,
+
 	isc_info_db_last_value   /* Leave this LAST! */
 };
 
@@ -1349,6 +1349,7 @@ static const struct {
 	{"dsql_string_char_length", 336397332},
 	{"dsql_max_nesting", 336397333},
 	{"dsql_recreate_user_failed", 336397334},
+	{"dsql_analyze_table_failed", 336397335},
 	{"gsec_cant_open_db", 336723983},
 	{"gsec_switches_error", 336723984},
 	{"gsec_no_op_spec", 336723985},
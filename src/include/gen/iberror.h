@@ -1383,6 +1383,7 @@ const ISC_STATUS isc_dsql_string_byte_length          = 336397331L;
 const ISC_STATUS isc_dsql_string_char_length          = 336397332L;
 const ISC_STATUS isc_dsql_max_nesting                 = 336397333L;
 const ISC_STATUS isc_dsql_recreate_user_failed        = 336397334L;
+const ISC_STATUS isc_dsql_analyze_table_failed        = 336397335L;
 const ISC_STATUS isc_gsec_cant_open_db                = 336723983L;
 const ISC_STATUS isc_gsec_switches_error              = 336723984L;
 const ISC_STATUS isc_gsec_no_op_spec                  = 336723985L;
@@ -1489,7 +1490,7 @@ const ISC_STATUS isc_trace_switch_user_only           = 337182757L;
 const ISC_STATUS isc_trace_switch_param_miss          = 337182758L;
 const ISC_STATUS isc_trace_param_act_notcompat        = 337182759L;
 const ISC_STATUS isc_trace_mandatory_switch_miss      = 337182760L;
-const ISC_STATUS isc_err_max                          = 1433;
+const ISC_STATUS isc_err_max                          = 1434;
 
 #else /* c definitions */
 
@@ -2842,6 +2843,7 @@ const ISC_STATUS isc_err_max                          = 1433;
 #define isc_dsql_string_char_length          336397332L
 #define isc_dsql_max_nesting                 336397333L
 #define isc_dsql_recreate_user_failed        336397334L
+#define isc_dsql_analyze_table_failed        336397335L
 #define isc_gsec_cant_open_db                336723983L
 #define isc_gsec_switches_error              336723984L
 #define isc_gsec_no_op_spec                  336723985L
@@ -2948,7 +2950,7 @@ const ISC_STATUS isc_err_max                          = 1433;
 #define isc_trace_switch_param_miss          337182758L
 #define isc_trace_param_act_notcompat        337182759L
 #define isc_trace_mandatory_switch_miss      337182760L
-#define isc_err_max                          1433
+#define isc_err_max                          1434
 
 #endif
 
@@ -555,6 +555,8 @@
 	const USHORT  f_mon_stmt_expl_plan = 7;
 	const USHORT  f_mon_stmt_timeout = 8;
 	const USHORT  f_mon_stmt_timer = 9;
+	const USHORT  f_mon_stmt_temp_granted = 10;
+	const USHORT  f_mon_stmt_temp_spilled = 11;
 
 
 // Relation 37 (MON$CALL_STACK)
@@ -705,3 +707,13 @@
 	const USHORT  f_tz_name = 1;
 
 
+// Relation 51 (RDB$COLUMN_STATISTICS)
+
+	const USHORT  f_cst_rel_name = 0;
+	const USHORT  f_cst_fld_name = 1;
+	const USHORT  f_cst_records = 2;
+	const USHORT  f_cst_distinct = 3;
+	const USHORT  f_cst_null_frac = 4;
+	const USHORT  f_cst_histogram = 5;
+
+
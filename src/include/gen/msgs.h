@@ -1352,6 +1352,7 @@ Data source : @4"},		/* eds_statement */
 	{336397332, "String literal with @1 characters exceeds the maximum length of @2 characters for the @3 character set"},		/* dsql_string_char_length */
 	{336397333, "Too many BEGIN...END nesting. Maximum level is @1"},		/* dsql_max_nesting */
 	{336397334, "RECREATE USER @1 failed"},		/* dsql_recreate_user_failed */
+	{336397335, "ANALYZE TABLE @1 failed"},		/* dsql_analyze_table_failed */
 	{336723983, "unable to open database"},		/* gsec_cant_open_db */
 	{336723984, "error in switch specifications"},		/* gsec_switches_error */
 	{336723985, "no operation specified"},		/* gsec_no_op_spec */
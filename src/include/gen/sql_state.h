@@ -1348,6 +1348,7 @@ static const struct {
 	{336397332, "42000"}, // 1044 dsql_string_char_length
 	{336397333, "07002"}, // 1045 dsql_max_nesting
 	{336397334, "42000"}, // 1046 dsql_recreate_user_failed
+	{336397335, "42000"}, // 1047 dsql_analyze_table_failed
 	{336723983, "00000"}, //  15 gsec_cant_open_db
 	{336723984, "00000"}, //  16 gsec_switches_error
 	{336723985, "00000"}, //  17 gsec_no_op_spec
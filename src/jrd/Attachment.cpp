@@ -249,6 +249,7 @@ Jrd::Attachment::Attachment(MemoryPool* pool, Database* dbb)
 	  att_pools(*pool),
 	  att_idle_timeout(0),
 	  att_stmt_timeout(0),
+	  att_parallel_workers(0),
 	  att_batches(*pool),
 	  att_initial_options(*pool)
 {
@@ -499,6 +500,12 @@ void Jrd::Attachment::resetSession(thread_db* tdbb, jrd_tra** traHandle)
 	setIdleTimeout(0);
 	setStatementTimeout(0);
 
+	// reset parallel workers
+	setParallelWorkers(0);
+
+	// reset profiling of the record sources
+	att_flags &= ~ATT_explain_analyze;
+
 	// reset context variables
 	att_context_vars.clear();
 
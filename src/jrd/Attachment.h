@@ -158,6 +158,7 @@ const ULONG ATT_monitor_done		= 0x10000L; // Monitoring data is refreshed
 const ULONG ATT_security_db			= 0x20000L; // Attachment used for security purposes
 const ULONG ATT_mapping				= 0x40000L; // Attachment used for mapping auth block
 const ULONG ATT_crypt_thread		= 0x80000L; // Attachment from crypt thread
+const ULONG ATT_explain_analyze	= 0x100000L; // Profile the record sources of the requests started
 
 const ULONG ATT_NO_CLEANUP			= (ATT_no_cleanup | ATT_notify_gc);
 
@@ -594,6 +595,16 @@ public:
 		att_stmt_timeout = timeOut;
 	}
 
+	unsigned int getParallelWorkers() const
+	{
+		return att_parallel_workers;
+	}
+
+	void setParallelWorkers(unsigned int workers)
+	{
+		att_parallel_workers = workers;
+	}
+
 	// evaluate new value or clear idle timer
 	void setupIdleTimer(bool clear);
 
@@ -668,6 +679,7 @@ private:
 
 	unsigned int att_idle_timeout;		// seconds
 	unsigned int att_stmt_timeout;		// milliseconds
+	unsigned int att_parallel_workers;	// for the statements prepared, zero for the database default
 	Firebird::RefPtr<IdleTimer> att_idle_timer;
 
 	Firebird::Array<JBatch*> att_batches;
@@ -0,0 +1,561 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		ColumnStatistics.cpp
+ *	DESCRIPTION:	Column statistics used by the optimizer
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include <math.h>
+#include <algorithm>
+#include "../jrd/ColumnStatistics.h"
+#include "../jrd/jrd.h"
+#include "../jrd/ods.h"
+#include "../jrd/req.h"
+#include "../jrd/tra.h"
+#include "../jrd/Relation.h"
+#include "../jrd/evl_proto.h"
+#include "../jrd/met_proto.h"
+#include "../jrd/mov_proto.h"
+#include "../jrd/rlck_proto.h"
+#include "../jrd/vio_proto.h"
+#include "../common/classes/timestamp.h"
+#include "../common/utils_proto.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+namespace
+{
+	// Format of the histogram blob
+	const UCHAR HISTOGRAM_VERSION = 1;
+	const unsigned HISTOGRAM_HEADER = 8;
+
+	// Number of values sampled to build the histogram
+	const unsigned SAMPLE_SIZE = 8192;
+
+	// HyperLogLog sketch counting the distinct values, 2^12 registers
+	// give the standard error of 1.6%
+	const unsigned HLL_BITS = 12;
+	const unsigned HLL_REGISTERS = 1 << HLL_BITS;
+
+	FB_UINT64 hashBytes(const UCHAR* data, ULONG length)
+	{
+		// FNV-1a followed by the MurmurHash3 finalizer, so that
+		// all bits of the hash depend on all bits of the value
+
+		FB_UINT64 hash = FB_CONST64(0xcbf29ce484222325);
+
+		for (const UCHAR* const end = data + length; data < end; data++)
+		{
+			hash ^= *data;
+			hash *= FB_CONST64(0x100000001b3);
+		}
+
+		hash ^= hash >> 33;
+		hash *= FB_CONST64(0xff51afd7ed558ccd);
+		hash ^= hash >> 33;
+		hash *= FB_CONST64(0xc4ceb9fe1a85ec53);
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
+	void putBytes(UCharBuffer& buffer, const void* data, FB_SIZE_T length)
+	{
+		buffer.add(static_cast<const UCHAR*>(data), length);
+	}
+
+	// Accumulates the values of a column during the relation scan
+
+	class Collector
+	{
+	public:
+		Collector(MemoryPool& p, ColumnStatistics* aStats)
+			: stats(aStats),
+			  histogram(ColumnStatistics::hasHistogramType(aStats->cst_dtype)),
+			  registers(p), sample(p),
+			  nulls(0), values(0), minimum(0), maximum(0),
+			  seed(FB_CONST64(0x9e3779b97f4a7c15))
+		{
+			memset(registers.getBuffer(HLL_REGISTERS), 0, HLL_REGISTERS);
+		}
+
+		void add(thread_db* tdbb, const dsc* desc);
+		void finish(SINT64 records);
+
+	private:
+		void addHash(FB_UINT64 hash);
+		void addSample(double value);
+		double estimateDistinct() const;
+
+		ColumnStatistics* const stats;
+		const bool histogram;
+		Array<UCHAR> registers;
+		Array<double> sample;
+		SINT64 nulls;
+		SINT64 values;
+		double minimum;
+		double maximum;
+		FB_UINT64 seed;
+	};
+
+	void Collector::add(thread_db* tdbb, const dsc* desc)
+	{
+		if (!desc)
+		{
+			nulls++;
+			return;
+		}
+
+		if (histogram)
+		{
+			double value;
+
+			if (!ColumnStatistics::getValue(tdbb, stats->cst_dtype, desc, value))
+				return;
+
+			if (value == 0)
+				value = 0;	// don't let -0.0 count as another value
+
+			addHash(hashBytes(reinterpret_cast<const UCHAR*>(&value), sizeof(value)));
+			addSample(value);
+			return;
+		}
+
+		const UCHAR* address = desc->dsc_address;
+		ULONG length = desc->dsc_length;
+
+		switch (desc->dsc_dtype)
+		{
+		case dtype_varying:
+			address = reinterpret_cast<const UCHAR*>(
+				reinterpret_cast<const vary*>(desc->dsc_address)->vary_string);
+			length = reinterpret_cast<const vary*>(desc->dsc_address)->vary_length;
+			break;
+
+		case dtype_cstring:
+			length = static_cast<ULONG>(strlen(reinterpret_cast<const char*>(address)));
+			break;
+		}
+
+		if (desc->isText())
+		{
+			// Trailing pad characters are not significant for comparisons
+			const UCHAR pad = (desc->getTextType() == ttype_binary) ? 0 : ' ';
+
+			while (length && address[length - 1] == pad)
+				length--;
+		}
+
+		addHash(hashBytes(address, length));
+		values++;
+	}
+
+	void Collector::addHash(FB_UINT64 hash)
+	{
+		// The leading bits choose the register, which keeps the longest
+		// run of leading zeros seen in the remaining bits
+
+		const unsigned index = static_cast<unsigned>(hash >> (64 - HLL_BITS));
+		const FB_UINT64 rest = hash << HLL_BITS;
+
+		UCHAR rank = 1;
+		for (FB_UINT64 bit = FB_CONST64(0x8000000000000000);
+			 rank <= 64 - HLL_BITS && !(rest & bit); bit >>= 1)
+		{
+			rank++;
+		}
+
+		if (registers[index] < rank)
+			registers[index] = rank;
+	}
+
+	void Collector::addSample(double value)
+	{
+		if (!values || value < minimum)
+			minimum = value;
+
+		if (!values || value > maximum)
+			maximum = value;
+
+		values++;
+
+		// Reservoir sampling: each of the values seen so far
+		// has the same chance to be kept in the sample
+
+		if (sample.getCount() < SAMPLE_SIZE)
+		{
+			sample.add(value);
+			return;
+		}
+
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+
+		const FB_UINT64 position = seed % static_cast<FB_UINT64>(values);
+
+		if (position < SAMPLE_SIZE)
+			sample[static_cast<FB_SIZE_T>(position)] = value;
+	}
+
+	double Collector::estimateDistinct() const
+	{
+		const double count = HLL_REGISTERS;
+		double sum = 0;
+		unsigned empty = 0;
+
+		for (const UCHAR* ptr = registers.begin(); ptr < registers.end(); ptr++)
+		{
+			sum += ldexp(1.0, -static_cast<int>(*ptr));
+
+			if (!*ptr)
+				empty++;
+		}
+
+		double estimate = (0.7213 / (1 + 1.079 / count)) * count * count / sum;
+
+		// Small cardinalities are counted better by the empty registers
+		if (estimate <= 2.5 * count && empty)
+			estimate = count * log(count / empty);
+
+		return estimate;
+	}
+
+	void Collector::finish(SINT64 records)
+	{
+		stats->cst_records = records;
+		stats->cst_null_fraction = records ? static_cast<double>(nulls) / records : 0;
+		stats->cst_distinct = MIN(estimateDistinct(), static_cast<double>(values));
+		stats->cst_bounds.clear();
+
+		if (!histogram || sample.isEmpty())
+			return;
+
+		// Equi-depth histogram: bucket boundaries are taken at equal distances
+		// in the sorted sample, the outer ones are the exact extremes
+
+		std::sort(sample.begin(), sample.end());
+
+		const FB_SIZE_T last = sample.getCount() - 1;
+		const unsigned buckets = ColumnStatistics::HISTOGRAM_BUCKETS;
+
+		stats->cst_bounds.add(minimum);
+
+		for (unsigned i = 1; i < buckets; i++)
+		{
+			const FB_SIZE_T position = static_cast<FB_SIZE_T>(
+				(static_cast<FB_UINT64>(last) * i + buckets / 2) / buckets);
+			stats->cst_bounds.add(sample[position]);
+		}
+
+		stats->cst_bounds.add(maximum);
+	}
+}
+
+
+bool ColumnStatistics::isSupported(thread_db* tdbb)
+{
+	const Database* const dbb = tdbb->getDatabase();
+
+	return ENCODE_ODS(dbb->dbb_ods_version, dbb->dbb_minor_version) >= ODS_13_1;
+}
+
+bool ColumnStatistics::hasHistogramType(UCHAR dtype)
+{
+	return DTYPE_IS_EXACT(dtype) || DTYPE_IS_APPROX(dtype) || DTYPE_IS_DECFLOAT(dtype) ||
+		DTYPE_IS_DATE(dtype) || dtype == dtype_boolean;
+}
+
+bool ColumnStatistics::getValue(thread_db* tdbb, UCHAR dtype, const dsc* desc, double& value)
+{
+	const double ticksPerDay = static_cast<double>(TimeStamp::ISC_TICKS_PER_DAY);
+
+	try
+	{
+		switch (dtype)
+		{
+		case dtype_sql_date:
+			value = MOV_get_sql_date(desc);
+			return true;
+
+		case dtype_sql_time:
+			value = MOV_get_sql_time(desc) / ticksPerDay;
+			return true;
+
+		case dtype_sql_time_tz:
+			value = MOV_get_sql_time_tz(desc).utc_time / ticksPerDay;
+			return true;
+
+		case dtype_timestamp:
+			{
+				const ISC_TIMESTAMP ts = MOV_get_timestamp(desc);
+				value = ts.timestamp_date + ts.timestamp_time / ticksPerDay;
+			}
+			return true;
+
+		case dtype_timestamp_tz:
+			{
+				const ISC_TIMESTAMP ts = MOV_get_timestamp_tz(desc).utc_timestamp;
+				value = ts.timestamp_date + ts.timestamp_time / ticksPerDay;
+			}
+			return true;
+
+		case dtype_boolean:
+			value = MOV_get_boolean(desc) ? 1 : 0;
+			return true;
+
+		default:
+			if (!hasHistogramType(dtype))
+				return false;
+
+			value = MOV_get_double(tdbb, desc);
+			return true;
+		}
+	}
+	catch (const Exception&)
+	{
+		// The value is not convertible to the column type,
+		// the statistics just aren't applicable
+		fb_utils::init_status(tdbb->tdbb_status_vector);
+	}
+
+	return false;
+}
+
+void ColumnStatistics::gather(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation,
+	Array<ColumnStatistics*>& columns)
+{
+	SET_TDBB(tdbb);
+	MemoryPool& pool = *tdbb->getDefaultPool();
+
+	MET_scan_relation(tdbb, relation);
+	const Format* const format = MET_current(tdbb, relation);
+	const vec<jrd_fld*>* const fields = relation->rel_fields;
+
+	HalfStaticArray<Collector*, 16> collectors;
+
+	for (USHORT id = 0; id < format->fmt_count; id++)
+	{
+		const dsc* const desc = &format->fmt_desc[id];
+		const jrd_fld* const field = (fields && id < fields->count()) ? (*fields)[id] : NULL;
+
+		// Dropped and computed fields aren't stored, blobs can't be compared
+		if (!field || field->fld_computation || !desc->dsc_dtype ||
+			DTYPE_IS_BLOB(desc->dsc_dtype))
+		{
+			continue;
+		}
+
+		ColumnStatistics* const stats = FB_NEW_POOL(pool) ColumnStatistics(pool);
+		stats->cst_field_id = id;
+		stats->cst_dtype = desc->dsc_dtype;
+		stats->cst_scale = desc->dsc_scale;
+		stats->cst_length = desc->dsc_length;
+
+		columns.add(stats);
+		collectors.add(FB_NEW_POOL(pool) Collector(pool, stats));
+	}
+
+	if (columns.isEmpty())
+		return;
+
+	RLCK_reserve_relation(tdbb, transaction, relation, false);
+
+	record_param rpb;
+	rpb.rpb_relation = relation;
+	rpb.rpb_number.setValue(BOF_NUMBER);
+
+	SINT64 records = 0;
+
+	while (VIO_next_record(tdbb, &rpb, transaction, &pool, false))
+	{
+		if (--tdbb->tdbb_quantum < 0)
+			JRD_reschedule(tdbb, 0, true);
+
+		records++;
+
+		for (FB_SIZE_T i = 0; i < columns.getCount(); i++)
+		{
+			dsc desc;
+			const bool notNull = EVL_field(relation, rpb.rpb_record, columns[i]->cst_field_id, &desc);
+			collectors[i]->add(tdbb, notNull ? &desc : NULL);
+		}
+	}
+
+	delete rpb.rpb_record;
+
+	for (FB_SIZE_T i = 0; i < collectors.getCount(); i++)
+	{
+		collectors[i]->finish(records);
+		delete collectors[i];
+	}
+}
+
+void ColumnStatistics::serialize(UCharBuffer& buffer) const
+{
+	const USHORT count = static_cast<USHORT>(cst_bounds.getCount());
+
+	buffer.clear();
+	buffer.add(HISTOGRAM_VERSION);
+	buffer.add(cst_dtype);
+	buffer.add(static_cast<UCHAR>(cst_scale));
+	buffer.add(0);
+	putBytes(buffer, &cst_length, sizeof(cst_length));
+	putBytes(buffer, &count, sizeof(count));
+	putBytes(buffer, cst_bounds.begin(), count * sizeof(double));
+
+	fb_assert(buffer.getCount() == HISTOGRAM_HEADER + count * sizeof(double));
+}
+
+bool ColumnStatistics::parse(const UCHAR* data, ULONG length)
+{
+	if (length < HISTOGRAM_HEADER || data[0] != HISTOGRAM_VERSION)
+		return false;
+
+	USHORT count;
+	memcpy(&count, data + 6, sizeof(count));
+
+	if ((count && count != HISTOGRAM_BUCKETS + 1) ||
+		length != HISTOGRAM_HEADER + count * sizeof(double))
+	{
+		return false;
+	}
+
+	cst_dtype = data[1];
+	cst_scale = static_cast<SCHAR>(data[2]);
+	memcpy(&cst_length, data + 4, sizeof(cst_length));
+	memcpy(cst_bounds.getBuffer(count), data + HISTOGRAM_HEADER, count * sizeof(double));
+
+	prepare();
+	return true;
+}
+
+void ColumnStatistics::prepare()
+{
+	// Values filling whole buckets are the common ones, find how many
+	// rows they take to tell the frequency of the rest of the values
+
+	cst_common_fraction = 0;
+	cst_common_values = 0;
+
+	if (!hasHistogram())
+		return;
+
+	for (unsigned i = 0; i < HISTOGRAM_BUCKETS; )
+	{
+		unsigned count = 0;
+
+		while (i + count < HISTOGRAM_BUCKETS && cst_bounds[i + count] == cst_bounds[i + count + 1] &&
+			cst_bounds[i + count] == cst_bounds[i])
+		{
+			count++;
+		}
+
+		if (count)
+		{
+			cst_common_fraction += (count + 1.0) / HISTOGRAM_BUCKETS;
+			cst_common_values++;
+			i += count;
+		}
+		else
+			i++;
+	}
+
+	cst_common_fraction = MIN(cst_common_fraction, 1.0);
+}
+
+double ColumnStatistics::getFractionBelow(double value, bool inclusive) const
+{
+	// Fraction of non-null values less than (or equal to) the given one,
+	// the values are assumed to be spread uniformly inside a bucket
+
+	double buckets = 0;
+
+	for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		const double lower = cst_bounds[i];
+		const double upper = cst_bounds[i + 1];
+
+		if (upper < value || (inclusive && upper == value))
+			buckets += 1;
+		else if (lower < value)
+			buckets += (value - lower) / (upper - lower);
+		else
+			break;
+	}
+
+	return buckets / HISTOGRAM_BUCKETS;
+}
+
+double ColumnStatistics::getMinimumSelectivity() const
+{
+	// Never estimate less than a single row, the statistics may be outdated
+	return cst_records ? 1.0 / cst_records : 1.0;
+}
+
+double ColumnStatistics::getNullSelectivity() const
+{
+	return MAX(cst_null_fraction, getMinimumSelectivity());
+}
+
+double ColumnStatistics::getEqualitySelectivity(const double* value) const
+{
+	if (cst_distinct < 1)
+		return getMinimumSelectivity();
+
+	double selectivity = 1 / cst_distinct;
+
+	if (value && hasHistogram())
+	{
+		if (*value < cst_bounds.front() || *value > cst_bounds.back())
+			return getMinimumSelectivity();
+
+		unsigned count = 0;
+
+		for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+		{
+			if (cst_bounds[i] == *value && cst_bounds[i + 1] == *value)
+				count++;
+		}
+
+		if (count)
+			selectivity = (count + 1.0) / HISTOGRAM_BUCKETS;
+		else if (cst_distinct > cst_common_values)
+			selectivity = (1 - cst_common_fraction) / (cst_distinct - cst_common_values);
+	}
+
+	selectivity = MIN(selectivity, 1.0) * (1 - cst_null_fraction);
+
+	return MAX(selectivity, getMinimumSelectivity());
+}
+
+double ColumnStatistics::getRangeSelectivity(const double* lower, bool lowerInclusive,
+	const double* upper, bool upperInclusive) const
+{
+	fb_assert(hasHistogram());
+
+	const double below = upper ? getFractionBelow(*upper, upperInclusive) : 1.0;
+	const double above = lower ? getFractionBelow(*lower, !lowerInclusive) : 0;
+
+	const double selectivity = MAX(below - above, 0) * (1 - cst_null_fraction);
+
+	return MAX(selectivity, getMinimumSelectivity());
+}
@@ -0,0 +1,126 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		ColumnStatistics.h
+ *	DESCRIPTION:	Column statistics used by the optimizer
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_COLUMN_STATISTICS_H
+#define JRD_COLUMN_STATISTICS_H
+
+#include "../common/classes/alloc.h"
+#include "../common/classes/array.h"
+#include "../common/classes/fb_string.h"
+#include "../common/classes/MetaName.h"
+#include "../common/dsc.h"
+
+namespace Jrd {
+
+class thread_db;
+class jrd_rel;
+class jrd_tra;
+
+// Statistics of a table column, gathered by ANALYZE TABLE and stored in
+// RDB$COLUMN_STATISTICS: the number of distinct values, the fraction of NULLs
+// and, for numeric and date/time columns, an equi-depth histogram. Values of
+// such columns are mapped onto a double axis (dates are days, times are
+// fractions of a day, time zone types use UTC), the histogram keeps the
+// boundaries of buckets holding the same number of non-null values.
+
+class ColumnStatistics : public Firebird::PermanentStorage
+{
+public:
+	explicit ColumnStatistics(MemoryPool& p)
+		: PermanentStorage(p),
+		  cst_field_id(0), cst_records(0), cst_distinct(0), cst_null_fraction(0),
+		  cst_dtype(dtype_unknown), cst_scale(0), cst_length(0),
+		  cst_bounds(p), cst_common_fraction(0), cst_common_values(0)
+	{
+	}
+
+	static USHORT generate(const ColumnStatistics* stats)
+	{
+		return stats->cst_field_id;
+	}
+
+	// Number of histogram buckets
+	static const unsigned HISTOGRAM_BUCKETS = 64;
+
+	// Whether the database has RDB$COLUMN_STATISTICS (ODS 13.1 and later)
+	static bool isSupported(thread_db* tdbb);
+
+	// Whether values of the given type are placed in a histogram
+	static bool hasHistogramType(UCHAR dtype);
+
+	// Map a value onto the histogram axis of a column of the given type,
+	// returns false if the value cannot be converted
+	static bool getValue(thread_db* tdbb, UCHAR dtype, const dsc* desc, double& value);
+
+	// Scan the relation and gather the statistics of the given fields
+	static void gather(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation,
+		Firebird::Array<ColumnStatistics*>& columns);
+
+	// Histogram blob stored in RDB$COLUMN_STATISTICS
+	void serialize(Firebird::UCharBuffer& buffer) const;
+	bool parse(const UCHAR* data, ULONG length);
+
+	// Statistics describe the column as it is defined now
+	bool matches(const dsc* desc) const
+	{
+		return cst_dtype == desc->dsc_dtype && cst_scale == desc->dsc_scale &&
+			cst_length == desc->dsc_length;
+	}
+
+	bool hasHistogram() const
+	{
+		return cst_bounds.getCount() == HISTOGRAM_BUCKETS + 1;
+	}
+
+	// Estimated fractions of all rows of the table
+	double getNullSelectivity() const;
+	double getEqualitySelectivity(const double* value) const;
+	double getRangeSelectivity(const double* lower, bool lowerInclusive,
+		const double* upper, bool upperInclusive) const;
+
+	USHORT cst_field_id;
+	SINT64 cst_records;			// rows in the table when analyzed
+	double cst_distinct;		// distinct non-null values
+	double cst_null_fraction;	// fraction of rows being NULL
+
+	UCHAR cst_dtype;			// descriptor of the column when analyzed
+	SCHAR cst_scale;
+	USHORT cst_length;
+
+	Firebird::Array<double> cst_bounds;	// histogram bucket boundaries
+
+private:
+	void prepare();
+	double getFractionBelow(double value, bool inclusive) const;
+	double getMinimumSelectivity() const;
+
+	double cst_common_fraction;	// fraction of non-null rows taken by values filling buckets
+	unsigned cst_common_values;	// number of such values
+};
+
+typedef Firebird::SortedArray<ColumnStatistics*, Firebird::EmptyStorage<ColumnStatistics*>,
+	USHORT, ColumnStatistics> ColumnStatisticsList;
+
+} // namespace Jrd
+
+#endif // JRD_COLUMN_STATISTICS_H
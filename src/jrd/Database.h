@@ -399,6 +399,8 @@ public:
 
 	Firebird::Mutex dbb_temp_cache_mutex;
 	FB_UINT64 dbb_temp_cache_size;		// total size of in-memory temp space chunks (see TempSpace class)
+	FB_UINT64 dbb_temp_cache_weight;	// total weight of temp spaces using the cache
+	FB_UINT64 dbb_temp_cache_wanted;	// memory refused to temp spaces within their shares
 
 	TraNumber dbb_oldest_active;		// Cached "oldest active" transaction
 	TraNumber dbb_oldest_transaction;	// Cached "oldest interesting" transaction
@@ -441,6 +443,7 @@ public:
 	FB_UINT64 dbb_repl_sequence;		// replication sequence
 	ReplicaMode dbb_replica_mode;		// replica access mode
 	unsigned dbb_compatibility_index;	// datatype backward compatibility level
+	Firebird::AtomicCounter dbb_column_stats_generation;	// bumped when column statistics change
 
 	// returns true if primary file is located on raw device
 	bool onRawDevice() const;
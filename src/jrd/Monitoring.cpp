@@ -1134,6 +1134,12 @@ void Monitoring::putRequest(SnapshotData::DumpRecord& record, const jrd_req* req
 
 	// statement timeout, milliseconds
 	record.storeInteger(f_mon_stmt_timeout, request->req_timeout);
+
+	// temp cache memory granted and temp file space used, bytes
+	record.storeInteger(f_mon_stmt_temp_granted,
+		request->req_stats.getValue(RuntimeStatistics::TEMP_GRANTED));
+	record.storeInteger(f_mon_stmt_temp_spilled,
+		request->req_stats.getValue(RuntimeStatistics::TEMP_SPILLED));
 	record.write();
 
 	putStatistics(record, request->req_stats, stat_id, stat_statement);
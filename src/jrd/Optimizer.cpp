@@ -33,6 +33,7 @@
 #include "../jrd/btr.h"
 #include "../jrd/intl.h"
 #include "../jrd/Collation.h"
+#include "../jrd/ColumnStatistics.h"
 #include "../jrd/rse.h"
 #include "../jrd/ods.h"
 #include "../jrd/Optimizer.h"
@@ -96,6 +97,130 @@ bool checkExpressionIndex(CompilerScratch* csb, const index_desc* idx, ValueExpr
 }
 
 
+// Comparison of a stream field with a value, the value descriptors
+// are set for literals only
+struct FieldPredicate
+{
+	USHORT fieldId;
+	UCHAR blrOp;
+	bool negated;
+	const dsc* value;
+	const dsc* value2;
+};
+
+// Check the boolean for restricting a single field of the given stream
+// in the way that can be estimated using the column statistics
+static bool getFieldPredicate(const BoolExprNode* node, StreamType stream, FieldPredicate& predicate)
+{
+	predicate.negated = false;
+	predicate.value = predicate.value2 = NULL;
+
+	const NotBoolNode* const notNode = nodeAs<NotBoolNode>(node);
+
+	if (notNode)
+	{
+		node = notNode->arg;
+		predicate.negated = true;
+	}
+
+	const MissingBoolNode* const missingNode = nodeAs<MissingBoolNode>(node);
+
+	if (missingNode)
+	{
+		const FieldNode* const fieldNode = nodeAs<FieldNode>(missingNode->arg);
+
+		if (!fieldNode || fieldNode->fieldStream != stream)
+			return false;
+
+		predicate.fieldId = fieldNode->fieldId;
+		predicate.blrOp = blr_missing;
+		return true;
+	}
+
+	const ComparativeBoolNode* const cmpNode = nodeAs<ComparativeBoolNode>(node);
+
+	if (!cmpNode || predicate.negated)
+		return false;
+
+	UCHAR blrOp = cmpNode->blrOp;
+
+	switch (blrOp)
+	{
+		case blr_eql:
+		case blr_equiv:
+		case blr_neq:
+		case blr_gtr:
+		case blr_geq:
+		case blr_lss:
+		case blr_leq:
+		case blr_between:
+			break;
+
+		default:
+			return false;
+	}
+
+	const FieldNode* fieldNode = nodeAs<FieldNode>(cmpNode->arg1);
+	const ValueExprNode* value = cmpNode->arg2;
+
+	if (!fieldNode || fieldNode->fieldStream != stream)
+	{
+		fieldNode = nodeAs<FieldNode>(cmpNode->arg2);
+
+		if (blrOp == blr_between || !fieldNode || fieldNode->fieldStream != stream)
+			return false;
+
+		value = cmpNode->arg1;
+
+		// The field is compared from the right side, swap the operator
+		switch (blrOp)
+		{
+			case blr_gtr:
+				blrOp = blr_lss;
+				break;
+
+			case blr_geq:
+				blrOp = blr_leq;
+				break;
+
+			case blr_lss:
+				blrOp = blr_gtr;
+				break;
+
+			case blr_leq:
+				blrOp = blr_geq;
+				break;
+		}
+	}
+
+	predicate.fieldId = fieldNode->fieldId;
+	predicate.blrOp = (blrOp == blr_equiv) ? blr_eql : blrOp;
+
+	const LiteralNode* const literal = nodeAs<LiteralNode>(value);
+
+	if (literal)
+		predicate.value = &literal->litDesc;
+
+	if (blrOp == blr_between)
+	{
+		const LiteralNode* const literal2 = nodeAs<LiteralNode>(cmpNode->arg3);
+
+		if (literal2)
+			predicate.value2 = &literal2->litDesc;
+	}
+
+	return true;
+}
+
+// Selectivity of a boolean applied as a filter when nothing is known about the data
+static double getReduceFactor(const BoolExprNode* node)
+{
+	const ComparativeBoolNode* const cmpNode = nodeAs<ComparativeBoolNode>(node);
+
+	return (cmpNode && cmpNode->blrOp == blr_eql) ?
+		REDUCE_SELECTIVITY_FACTOR_EQUALITY : REDUCE_SELECTIVITY_FACTOR_INEQUALITY;
+}
+
 string OPT_make_alias(thread_db* tdbb, const CompilerScratch* csb,
 					  const CompilerScratch::csb_repeat* base_tail)
 {
@@ -548,6 +673,8 @@ InversionCandidate* OptimizerRetrieval::generateInversion()
 	}
 
 	// Adjust the effective selectivity by treating computable conjunctions as filters
+	Array<BoolExprNode*> filters;
+
 	for (const OptimizerBlk::opt_conjunct* tail = optimizer->opt_conjuncts.begin();
 		tail < optimizer->opt_conjuncts.end(); tail++)
 	{
@@ -557,11 +684,47 @@ InversionCandidate* OptimizerRetrieval::generateInversion()
 			node->computable(csb, stream, true) &&
 			!invCandidate->matches.exist(node))
 		{
-			const ComparativeBoolNode* const cmpNode = nodeAs<ComparativeBoolNode>(node);
+			filters.add(node);
+		}
+	}
+
+	// Filters restricting the same field are estimated together using the column
+	// statistics, if any. Otherwise every filter is assumed to reduce the selectivity
+	// by a fixed factor.
+	while (filters.hasData())
+	{
+		Array<BoolExprNode*> group;
+		FieldPredicate predicate;
+
+		if (getFieldPredicate(filters[0], stream, predicate))
+		{
+			const USHORT fieldId = predicate.fieldId;
+
+			for (FB_SIZE_T i = 0; i < filters.getCount();)
+			{
+				if (getFieldPredicate(filters[i], stream, predicate) && predicate.fieldId == fieldId)
+				{
+					group.add(filters[i]);
+					filters.remove(i);
+				}
+				else
+					i++;
+			}
+		}
+		else
+		{
+			group.add(filters[0]);
+			filters.remove((FB_SIZE_T) 0);
+		}
 
-			const double factor = (cmpNode && cmpNode->blrOp == blr_eql) ?
-				REDUCE_SELECTIVITY_FACTOR_EQUALITY : REDUCE_SELECTIVITY_FACTOR_INEQUALITY;
-			invCandidate->selectivity *= factor;
+		double selectivity;
+
+		if (estimateSelectivity(group, selectivity))
+			invCandidate->selectivity *= selectivity;
+		else
+		{
+			for (FB_SIZE_T i = 0; i < group.getCount(); i++)
+				invCandidate->selectivity *= getReduceFactor(group[i]);
 		}
 	}
 
@@ -1119,6 +1282,19 @@ void OptimizerRetrieval::getInversionCandidates(InversionCandidateList* inversio
 				}
 			}
 
+			// A scan restricting the leading segment only can be estimated
+			// more precisely using the column statistics, if they're available
+			if (!unique && !(scratch.idx->idx_flags & idx_expressn) &&
+				scratch.lowerCount <= 1 && scratch.upperCount <= 1 &&
+				scratch.segments[0]->scanType != segmentScanNone &&
+				scratch.segments[0]->scanType != segmentScanStarting)
+			{
+				double selectivity;
+
+				if (estimateSelectivity(scratch.segments[0]->matches, selectivity))
+					scratch.selectivity = selectivity;
+			}
+
 			if (scratch.scopeCandidate)
 			{
 				// When selectivity is zero the statement is prepared on an
@@ -1160,6 +1336,140 @@ void OptimizerRetrieval::getInversionCandidates(InversionCandidateList* inversio
 	}
 }
 
+bool OptimizerRetrieval::estimateSelectivity(const Array<BoolExprNode*>& booleans,
+	double& selectivity) const
+{
+/**************************************
+ *
+ *	e s t i m a t e S e l e c t i v i t y
+ *
+ **************************************
+ *
+ * Functional description
+ *	Estimate the selectivity of booleans restricting
+ *	the same field using the statistics gathered by
+ *	ANALYZE TABLE. Return false if there are none or
+ *	the booleans cannot be estimated this way.
+ *
+ **************************************/
+	if (!relation || booleans.isEmpty())
+		return false;
+
+	const ColumnStatistics* stats = NULL;
+	double result = MAXIMUM_SELECTIVITY;
+
+	bool range = false, hasLower = false, hasUpper = false;
+	bool lowerInclusive = true, upperInclusive = true;
+	double lower = 0, upper = 0;
+
+	for (const BoolExprNode* const* iter = booleans.begin(); iter != booleans.end(); ++iter)
+	{
+		FieldPredicate predicate;
+
+		if (!getFieldPredicate(*iter, stream, predicate))
+			return false;
+
+		if (!stats)
+		{
+			stats = MET_get_column_statistics(tdbb, relation, predicate.fieldId);
+
+			if (!stats)
+				return false;
+		}
+		else if (stats->cst_field_id != predicate.fieldId)
+			return false;
+
+		double value = 0, value2 = 0;
+		const bool literal = predicate.value &&
+			ColumnStatistics::getValue(tdbb, stats->cst_dtype, predicate.value, value);
+
+		switch (predicate.blrOp)
+		{
+			case blr_missing:
+				result *= predicate.negated ?
+					1 - stats->cst_null_fraction : stats->getNullSelectivity();
+				break;
+
+			case blr_eql:
+				result *= stats->getEqualitySelectivity(literal ? &value : NULL);
+				break;
+
+			case blr_neq:
+				result *= MAX(1 - stats->cst_null_fraction -
+					stats->getEqualitySelectivity(literal ? &value : NULL), 0.0);
+				break;
+
+			case blr_gtr:
+			case blr_geq:
+			case blr_lss:
+			case blr_leq:
+			case blr_between:
+			{
+				// Ranges need literal bounds and a histogram,
+				// several ones are intersected rather than multiplied
+
+				if (!literal || !stats->hasHistogram())
+					return false;
+
+				range = true;
+
+				if (predicate.blrOp == blr_between)
+				{
+					if (!predicate.value2 ||
+						!ColumnStatistics::getValue(tdbb, stats->cst_dtype, predicate.value2, value2))
+					{
+						return false;
+					}
+				}
+
+				if (predicate.blrOp == blr_gtr || predicate.blrOp == blr_geq ||
+					predicate.blrOp == blr_between)
+				{
+					const bool inclusive = (predicate.blrOp != blr_gtr);
+
+					if (!hasLower || value > lower || (value == lower && !inclusive))
+					{
+						lower = value;
+						lowerInclusive = inclusive;
+						hasLower = true;
+					}
+				}
+
+				if (predicate.blrOp == blr_between)
+					value = value2;
+
+				if (predicate.blrOp == blr_lss || predicate.blrOp == blr_leq ||
+					predicate.blrOp == blr_between)
+				{
+					const bool inclusive = (predicate.blrOp != blr_lss);
+
+					if (!hasUpper || value < upper || (value == upper && !inclusive))
+					{
+						upper = value;
+						upperInclusive = inclusive;
+						hasUpper = true;
+					}
+				}
+				break;
+			}
+
+			default:
+				fb_assert(false);
+				return false;
+		}
+	}
+
+	if (range)
+	{
+		result *= stats->getRangeSelectivity(hasLower ? &lower : NULL, lowerInclusive,
+			hasUpper ? &upper : NULL, upperInclusive);
+	}
+
+	// Never estimate less than a single row, the statistics may be outdated
+	selectivity = MAX(result, 1.0 / stats->cst_records);
+	return true;
+}
+
 ValueExprNode* OptimizerRetrieval::findDbKey(ValueExprNode* dbkey, SLONG* position) const
 {
 /**************************************
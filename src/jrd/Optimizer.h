@@ -190,6 +190,8 @@ protected:
 		bool ignoreUnmatched) const;
 	InversionNode* composeInversion(InversionNode* node1, InversionNode* node2,
 		InversionNode::Type node_type) const;
+	bool estimateSelectivity(const Firebird::Array<BoolExprNode*>& booleans,
+		double& selectivity) const;
 	const Firebird::string& getAlias();
 	InversionCandidate* generateInversion();
 	void getInversionCandidates(InversionCandidateList* inversions,
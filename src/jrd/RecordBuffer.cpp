@@ -49,6 +49,7 @@ offset_t RecordBuffer::store(const Record* new_record)
 	const ULONG length = record->getLength();
 	fb_assert(new_record->getLength() == length);
 
+	space->spill();
 	space->write(count * length, new_record->getData(), length);
 
 	return count++;
@@ -67,6 +68,11 @@ bool RecordBuffer::fetch(offset_t position, Record* to_record)
 	return true;
 }
 
+void RecordBuffer::setEstimate(FB_UINT64 records)
+{
+	space->setEstimate(records * record->getLength());
+}
+
 const Format* RecordBuffer::getFormat() const
 {
 	return record->getFormat();
@@ -49,6 +49,8 @@ public:
 	offset_t store(const Record*);
 	bool fetch(offset_t, Record*);
 
+	void setEstimate(FB_UINT64);
+
 private:
 	offset_t count;
 	Record* record;
@@ -1598,6 +1598,16 @@ RecordSource* AggregateSourceNode::generate(thread_db* tdbb, OptimizerBlk* opt,
 	CompilerScratch* const csb = opt->opt_csb;
 	rse->rse_sorted = group;
 
+	// Unless the parent relies on the order of the groups, they may be collected
+	// in a hash table instead of sorting the input. Keep the sort if the plan
+	// is specified explicitly or the first rows are expected quickly.
+	const bool hashed = group && !ordered && !rse->rse_plan &&
+		!(rse->flags & RseNode::FLAG_OPT_FIRST_ROWS) &&
+		HashAggregatedStream::isSupported(tdbb, csb, &group->expressions, map);
+
+	if (hashed)
+		rse->rse_sorted = NULL;
+
 	// AB: Try to distribute items from the HAVING CLAUSE to the WHERE CLAUSE.
 	// Zip thru stack of booleans looking for fields that belong to shellStream.
 	// Those fields are mappings. Mappings that hold a plain field may be used
@@ -1611,7 +1621,7 @@ RecordSource* AggregateSourceNode::generate(thread_db* tdbb, OptimizerBlk* opt,
 	NestConst<ValueExprNode>* ptr;
 	AggNode* aggNode = NULL;
 
-	if (map->sourceList.getCount() == 1 && (ptr = map->sourceList.begin()) &&
+	if (!hashed && map->sourceList.getCount() == 1 && (ptr = map->sourceList.begin()) &&
 		(aggNode = nodeAs<AggNode>(*ptr)) &&
 		(aggNode->aggInfo.blr == blr_agg_min || aggNode->aggInfo.blr == blr_agg_max))
 	{
@@ -1635,8 +1645,36 @@ RecordSource* AggregateSourceNode::generate(thread_db* tdbb, OptimizerBlk* opt,
 
 	// allocate and optimize the record source block
 
-	AggregatedStream* const rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) AggregatedStream(tdbb, csb,
-		stream, (group ? &group->expressions : NULL), map, nextRsb);
+	RecordSource* rsb;
+
+	if (hashed)
+	{
+		// The groups are aggregated by sorting the same input
+		// if the key of some value doesn't fit the hash table
+
+		StreamList streams;
+		nextRsb->findUsedStreams(streams);
+
+		SortedStream* const sortRsb = OPT_gen_sort(tdbb, csb, streams, NULL, nextRsb, group, false);
+
+		RecordSource* const fallback = FB_NEW_POOL(*tdbb->getDefaultPool()) AggregatedStream(tdbb, csb,
+			stream, &group->expressions, map, sortRsb);
+
+		rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) HashAggregatedStream(tdbb, csb,
+			stream, &group->expressions, map, nextRsb, fallback);
+	}
+	else if (!group && !rse->rse_aggregate &&
+		ParallelAggregatedStream::isSupported(tdbb, csb, map, nextRsb))
+	{
+		// Large tables are scanned and aggregated by several threads
+		rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) ParallelAggregatedStream(tdbb, csb,
+			stream, map, nextRsb);
+	}
+	else
+	{
+		rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) AggregatedStream(tdbb, csb,
+			stream, (group ? &group->expressions : NULL), map, nextRsb);
+	}
 
 	if (rse->rse_aggregate)
 	{
@@ -456,6 +456,7 @@ public:
 		  dsqlWindow(false),
 		  group(NULL),
 		  map(NULL),
+		  ordered(false),
 		  rse(NULL)
 	{
 	}
@@ -505,6 +506,7 @@ public:
 	bool dsqlWindow;
 	NestConst<SortNode> group;
 	NestConst<MapNode> map;
+	bool ordered;		// the parent relies on the groups being sorted
 
 private:
 	NestConst<RseNode> rse;
@@ -28,6 +28,7 @@
 #include "../jrd/pag.h"
 #include "../jrd/val.h"
 #include "../jrd/Attachment.h"
+#include "../jrd/ColumnStatistics.h"
 
 namespace Jrd
 {
@@ -263,6 +264,9 @@ public:
 	frgn		rel_foreign_refs;	// foreign references to other relations' primary keys
 	Nullable<bool>	rel_ss_definer;
 
+	ColumnStatisticsList*	rel_column_stats;	// column statistics, loaded on demand
+	IPTR		rel_column_stats_generation;	// dbb_column_stats_generation when loaded
+
 	Firebird::Mutex rel_drop_mutex;
 
 	bool isSystem() const;
@@ -405,6 +409,7 @@ inline jrd_rel::jrd_rel(MemoryPool& p)
 	: rel_pool(&p), rel_flags(REL_gc_lockneed),
 	  rel_name(p), rel_owner_name(p), rel_security_name(p),
 	  rel_view_contexts(p), rel_gc_records(p), rel_ss_definer(false),
+	  rel_column_stats(NULL), rel_column_stats_generation(0),
 	  rel_pages_base(p)
 {
 }
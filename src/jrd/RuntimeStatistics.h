@@ -67,6 +67,12 @@ public:
 		RECORD_RPT_READS,
 		RECORD_IMGC,
 		RECORD_LAST_ITEM = RECORD_IMGC,
+		SORT_RECORDS,
+		SORT_RUNS,
+		SORT_MERGES,
+		SORT_PARALLEL,
+		TEMP_GRANTED,
+		TEMP_SPILLED,
 		TOTAL_ITEMS		// last
 	};
 
@@ -45,41 +45,6 @@ FB_SIZE_T TempSpace::minBlockSize = 0;
 namespace
 {
 	const size_t MIN_TEMP_BLOCK_SIZE = 64 * 1024;
-
-	class TempCacheLimitGuard
-	{
-	public:
-		explicit TempCacheLimitGuard(FB_SIZE_T size)
-			: m_dbb(GET_DBB()), m_size(size),
-			  m_guard(m_dbb->dbb_temp_cache_mutex, FB_FUNCTION)
-		{
-			m_allowed = (m_dbb->dbb_temp_cache_size + size <= m_dbb->dbb_config->getTempCacheLimit());
-		}
-
-		bool isAllowed() const
-		{
-			return m_allowed;
-		}
-
-		void increment()
-		{
-			fb_assert(m_allowed);
-			m_dbb->dbb_temp_cache_size += m_size;
-		}
-
-		static void decrement(FB_SIZE_T size)
-		{
-			Database* const dbb = GET_DBB();
-			MutexLockGuard guard(dbb->dbb_temp_cache_mutex, FB_FUNCTION);
-			dbb->dbb_temp_cache_size -= size;
-		}
-
-	private:
-		Database* const m_dbb;
-		FB_SIZE_T m_size;
-		MutexLockGuard m_guard;
-		bool m_allowed;
-	};
 }
 
 //
@@ -138,7 +103,8 @@ FB_SIZE_T TempSpace::FileBlock::write(offset_t offset, const void* buffer, FB_SI
 
 TempSpace::TempSpace(MemoryPool& p, const PathName& prefix, bool dynamic)
 		: pool(p), filePrefix(p, prefix),
-		  logicalSize(0), physicalSize(0), localCacheUsage(0),
+		  logicalSize(0), physicalSize(0), localCacheUsage(0), reservedMemory(0),
+		  estimate(0), cacheWeight(0), cacheWanted(0),
 		  head(NULL), tail(NULL), tempFiles(p),
 		  initialBuffer(p), initiallyDynamic(dynamic),
 		  freeSegments(p)
@@ -175,7 +141,7 @@ TempSpace::~TempSpace()
 		head = temp;
 	}
 
-	TempCacheLimitGuard::decrement(localCacheUsage);
+	releaseCache(localCacheUsage, true);
 
 	while (tempFiles.getCount())
 		delete tempFiles.pop();
@@ -311,22 +277,17 @@ void TempSpace::extend(FB_SIZE_T size)
 
 		Block* block = NULL;
 
-		{	// scope
-			TempCacheLimitGuard guard(size);
-
-			if (guard.isAllowed())
+		if (acquireCache(size))
+		{
+			try
+			{
+				// allocate block in virtual memory
+				block = FB_NEW_POOL(pool) MemoryBlock(FB_NEW_POOL(pool) UCHAR[size], tail, size);
+			}
+			catch (const BadAlloc&)
 			{
-				try
-				{
-					// allocate block in virtual memory
-					block = FB_NEW_POOL(pool) MemoryBlock(FB_NEW_POOL(pool) UCHAR[size], tail, size);
-					localCacheUsage += size;
-					guard.increment();
-				}
-				catch (const BadAlloc&)
-				{
-					// not enough memory
-				}
+				// not enough memory
+				releaseCache(size, false);
 			}
 		}
 
@@ -338,7 +299,8 @@ void TempSpace::extend(FB_SIZE_T size)
 			// allocate block in the temp file
 			TempFile* const file = setupFile(size);
 			fb_assert(file);
-			if (tail && tail->sameFile(file))
+			JRD_get_thread_data()->bumpStats(RuntimeStatistics::TEMP_SPILLED, size);
+			if (tail && tail->endsAt(file, file->getSize() - size))
 			{
 				fb_assert(!initialSize);
 				tail->size += size;
@@ -556,6 +518,199 @@ void TempSpace::releaseSpace(offset_t position, FB_SIZE_T size)
 	freeSegments.add(Segment(position, size));
 }
 
+//
+// TempSpace::getCacheShare
+//
+// Returns the part of the temp cache this space is entitled to
+//
+
+offset_t TempSpace::getCacheShare(const Database* dbb) const
+{
+	fb_assert(cacheWeight && dbb->dbb_temp_cache_weight >= cacheWeight);
+
+	const double limit = (double) dbb->dbb_config->getTempCacheLimit();
+	return (offset_t) (limit * cacheWeight / dbb->dbb_temp_cache_weight);
+}
+
+//
+// TempSpace::acquireCache
+//
+// Asks for the memory of the temp cache. The space joins the cache
+// with the weight of its estimated size on the first request.
+// While nobody is refused memory within its share, the spaces
+// grow freely up to the limit, then they keep to their shares.
+//
+
+bool TempSpace::acquireCache(FB_SIZE_T size)
+{
+	Database* const dbb = GET_DBB();
+	const FB_UINT64 limit = dbb->dbb_config->getTempCacheLimit();
+
+	if (!limit)
+		return false;
+
+	MutexLockGuard guard(dbb->dbb_temp_cache_mutex, FB_FUNCTION);
+
+	if (!cacheWeight)
+	{
+		cacheWeight = estimate ? MIN(MAX(estimate, (offset_t) minBlockSize), limit) : limit;
+		dbb->dbb_temp_cache_weight += cacheWeight;
+	}
+
+	const bool withinShare = (localCacheUsage + size <= getCacheShare(dbb));
+
+	if (dbb->dbb_temp_cache_size + size > limit)
+	{
+		// Make the spaces over their shares give memory back
+		if (withinShare)
+		{
+			cacheWanted += size;
+			dbb->dbb_temp_cache_wanted += size;
+		}
+
+		return false;
+	}
+
+	if (!withinShare && dbb->dbb_temp_cache_wanted)
+		return false;
+
+	if (withinShare && cacheWanted)
+	{
+		dbb->dbb_temp_cache_wanted -= cacheWanted;
+		cacheWanted = 0;
+	}
+
+	dbb->dbb_temp_cache_size += size;
+	localCacheUsage += size;
+
+	JRD_get_thread_data()->bumpStats(RuntimeStatistics::TEMP_GRANTED, size);
+	return true;
+}
+
+//
+// TempSpace::releaseCache
+//
+// Gives the memory back to the temp cache, optionally leaving the cache
+//
+
+void TempSpace::releaseCache(offset_t size, bool detach)
+{
+	fb_assert(size <= localCacheUsage);
+
+	if (!cacheWeight)
+		return;
+
+	Database* const dbb = GET_DBB();
+	MutexLockGuard guard(dbb->dbb_temp_cache_mutex, FB_FUNCTION);
+
+	dbb->dbb_temp_cache_size -= size;
+	localCacheUsage -= size;
+
+	if (detach)
+	{
+		dbb->dbb_temp_cache_weight -= cacheWeight;
+		dbb->dbb_temp_cache_wanted -= cacheWanted;
+		cacheWeight = cacheWanted = 0;
+	}
+}
+
+//
+// TempSpace::reserveMemory
+//
+// Asks for the temp cache memory to be used outside of the space
+//
+
+bool TempSpace::reserveMemory(FB_SIZE_T size)
+{
+	if (!acquireCache(size))
+		return false;
+
+	reservedMemory += size;
+	return true;
+}
+
+//
+// TempSpace::releaseMemory
+//
+// Gives back the memory obtained by reserveMemory()
+//
+
+void TempSpace::releaseMemory(FB_SIZE_T size)
+{
+	fb_assert(size <= reservedMemory);
+
+	reservedMemory -= size;
+	releaseCache(size, false);
+}
+
+//
+// TempSpace::spill
+//
+// Moves the memory blocks over the share of the temp cache to the temp file
+// if somebody else needs the memory
+//
+
+void TempSpace::spill()
+{
+	if (!localCacheUsage)
+		return;
+
+	Database* const dbb = GET_DBB();
+
+	// Unlocked check, the next call will see the changes we missed
+	if (!dbb->dbb_temp_cache_wanted)
+		return;
+
+	offset_t excess;
+
+	{	// scope
+		MutexLockGuard guard(dbb->dbb_temp_cache_mutex, FB_FUNCTION);
+
+		const offset_t share = getCacheShare(dbb);
+
+		if (!dbb->dbb_temp_cache_wanted || localCacheUsage <= share)
+			return;
+
+		excess = localCacheUsage - share;
+	}
+
+	offset_t spilled = 0;
+
+	for (Block* block = head; block && spilled < excess; block = block->next)
+	{
+		const FB_SIZE_T size = static_cast<FB_SIZE_T>(block->size);
+		UCHAR* const memory = block->inMemory(0, size);
+
+		if (!memory)
+			continue;
+
+		TempFile* const file = setupFile(size);
+		Block* const fileBlock = FB_NEW_POOL(pool) FileBlock(file, NULL, size);
+		fileBlock->write(0, memory, size);
+
+		// replace the memory block in the chain
+		fileBlock->prev = block->prev;
+		fileBlock->next = block->next;
+
+		if (block->prev)
+			block->prev->next = fileBlock;
+		else
+			head = fileBlock;
+
+		if (block->next)
+			block->next->prev = fileBlock;
+		else
+			tail = fileBlock;
+
+		delete block;
+		block = fileBlock;
+
+		releaseCache(size, false);
+		JRD_get_thread_data()->bumpStats(RuntimeStatistics::TEMP_SPILLED, size);
+		spilled += size;
+	}
+}
+
 //
 // TempSpace::inMemory
 //
@@ -620,7 +775,7 @@ bool TempSpace::validate(offset_t& free) const
 	for (FB_SIZE_T i = 0; i < tempFiles.getCount(); i++)
 		disk += tempFiles[i]->getSize();
 
-	return ((initialBuffer.getCount() + localCacheUsage + disk) == physicalSize);
+	return ((initialBuffer.getCount() + localCacheUsage - reservedMemory + disk) == physicalSize);
 }
 
 
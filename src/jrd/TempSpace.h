@@ -31,6 +31,11 @@
 #include "../common/classes/init.h"
 #include "../common/classes/tree.h"
 
+namespace Jrd
+{
+	class Database;
+}
+
 class TempSpace : public Firebird::File
 {
 public:
@@ -66,6 +71,27 @@ public:
 	ULONG allocateBatch(ULONG count, FB_SIZE_T minSize, FB_SIZE_T maxSize, Segments& segments);
 
 	bool validate(offset_t& freeSize) const;
+
+	// Temp cache (TempCacheLimit) is shared between the temporary spaces in proportion
+	// to the amount of data they expect to hold. Under memory pressure the space gives
+	// the memory over its share back by moving the blocks to the temporary file.
+	// Call spill() only when no pointers obtained from inMemory() or allocateBatch()
+	// are kept.
+
+	void setEstimate(offset_t size)
+	{
+		estimate = size;
+	}
+
+	void spill();
+
+	// Memory kept by the owner of the space outside of it (sort buffers, hash
+	// tables) is accounted in the temp cache as well. It's given back when the
+	// space is destroyed if not released before.
+
+	bool reserveMemory(FB_SIZE_T size);
+	void releaseMemory(FB_SIZE_T size);
+
 private:
 
 	// Generic space block
@@ -88,7 +114,7 @@ private:
 		virtual FB_SIZE_T write(offset_t offset, const void* buffer, FB_SIZE_T length) = 0;
 
 		virtual UCHAR* inMemory(offset_t offset, size_t size) const = 0;
-		virtual bool sameFile(const Firebird::TempFile* file) const = 0;
+		virtual bool endsAt(const Firebird::TempFile* file, offset_t position) const = 0;
 
 		Block *prev;
 		Block *next;
@@ -118,7 +144,7 @@ private:
 			return NULL;
 		}
 
-		bool sameFile(const Firebird::TempFile*) const
+		bool endsAt(const Firebird::TempFile*, offset_t) const
 		{
 			return false;
 		}
@@ -163,9 +189,9 @@ private:
 			return NULL;
 		}
 
-		bool sameFile(const Firebird::TempFile* aFile) const
+		bool endsAt(const Firebird::TempFile* aFile, offset_t position) const
 		{
-			return (aFile == this->file);
+			return (aFile == this->file && seek + this->size == position);
 		}
 
 	private:
@@ -176,6 +202,10 @@ private:
 	Block* findBlock(offset_t& offset) const;
 	Firebird::TempFile* setupFile(FB_SIZE_T size);
 
+	bool acquireCache(FB_SIZE_T size);
+	void releaseCache(offset_t size, bool detach);
+	offset_t getCacheShare(const Jrd::Database* dbb) const;
+
 	UCHAR* findMemory(offset_t& begin, offset_t end, size_t size) const;
 
 	//  free/used segments management
@@ -203,6 +233,10 @@ private:
 	offset_t logicalSize;
 	offset_t physicalSize;
 	offset_t localCacheUsage;
+	offset_t reservedMemory;	// part of localCacheUsage kept outside of the space
+	offset_t estimate;			// expected size of data, zero if unknown
+	offset_t cacheWeight;		// weight in the temp cache, zero if not using it
+	offset_t cacheWanted;		// cache memory refused within the share
 	Block* head;
 	Block* tail;
 	Firebird::Array<Firebird::TempFile*> tempFiles;
@@ -0,0 +1,276 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		WorkerPool.cpp
+ *	DESCRIPTION:	Threads executing parts of engine operations
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/WorkerPool.h"
+#include "../common/ThreadStart.h"
+#include "../common/StatusHolder.h"
+#include "../common/classes/array.h"
+#include "../common/classes/fb_atomic.h"
+#include "../common/classes/init.h"
+#include "../common/classes/locks.h"
+#include "../common/classes/semaphore.h"
+#include "../common/classes/ImplementHelper.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+namespace
+{
+	// Seconds an idle worker waits for a new job before it exits
+	const int WORKER_IDLE_TIMEOUT = 60;
+
+	// Job being executed, it's shared by the caller and the workers which joined it
+
+	struct Batch
+	{
+		Batch(WorkerJob* aJob, unsigned aCount)
+			: job(aJob), count(aCount), workers(0), failed(false), status(&localStatus)
+		{}
+
+		void executeParts()
+		{
+			unsigned part;
+			while ((part = (unsigned) next.exchangeAdd(1)) < count)
+			{
+				if (failed)
+					continue;
+
+				try
+				{
+					job->execute(part);
+				}
+				catch (const Exception& ex)
+				{
+					MutexLockGuard guard(errorMutex, FB_FUNCTION);
+
+					if (!failed)
+					{
+						ex.stuffException(&status);
+						failed = true;
+					}
+				}
+			}
+		}
+
+		WorkerJob* const job;
+		const unsigned count;
+		AtomicCounter next;
+		unsigned workers;				// Workers executing parts of the batch
+		Semaphore finished;				// Posted when the last worker leaves the batch
+		volatile bool failed;
+		Mutex errorMutex;
+		LocalStatus localStatus;
+		CheckStatusWrapper status;
+	};
+
+	class Workers
+	{
+	public:
+		explicit Workers(MemoryPool& p)
+			: batches(p), threads(0), idle(0), shutdown(false)
+		{}
+
+		~Workers()
+		{
+			MutexLockGuard guard(mutex, FB_FUNCTION);
+
+			shutdown = true;
+			for (unsigned n = threads; n; n--)
+				wakeup.release();
+
+			while (threads)
+			{
+				MutexUnlockGuard unlock(mutex, FB_FUNCTION);
+				stopped.tryEnter(1);
+			}
+		}
+
+		void run(WorkerJob* job, unsigned count, unsigned degree);
+
+	private:
+		static THREAD_ENTRY_DECLARE worker(THREAD_ENTRY_PARAM arg)
+		{
+			((Workers*) arg)->work();
+			return 0;
+		}
+
+		void work();
+
+		Mutex mutex;
+		Semaphore wakeup;				// Posted once per worker wanted by the batches
+		Semaphore stopped;				// Posted when the worker exits at shutdown
+		HalfStaticArray<Batch*, 8> batches;
+		unsigned threads;				// Running workers
+		unsigned idle;					// Workers waiting for a job
+		bool shutdown;
+	};
+
+	GlobalPtr<Workers, InstanceControl::PRIORITY_DELETE_FIRST> workers;
+
+
+	void Workers::run(WorkerJob* job, unsigned count, unsigned degree)
+	{
+		Batch batch(job, count);
+
+		const unsigned helpers = MIN(degree, count) - 1;
+
+		{ // scope
+			MutexLockGuard guard(mutex, FB_FUNCTION);
+
+			// Nobody helps during shutdown, the caller executes all parts itself
+
+			if (!shutdown)
+			{
+				batches.add(&batch);
+
+				// Start more workers if not enough of them are waiting for a job
+
+				for (unsigned n = idle; n < helpers && threads < WorkerPool::MAX_WORKERS; n++)
+				{
+					try
+					{
+						Thread::start(worker, this, THREAD_medium);
+						threads++;
+						idle++;
+					}
+					catch (const Exception&)
+					{
+						break;	// make do with existing workers or alone
+					}
+				}
+
+				for (unsigned n = 0; n < helpers; n++)
+					wakeup.release();
+			}
+		}
+
+		batch.executeParts();
+
+		{ // scope
+			MutexLockGuard guard(mutex, FB_FUNCTION);
+
+			FB_SIZE_T pos;
+			if (batches.find(&batch, pos))
+				batches.remove(pos);
+
+			// Wait for workers which still execute their parts
+
+			while (batch.workers)
+			{
+				MutexUnlockGuard unlock(mutex, FB_FUNCTION);
+				batch.finished.enter();
+			}
+		}
+
+		if (batch.failed)
+			status_exception::raise(&batch.status);
+	}
+
+
+	void Workers::work()
+	{
+		MutexLockGuard guard(mutex, FB_FUNCTION);
+
+		while (!shutdown)
+		{
+			bool timeout;
+
+			{ // scope
+				MutexUnlockGuard unlock(mutex, FB_FUNCTION);
+				timeout = !wakeup.tryEnter(WORKER_IDLE_TIMEOUT);
+			}
+
+			if (shutdown)
+				break;
+
+			if (timeout)
+			{
+				if (batches.isEmpty())
+					break;
+
+				continue;
+			}
+
+			// Join the oldest batch which still has parts to execute
+
+			Batch* batch = NULL;
+			for (Batch** iter = batches.begin(); iter < batches.end(); iter++)
+			{
+				if ((unsigned) (*iter)->next.value() < (*iter)->count)
+				{
+					batch = *iter;
+					break;
+				}
+			}
+
+			if (!batch)
+				continue;
+
+			batch->workers++;
+			idle--;
+
+			{ // scope
+				MutexUnlockGuard unlock(mutex, FB_FUNCTION);
+				batch->executeParts();
+			}
+
+			idle++;
+			if (!--batch->workers)
+				batch->finished.release();
+		}
+
+		idle--;
+		threads--;
+
+		if (shutdown)
+			stopped.release();
+	}
+} // anonymous namespace
+
+
+void WorkerPool::run(WorkerJob* job, unsigned count, unsigned degree)
+{
+/**************************************
+ *
+ *	r u n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Execute the parts of the job in parallel.
+ *
+ **************************************/
+	if (!count)
+		return;
+
+	if (degree <= 1 || count == 1)
+	{
+		for (unsigned part = 0; part < count; part++)
+			job->execute(part);
+
+		return;
+	}
+
+	workers->run(job, count, MIN(degree, MAX_WORKERS + 1));
+}
@@ -0,0 +1,60 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		WorkerPool.h
+ *	DESCRIPTION:	Threads executing parts of engine operations
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_WORKER_POOL_H
+#define JRD_WORKER_POOL_H
+
+namespace Jrd {
+
+// Process wide pool of threads which execute independent parts of a job,
+// such as sorting pieces of the sort buffer. The job must not touch engine
+// structures which require an attachment or database locks, unless it sets up
+// its own thread context marked with TDBB_parallel_worker while the calling
+// thread holds the attachment (see ParallelAggregatedStream). The calling
+// thread executes parts too, therefore the job is completed even if no
+// worker thread could be started. Idle workers exit after a while.
+
+class WorkerJob
+{
+public:
+	virtual ~WorkerJob() {}
+
+	// Execute the given part of the job, parts are independent of each other
+	virtual void execute(unsigned part) = 0;
+};
+
+class WorkerPool
+{
+public:
+	// Execute parts [0, count) of the job using up to degree threads, including
+	// the calling one. Returns when all parts are done. The first exception
+	// thrown by a part is rethrown after that.
+	static void run(WorkerJob* job, unsigned count, unsigned degree);
+
+	// Maximum number of worker threads in the process
+	static const unsigned MAX_WORKERS = 64;
+};
+
+} // namespace Jrd
+
+#endif // JRD_WORKER_POOL_H
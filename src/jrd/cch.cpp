@@ -62,6 +62,15 @@
 #include "../common/classes/MsgPrint.h"
 #include "../jrd/CryptoManager.h"
 #include "../common/utils_proto.h"
+#include "../common/os/os_utils.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef WIN_NT
+#include <process.h>
+#endif
 
 using namespace Jrd;
 using namespace Ods;
@@ -115,8 +124,48 @@ enum LatchState
 	lsPageChanged
 };
 
+// Cache writers: max number of dirty buffers collected by single writer pass
+// and max number of pages written together, adjacent ones by single I/O request
+
+const FB_SIZE_T WRITE_BATCH	= 64;
+const USHORT WRITE_RUN		= 64;
+
+namespace
+{
+	// Dirty buffer collected by cache writer with its page number at
+	// collection time, buffer could be reassigned before it is written
+	struct DirtyBuffer
+	{
+		BufferDesc* bdb;
+		PageNumber page;
+	};
+
+	typedef Firebird::HalfStaticArray<DirtyBuffer, WRITE_BATCH> DirtyBatch;
+	typedef Firebird::HalfStaticArray<BufferDesc*, WRITE_RUN> WriteRun;
+
+	// Header of the file with numbers of hot pages saved to warm up the
+	// cache, page numbers follow the header, the hottest page first
+	struct WarmupHeader
+	{
+		ULONG wh_magic;
+		ULONG wh_version;
+		ULONG wh_page_size;
+		ULONG wh_count;		// number of pages in file
+		Guid wh_guid;		// database the pages belong to
+	};
+}
+
+// Cache warm-up file: <database file name> + WARMUP_SUFFIX. Pages are read
+// back by chunks, between chunks cache prefetcher serves scans read-ahead.
+
+const char* const WARMUP_SUFFIX	= ".warmup";
+const ULONG WARMUP_MAGIC		= 0x57434246;	// FBCW
+const ULONG WARMUP_VERSION		= 1;
+const FB_SIZE_T WARMUP_CHUNK	= 256;
+
 static void adjust_scan_count(WIN* window, bool mustRead);
 static BufferDesc* alloc_bdb(thread_db*, BufferControl*, UCHAR **);
+static UCHAR* alloc_extent(thread_db*, BufferControl*, size_t&);
 static Lock* alloc_page_lock(Jrd::thread_db*, BufferDesc*);
 static int blocking_ast_bdb(void*);
 #ifdef CACHE_READER
@@ -125,6 +174,7 @@ static void prefetch_init(Prefetch*, thread_db*);
 static void prefetch_io(Prefetch*, FbStatusVector *);
 static void prefetch_prologue(Prefetch*, SLONG *);
 #endif
+static bool can_write_run(thread_db*, BufferDesc*, const bool);
 static void check_precedence(thread_db*, WIN*, PageNumber);
 static void clear_precedence(thread_db*, BufferDesc*);
 static BufferDesc* dealloc_bdb(BufferDesc*);
@@ -132,19 +182,34 @@ static void down_grade(thread_db*, BufferDesc*, int high = 0);
 static bool expand_buffers(thread_db*, ULONG);
 static BufferDesc* find_buffer(BufferControl* bcb, const PageNumber page, bool findPending);
 static BufferDesc* get_buffer(thread_db*, const PageNumber, SyncType, int);
+static void get_dirty_batch(thread_db*, BufferControl*, DirtyBatch&);
+static void update_writer_rate(BufferControl*);
 static int get_related(BufferDesc*, PagesArray&, int, const ULONG);
 static ULONG get_prec_walk_mark(BufferControl*);
 static LatchState latch_buffer(thread_db*, Sync&, BufferDesc*, const PageNumber, SyncType, int);
+static void load_hot_pages(thread_db*, Firebird::Array<FB_UINT64>&);
 static LockState lock_buffer(thread_db*, BufferDesc*, const SSHORT, const SCHAR);
+static void log_memory_layout(thread_db*, BufferControl*);
+static size_t max_extent_size(const BufferControl*);
 static ULONG memory_init(thread_db*, BufferControl*, SLONG);
 static void page_validation_error(thread_db*, win*, SSHORT);
+static void page_written(thread_db*, BufferDesc*);
 static void purgePrecedence(BufferControl*, BufferDesc*);
+static void read_ahead(thread_db*, const FB_UINT64*, FB_SIZE_T);
+static void read_ahead_run(thread_db*, BufferDesc* const*, USHORT);
+static void release_extent(BufferControl*, const bcb_extent&);
 static SSHORT related(BufferDesc*, const BufferDesc*, SSHORT, const ULONG);
+static bool save_hot_pages(thread_db*);
+static ULONG shrink_buffers(thread_db*, ULONG);
+static void warm_up(thread_db*, const FB_UINT64*, FB_SIZE_T);
 static bool writeable(BufferDesc*);
 static bool is_writeable(BufferDesc*, const ULONG);
+static void write_batch(thread_db*, DirtyBuffer*, FB_SIZE_T, FbStatusVector* const);
+static void write_batch_runs(thread_db*, const DirtyBuffer*, FB_SIZE_T, FbStatusVector* const);
 static int write_buffer(thread_db*, BufferDesc*, const PageNumber, const bool, FbStatusVector* const,
 	const bool);
 static bool write_page(thread_db*, BufferDesc*, FbStatusVector* const, const bool);
+static bool write_run(thread_db*, BufferDesc* const*, USHORT, const bool, FbStatusVector* const);
 static bool set_diff_page(thread_db*, BufferDesc*);
 static void clear_dirty_flag_and_nbak_state(thread_db*, BufferDesc*);
 
@@ -186,12 +251,42 @@ static inline void removeDirty(BufferControl* bcb, BufferDesc* bdb)
 static void flushDirty(thread_db* tdbb, SLONG transaction_mask, const bool sys_only);
 static void flushAll(thread_db* tdbb, USHORT flush_flag);
 static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count);
+static void flushRun(thread_db* tdbb, WriteRun& run);
 
 static void recentlyUsed(BufferDesc* bdb);
 static void requeueRecentlyUsed(BufferControl* bcb);
+static void insertInUse(BufferControl* bcb, BufferDesc* bdb, const PageNumber page);
+static void removeInUse(BufferControl* bcb, BufferDesc* bdb);
+static void setCacheLimits(BufferControl* bcb);
+
+static inline que& inUseQue(BufferControl* bcb, const BufferDesc* bdb)
+{
+	return bdb->bdb_cold ? bcb->bcb_cold : bcb->bcb_in_use;
+}
+
+static inline bcb_partition& hashPartition(BufferControl* bcb, const PageNumber page)
+{
+	return bcb->bcb_partitions[(page.getPageNum() % bcb->bcb_count) % BCB_HASH_PARTITIONS];
+}
+
+static inline void countHit(bcb_partition& partition, const BufferDesc* bdb)
+{
+	if (bdb->bdb_cold)
+		++partition.bcp_cold_hits;
+	else
+		++partition.bcp_hot_hits;
+}
+
+static void lockHashPartition(BufferControl* bcb, Sync& sync, const PageNumber page, SyncType type);
 
 
 const ULONG MIN_BUFFER_SEGMENT = 65536;
+const size_t MAX_BUFFER_SEGMENT = 64 * 1024 * 1024;
+
+// Sizes of explicit huge pages, transparent huge pages are 2MB as well
+
+const size_t HUGE_PAGE_2M = 2 * 1024 * 1024;
+const size_t HUGE_PAGE_1G = 1024 * 1024 * 1024;
 
 // Given pointer a field in the block, find the block
 
@@ -200,6 +295,12 @@ const ULONG MIN_BUFFER_SEGMENT = 65536;
 
 const PageNumber FREE_PAGE(DB_PAGE_SPACE, -1);
 
+// Read-ahead: max number of pages read together, adjacent ones by single
+// I/O request, and max number of pages waiting in the prefetch queue
+
+const USHORT READ_AHEAD_RUN		= 64;
+const FB_SIZE_T READ_AHEAD_QUEUE	= 4 * MAX_READ_AHEAD_PAGES;
+
 const int PRE_SEARCH_LIMIT	= 256;
 const int PRE_EXISTS		= -1;
 const int PRE_UNKNOWN		= -2;
@@ -228,8 +329,8 @@ void CCH_clean_page(thread_db* tdbb, PageNumber page)
 	BufferControl* bcb = dbb->dbb_bcb;
 	BufferDesc* bdb = NULL;
 	{
-		Sync bcbSync(&bcb->bcb_syncObject, "CCH_clean_page");
-		bcbSync.lock(SYNC_SHARED);
+		Sync hashSync(&bcb->bcb_syncObject, "CCH_clean_page");
+		lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
 
 		bdb = find_buffer(bcb, page, false);
 		if (!bdb)
@@ -274,7 +375,7 @@ void CCH_clean_page(thread_db* tdbb, PageNumber page)
 			requeueRecentlyUsed(bcb);
 
 		QUE_DELETE(bdb->bdb_in_use);
-		QUE_APPEND(bcb->bcb_in_use, bdb->bdb_in_use);
+		QUE_APPEND(inUseQue(bcb, bdb), bdb->bdb_in_use);
 	}
 
 	bdb->release(tdbb, true);
@@ -1017,9 +1118,23 @@ void CCH_forget_page(thread_db* tdbb, WIN* window)
 
 	removeDirty(bcb, bdb);
 
-	QUE_DELETE(bdb->bdb_in_use);
-	QUE_DELETE(bdb->bdb_que);
-	QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
+	{ // scope
+		SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, "CCH_forget_page");
+
+		{ // bcb_syncLRU scope
+			SyncLockGuard lruSync(&bcb->bcb_syncLRU, SYNC_EXCLUSIVE, "CCH_forget_page");
+
+			if (bcb->bcb_lru_chain.load() != NULL)
+				requeueRecentlyUsed(bcb);
+
+			removeInUse(bcb, bdb);
+		}
+
+		SyncLockGuard hashSync(&hashPartition(bcb, bdb->bdb_page).bcp_sync, SYNC_EXCLUSIVE, "CCH_forget_page");
+
+		QUE_DELETE(bdb->bdb_que);
+		QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
+	}
 
 	if (tdbb->tdbb_flags & TDBB_no_cache_unwind)
 		bdb->release(tdbb, true);
@@ -1057,12 +1172,15 @@ void CCH_fini(thread_db* tdbb)
 		}
 	}
 
+	while (bcb->bcb_retired.hasData())
+		delete bcb->bcb_retired.pop();
+
 	delete[] bcb->bcb_rpt;
 	bcb->bcb_rpt = NULL;
 	bcb->bcb_count = 0;
 
 	while (bcb->bcb_memory.hasData())
-		bcb->bcb_bufferpool->deallocate(bcb->bcb_memory.pop());
+		release_extent(bcb, bcb->bcb_memory.pop());
 
 	BufferControl::destroy(bcb);
 	dbb->dbb_bcb = NULL;
@@ -1297,11 +1415,11 @@ void CCH_get_related(thread_db* tdbb, PageNumber page, PagesArray &lowPages)
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
 
-	Sync bcbSync(&bcb->bcb_syncObject, "CCH_get_related");
-	bcbSync.lock(SYNC_SHARED);
+	Sync hashSync(&bcb->bcb_syncObject, "CCH_get_related");
+	lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
 
 	BufferDesc* bdb = find_buffer(bcb, page, false);
-	bcbSync.unlock();
+	hashSync.unlock();
 
 	if (bdb)
 	{
@@ -1486,7 +1604,25 @@ void CCH_init(thread_db* tdbb, ULONG number)
 	bcb->bcb_flags = shared ? BCB_exclusive : 0;
 	//bcb->bcb_flags = BCB_exclusive;	// TODO detect real state using LM
 
+	bcb->bcb_policy = dbb->dbb_config->getPageCachePolicy();
+
+	// Huge pages and NUMA placement make sense for large shared cache only
+
+	if (shared)
+	{
+		bcb->bcb_huge_pages = dbb->dbb_config->getPageCacheHugePages();
+		bcb->bcb_numa_policy = dbb->dbb_config->getPageCacheNumaPolicy();
+
+		if (bcb->bcb_numa_policy != NUMA_POLICY_NONE)
+		{
+			bcb->bcb_numa_nodes = os_utils::getNumaNodes();
+			if (bcb->bcb_numa_nodes < 2)
+				bcb->bcb_numa_policy = NUMA_POLICY_NONE;
+		}
+	}
+
 	QUE_INIT(bcb->bcb_in_use);
+	QUE_INIT(bcb->bcb_cold);
 	QUE_INIT(bcb->bcb_dirty);
 	bcb->bcb_dirty_count = 0;
 	QUE_INIT(bcb->bcb_empty);
@@ -1495,6 +1631,15 @@ void CCH_init(thread_db* tdbb, ULONG number)
 
 	bcb->bcb_count = memory_init(tdbb, bcb, static_cast<SLONG>(number));
 	bcb->bcb_free_minimum = (SSHORT) MIN(bcb->bcb_count / 4, 128);
+	setCacheLimits(bcb);
+
+	// Don't let read-ahead occupy more than 1/8 of the cache
+
+	if (shared)
+	{
+		bcb->bcb_prefetch_pages = MIN(dbb->dbb_config->getReadAheadPages(), bcb->bcb_count / 8);
+		bcb->bcb_warmup_interval = dbb->dbb_config->getPageCacheWarmup();
+	}
 
 	if (bcb->bcb_count < MIN_PAGE_BUFFERS)
 		ERR_post(Arg::Gds(isc_cache_too_small));
@@ -1507,6 +1652,12 @@ void CCH_init(thread_db* tdbb, ULONG number)
 			 tdbb->getAttachment()->att_filename.c_str(), bcb->bcb_count, count);
 	}
 
+	if (shared && (dbb->dbb_config->getPageCacheHugePages() != HUGE_PAGES_NONE ||
+		dbb->dbb_config->getPageCacheNumaPolicy() != NUMA_POLICY_NONE))
+	{
+		log_memory_layout(tdbb, bcb);
+	}
+
 	if (dbb->dbb_lock->lck_logical != LCK_EX)
 		dbb->dbb_ast_flags |= DBB_assert_locks;
 }
@@ -1535,20 +1686,59 @@ void CCH_init2(thread_db* tdbb)
 	const Attachment* att = tdbb->getAttachment();
 	if (!(dbb->dbb_flags & DBB_read_only) && !(att->att_flags & ATT_security_db))
 	{
-		// writer startup in progress
+		// writers startup in progress
 		bcb->bcb_flags |= BCB_writer_start;
 
+		const ULONG writers = dbb->dbb_config->getCacheWriters();
+		while (bcb->bcb_writers.getCount() < writers)
+		{
+			BufferControl::BcbThreadSync* const writer = FB_NEW_POOL(*bcb->bcb_bufferpool)
+				BufferControl::BcbThreadSync(*bcb->bcb_bufferpool, BufferControl::cache_writer, THREAD_medium);
+			bcb->bcb_writers.add(writer);
+
+			try
+			{
+				writer->run(bcb);
+			}
+			catch (const Exception&)
+			{
+				delete bcb->bcb_writers.pop();
+
+				if (bcb->bcb_writers.isEmpty())
+				{
+					bcb->bcb_flags &= ~BCB_writer_start;
+					ERR_bugcheck_msg("cannot start cache writer thread");
+				}
+
+				break;
+			}
+		}
+
+		for (FB_SIZE_T n = 0; n < bcb->bcb_writers.getCount(); n++)
+			bcb->bcb_writer_init.enter();
+
+		bcb->bcb_flags &= ~BCB_writer_start;
+	}
+
+	// Cache prefetcher does read-ahead for scans and warms up the cache
+
+	if ((bcb->bcb_prefetch_pages || bcb->bcb_warmup_interval) && !(att->att_flags & ATT_security_db) &&
+		!(bcb->bcb_flags & (BCB_prefetcher | BCB_prefetcher_start)))
+	{
+		// prefetcher startup in progress
+		bcb->bcb_flags |= BCB_prefetcher_start;
+
 		try
 		{
-			bcb->bcb_writer_fini.run(bcb);
+			bcb->bcb_prefetcher_fini.run(bcb);
 		}
 		catch (const Exception&)
 		{
-			bcb->bcb_flags &= ~BCB_writer_start;
-			ERR_bugcheck_msg("cannot start cache writer thread");
+			bcb->bcb_flags &= ~BCB_prefetcher_start;
+			ERR_bugcheck_msg("cannot start cache prefetcher thread");
 		}
 
-		bcb->bcb_writer_init.enter();
+		bcb->bcb_prefetcher_init.enter();
 	}
 }
 
@@ -1894,6 +2084,46 @@ bool set_diff_page(thread_db* tdbb, BufferDesc* bdb)
 }
 
 
+void CCH_read_ahead(thread_db* tdbb, USHORT pageSpaceId, const ULONG* pages, FB_SIZE_T count)
+{
+/**************************************
+ *
+ *	C C H _ r e a d _ a h e a d
+ *
+ **************************************
+ *
+ * Functional description
+ *	Queue pages which are going to be fetched soon to be read
+ *	into cache by the cache prefetcher. Pages already queued are
+ *	ignored, if the queue is full the rest of pages is ignored.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	BufferControl* const bcb = tdbb->getDatabase()->dbb_bcb;
+
+	if (!(bcb->bcb_flags & BCB_prefetcher) || !count)
+		return;
+
+	{ // scope
+		MutexLockGuard guard(bcb->bcb_prefetch_mutex, FB_FUNCTION);
+
+		for (FB_SIZE_T i = 0; i < count; i++)
+		{
+			if (bcb->bcb_prefetch_queue.getCount() >= READ_AHEAD_QUEUE)
+				break;
+
+			const FB_UINT64 key = ((FB_UINT64) pageSpaceId << 32) | pages[i];
+
+			FB_SIZE_T pos;
+			if (!bcb->bcb_prefetch_queue.find(key, pos))
+				bcb->bcb_prefetch_queue.insert(pos, key);
+		}
+	}
+
+	bcb->bcb_prefetcher_sem.release();
+}
+
+
 void CCH_release(thread_db* tdbb, WIN* window, const bool release_tail)
 {
 /**************************************
@@ -2002,7 +2232,7 @@ void CCH_release(thread_db* tdbb, WIN* window, const bool release_tail)
 					}
 
 					QUE_DELETE(bdb->bdb_in_use);
-					QUE_APPEND(bcb->bcb_in_use, bdb->bdb_in_use);
+					QUE_APPEND(inUseQue(bcb, bdb), bdb->bdb_in_use);
 				}
 
 				if ((bcb->bcb_flags & BCB_cache_writer) &&
@@ -2050,6 +2280,45 @@ void CCH_release_exclusive(thread_db* tdbb)
 }
 
 
+bool CCH_resize(thread_db* tdbb, ULONG number)
+{
+/**************************************
+ *
+ *	C C H _ r e s i z e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Grow or shrink the cache online. Zero means the configured
+ *	default number of buffers. Shrinking releases memory by whole
+ *	extents, so the cache could stay a bit larger than asked.
+ *	Return true if number of buffers was changed.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	if (!number)
+		number = dbb->dbb_config->getDefaultDbCachePages();
+
+	if (number < MIN_PAGE_BUFFERS)
+		number = MIN_PAGE_BUFFERS;
+	if (number > MAX_PAGE_BUFFERS)
+		number = MAX_PAGE_BUFFERS;
+
+	const ULONG count = bcb->bcb_count;
+
+	if (number > count)
+		return expand_buffers(tdbb, number);
+
+	if (number < count)
+		return shrink_buffers(tdbb, number) != count;
+
+	return false;
+}
+
+
 bool CCH_rollover_to_shadow(thread_db* tdbb, Database* dbb, jrd_file* file, const bool inAst)
 {
 /**************************************
@@ -2112,18 +2381,37 @@ void CCH_shutdown(thread_db* tdbb)
 	}
 #endif
 
+	// Shutdown the cache prefetcher, wait for its startup to complete first
+
+	while (bcb->bcb_flags & BCB_prefetcher_start)
+		Thread::yield();
+
+	if (bcb->bcb_flags & BCB_prefetcher)
+	{
+		bcb->bcb_flags &= ~BCB_prefetcher;
+		bcb->bcb_prefetcher_sem.release(); // Wake up running thread
+		bcb->bcb_prefetcher_fini.waitForCompletion();
+	}
+
 	// Wait for cache writer startup to complete
 
 	while (bcb->bcb_flags & BCB_writer_start)
 		Thread::yield();
 
-	// Shutdown the dedicated cache writer for this database
+	// Shutdown the dedicated cache writers for this database
 
-	if (bcb->bcb_flags & BCB_cache_writer)
+	if (bcb->bcb_writers.hasData())
 	{
 		bcb->bcb_flags &= ~BCB_cache_writer;
-		bcb->bcb_writer_sem.release(); // Wake up running thread
-		bcb->bcb_writer_fini.waitForCompletion();
+		bcb->bcb_writer_sem.release(bcb->bcb_writers.getCount()); // Wake up running threads
+
+		for (FB_SIZE_T n = 0; n < bcb->bcb_writers.getCount(); n++)
+		{
+			bcb->bcb_writers[n]->waitForCompletion();
+			delete bcb->bcb_writers[n];
+		}
+
+		bcb->bcb_writers.clear();
 	}
 
 	SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, "CCH_shutdown");
@@ -2461,6 +2749,11 @@ static void adjust_scan_count(WIN* window, bool mustRead)
 		if (bdb->bdb_flags & BDB_garbage_collect)
 			bdb->bdb_flags &= ~BDB_garbage_collect;
 	}
+
+	// Page read ahead is referenced now
+
+	if (bdb->bdb_flags & BDB_prefetch)
+		bdb->bdb_flags &= ~BDB_prefetch;
 }
 
 
@@ -2478,15 +2771,28 @@ static BufferDesc* alloc_bdb(thread_db* tdbb, BufferControl* bcb, UCHAR** memory
  **************************************/
 	SET_TDBB(tdbb);
 
-	BufferDesc* bdb = FB_NEW_POOL(*bcb->bcb_bufferpool) BufferDesc(bcb);
+	BufferDesc* bdb;
 
-	try {
-		bdb->bdb_lock = alloc_page_lock(tdbb, bdb);
+	if (bcb->bcb_retired.hasData())
+	{
+		// Reuse descriptor of the buffer removed by shrink_buffers
+
+		bdb = bcb->bcb_retired.pop();
+		bdb->bdb_page = PageNumber(0, 0);
+		bdb->bdb_flags = 0;
 	}
-	catch (const Firebird::Exception&)
+	else
 	{
-		delete bdb;
-		throw;
+		bdb = FB_NEW_POOL(*bcb->bcb_bufferpool) BufferDesc(bcb);
+
+		try {
+			bdb->bdb_lock = alloc_page_lock(tdbb, bdb);
+		}
+		catch (const Firebird::Exception&)
+		{
+			delete bdb;
+			throw;
+		}
 	}
 
 	bdb->bdb_buffer = (pag*) *memory;
@@ -2498,6 +2804,69 @@ static BufferDesc* alloc_bdb(thread_db* tdbb, BufferControl* bcb, UCHAR** memory
 }
 
 
+static UCHAR* alloc_extent(thread_db* tdbb, BufferControl* bcb, size_t& size)
+{
+/**************************************
+ *
+ *	a l l o c _ e x t e n t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Allocate large block of memory to be partitioned into buffers.
+ *	Block backed by huge pages could be smaller than requested, its
+ *	size is rounded down to huge page size. Throws BadAlloc.
+ *
+ **************************************/
+	bcb_extent extent;
+	extent.bce_huge_page = 0;
+	extent.bce_os = (bcb->bcb_huge_pages != HUGE_PAGES_NONE || bcb->bcb_numa_policy != NUMA_POLICY_NONE);
+
+	if (extent.bce_os)
+	{
+		size_t huge_page = 0;
+		if (bcb->bcb_huge_pages == HUGE_PAGES_2M)
+			huge_page = HUGE_PAGE_2M;
+		else if (bcb->bcb_huge_pages == HUGE_PAGES_1G)
+			huge_page = HUGE_PAGE_1G;
+
+		// Block smaller than huge page uses normal pages
+
+		if (huge_page && size >= huge_page)
+			size -= size % huge_page;
+		else
+			huge_page = 0;
+
+		extent.bce_memory = (UCHAR*) os_utils::allocLargeMemory(size, huge_page,
+			bcb->bcb_huge_pages != HUGE_PAGES_NONE, &extent.bce_huge_page);
+
+		if (!extent.bce_memory)
+			BadAlloc::raise();
+
+		if (bcb->bcb_numa_policy == NUMA_POLICY_INTERLEAVE)
+			os_utils::setNumaPolicy(extent.bce_memory, size, -1);
+		else if (bcb->bcb_numa_policy == NUMA_POLICY_BIND)
+			os_utils::setNumaPolicy(extent.bce_memory, size, bcb->bcb_numa_next++);
+	}
+	else
+		extent.bce_memory = (UCHAR*) bcb->bcb_bufferpool->allocate(size ALLOC_ARGS);
+
+	extent.bce_size = size;
+
+	try
+	{
+		bcb->bcb_memory.push(extent);
+	}
+	catch (const Firebird::Exception&)
+	{
+		release_extent(bcb, extent);
+		throw;
+	}
+
+	return extent.bce_memory;
+}
+
+
 static Lock* alloc_page_lock(thread_db* tdbb, BufferDesc* bdb)
 {
 /**************************************
@@ -2703,6 +3072,34 @@ extern "C" {
 
 		return 0;
 	}
+
+	static int cmpDirtyBuffers(const void* a, const void* b)
+	{
+		const DirtyBuffer* dirtyA = (DirtyBuffer*) a;
+		const DirtyBuffer* dirtyB = (DirtyBuffer*) b;
+
+		if (dirtyA->page > dirtyB->page)
+			return 1;
+
+		if (dirtyA->page < dirtyB->page)
+			return -1;
+
+		return 0;
+	}
+
+	static int cmpPageNumbers(const void* a, const void* b)
+	{
+		const ULONG pageA = *(ULONG*) a;
+		const ULONG pageB = *(ULONG*) b;
+
+		if (pageA > pageB)
+			return 1;
+
+		if (pageA < pageB)
+			return -1;
+
+		return 0;
+	}
 } // extern C
 
 
@@ -2713,16 +3110,21 @@ extern "C" {
 // no such pages (i.e. all of not written yet pages have high precedence pages)
 // then write them all at last iteration (of course write_buffer will also check
 // for precedence before write).
+// Adjacent pages with no precedence are collected into runs and written by
+// single I/O request. Pages of current run stay latched and locked for I/O,
+// therefore run is written before any wait for another page.
 static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count)
 {
 	FbStatusVector* const status = tdbb->tdbb_status_vector;
 	const bool all_flag = (flush_flag & FLUSH_ALL) != 0;
 	const bool release_flag = (flush_flag & FLUSH_RLSE) != 0;
 	const bool write_thru = release_flag;
+	const SyncType syncType = release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED;
 
 	qsort(begin, count, sizeof(BufferDesc*), cmpBdbs);
 
 	MarkIterator<BufferDesc*> iter(begin, count);
+	WriteRun run;
 
 	FB_SIZE_T written = 0;
 	bool writeAll = false;
@@ -2737,14 +3139,48 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 			if (!bdb)
 				continue;
 
-			bdb->addRef(tdbb, release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED);
+			if (run.isEmpty() || !bdb->addRefConditional(tdbb, syncType))
+			{
+				flushRun(tdbb, run);
+				bdb->addRef(tdbb, syncType);
+			}
 
 			BufferControl* bcb = bdb->bdb_bcb;
 			if (!writeAll)
 				purgePrecedence(bcb, bdb);
 
+			if (!release_flag && !writeAll && QUE_EMPTY(bdb->bdb_higher) &&
+				bdb->lockIOConditional(tdbb))
+			{
+				if (can_write_run(tdbb, bdb, false))
+				{
+					if (run.hasData())
+					{
+						const BufferDesc* const last = run.back();
+
+						if (run.getCount() >= WRITE_RUN ||
+							last->bdb_page.getPageSpaceID() != bdb->bdb_page.getPageSpaceID() ||
+							last->bdb_page.getPageNum() + 1 != bdb->bdb_page.getPageNum())
+						{
+							flushRun(tdbb, run);
+						}
+					}
+
+					run.add(bdb);
+
+					iter.mark();
+					found = true;
+					written++;
+					continue;
+				}
+
+				bdb->unLockIO(tdbb);
+			}
+
 			if (writeAll || QUE_EMPTY(bdb->bdb_higher))
 			{
+				flushRun(tdbb, run);
+
 				if (release_flag)
 				{
 					if (bdb->bdb_use_count > 1)
@@ -2774,6 +3210,8 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 			}
 		}
 
+		flushRun(tdbb, run);
+
 		if (!found)
 			writeAll = true;
 
@@ -2784,6 +3222,25 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 }
 
 
+// Write run of adjacent pages collected by flushPages and release them
+static void flushRun(thread_db* tdbb, WriteRun& run)
+{
+	if (run.isEmpty())
+		return;
+
+	if (!write_run(tdbb, run.begin(), run.getCount(), false, tdbb->tdbb_status_vector))
+		CCH_unwind(tdbb, true);
+
+	for (BufferDesc** iter = run.begin(); iter != run.end(); ++iter)
+	{
+		BufferDesc* const bdb = *iter;
+		bdb->release(tdbb, !(bdb->bdb_flags & BDB_dirty));
+	}
+
+	run.clear();
+}
+
+
 #ifdef CACHE_READER
 void BufferControl::cache_reader(BufferControl* bcb)
 {
@@ -2953,6 +3410,7 @@ void BufferControl::cache_writer(BufferControl* bcb)
  **************************************/
 	FbLocalStatus status_vector;
 	Database* const dbb = bcb->bcb_database;
+	bool started = false;
 
 	try
 	{
@@ -2978,10 +3436,11 @@ void BufferControl::cache_writer(BufferControl* bcb)
 
 			sAtt->initDone();
 
+			++bcb->bcb_writer_count;
 			bcb->bcb_flags |= BCB_cache_writer;
-			bcb->bcb_flags &= ~BCB_writer_start;
 
 			// Notify our creator that we have started
+			started = true;
 			bcb->bcb_writer_init.release();
 
 			while (bcb->bcb_flags & BCB_cache_writer)
@@ -2991,6 +3450,8 @@ void BufferControl::cache_writer(BufferControl* bcb)
 				SLONG starting_page = -1;
 #endif
 
+				update_writer_rate(bcb);
+
 				if (dbb->dbb_flags & DBB_suspend_bgio)
 				{
 					EngineCheckout cout(tdbb, FB_FUNCTION);
@@ -3010,9 +3471,20 @@ void BufferControl::cache_writer(BufferControl* bcb)
 
 				if (bcb->bcb_flags & BCB_free_pending)
 				{
-					BufferDesc* const bdb = get_buffer(tdbb, FREE_PAGE, SYNC_NONE, 1);
-					if (bdb)
-						write_buffer(tdbb, bdb, bdb->bdb_page, true, &status_vector, true);
+					DirtyBatch batch;
+					get_dirty_batch(tdbb, bcb, batch);
+
+					if (batch.hasData())
+					{
+						const SINT64 writes = attachment->att_stats.getValue(RuntimeStatistics::PAGE_WRITES);
+						write_batch(tdbb, batch.begin(), batch.getCount(), &status_vector);
+						bcb->bcb_writer_pages +=
+							attachment->att_stats.getValue(RuntimeStatistics::PAGE_WRITES) - writes;
+					}
+
+					// Full batch means there are more dirty buffers, let another writer help us
+					if (batch.getCount() == WRITE_BATCH)
+						bcb->bcb_writer_sem.release();
 				}
 
 				// If there's more work to do voluntarily ask to be rescheduled.
@@ -3061,15 +3533,16 @@ void BufferControl::cache_writer(BufferControl* bcb)
 		bcb->exceptionHandler(ex, cache_writer);
 	}
 
-	bcb->bcb_flags &= ~BCB_cache_writer;
+	// The last running writer clears the flag, dirty buffers are written
+	// by the threads which need free buffers then
+
+	if (started && --bcb->bcb_writer_count == 0)
+		bcb->bcb_flags &= ~BCB_cache_writer;
 
 	try
 	{
-		if (bcb->bcb_flags & BCB_writer_start)
-		{
-			bcb->bcb_flags &= ~BCB_writer_start;
+		if (!started)
 			bcb->bcb_writer_init.release();
-		}
 	}
 	catch (const Firebird::Exception& ex)
 	{
@@ -3078,15 +3551,209 @@ void BufferControl::cache_writer(BufferControl* bcb)
 }
 
 
-void BufferControl::exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine*)
+void BufferControl::cache_prefetcher(BufferControl* bcb)
 {
-	FbLocalStatus status_vector;
-	ex.stuffException(&status_vector);
-	iscDbLogStatus(bcb_database->dbb_filename.c_str(), &status_vector);
-}
-
-
-static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
+/**************************************
+ *
+ *	c a c h e _ p r e f e t c h e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read pages queued by CCH_read_ahead() into cache ahead of scans.
+ *
+ **************************************/
+	FbLocalStatus status_vector;
+	Database* const dbb = bcb->bcb_database;
+
+	try
+	{
+		UserId user;
+		user.setUserName("Cache Prefetcher");
+
+		Jrd::Attachment* const attachment = Jrd::Attachment::create(dbb);
+		RefPtr<SysStableAttachment> sAtt(FB_NEW SysStableAttachment(attachment));
+		attachment->setStable(sAtt);
+		attachment->att_filename = dbb->dbb_filename;
+		attachment->att_user = &user;
+
+		BackgroundContextHolder tdbb(dbb, attachment, &status_vector, FB_FUNCTION);
+
+		try
+		{
+			LCK_init(tdbb, LCK_OWNER_attachment);
+			PAG_header(tdbb, true);
+			PAG_attachment_id(tdbb);
+			TRA_init(attachment);
+
+			Monitoring::publishAttachment(tdbb);
+
+			sAtt->initDone();
+
+			bcb->bcb_flags |= BCB_prefetcher;
+			bcb->bcb_flags &= ~BCB_prefetcher_start;
+
+			// Notify our creator that we have started
+			bcb->bcb_prefetcher_init.release();
+
+			HalfStaticArray<FB_UINT64, READ_AHEAD_QUEUE> pages;
+
+			// Pages to warm up the cache with, saved when database was used last time
+
+			Array<FB_UINT64> warmup;
+			FB_SIZE_T warmupNext = 0;
+			time_t warmupSaved = time(NULL);
+
+			if (bcb->bcb_warmup_interval)
+				load_hot_pages(tdbb, warmup);
+
+			while (bcb->bcb_flags & BCB_prefetcher)
+			{
+				pages.clear();
+
+				{ // scope
+					MutexLockGuard guard(bcb->bcb_prefetch_mutex, FB_FUNCTION);
+
+					if (!(dbb->dbb_flags & DBB_suspend_bgio))
+						pages.push(bcb->bcb_prefetch_queue.begin(), bcb->bcb_prefetch_queue.getCount());
+
+					bcb->bcb_prefetch_queue.clear();
+				}
+
+				// Scans are served first, cache is warmed up while they don't need us
+
+				bool warming = false;
+				if (pages.isEmpty() && warmupNext < warmup.getCount() &&
+					!(dbb->dbb_flags & DBB_suspend_bgio))
+				{
+					const FB_SIZE_T count = MIN(WARMUP_CHUNK, warmup.getCount() - warmupNext);
+					pages.push(warmup.begin() + warmupNext, count);
+					warmupNext += count;
+					warming = true;
+				}
+
+				if (pages.isEmpty())
+				{
+					// Save hot pages periodically once warm-up is done, else
+					// pages not read back yet would be lost from the list
+
+					if (bcb->bcb_warmup_interval && warmupNext >= warmup.getCount() &&
+						time(NULL) - warmupSaved >= (time_t) bcb->bcb_warmup_interval)
+					{
+						save_hot_pages(tdbb);
+						warmupSaved = time(NULL);
+					}
+
+					EngineCheckout cout(tdbb, FB_FUNCTION);
+					bcb->bcb_prefetcher_sem.tryEnter(10);
+					continue;
+				}
+
+				try
+				{
+					if (warming)
+						warm_up(tdbb, pages.begin(), pages.getCount());
+					else
+						read_ahead(tdbb, pages.begin(), pages.getCount());
+				}
+				catch (const Firebird::Exception& ex)
+				{
+					// Read-ahead is just a hint, report the error and go on
+
+					ex.stuffException(&status_vector);
+					iscDbLogStatus(dbb->dbb_filename.c_str(), &status_vector);
+					CCH_unwind(tdbb, false);
+				}
+			}
+
+			// Database is closed, remember what was hot for the next time
+
+			if (bcb->bcb_warmup_interval && warmupNext >= warmup.getCount())
+				save_hot_pages(tdbb);
+		}
+		catch (const Firebird::Exception& ex)
+		{
+			ex.stuffException(&status_vector);
+			iscDbLogStatus(dbb->dbb_filename.c_str(), &status_vector);
+			// continue execution to clean up
+		}
+
+		Monitoring::cleanupAttachment(tdbb);
+		attachment->releaseLocks(tdbb);
+		LCK_fini(tdbb, LCK_OWNER_attachment);
+
+		attachment->releaseRelations(tdbb);
+	}	// try
+	catch (const Firebird::Exception& ex)
+	{
+		bcb->exceptionHandler(ex, cache_prefetcher);
+	}
+
+	bcb->bcb_flags &= ~BCB_prefetcher;
+
+	try
+	{
+		if (bcb->bcb_flags & BCB_prefetcher_start)
+		{
+			bcb->bcb_flags &= ~BCB_prefetcher_start;
+			bcb->bcb_prefetcher_init.release();
+		}
+	}
+	catch (const Firebird::Exception& ex)
+	{
+		bcb->exceptionHandler(ex, cache_prefetcher);
+	}
+}
+
+
+void BufferControl::exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine*)
+{
+	FbLocalStatus status_vector;
+	ex.stuffException(&status_vector);
+	iscDbLogStatus(bcb_database->dbb_filename.c_str(), &status_vector);
+}
+
+
+static bool can_write_run(thread_db* tdbb, BufferDesc* bdb, const bool write_thru)
+{
+/**************************************
+ *
+ *	c a n _ w r i t e _ r u n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Check if dirty buffer, locked for I/O by caller, could be
+ *	written as a part of run of adjacent pages. Pages which need
+ *	special handling (header page, shadows, backup state other
+ *	than normal, precedence) are written by write_buffer.
+ *
+ **************************************/
+	if (!(bdb->bdb_flags & BDB_dirty) && !(write_thru && (bdb->bdb_flags & BDB_db_dirty)))
+		return false;
+
+	if (bdb->bdb_flags & (BDB_marked | BDB_not_valid))
+		return false;
+
+	Database* const dbb = tdbb->getDatabase();
+
+	if (bdb->bdb_page == HEADER_PAGE_NUMBER || dbb->dbb_shadow)
+		return false;
+
+	if (QUE_NOT_EMPTY(bdb->bdb_higher))
+	{
+		purgePrecedence(bdb->bdb_bcb, bdb);
+
+		if (QUE_NOT_EMPTY(bdb->bdb_higher))
+			return false;
+	}
+
+	return PageSpace::isTemporary(bdb->bdb_page.getPageSpaceID()) ||
+		dbb->dbb_backup_manager->getState() == Ods::hdr_nbak_normal;
+}
+
+
+static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
 {
 /**************************************
  *
@@ -3139,11 +3806,11 @@ static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
 
 	// Start by finding the buffer containing the high priority page
 
-	Sync bcbSync(&bcb->bcb_syncObject, "check_precedence");
-	bcbSync.lock(SYNC_SHARED);
+	Sync hashSync(&bcb->bcb_syncObject, "check_precedence");
+	lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
 
 	BufferDesc* high = find_buffer(bcb, page, false);
-	bcbSync.unlock();
+	hashSync.unlock();
 
 	if (!high)
 		return;
@@ -3530,12 +4197,6 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 	Sync syncBcb(&bcb->bcb_syncObject, "expand_buffers");
 	syncBcb.lock(SYNC_EXCLUSIVE);
 
-	// for Win16 platform, we want to ensure that no cache buffer ever ends on a segment boundary
-	// CVC: Is this code obsolete or only the comment?
-
-	ULONG num_per_seg = number - bcb->bcb_count;
-	ULONG left_to_do = num_per_seg;
-
 	// Allocate and initialize buffers control block
 	Jrd::ContextPoolHolder context(tdbb, bcb->bcb_bufferpool);
 
@@ -3543,6 +4204,13 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 
 	bcb_repeat* const new_rpt = FB_NEW_POOL(*bcb->bcb_bufferpool) bcb_repeat[number];
 	bcb_repeat* const old_rpt = bcb->bcb_rpt;
+
+	// Hash chains are rebuilt and partition of every hash slot is changed,
+	// so all partitions of hash table must be latched
+
+	for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+		bcb->bcb_partitions[i].bcp_sync.lock(NULL, SYNC_EXCLUSIVE, "expand_buffers");
+
 	bcb->bcb_rpt = new_rpt;
 
 	bcb->bcb_count = number;
@@ -3572,28 +4240,28 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 		}
 	}
 
+	for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+		bcb->bcb_partitions[i].bcp_sync.unlock(NULL, SYNC_EXCLUSIVE);
+
+	setCacheLimits(bcb);
+
 	// Allocate new buffer descriptor blocks
 
-	ULONG num_in_seg = 0;
 	UCHAR* memory = NULL;
+	const UCHAR* memory_end = NULL;
 	for (; new_tail < new_end; new_tail++)
 	{
 		// if current segment is exhausted, allocate another
 
-		if (!num_in_seg)
+		if (!memory || memory + dbb->dbb_page_size > memory_end)
 		{
-			const size_t alloc_size = dbb->dbb_page_size * (num_per_seg + 1);
-			memory = (UCHAR*) bcb->bcb_bufferpool->allocate(alloc_size ALLOC_ARGS);
-			bcb->bcb_memory.push(memory);
+			size_t alloc_size = dbb->dbb_page_size * (new_end - new_tail + 1);
+			alloc_size = MIN(alloc_size, max_extent_size(bcb));
+			memory = alloc_extent(tdbb, bcb, alloc_size);
+			memory_end = memory + alloc_size;
 			memory = FB_ALIGN(memory, dbb->dbb_page_size);
-
-			num_in_seg = num_per_seg;
-			left_to_do -= num_per_seg;
-			if (num_per_seg > left_to_do)
-				num_per_seg = left_to_do;
 		}
 		new_tail->bcb_bdb = alloc_bdb(tdbb, bcb, &memory);
-		num_in_seg--;
 	}
 
 	// Set up new buffer control, release old buffer control, and clean up
@@ -3603,6 +4271,35 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 	return true;
 }
 
+static void lockHashPartition(BufferControl* bcb, Sync& sync, const PageNumber page, SyncType type)
+{
+/**************************************
+ *
+ *	l o c k H a s h P a r t i t i o n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Latch the hash table partition the page belongs to. Partition
+ *	depends on bcb_count, which could be changed by expand_buffers()
+ *	while we wait for the latch, so check it again when latch is taken.
+ *
+ **************************************/
+	while (true)
+	{
+		const ULONG count = bcb->bcb_count;
+
+		sync.setObject(&bcb->bcb_partitions[(page.getPageNum() % count) % BCB_HASH_PARTITIONS].bcp_sync);
+		sync.lock(type);
+
+		if (count == bcb->bcb_count)
+			return;
+
+		sync.unlock();
+	}
+}
+
+
 static BufferDesc* find_buffer(BufferControl* bcb, const PageNumber page, bool findPending)
 {
 	QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
@@ -3716,16 +4413,24 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
 
-	Sync bcbSync(&bcb->bcb_syncObject, "get_buffer");
 	if (page != FREE_PAGE)
 	{
-		bcbSync.lock(SYNC_SHARED);
-		BufferDesc* bdb = find_buffer(bcb, page, true);
+		// Look into the hash partition of the page only. Buffers being
+		// reassigned to another page are not in hash chains, they are
+		// looked for below with bcb_syncObject locked.
+
+		Sync hashSync(&bcb->bcb_syncObject, "get_buffer");
+		lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
+
+		BufferDesc* bdb = find_buffer(bcb, page, false);
 		while (bdb)
 		{
-			const LatchState ret = latch_buffer(tdbb, bcbSync, bdb, page, syncType, wait);
+			bcb_partition& partition = hashPartition(bcb, page);
+
+			const LatchState ret = latch_buffer(tdbb, hashSync, bdb, page, syncType, wait);
 			if (ret == lsOk)
 			{
+				countHit(partition, bdb);
 				tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES);
 				return bdb;
 			}
@@ -3733,12 +4438,12 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			if (ret == lsTimeout)
 				return NULL;
 
-			bcbSync.lock(SYNC_SHARED);
-			bdb = find_buffer(bcb, page, true);
+			lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
+			bdb = find_buffer(bcb, page, false);
 		}
-		bcbSync.unlock();
 	}
 
+	Sync bcbSync(&bcb->bcb_syncObject, "get_buffer");
 	bcbSync.lock(SYNC_EXCLUSIVE);
 
 	QUE que_inst;
@@ -3751,9 +4456,12 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			BufferDesc* bdb = find_buffer(bcb, page, true);
 			while (bdb)
 			{
+				bcb_partition& partition = hashPartition(bcb, page);
+
 				const LatchState ret = latch_buffer(tdbb, bcbSync, bdb, page, syncType, wait);
 				if (ret == lsOk)
 				{
+					countHit(partition, bdb);
 					tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES);
 					return bdb;
 				}
@@ -3775,24 +4483,31 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			Sync lruSync(&bcb->bcb_syncLRU, "get_buffer");
 			lruSync.lock(SYNC_EXCLUSIVE);
 
-			for (que_inst = bcb->bcb_in_use.que_backward;
-				 que_inst != &bcb->bcb_in_use; que_inst = que_inst->que_backward)
-			{
-				BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
+			que* const lruQues[2] = {&bcb->bcb_cold, &bcb->bcb_in_use};
 
-				if (bdb->bdb_use_count || (bdb->bdb_flags & BDB_free_pending))
-					continue;
+			for (int n = 0; n < 2 && walk; n++)
+			{
+				que* const lruQue = lruQues[n];
 
-				if (bdb->bdb_flags & BDB_db_dirty)
+				for (que_inst = lruQue->que_backward;
+					 que_inst != lruQue; que_inst = que_inst->que_backward)
 				{
-					//tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES); shouldn't it be here?
-					return bdb;
-				}
+					BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
 
-				if (!--walk)
-				{
-					bcb->bcb_flags &= ~BCB_free_pending;
-					break;
+					if (bdb->bdb_use_count || (bdb->bdb_flags & BDB_free_pending))
+						continue;
+
+					if (bdb->bdb_flags & BDB_db_dirty)
+					{
+						//tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES); shouldn't it be here?
+						return bdb;
+					}
+
+					if (!--walk)
+					{
+						bcb->bcb_flags &= ~BCB_free_pending;
+						break;
+					}
 				}
 			}
 
@@ -3814,8 +4529,12 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 
 			if (page != FREE_PAGE)
 			{
-				QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
-				QUE_INSERT(*mod_que, *que_inst);
+				{ // scope
+					SyncLockGuard hashSync(&hashPartition(bcb, page).bcp_sync, SYNC_EXCLUSIVE, "get_buffer");
+
+					QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
+					QUE_INSERT(*mod_que, *que_inst);
+				}
 #ifdef SUPERSERVER_V2
 				// Reserve a buffer for header page with deferred header
 				// page write mechanism. Otherwise, a deadlock will occur
@@ -3829,7 +4548,7 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 					Sync lruSync(&bcb->bcb_syncLRU, "get_buffer");
 					lruSync.lock(SYNC_EXCLUSIVE);
 
-					QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+					insertInUse(bcb, bdb, page);
 				}
 			}
 
@@ -3863,164 +4582,196 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 		if (bcb->bcb_lru_chain.load() != NULL)
 			requeueRecentlyUsed(bcb);
 
-		for (que_inst = bcb->bcb_in_use.que_backward;
-			 que_inst != &bcb->bcb_in_use;
-			 que_inst = que_inst->que_backward)
-		{
-			// get the oldest buffer as the least recently used -- note
-			// that since there are no empty buffers this queue cannot be empty
-
-			if (bcb->bcb_in_use.que_forward == &bcb->bcb_in_use)
-				BUGCHECK(213);	// msg 213 insufficient cache size
-
-			BufferDesc* oldest = BLOCK(que_inst, BufferDesc, bdb_in_use);
+		// Under 2Q policy buffers are reused from the cold que while it is larger
+		// than its limit, buffers of the main que are reused when the cold que
+		// has no suitable candidates. With LRU policy the cold que is always empty.
 
-			if (oldest->bdb_flags & BDB_lru_chained)
-				continue;
+		que* lruQues[2] = {&bcb->bcb_in_use, &bcb->bcb_cold};
+		if (bcb->bcb_cold_count > bcb->bcb_cold_limit)
+		{
+			lruQues[0] = &bcb->bcb_cold;
+			lruQues[1] = &bcb->bcb_in_use;
+		}
 
-			if (oldest->bdb_use_count || !oldest->addRefConditional(tdbb, SYNC_EXCLUSIVE))
-				continue;
+		bool exhausted = true;
+		for (int n = 0; n < 2 && exhausted; n++)
+		{
+			que* const lruQue = lruQues[n];
 
-			if ((oldest->bdb_flags & BDB_free_pending) || !writeable(oldest))
+			for (que_inst = lruQue->que_backward;
+				 que_inst != lruQue;
+				 que_inst = que_inst->que_backward)
 			{
-				oldest->release(tdbb, true);
-				continue;
-			}
+				// get the oldest buffer as the least recently used -- note
+				// that since there are no empty buffers this queue cannot be empty
 
-#ifdef SUPERSERVER_V2
-			// If page has been prefetched but not yet fetched, let
-			// it cycle once more thru LRU queue before re-using it.
+				if (QUE_EMPTY(bcb->bcb_in_use) && QUE_EMPTY(bcb->bcb_cold))
+					BUGCHECK(213);	// msg 213 insufficient cache size
 
-			if (oldest->bdb_flags & BDB_prefetch)
-			{
-				oldest->bdb_flags &= ~BDB_prefetch;
-				que_inst = que_inst->que_forward;
-				QUE_MOST_RECENTLY_USED(oldest->bdb_in_use);
-				//LATCH_MUTEX_RELEASE;
-				continue;
-			}
-#endif
+				BufferDesc* oldest = BLOCK(que_inst, BufferDesc, bdb_in_use);
 
-			if ((bcb->bcb_flags & BCB_cache_writer) &&
-				(oldest->bdb_flags & (BDB_dirty | BDB_db_dirty)) )
-			{
-				bcb->bcb_flags |= BCB_free_pending;
+				if (oldest->bdb_flags & BDB_lru_chained)
+					continue;
 
-				if (!(bcb->bcb_flags & BCB_writer_active))
-					bcb->bcb_writer_sem.release();
+				if (oldest->bdb_use_count || !oldest->addRefConditional(tdbb, SYNC_EXCLUSIVE))
+					continue;
 
-				if (walk)
+				if ((oldest->bdb_flags & BDB_free_pending) || !writeable(oldest))
 				{
 					oldest->release(tdbb, true);
-					if (!--walk)
-						break;
+					continue;
+				}
+
+#ifdef SUPERSERVER_V2
+				// If page has been prefetched but not yet fetched, let
+				// it cycle once more thru LRU queue before re-using it.
 
+				if (oldest->bdb_flags & BDB_prefetch)
+				{
+					oldest->bdb_flags &= ~BDB_prefetch;
+					que_inst = que_inst->que_forward;
+					QUE_MOST_RECENTLY_USED(oldest->bdb_in_use);
+					//LATCH_MUTEX_RELEASE;
 					continue;
 				}
-			}
+#endif
 
-			BufferDesc* bdb = oldest;
+				if ((bcb->bcb_flags & BCB_cache_writer) &&
+					(oldest->bdb_flags & (BDB_dirty | BDB_db_dirty)) )
+				{
+					bcb->bcb_flags |= BCB_free_pending;
 
-			// hvlad: we already have bcb_lruSync here
-			//recentlyUsed(bdb);
-			fb_assert(!(bdb->bdb_flags & BDB_lru_chained));
-			QUE_DELETE(bdb->bdb_in_use);
-			QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+					if (!(bcb->bcb_flags & BCB_writer_active))
+						bcb->bcb_writer_sem.release();
 
-			lruSync.unlock();
+					if (walk)
+					{
+						oldest->release(tdbb, true);
+						if (!--walk)
+						{
+							exhausted = false;
+							break;
+						}
 
-			bdb->bdb_flags |= BDB_free_pending;
-			bdb->bdb_pending_page = page;
+						continue;
+					}
+				}
 
-			QUE_DELETE(bdb->bdb_que);
-			QUE_INSERT(bcb->bcb_pending, bdb->bdb_que);
+				BufferDesc* bdb = oldest;
 
-			const bool needCleanup = (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) ||
-				QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower);
+				// hvlad: we already have bcb_lruSync here
+				//recentlyUsed(bdb);
+				fb_assert(!(bdb->bdb_flags & BDB_lru_chained));
 
-			if (needCleanup)
-			{
-				bcbSync.unlock();
+				if (bdb->bdb_cold)
+					bcb->bcb_ghosts.add(bdb->bdb_page);
 
-				// If the buffer selected is dirty, arrange to have it written.
+				removeInUse(bcb, bdb);
+				insertInUse(bcb, bdb, page);
 
-				if (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty))
-				{
-					const bool write_thru = (bcb->bcb_flags & BCB_exclusive);
-					if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, tdbb->tdbb_status_vector, true))
-					{
-						bcbSync.lock(SYNC_EXCLUSIVE);
-						bdb->bdb_flags &= ~BDB_free_pending;
-						QUE_DELETE(bdb->bdb_in_use);
-						QUE_APPEND(bcb->bcb_in_use, bdb->bdb_in_use);
-						bcbSync.unlock();
+				lruSync.unlock();
 
-						bdb->release(tdbb, true);
-						CCH_unwind(tdbb, true);
-					}
-				}
+				bdb->bdb_flags |= BDB_free_pending;
+				bdb->bdb_pending_page = page;
 
-				// If the buffer is still in the dirty tree, remove it.
-				// In any case, release any lock it may have.
+				{ // scope
+					SyncLockGuard hashSync(&hashPartition(bcb, bdb->bdb_page).bcp_sync, SYNC_EXCLUSIVE, "get_buffer");
 
-				removeDirty(bcb, bdb);
+					QUE_DELETE(bdb->bdb_que);
+					QUE_INSERT(bcb->bcb_pending, bdb->bdb_que);
+				}
 
-				// Cleanup any residual precedence blocks.  Unless something is
-				// screwed up, the only precedence blocks that can still be hanging
-				// around are ones cleared at AST level.
+				const bool needCleanup = (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) ||
+					QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower);
 
-				if (QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower))
+				if (needCleanup)
 				{
-					Sync precSync(&bcb->bcb_syncPrecedence, "get_buffer");
-					precSync.lock(SYNC_EXCLUSIVE);
+					bcbSync.unlock();
+
+					// If the buffer selected is dirty, arrange to have it written.
 
-					while (QUE_NOT_EMPTY(bdb->bdb_higher))
+					if (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty))
 					{
-						QUE que2 = bdb->bdb_higher.que_forward;
-						Precedence* precedence = BLOCK(que2, Precedence, pre_higher);
-						QUE_DELETE(precedence->pre_higher);
-						QUE_DELETE(precedence->pre_lower);
-						precedence->pre_hi = (BufferDesc*) bcb->bcb_free;
-						bcb->bcb_free = precedence;
+						const bool write_thru = (bcb->bcb_flags & BCB_exclusive);
+						if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, tdbb->tdbb_status_vector, true))
+						{
+							bcbSync.lock(SYNC_EXCLUSIVE);
+							bdb->bdb_flags &= ~BDB_free_pending;
+							QUE_DELETE(bdb->bdb_in_use);
+							QUE_APPEND(inUseQue(bcb, bdb), bdb->bdb_in_use);
+							bcbSync.unlock();
+
+							bdb->release(tdbb, true);
+							CCH_unwind(tdbb, true);
+						}
 					}
 
-					clear_precedence(tdbb, bdb);
-				}
+					// If the buffer is still in the dirty tree, remove it.
+					// In any case, release any lock it may have.
 
-				bcbSync.lock(SYNC_EXCLUSIVE);
-			}
+					removeDirty(bcb, bdb);
 
-			QUE_DELETE(bdb->bdb_que);	// bcb_pending
+					// Cleanup any residual precedence blocks.  Unless something is
+					// screwed up, the only precedence blocks that can still be hanging
+					// around are ones cleared at AST level.
 
-			QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
-			QUE_INSERT((*mod_que), bdb->bdb_que);
-			bdb->bdb_flags &= ~BDB_free_pending;
+					if (QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower))
+					{
+						Sync precSync(&bcb->bcb_syncPrecedence, "get_buffer");
+						precSync.lock(SYNC_EXCLUSIVE);
 
-			// This correction for bdb_use_count below is needed to
-			// avoid a deadlock situation in latching code.  It's not
-			// clear though how the bdb_use_count can get < 0 for a bdb
-			// in bcb_empty queue
+						while (QUE_NOT_EMPTY(bdb->bdb_higher))
+						{
+							QUE que2 = bdb->bdb_higher.que_forward;
+							Precedence* precedence = BLOCK(que2, Precedence, pre_higher);
+							QUE_DELETE(precedence->pre_higher);
+							QUE_DELETE(precedence->pre_lower);
+							precedence->pre_hi = (BufferDesc*) bcb->bcb_free;
+							bcb->bcb_free = precedence;
+						}
 
-			if (bdb->bdb_use_count < 0)
-				BUGCHECK(301);	/* msg 301 Non-zero use_count of a buffer in the empty Que */
+						clear_precedence(tdbb, bdb);
+					}
 
-			bdb->bdb_page = page;
-			bdb->bdb_flags &= BDB_lru_chained; // yes, clear all except BDB_lru_chained
-			bdb->bdb_flags |= BDB_read_pending;
-			bdb->bdb_scan_count = 0;
+					bcbSync.lock(SYNC_EXCLUSIVE);
+				}
 
-			bcbSync.unlock();
+				QUE_DELETE(bdb->bdb_que);	// bcb_pending
 
-			if (page != FREE_PAGE)
-				bdb->bdb_lock->lck_logical = LCK_none;
-			else
-				PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+				{ // scope
+					SyncLockGuard hashSync(&hashPartition(bcb, page).bcp_sync, SYNC_EXCLUSIVE, "get_buffer");
 
-			tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES);
-			return bdb;
+					QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
+					QUE_INSERT((*mod_que), bdb->bdb_que);
+				}
+				bdb->bdb_flags &= ~BDB_free_pending;
+
+				// This correction for bdb_use_count below is needed to
+				// avoid a deadlock situation in latching code.  It's not
+				// clear though how the bdb_use_count can get < 0 for a bdb
+				// in bcb_empty queue
+
+				if (bdb->bdb_use_count < 0)
+					BUGCHECK(301);	/* msg 301 Non-zero use_count of a buffer in the empty Que */
+
+				bdb->bdb_page = page;
+				bdb->bdb_flags &= BDB_lru_chained; // yes, clear all except BDB_lru_chained
+				bdb->bdb_flags |= BDB_read_pending;
+				bdb->bdb_scan_count = 0;
+
+				bcbSync.unlock();
+
+				if (page != FREE_PAGE)
+					bdb->bdb_lock->lck_logical = LCK_none;
+				else
+					PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+
+				tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES);
+				return bdb;
+			}
 		}
 
-		if (que_inst == &bcb->bcb_in_use)
+		if (exhausted)
 			expand_buffers(tdbb, bcb->bcb_count + 75);
 	}
 }
@@ -4051,6 +4802,99 @@ static ULONG get_prec_walk_mark(BufferControl* bcb)
 }
 
 
+static void get_dirty_batch(thread_db* tdbb, BufferControl* bcb, DirtyBatch& batch)
+{
+/**************************************
+ *
+ *	g e t _ d i r t y _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Collect the least recently used dirty buffers for the cache
+ *	writer. Buffers are not latched, caller should check if the
+ *	buffer still contains the same page before writing it.
+ *	Collected buffers are marked, so concurrent writers don't
+ *	collect them again until write_batch is done with them.
+ *
+ **************************************/
+	Sync bcbSync(&bcb->bcb_syncObject, "get_dirty_batch");
+	bcbSync.lock(SYNC_SHARED);
+
+	Sync lruSync(&bcb->bcb_syncLRU, "get_dirty_batch");
+	lruSync.lock(SYNC_EXCLUSIVE);
+
+	que* const lruQues[2] = {&bcb->bcb_cold, &bcb->bcb_in_use};
+	int walk = bcb->bcb_free_minimum;
+
+	for (int n = 0; n < 2 && walk && batch.getCount() < WRITE_BATCH; n++)
+	{
+		que* const lruQue = lruQues[n];
+
+		for (QUE que_inst = lruQue->que_backward;
+			 que_inst != lruQue; que_inst = que_inst->que_backward)
+		{
+			BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
+
+			if (bdb->bdb_use_count || (bdb->bdb_flags & BDB_free_pending))
+				continue;
+
+			// Buffer is in the batch of another writer already
+			if (bdb->bdb_flags & BDB_writer_batch)
+				continue;
+
+			if (bdb->bdb_flags & BDB_db_dirty)
+			{
+				bdb->bdb_flags |= BDB_writer_batch;
+
+				DirtyBuffer& dirty = batch.add();
+				dirty.bdb = bdb;
+				dirty.page = bdb->bdb_page;
+
+				if (batch.getCount() == WRITE_BATCH)
+					break;
+			}
+			else if (!--walk)
+				break;
+		}
+	}
+
+	if (!walk || batch.isEmpty())
+		bcb->bcb_flags &= ~BCB_free_pending;
+}
+
+
+static void update_writer_rate(BufferControl* bcb)
+{
+/**************************************
+ *
+ *	u p d a t e _ w r i t e r _ r a t e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Sample the number of pages written by cache writers
+ *	about once a second and compute pages per second.
+ *	Called by every cache writer on every pass, only one
+ *	of them takes the sample.
+ *
+ **************************************/
+	const AtomicCounter::counter_type now = (AtomicCounter::counter_type) time(NULL);
+	const AtomicCounter::counter_type stamp = bcb->bcb_writer_rate_stamp.value();
+
+	if (now <= stamp || !bcb->bcb_writer_rate_stamp.compareExchange(stamp, now))
+		return;
+
+	const AtomicCounter::counter_type pages = bcb->bcb_writer_pages.value();
+	const AtomicCounter::counter_type previous = bcb->bcb_writer_rate_pages.value();
+	bcb->bcb_writer_rate_pages.setValue(pages);
+
+	// The very first sample has nothing to compare with
+	if (stamp)
+		bcb->bcb_writer_rate.setValue((pages - previous) / (now - stamp));
+}
+
+
 static int get_related(BufferDesc* bdb, PagesArray &lowPages, int limit, const ULONG mark)
 {
 /**************************************
@@ -4102,6 +4946,60 @@ static int get_related(BufferDesc* bdb, PagesArray &lowPages, int limit, const U
 }
 
 
+static void load_hot_pages(thread_db* tdbb, Firebird::Array<FB_UINT64>& pages)
+{
+/**************************************
+ *
+ *	l o a d _ h o t _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read numbers of pages saved by save_hot_pages() when database
+ *	was used last time. Only the hottest pages which fit into the
+ *	main (not cold) part of the cache are taken. Pages are returned
+ *	sorted to be read by large sequential requests. Missing, damaged
+ *	or foreign file is silently ignored.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	const PathName fileName(dbb->dbb_filename + WARMUP_SUFFIX);
+
+	FILE* const file = os_utils::fopen(fileName.c_str(), "rb");
+	if (!file)
+		return;
+
+	WarmupHeader header;
+	HalfStaticArray<ULONG, WARMUP_CHUNK> numbers;
+
+	if (fread(&header, sizeof(header), 1, file) == 1 &&
+		header.wh_magic == WARMUP_MAGIC && header.wh_version == WARMUP_VERSION &&
+		header.wh_page_size == dbb->dbb_page_size &&
+		!memcmp(&header.wh_guid, &dbb->dbb_guid, sizeof(Guid)))
+	{
+		const ULONG count = MIN(header.wh_count, bcb->bcb_count - bcb->bcb_count / 4);
+		ULONG* const buffer = numbers.getBuffer(count);
+		numbers.shrink(fread(buffer, sizeof(ULONG), count, file));
+	}
+
+	fclose(file);
+
+	qsort(numbers.begin(), numbers.getCount(), sizeof(ULONG), cmpPageNumbers);
+
+	// Database could be shrunk by restore since the file was saved
+
+	const ULONG maxPage = PageSpace::maxAlloc(dbb);
+
+	for (const ULONG* page = numbers.begin(); page < numbers.end(); page++)
+	{
+		if (*page < maxPage)
+			pages.add(((FB_UINT64) DB_PAGE_SPACE << 32) | *page);
+	}
+}
+
+
 static LockState lock_buffer(thread_db* tdbb, BufferDesc* bdb, const SSHORT wait,
 	const SCHAR page_type)
 {
@@ -4253,6 +5151,75 @@ static LockState lock_buffer(thread_db* tdbb, BufferDesc* bdb, const SSHORT wait
 }
 
 
+static void log_memory_layout(thread_db* tdbb, BufferControl* bcb)
+{
+/**************************************
+ *
+ *	l o g _ m e m o r y _ l a y o u t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write the kind of memory backing the cache buffers
+ *	into the log.
+ *
+ **************************************/
+	FB_UINT64 total = 0, huge = 0;
+	size_t huge_page = 0;
+	ULONG extents = 0;
+
+	for (Firebird::Stack<bcb_extent>::iterator iter(bcb->bcb_memory); iter.hasData(); ++iter)
+	{
+		const bcb_extent& extent = iter.object();
+
+		extents++;
+		total += extent.bce_size;
+		if (extent.bce_huge_page)
+		{
+			huge += extent.bce_size;
+			huge_page = extent.bce_huge_page;
+		}
+	}
+
+	const char* pages = "normal";
+	if (huge)
+		pages = (huge_page >= HUGE_PAGE_1G) ? "1G" : "2M";
+	else if (bcb->bcb_huge_pages != HUGE_PAGES_NONE)
+		pages = "normal (transparent huge pages allowed)";
+
+	const char* numa = "default";
+	if (bcb->bcb_numa_policy == NUMA_POLICY_INTERLEAVE)
+		numa = "interleaved";
+	else if (bcb->bcb_numa_policy == NUMA_POLICY_BIND)
+		numa = "bound";
+
+	gds__log("Database: %s\n\tPage cache: %u buffers, %" UQUADFORMAT " MB in %u extents\n"
+		"\t%" UQUADFORMAT " MB on %s pages, NUMA placement %s over %u nodes",
+		tdbb->getAttachment()->att_filename.c_str(), bcb->bcb_count, total >> 20, extents,
+		huge ? huge >> 20 : total >> 20, pages, numa, MAX(bcb->bcb_numa_nodes, 1));
+}
+
+
+static size_t max_extent_size(const BufferControl* bcb)
+{
+/**************************************
+ *
+ *	m a x _ e x t e n t _ s i z e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Return max size of memory block allocated for buffers,
+ *	block should fit at least one huge page.
+ *
+ **************************************/
+	if (bcb->bcb_huge_pages == HUGE_PAGES_1G)
+		return HUGE_PAGE_1G;
+
+	return MAX_BUFFER_SEGMENT;
+}
+
+
 static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, SLONG number)
 {
 /**************************************
@@ -4275,6 +5242,14 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, SLONG number)
 	size_t memory_size = page_size * (number + 1);
 	fb_assert(memory_size > 0);
 
+	// Buffers are allocated by extents of limited size, so the cache could
+	// be shrunk online. Buffers bound to NUMA nodes take an extent per node
+	// at least.
+
+	size_t max_size = max_extent_size(bcb);
+	if (bcb->bcb_numa_policy == NUMA_POLICY_BIND)
+		max_size = MIN(max_size, page_size * (number / bcb->bcb_numa_nodes + 1));
+
 	SLONG old_buffers = 0;
 	bcb_repeat* old_tail = NULL;
 	const UCHAR* memory_end = NULL;
@@ -4289,10 +5264,13 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, SLONG number)
 			if (memory_size > (page_size * (number + 1)))
 				memory_size = page_size * (number + 1);
 
+			if (memory_size > max_size)
+				memory_size = max_size;
+
 			while (true)
 			{
 				try {
-					memory = (UCHAR*) bcb->bcb_bufferpool->allocate(memory_size ALLOC_ARGS);
+					memory = alloc_extent(tdbb, bcb, memory_size);
 					break;
 				}
 				catch (Firebird::BadAlloc&)
@@ -4310,7 +5288,6 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, SLONG number)
 				}
 			}
 
-			bcb->bcb_memory.push(memory);
 			memory_end = memory + memory_size;
 
 			// Allocate buffers on an address that is an even multiple
@@ -4334,7 +5311,7 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, SLONG number)
 			// the page buffer overhead. Reduce this number by a 25% fudge factor to
 			// leave some memory for useful work.
 
-			bcb->bcb_bufferpool->deallocate(bcb->bcb_memory.pop());
+			release_extent(bcb, bcb->bcb_memory.pop());
 			memory = NULL;
 
 			for (bcb_repeat* tail2 = old_tail; tail2 < tail; tail2++)
@@ -4590,153 +5567,812 @@ static void prefetch_prologue(Prefetch* prefetch, SLONG* start_page)
 #endif // CACHE_READER
 
 
-static SSHORT related(BufferDesc* low, const BufferDesc* high, SSHORT limit, const ULONG mark)
+static void read_ahead(thread_db* tdbb, const FB_UINT64* pages, FB_SIZE_T count)
 {
 /**************************************
  *
- *	r e l a t e d
+ *	r e a d _ a h e a d
  *
  **************************************
  *
  * Functional description
- *	See if there are precedence relationships linking two buffers.
- *	Since precedence graphs can become very complex, limit search for
- *	precedence relationship by visiting a presribed limit of higher
- *	precedence blocks.
+ *	Read sorted list of pages into cache, skipping pages which
+ *	are in cache already. Buffers of pages are collected into runs
+ *	read together, adjacent pages of a run by single I/O request.
  *
  **************************************/
-	const struct que* base = &low->bdb_higher;
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
-	for (const struct que* que_inst = base->que_forward; que_inst != base; que_inst = que_inst->que_forward)
+	HalfStaticArray<BufferDesc*, READ_AHEAD_RUN> run;
+
+	for (FB_SIZE_T i = 0; i < count && (bcb->bcb_flags & BCB_prefetcher); i++)
 	{
-		if (!--limit)
-			return PRE_UNKNOWN;
+		const PageNumber page((USHORT) (pages[i] >> 32), (ULONG) pages[i]);
 
-		const Precedence* precedence = BLOCK(que_inst, Precedence, pre_higher);
-		if (!(precedence->pre_flags & PRE_cleared))
+		bool cached;
+		{ // scope
+			Sync hashSync(&bcb->bcb_syncObject, "read_ahead");
+			lockHashPartition(bcb, hashSync, page, SYNC_SHARED);
+			cached = (find_buffer(bcb, page, false) != NULL);
+		}
+
+		// Never wait for a buffer latched by somebody else
+
+		BufferDesc* bdb = cached ? NULL : get_buffer(tdbb, page, SYNC_EXCLUSIVE, 0);
+
+		if (bdb && !(bdb->bdb_flags & BDB_read_pending))
 		{
-			if (precedence->pre_hi->bdb_prec_walk_mark == mark)
-				continue;
+			bdb->release(tdbb, true);
+			bdb = NULL;
+		}
 
-			if (precedence->pre_hi == high)
-				return PRE_EXISTS;
+		if (run.hasData())
+		{
+			const PageNumber& last = run.back()->bdb_page;
 
-			if (QUE_NOT_EMPTY(precedence->pre_hi->bdb_higher))
+			if (run.getCount() == READ_AHEAD_RUN || last.getPageSpaceID() != page.getPageSpaceID())
 			{
-				limit = related(precedence->pre_hi, high, limit, mark);
-				if (limit == PRE_EXISTS || limit == PRE_UNKNOWN)
-					return limit;
+				read_ahead_run(tdbb, run.begin(), run.getCount());
+				run.clear();
 			}
-			else
-				precedence->pre_hi->bdb_prec_walk_mark = mark;
 		}
+
+		if (bdb)
+			run.add(bdb);
 	}
 
-	low->bdb_prec_walk_mark = mark;
-	return limit;
+	if (run.hasData())
+		read_ahead_run(tdbb, run.begin(), run.getCount());
 }
 
 
-static inline bool writeable(BufferDesc* bdb)
+static void read_ahead_run(thread_db* tdbb, BufferDesc* const* bdbs, USHORT count)
 {
 /**************************************
  *
- *	w r i t e a b l e
+ *	r e a d _ a h e a d _ r u n
  *
  **************************************
  *
  * Functional description
- *	See if a buffer is writeable.  A buffer is writeable if
- *	neither it nor any of it's higher precedence cousins are
- *	marked for write.
- *  This is the starting point of recursive walk of precedence
- *  graph. The writeable_mark member is used to mark already seen
- *  buffers to avoid repeated walk of the same sub-graph.
- *  Currently this function can't be called from more than one
- *  thread simultaneously. When SMP will be implemented we must
- *  take additional care about thread-safety.
+ *	Read sorted run of pages into buffers latched exclusively and
+ *	release the buffers. If a page was not read it keeps BDB_read_pending
+ *	flag and will be read by CCH_fetch_page() as usual, so errors are not
+ *	reported here.
  *
  **************************************/
-	if (bdb->bdb_flags & BDB_marked)
-		return false;
+	class ReadAheadIO : public CryptoManager::IOCallback
+	{
+	public:
+		ReadAheadIO(jrd_file* f, BufferDesc* b)
+			: file(f), bdb(b), haveImage(true)
+		{ }
 
-	if (QUE_EMPTY(bdb->bdb_higher))
-		return true;
+		bool callback(thread_db* tdbb, FbStatusVector* status, Ods::pag* page)
+		{
+			// Page image is read already, read it again only if asked once more
 
-	BufferControl* bcb = bdb->bdb_bcb;
+			if (haveImage)
+			{
+				haveImage = false;
+				return true;
+			}
 
-	Sync syncPrec(&bcb->bcb_syncPrecedence, "writeable");
-	syncPrec.lock(SYNC_EXCLUSIVE);
+			return PIO_read(tdbb, file, bdb, page, status);
+		}
 
-	const ULONG mark = get_prec_walk_mark(bcb);
-	return is_writeable(bdb, mark);
-}
+	private:
+		jrd_file* file;
+		BufferDesc* bdb;
+		bool haveImage;
+	};
 
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
-static bool is_writeable(BufferDesc* bdb, const ULONG mark)
-{
-/**************************************
- *
- *	i s _ w r i t e a b l e
- *
- **************************************
- *
- * Functional description
- *	See if a buffer is writeable.  A buffer is writeable if
- *	neither it nor any of it's higher precedence cousins are
- *	marked for write.
- *
- **************************************/
+	PageSpace* const pageSpace = dbb->dbb_page_manager.findPageSpace(bdbs[0]->bdb_page.getPageSpaceID());
+	fb_assert(pageSpace);
 
-	// If there are buffers that must be written first, check them, too.
+	FbLocalStatus status;
 
-	for (const que* queue = bdb->bdb_higher.que_forward;
-		queue != &bdb->bdb_higher; queue = queue->que_forward)
-	{
-		const Precedence* precedence = BLOCK(queue, Precedence, pre_higher);
+	{ // scope
+		// Pages could be in the difference file unless nbak state is normal,
+		// leave them to CCH_fetch_page()
 
-		if (!(precedence->pre_flags & PRE_cleared))
-		{
-			BufferDesc* high = precedence->pre_hi;
+		BackupManager::StateReadGuard stateGuard(tdbb);
 
-			if (high->bdb_flags & BDB_marked)
-				return false;
+		if (pageSpace->isTemporary() || dbb->dbb_backup_manager->getState() == Ods::hdr_nbak_normal)
+		{
+			jrd_file* const file = pageSpace->file;
 
-			if (high->bdb_prec_walk_mark != mark)
+			if (PIO_read_batch(tdbb, file, bdbs, count, &status))
 			{
-				if (QUE_EMPTY(high->bdb_higher))
-					high->bdb_prec_walk_mark = mark;
-				else if (!is_writeable(high, mark))
-					return false;
+				for (USHORT n = 0; n < count; n++)
+				{
+					BufferDesc* const bdb = bdbs[n];
+
+					ReadAheadIO io(file, bdb);
+					if (dbb->dbb_crypto_manager->read(tdbb, &status, bdb->bdb_buffer, &io))
+					{
+						bdb->bdb_incarnation = ++bcb->bcb_page_incarnation;
+						bdb->bdb_flags &= ~(BDB_not_valid | BDB_read_pending);
+						bdb->bdb_flags |= BDB_prefetch;
+						tdbb->bumpStats(RuntimeStatistics::PAGE_READS);
+					}
+				}
 			}
 		}
 	}
 
-	bdb->bdb_prec_walk_mark = mark;
-	return true;
+	for (USHORT n = 0; n < count; n++)
+		bdbs[n]->release(tdbb, true);
 }
 
 
-static int write_buffer(thread_db* tdbb,
-						BufferDesc* bdb,
-						const PageNumber page,
-						const bool write_thru,
-						FbStatusVector* const status, const bool write_this_page)
+static void warm_up(thread_db* tdbb, const FB_UINT64* pages, FB_SIZE_T count)
 {
 /**************************************
  *
- *	w r i t e _ b u f f e r
+ *	w a r m _ u p
  *
  **************************************
  *
  * Functional description
- *	Write a dirty buffer.  This may recurse due to
- *	precedence problems.
+ *	Read sorted list of pages saved as hot into cache. With 2Q policy
+ *	new pages go into the cold que and would push each other out, so
+ *	pages are made known as recently evicted first and thus are put
+ *	into the main que when read.
  *
- * input:  write_this_page
- *		= true if the input page needs to be written
- *			before returning.  (normal case)
- *		= false if the input page is being written
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	if (bcb->bcb_policy == PAGE_CACHE_2Q)
+	{
+		Sync lruSync(&bcb->bcb_syncLRU, "warm_up");
+		lruSync.lock(SYNC_EXCLUSIVE);
+
+		for (FB_SIZE_T i = 0; i < count; i++)
+			bcb->bcb_ghosts.add(PageNumber((USHORT) (pages[i] >> 32), (ULONG) pages[i]));
+	}
+
+	read_ahead(tdbb, pages, count);
+}
+
+
+static void release_extent(BufferControl* bcb, const bcb_extent& extent)
+{
+/**************************************
+ *
+ *	r e l e a s e _ e x t e n t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release memory allocated by alloc_extent.
+ *
+ **************************************/
+	if (extent.bce_os)
+		os_utils::releaseLargeMemory(extent.bce_memory, extent.bce_size);
+	else
+		bcb->bcb_bufferpool->deallocate(extent.bce_memory);
+}
+
+
+static SSHORT related(BufferDesc* low, const BufferDesc* high, SSHORT limit, const ULONG mark)
+{
+/**************************************
+ *
+ *	r e l a t e d
+ *
+ **************************************
+ *
+ * Functional description
+ *	See if there are precedence relationships linking two buffers.
+ *	Since precedence graphs can become very complex, limit search for
+ *	precedence relationship by visiting a presribed limit of higher
+ *	precedence blocks.
+ *
+ **************************************/
+	const struct que* base = &low->bdb_higher;
+
+	for (const struct que* que_inst = base->que_forward; que_inst != base; que_inst = que_inst->que_forward)
+	{
+		if (!--limit)
+			return PRE_UNKNOWN;
+
+		const Precedence* precedence = BLOCK(que_inst, Precedence, pre_higher);
+		if (!(precedence->pre_flags & PRE_cleared))
+		{
+			if (precedence->pre_hi->bdb_prec_walk_mark == mark)
+				continue;
+
+			if (precedence->pre_hi == high)
+				return PRE_EXISTS;
+
+			if (QUE_NOT_EMPTY(precedence->pre_hi->bdb_higher))
+			{
+				limit = related(precedence->pre_hi, high, limit, mark);
+				if (limit == PRE_EXISTS || limit == PRE_UNKNOWN)
+					return limit;
+			}
+			else
+				precedence->pre_hi->bdb_prec_walk_mark = mark;
+		}
+	}
+
+	low->bdb_prec_walk_mark = mark;
+	return limit;
+}
+
+
+static bool save_hot_pages(thread_db* tdbb)
+{
+/**************************************
+ *
+ *	s a v e _ h o t _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Save numbers of database pages in cache in the order of recency,
+ *	main que first then cold que, to warm up the cache with them when
+ *	database is opened next time. Return false if file can't be written,
+ *	this is logged once only. The file is replaced at once, so an
+ *	interrupted save leaves the previous list in place.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	Array<ULONG> numbers;
+
+	{ // scope
+		Sync lruSync(&bcb->bcb_syncLRU, "save_hot_pages");
+		lruSync.lock(SYNC_SHARED);
+
+		const que* const ques[2] = {&bcb->bcb_in_use, &bcb->bcb_cold};
+
+		for (int i = 0; i < 2; i++)
+		{
+			for (const que* que_inst = ques[i]->que_forward; que_inst != ques[i];
+				 que_inst = que_inst->que_forward)
+			{
+				const BufferDesc* const bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
+				const PageNumber page = bdb->bdb_page;
+
+				if (page.getPageSpaceID() == DB_PAGE_SPACE)
+					numbers.add(page.getPageNum());
+			}
+		}
+	}
+
+	WarmupHeader header;
+	memset(&header, 0, sizeof(header));
+	header.wh_magic = WARMUP_MAGIC;
+	header.wh_version = WARMUP_VERSION;
+	header.wh_page_size = dbb->dbb_page_size;
+	header.wh_count = numbers.getCount();
+	memcpy(&header.wh_guid, &dbb->dbb_guid, sizeof(Guid));
+
+	const PathName fileName(dbb->dbb_filename + WARMUP_SUFFIX);
+
+	// Write a temporary file and rename it then, so the previous list stays
+	// intact if we fail. Process ID makes it unique for Classic processes.
+
+	PathName tempName;
+	tempName.printf("%s.%d", fileName.c_str(), (int) getpid());
+
+	bool written = false;
+	int error = 0;
+
+	FILE* const file = os_utils::fopen(tempName.c_str(), "wb");
+	if (file)
+	{
+		written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(numbers.begin(), sizeof(ULONG), numbers.getCount(), file) == numbers.getCount();
+
+		if (fclose(file))
+			written = false;
+
+#ifdef WIN_NT
+		// rename() doesn't replace existing file on Windows
+		if (written)
+			remove(fileName.c_str());
+#endif
+
+		if (written && rename(tempName.c_str(), fileName.c_str()))
+			written = false;
+
+		if (!written)
+		{
+			error = errno;
+			remove(tempName.c_str());
+		}
+	}
+	else
+		error = errno;
+
+	if (!written && !bcb->bcb_warmup_error)
+	{
+		bcb->bcb_warmup_error = true;
+		gds__log("Database: %s\n\tCannot save list of hot pages into %s, errno %d",
+			dbb->dbb_filename.c_str(), fileName.c_str(), error);
+	}
+
+	return written;
+}
+
+
+static ULONG shrink_buffers(thread_db* tdbb, ULONG number)
+{
+/**************************************
+ *
+ *	s h r i n k _ b u f f e r s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Shrink the cache to about a given number of buffers. Memory is
+ *	given back by whole extents, most recently allocated first, thus
+ *	cache could stay a bit larger than asked. Buffers of the released
+ *	extents are written if dirty and removed from the cache. Their
+ *	descriptors are not freed as other threads (cache writers, flush
+ *	lists) may still refer them, they are kept for reuse by expand.
+ *	Buffers in use by somebody else can't be removed, so try a few
+ *	times and give up then. Return number of buffers in the cache.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	const int SHRINK_ATTEMPTS = 10;
+
+	Firebird::HalfStaticArray<ULONG, 16> bounds;
+	Firebird::HalfStaticArray<BufferDesc*, 1024> victims;
+
+	for (int attempt = 0; attempt < SHRINK_ATTEMPTS; attempt++)
+	{
+		ULONG count;
+
+		bounds.clear();
+		victims.clear();
+
+		{	// bcbSync scope
+			Sync bcbSync(&bcb->bcb_syncObject, "shrink_buffers");
+			bcbSync.lock(SYNC_SHARED);
+
+			// Buffers of an extent occupy a contiguous range of the tail of
+			// bcb_rpt, walk extents from the most recent one and remember
+			// the first buffer of every extent which could be released
+
+			count = bcb->bcb_count;
+			ULONG keep = count;
+
+			for (Firebird::Stack<bcb_extent>::iterator iter(bcb->bcb_memory); iter.hasData(); ++iter)
+			{
+				const bcb_extent& extent = iter.object();
+				const UCHAR* const extent_end = extent.bce_memory + extent.bce_size;
+
+				ULONG first = keep;
+				while (first)
+				{
+					const UCHAR* const buffer = (UCHAR*) bcb->bcb_rpt[first - 1].bcb_bdb->bdb_buffer;
+					if (buffer < extent.bce_memory || buffer >= extent_end)
+						break;
+					first--;
+				}
+
+				if (first == keep || first < number)
+					break;
+
+				keep = first;
+				bounds.add(keep);
+			}
+
+			if (bounds.isEmpty())
+				return count;
+
+			for (ULONG i = keep; i < count; i++)
+				victims.add(bcb->bcb_rpt[i].bcb_bdb);
+		}
+
+		// Write dirty victims and clean up their residual precedence.
+		// Nothing is latched by us here so writes are free to wait.
+
+		for (BufferDesc** iter = victims.begin(); iter < victims.end(); iter++)
+		{
+			BufferDesc* const bdb = *iter;
+
+			if (!(bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) ||
+				!bdb->addRefConditional(tdbb, SYNC_EXCLUSIVE))
+			{
+				continue;
+			}
+
+			if (!write_buffer(tdbb, bdb, bdb->bdb_page, true, tdbb->tdbb_status_vector, true))
+			{
+				bdb->release(tdbb, false);
+				CCH_unwind(tdbb, true);
+			}
+
+			bdb->release(tdbb, false);
+		}
+
+		{	// precSync scope
+			Sync precSync(&bcb->bcb_syncPrecedence, "shrink_buffers");
+			precSync.lock(SYNC_EXCLUSIVE);
+
+			for (BufferDesc** iter = victims.begin(); iter < victims.end(); iter++)
+			{
+				BufferDesc* const bdb = *iter;
+
+				QUE que_inst = bdb->bdb_higher.que_forward, next;
+				for (; que_inst != &bdb->bdb_higher; que_inst = next)
+				{
+					next = que_inst->que_forward;
+					Precedence* const precedence = BLOCK(que_inst, Precedence, pre_higher);
+					if (precedence->pre_flags & PRE_cleared)
+					{
+						QUE_DELETE(precedence->pre_higher);
+						QUE_DELETE(precedence->pre_lower);
+						precedence->pre_hi = (BufferDesc*) bcb->bcb_free;
+						bcb->bcb_free = precedence;
+					}
+				}
+
+				for (que_inst = bdb->bdb_lower.que_forward; que_inst != &bdb->bdb_lower; que_inst = next)
+				{
+					next = que_inst->que_forward;
+					Precedence* const precedence = BLOCK(que_inst, Precedence, pre_lower);
+					if (precedence->pre_flags & PRE_cleared)
+					{
+						QUE_DELETE(precedence->pre_higher);
+						QUE_DELETE(precedence->pre_lower);
+						precedence->pre_hi = (BufferDesc*) bcb->bcb_free;
+						bcb->bcb_free = precedence;
+					}
+				}
+			}
+		}
+
+		{	// bcbSync scope
+			Sync bcbSync(&bcb->bcb_syncObject, "shrink_buffers");
+			bcbSync.lock(SYNC_EXCLUSIVE);
+
+			// Cache was resized by somebody else, start over
+			if (bcb->bcb_count != count)
+				continue;
+
+			Sync lruSync(&bcb->bcb_syncLRU, "shrink_buffers");
+			lruSync.lock(SYNC_EXCLUSIVE);
+
+			if (bcb->bcb_lru_chain.load() != NULL)
+				requeueRecentlyUsed(bcb);
+
+			// No one could look up or latch victims while all hash
+			// partitions are latched, so idle victims stay idle
+
+			for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+				bcb->bcb_partitions[i].bcp_sync.lock(NULL, SYNC_EXCLUSIVE, "shrink_buffers");
+
+			// Extents containing busy buffers can't be released, as well
+			// as all extents allocated before them
+
+			FB_SIZE_T extents = bounds.getCount();
+			for (ULONG i = count; i > bounds[extents - 1]; )
+			{
+				const BufferDesc* const bdb = bcb->bcb_rpt[--i].bcb_bdb;
+
+				if (bdb->bdb_use_count ||
+					(bdb->bdb_flags & (BDB_dirty | BDB_db_dirty | BDB_marked | BDB_free_pending)) ||
+					QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower))
+				{
+					while (extents && bounds[extents - 1] <= i)
+						extents--;
+
+					if (!extents)
+						break;
+				}
+			}
+
+			bcb_repeat* new_rpt = NULL;
+
+			if (extents)
+			{
+				try
+				{
+					new_rpt = FB_NEW_POOL(*bcb->bcb_bufferpool) bcb_repeat[bounds[extents - 1]];
+				}
+				catch (const Firebird::Exception&)
+				{
+					for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+						bcb->bcb_partitions[i].bcp_sync.unlock(NULL, SYNC_EXCLUSIVE);
+					throw;
+				}
+			}
+
+			if (!new_rpt)
+			{
+				for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+					bcb->bcb_partitions[i].bcp_sync.unlock(NULL, SYNC_EXCLUSIVE);
+			}
+			else
+			{
+				const ULONG keep = bounds[extents - 1];
+
+				// Remove victims from the hash, LRU and dirty ques and retire them
+
+				for (ULONG i = keep; i < count; i++)
+				{
+					BufferDesc* const bdb = bcb->bcb_rpt[i].bcb_bdb;
+
+					QUE_DELETE(bdb->bdb_que);
+					QUE_INIT(bdb->bdb_que);
+					removeInUse(bcb, bdb);
+					QUE_INIT(bdb->bdb_in_use);
+					removeDirty(bcb, bdb);
+
+					PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+
+					bdb->bdb_page = FREE_PAGE;
+					bdb->bdb_buffer = NULL;
+					bdb->bdb_flags = 0;
+					bcb->bcb_retired.add(bdb);
+				}
+
+				// Rebuild hash table for the new number of buffers
+
+				bcb_repeat* const old_rpt = bcb->bcb_rpt;
+
+				bcb->bcb_rpt = new_rpt;
+				bcb->bcb_count = keep;
+				bcb->bcb_free_minimum = (SSHORT) MIN(keep / 4, 128);	/* 25% clean page reserve */
+
+				for (ULONG i = 0; i < keep; i++)
+				{
+					QUE_INIT(new_rpt[i].bcb_page_mod);
+					new_rpt[i].bcb_bdb = old_rpt[i].bcb_bdb;
+				}
+
+				for (ULONG i = 0; i < count; i++)
+				{
+					while (QUE_NOT_EMPTY(old_rpt[i].bcb_page_mod))
+					{
+						QUE que_inst = old_rpt[i].bcb_page_mod.que_forward;
+						BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_que);
+						QUE_DELETE(*que_inst);
+						QUE mod_que = &new_rpt[bdb->bdb_page.getPageNum() % keep].bcb_page_mod;
+						QUE_INSERT(*mod_que, *que_inst);
+					}
+				}
+
+				for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+					bcb->bcb_partitions[i].bcp_sync.unlock(NULL, SYNC_EXCLUSIVE);
+
+				setCacheLimits(bcb);
+
+				delete[] old_rpt;
+
+				for (; extents; extents--)
+					release_extent(bcb, bcb->bcb_memory.pop());
+
+				return keep;
+			}
+		}
+
+		// Some victims are busy, let them finish and try again
+
+		EngineCheckout cout(tdbb, FB_FUNCTION);
+		Thread::sleep(100);
+	}
+
+	return bcb->bcb_count;
+}
+
+
+static inline bool writeable(BufferDesc* bdb)
+{
+/**************************************
+ *
+ *	w r i t e a b l e
+ *
+ **************************************
+ *
+ * Functional description
+ *	See if a buffer is writeable.  A buffer is writeable if
+ *	neither it nor any of it's higher precedence cousins are
+ *	marked for write.
+ *  This is the starting point of recursive walk of precedence
+ *  graph. The writeable_mark member is used to mark already seen
+ *  buffers to avoid repeated walk of the same sub-graph.
+ *  Currently this function can't be called from more than one
+ *  thread simultaneously. When SMP will be implemented we must
+ *  take additional care about thread-safety.
+ *
+ **************************************/
+	if (bdb->bdb_flags & BDB_marked)
+		return false;
+
+	if (QUE_EMPTY(bdb->bdb_higher))
+		return true;
+
+	BufferControl* bcb = bdb->bdb_bcb;
+
+	Sync syncPrec(&bcb->bcb_syncPrecedence, "writeable");
+	syncPrec.lock(SYNC_EXCLUSIVE);
+
+	const ULONG mark = get_prec_walk_mark(bcb);
+	return is_writeable(bdb, mark);
+}
+
+
+static bool is_writeable(BufferDesc* bdb, const ULONG mark)
+{
+/**************************************
+ *
+ *	i s _ w r i t e a b l e
+ *
+ **************************************
+ *
+ * Functional description
+ *	See if a buffer is writeable.  A buffer is writeable if
+ *	neither it nor any of it's higher precedence cousins are
+ *	marked for write.
+ *
+ **************************************/
+
+	// If there are buffers that must be written first, check them, too.
+
+	for (const que* queue = bdb->bdb_higher.que_forward;
+		queue != &bdb->bdb_higher; queue = queue->que_forward)
+	{
+		const Precedence* precedence = BLOCK(queue, Precedence, pre_higher);
+
+		if (!(precedence->pre_flags & PRE_cleared))
+		{
+			BufferDesc* high = precedence->pre_hi;
+
+			if (high->bdb_flags & BDB_marked)
+				return false;
+
+			if (high->bdb_prec_walk_mark != mark)
+			{
+				if (QUE_EMPTY(high->bdb_higher))
+					high->bdb_prec_walk_mark = mark;
+				else if (!is_writeable(high, mark))
+					return false;
+			}
+		}
+	}
+
+	bdb->bdb_prec_walk_mark = mark;
+	return true;
+}
+
+
+static void write_batch(thread_db* tdbb, DirtyBuffer* batch, FB_SIZE_T count, FbStatusVector* const status)
+{
+/**************************************
+ *
+ *	w r i t e _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write batch of dirty buffers collected by cache writer.
+ *	Buffers are sorted by page number, pages of the same page
+ *	space are written together, adjacent pages by single I/O
+ *	request. Buffers locked for I/O by someone else are skipped,
+ *	they are written by their owner.
+ *
+ **************************************/
+	qsort(batch, count, sizeof(DirtyBuffer), cmpDirtyBuffers);
+
+	try
+	{
+		write_batch_runs(tdbb, batch, count, status);
+	}
+	catch (const Firebird::Exception&)
+	{
+		for (const DirtyBuffer* iter = batch; iter < batch + count; ++iter)
+			iter->bdb->bdb_flags &= ~BDB_writer_batch;
+
+		throw;
+	}
+
+	for (const DirtyBuffer* iter = batch; iter < batch + count; ++iter)
+		iter->bdb->bdb_flags &= ~BDB_writer_batch;
+}
+
+
+static void write_batch_runs(thread_db* tdbb, const DirtyBuffer* batch, FB_SIZE_T count,
+	FbStatusVector* const status)
+{
+/**************************************
+ *
+ *	w r i t e _ b a t c h _ r u n s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write sorted batch of dirty buffers by runs of adjacent pages.
+ *
+ **************************************/
+	WriteRun run;
+
+	for (const DirtyBuffer* iter = batch; iter < batch + count; ++iter)
+	{
+		BufferDesc* const bdb = iter->bdb;
+
+		if (!bdb->lockIOConditional(tdbb))
+			continue;
+
+		if (bdb->bdb_page != iter->page)
+		{
+			bdb->unLockIO(tdbb);
+			continue;
+		}
+
+		if (run.hasData())
+		{
+			const BufferDesc* const last = run.back();
+
+			if (run.getCount() >= WRITE_RUN ||
+				last->bdb_page.getPageSpaceID() != bdb->bdb_page.getPageSpaceID())
+			{
+				write_run(tdbb, run.begin(), run.getCount(), true, status);
+				run.clear();
+			}
+		}
+
+		if (can_write_run(tdbb, bdb, true))
+		{
+			run.add(bdb);
+			continue;
+		}
+
+		// Page needs special handling, write it alone. Nothing else is
+		// locked by us at this point so write_buffer is free to wait.
+
+		bdb->unLockIO(tdbb);
+
+		if (run.hasData())
+		{
+			write_run(tdbb, run.begin(), run.getCount(), true, status);
+			run.clear();
+		}
+
+		write_buffer(tdbb, bdb, iter->page, true, status, true);
+	}
+
+	if (run.hasData())
+		write_run(tdbb, run.begin(), run.getCount(), true, status);
+}
+
+
+static int write_buffer(thread_db* tdbb,
+						BufferDesc* bdb,
+						const PageNumber page,
+						const bool write_thru,
+						FbStatusVector* const status, const bool write_this_page)
+{
+/**************************************
+ *
+ *	w r i t e _ b u f f e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a dirty buffer.  This may recurse due to
+ *	precedence problems.
+ *
+ * input:  write_this_page
+ *		= true if the input page needs to be written
+ *			before returning.  (normal case)
+ *		= false if the input page is being written
  *			because of precedence.  Only write
  *			one page and return so that the caller
  *			can re-establish the need to write this
@@ -4866,6 +6502,47 @@ static int write_buffer(thread_db* tdbb,
 }
 
 
+static void page_written(thread_db* tdbb, BufferDesc* bdb)
+{
+/**************************************
+ *
+ *	p a g e _ w r i t t e n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Mark buffer, locked for I/O, as clean after its page
+ *	was successfully written.
+ *
+ **************************************/
+
+	// clear the dirty bit vector, since the buffer is now
+	// clean regardless of which transactions have modified it
+
+	// Destination difference page number is only valid between MARK and
+	// write_page so clean it now to avoid confusion
+	bdb->bdb_difference_page = 0;
+	bdb->bdb_transactions = 0;
+	bdb->bdb_mark_transaction = 0;
+
+	if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
+		removeDirty(bdb->bdb_bcb, bdb);
+
+	bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
+	clear_dirty_flag_and_nbak_state(tdbb, bdb);
+
+	if (bdb->bdb_flags & BDB_io_error)
+	{
+		// If a write error has cleared, signal background threads
+		// to resume their regular duties. If someone has freed up
+		// disk space these errors will spontaneously go away.
+
+		bdb->bdb_flags &= ~BDB_io_error;
+		tdbb->getDatabase()->dbb_flags &= ~DBB_suspend_bgio;
+	}
+}
+
+
 static bool write_page(thread_db* tdbb, BufferDesc* bdb, FbStatusVector* const status, const bool inAst)
 {
 /**************************************
@@ -5054,31 +6731,167 @@ static bool write_page(thread_db* tdbb, BufferDesc* bdb, FbStatusVector* const s
 		dbb->dbb_flags |= DBB_suspend_bgio;
 	}
 	else
+		page_written(tdbb, bdb);
+
+	return result;
+}
+
+
+static bool write_run(thread_db* tdbb, BufferDesc* const* bdbs, USHORT count, const bool write_thru,
+	FbStatusVector* const status)
+{
+/**************************************
+ *
+ *	w r i t e _ r u n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write sorted run of dirty pages of the same page space.
+ *	Adjacent pages are written by single I/O request, requests
+ *	are submitted at once if I/O backend supports it. Buffers
+ *	are locked for I/O by caller and accepted by can_write_run.
+ *	Locks are released on return. If the run can't be written
+ *	at once, pages are written one by one.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+	bool result = false;
+
+	if (count > 1)
 	{
-		// clear the dirty bit vector, since the buffer is now
-		// clean regardless of which transactions have modified it
+		// Encrypted copies of pages are gathered into staging buffer as
+		// crypt manager passes them to the callback in temporary memory
 
-		// Destination difference page number is only valid between MARK and
-		// write_page so clean it now to avoid confusion
-		bdb->bdb_difference_page = 0;
-		bdb->bdb_transactions = 0;
-		bdb->bdb_mark_transaction = 0;
+		class GatherIO : public CryptoManager::IOCallback
+		{
+		public:
+			GatherIO(Database* d, Ods::pag** p, USHORT c)
+				: dbb(d), pages(p), count(c), staging(*getDefaultMemoryPool()), buffer(NULL), current(0)
+			{ }
 
-		if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
-			removeDirty(bdb->bdb_bcb, bdb);
+			bool callback(thread_db*, FbStatusVector*, Ods::pag* page)
+			{
+				if (page != pages[current])
+				{
+					if (!buffer)
+					{
+						UCHAR* const memory =
+							staging.getBuffer(count * dbb->dbb_page_size + PAGE_ALIGNMENT);
+						buffer = FB_ALIGN(memory, PAGE_ALIGNMENT);
+					}
 
-		bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
-		clear_dirty_flag_and_nbak_state(tdbb, bdb);
+					Ods::pag* const copy = (Ods::pag*) (buffer + current * dbb->dbb_page_size);
+					memcpy(copy, page, dbb->dbb_page_size);
+					pages[current] = copy;
+				}
+
+				return true;
+			}
+
+			void setCurrent(USHORT n)
+			{
+				current = n;
+			}
+
+		private:
+			Database* dbb;
+			Ods::pag** pages;
+			USHORT count;
+			Firebird::Array<UCHAR> staging;
+			UCHAR* buffer;
+			USHORT current;
+		};
 
-		if (bdb->bdb_flags & BDB_io_error)
+		Firebird::HalfStaticArray<Ods::pag*, WRITE_RUN> pagesArray;
+		Ods::pag** const pages = pagesArray.getBuffer(count);
+		GatherIO io(dbb, pages, count);
+
+		USHORT prepared = 0;
+
+		result = true;
+		for (; prepared < count && result; prepared++)
+		{
+			BufferDesc* const bdb = bdbs[prepared];
+			pag* const page = bdb->bdb_buffer;
+
+			CCH_TRACE(("WRITE   %d:%06d", bdb->bdb_page.getPageSpaceID(), bdb->bdb_page.getPageNum()));
+
+			page->pag_generation++;
+			page->pag_pageno = bdb->bdb_page.getPageNum();
+
+			pages[prepared] = page;
+			io.setCurrent(prepared);
+			result = dbb->dbb_crypto_manager->write(tdbb, status, page, &io);
+		}
+
+		if (result)
+		{
+			PageSpace* const pageSpace =
+				dbb->dbb_page_manager.findPageSpace(bdbs[0]->bdb_page.getPageSpaceID());
+			fb_assert(pageSpace);
+
+			result = PIO_write_batch(tdbb, pageSpace->file, bdbs, pages, count, status);
+		}
+
+		if (result)
 		{
-			// If a write error has cleared, signal background threads
-			// to resume their regular duties. If someone has freed up
-			// disk space these errors will spontaneously go away.
+			for (USHORT n = 0; n < count; )
+			{
+				USHORT length = 1;
+				while (n + length < count &&
+					bdbs[n + length]->bdb_page.getPageNum() == bdbs[n]->bdb_page.getPageNum() + length)
+				{
+					length++;
+				}
+
+				if (length > 1)
+				{
+					++bcb->bcb_vectored_writes;
+					bcb->bcb_vectored_pages += length;
+				}
+
+				n += length;
+			}
 
-			bdb->bdb_flags &= ~BDB_io_error;
-			dbb->dbb_flags &= ~DBB_suspend_bgio;
+			for (USHORT n = 0; n < count; n++)
+			{
+				BufferDesc* const bdb = bdbs[n];
+
+				tdbb->bumpStats(RuntimeStatistics::PAGE_WRITES);
+				bdb->bdb_flags &= ~BDB_db_dirty;
+				page_written(tdbb, bdb);
+
+				bdb->unLockIO(tdbb);
+				clear_precedence(tdbb, bdb);
+			}
+
+			return true;
 		}
+
+		// Pages are written one by one below and write_page increments
+		// their generations again, so undo our increments
+
+		for (USHORT n = 0; n < prepared; n++)
+			bdbs[n]->bdb_buffer->pag_generation--;
+
+		// Error is reported again if the page can't be written alone
+		status->init();
+	}
+
+	Firebird::HalfStaticArray<PageNumber, WRITE_RUN> pageNumbers;
+	for (USHORT n = 0; n < count; n++)
+	{
+		pageNumbers.add(bdbs[n]->bdb_page);
+		bdbs[n]->unLockIO(tdbb);
+	}
+
+	result = true;
+	for (USHORT n = 0; n < count; n++)
+	{
+		if (!write_buffer(tdbb, bdbs[n], pageNumbers[n], write_thru, status, true))
+			result = false;
 	}
 
 	return result;
@@ -5102,6 +6915,11 @@ static void clear_dirty_flag_and_nbak_state(thread_db* tdbb, BufferDesc* bdb)
 
 void recentlyUsed(BufferDesc* bdb)
 {
+	// Buffers of the cold que are not reordered, it is FIFO
+
+	if (bdb->bdb_cold)
+		return;
+
 	const AtomicCounter::counter_type oldFlags = bdb->bdb_flags.exchangeBitOr(BDB_lru_chained);
 	if (oldFlags & BDB_lru_chained)
 		return;
@@ -5156,8 +6974,13 @@ void requeueRecentlyUsed(BufferControl* bcb)
 	while ((bdb = reversed) != NULL)
 	{
 		reversed = bdb->bdb_lru_chain;
-		QUE_DELETE(bdb->bdb_in_use);
-		QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+
+		// Buffer could be moved into the cold que after it was chained
+		if (!bdb->bdb_cold)
+		{
+			QUE_DELETE(bdb->bdb_in_use);
+			QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+		}
 
 		bdb->bdb_lru_chain = NULL;
 		bdb->bdb_flags &= ~BDB_lru_chained;
@@ -5167,6 +6990,179 @@ void requeueRecentlyUsed(BufferControl* bcb)
 }
 
 
+void insertInUse(BufferControl* bcb, BufferDesc* bdb, const PageNumber page)
+{
+/**************************************
+ *
+ *	i n s e r t I n U s e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Put buffer just assigned to the page at the head of LRU que.
+ *	With 2Q policy page read for the first time goes into the cold
+ *	que, page evicted from the cold que recently goes into the main
+ *	que as it is used not by single scan only.
+ *	bcb_syncLRU must be locked by caller.
+ *
+ **************************************/
+	++bcb->bcb_misses;
+
+	bdb->bdb_cold = false;
+	if (bcb->bcb_policy == PAGE_CACHE_2Q)
+	{
+		if (bcb->bcb_ghosts.remove(page))
+			++bcb->bcb_ghost_hits;
+		else
+			bdb->bdb_cold = true;
+	}
+
+	if (bdb->bdb_cold)
+		bcb->bcb_cold_count++;
+
+	QUE_INSERT(inUseQue(bcb, bdb), bdb->bdb_in_use);
+}
+
+
+void removeInUse(BufferControl* bcb, BufferDesc* bdb)
+{
+	QUE_DELETE(bdb->bdb_in_use);
+
+	if (bdb->bdb_cold)
+	{
+		fb_assert(bcb->bcb_cold_count > 0);
+		bcb->bcb_cold_count--;
+		bdb->bdb_cold = false;
+	}
+}
+
+
+void setCacheLimits(BufferControl* bcb)
+{
+/**************************************
+ *
+ *	s e t C a c h e L i m i t s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Size 2Q queues after the number of buffers: cold que is kept
+ *	about 1/4 of cache, ghost list remembers 1/2 of cache pages.
+ *
+ **************************************/
+	if (bcb->bcb_policy != PAGE_CACHE_2Q)
+		return;
+
+	bcb->bcb_cold_limit = bcb->bcb_count / 4;
+	bcb->bcb_ghosts.resize(bcb->bcb_count / 2);
+}
+
+
+const ULONG GHOST_NONE = MAX_ULONG;
+const FB_UINT64 GHOST_EMPTY = MAX_UINT64;
+
+void GhostPages::resize(ULONG capacity)
+{
+	gp_entries.clear();
+	gp_hash.clear();
+	gp_next = 0;
+
+	if (!capacity)
+		return;
+
+	Entry* const entries = gp_entries.getBuffer(capacity);
+	ULONG* const hash = gp_hash.getBuffer(capacity);
+
+	for (ULONG i = 0; i < capacity; i++)
+	{
+		entries[i].key = GHOST_EMPTY;
+		entries[i].next = GHOST_NONE;
+		hash[i] = GHOST_NONE;
+	}
+}
+
+
+void GhostPages::add(const PageNumber& page)
+{
+	const ULONG capacity = gp_entries.getCount();
+	if (!capacity)
+		return;
+
+	// Reuse the oldest slot
+
+	const ULONG slot = gp_next;
+	gp_next = (gp_next + 1) % capacity;
+
+	if (gp_entries[slot].key != GHOST_EMPTY)
+		unlink(slot);
+
+	const FB_UINT64 key = getKey(page);
+	ULONG& head = gp_hash[key % capacity];
+
+	gp_entries[slot].key = key;
+	gp_entries[slot].next = head;
+	head = slot;
+}
+
+
+bool GhostPages::remove(const PageNumber& page)
+{
+	const ULONG capacity = gp_entries.getCount();
+	if (!capacity)
+		return false;
+
+	const FB_UINT64 key = getKey(page);
+
+	for (ULONG slot = gp_hash[key % capacity]; slot != GHOST_NONE; slot = gp_entries[slot].next)
+	{
+		if (gp_entries[slot].key == key)
+		{
+			unlink(slot);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void GhostPages::unlink(ULONG slot)
+{
+	Entry& entry = gp_entries[slot];
+	ULONG* ptr = &gp_hash[entry.key % gp_entries.getCount()];
+
+	while (*ptr != slot)
+	{
+		fb_assert(*ptr != GHOST_NONE);
+		ptr = &gp_entries[*ptr].next;
+	}
+
+	*ptr = entry.next;
+	entry.key = GHOST_EMPTY;
+	entry.next = GHOST_NONE;
+}
+
+
+SINT64 BufferControl::getHotHits() const
+{
+	SINT64 hits = 0;
+	for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+		hits += bcb_partitions[i].bcp_hot_hits.value();
+
+	return hits;
+}
+
+
+SINT64 BufferControl::getColdHits() const
+{
+	SINT64 hits = 0;
+	for (ULONG i = 0; i < BCB_HASH_PARTITIONS; i++)
+		hits += bcb_partitions[i].bcp_cold_hits.value();
+
+	return hits;
+}
+
+
 BufferControl* BufferControl::create(Database* dbb)
 {
 	MemoryPool* const pool = dbb->createPool();
@@ -5176,6 +7172,13 @@ BufferControl* BufferControl::create(Database* dbb)
 }
 
 
+BufferControl::~BufferControl()
+{
+	for (BcbThreadSync** iter = bcb_writers.begin(); iter != bcb_writers.end(); ++iter)
+		delete *iter;
+}
+
+
 void BufferControl::destroy(BufferControl* bcb)
 {
 	Database* const dbb = bcb->bcb_database;
@@ -5282,6 +7285,22 @@ void BufferDesc::lockIO(thread_db* tdbb)
 }
 
 
+bool BufferDesc::lockIOConditional(thread_db* tdbb)
+{
+	if (!bdb_syncIO.lockConditional(SYNC_EXCLUSIVE, FB_FUNCTION))
+		return false;
+
+	fb_assert(!bdb_io_locks && bdb_io != tdbb || bdb_io_locks && bdb_io == tdbb);
+
+	bdb_io = tdbb;
+	bdb_io->registerBdb(this);
+	++bdb_io_locks;
+	++bdb_use_count;
+
+	return true;
+}
+
+
 void BufferDesc::unLockIO(thread_db* tdbb)
 {
 	fb_assert(bdb_io && bdb_io == tdbb);
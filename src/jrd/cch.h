@@ -29,6 +29,7 @@
 #include "../common/classes/RefCounted.h"
 #include "../common/classes/semaphore.h"
 #include "../common/classes/SyncObject.h"
+#include "../common/classes/locks.h"
 #include "../common/ThreadStart.h"
 #ifdef SUPERSERVER_V2
 #include "../jrd/sbm.h"
@@ -73,6 +74,41 @@ const ULONG MAX_PAGE_BUFFERS = MAX_SLONG - 1;
 #endif
 
 
+// GhostPages -- numbers of pages recently evicted from the cold queue.
+// Used by 2Q replacement policy to detect pages which are re-referenced
+// soon after they have been dropped from cache (A1out queue in 2Q terms).
+
+class GhostPages
+{
+public:
+	explicit GhostPages(MemoryPool& p)
+		: gp_entries(p), gp_hash(p), gp_next(0)
+	{ }
+
+	void resize(ULONG capacity);
+	void add(const PageNumber& page);
+	bool remove(const PageNumber& page);
+
+private:
+	struct Entry
+	{
+		FB_UINT64	key;		// page space and page number, GHOST_EMPTY if slot is free
+		ULONG		next;		// next slot in hash chain
+	};
+
+	static FB_UINT64 getKey(const PageNumber& page)
+	{
+		return ((FB_UINT64) page.getPageSpaceID() << 32) | page.getPageNum();
+	}
+
+	void unlink(ULONG slot);
+
+	Firebird::Array<Entry>	gp_entries;		// ring of remembered pages, oldest at gp_next
+	Firebird::Array<ULONG>	gp_hash;		// heads of hash chains
+	ULONG					gp_next;		// slot to be reused by next add()
+};
+
+
 // BufferControl -- Buffer control block -- one per system
 
 struct bcb_repeat
@@ -81,16 +117,48 @@ struct bcb_repeat
 	que			bcb_page_mod;	// Que of buffers with page mod n
 };
 
+// Page hash table is split into partitions, each latched independently.
+// Hash slot n belongs to partition (n % BCB_HASH_PARTITIONS). Cache hit
+// latches only the partition of the page, not bcb_syncObject. Changes of
+// hash chains require both bcb_syncObject and the partition latched
+// exclusively, expand_buffers() latches all partitions.
+
+const ULONG BCB_HASH_PARTITIONS = 64;
+
+// Large block of memory partitioned into buffers. Blocks are allocated by the
+// buffer pool or, when huge pages or NUMA placement are requested, directly
+// by OS.
+
+struct bcb_extent
+{
+	UCHAR*		bce_memory;		// Start of the block
+	size_t		bce_size;		// Size of the block in bytes
+	size_t		bce_huge_page;	// Size of huge pages backing the block, 0 for normal pages
+	bool		bce_os;			// Allocated directly by OS
+};
+
+struct bcb_partition
+{
+	Firebird::SyncObject	bcp_sync;		// Latch for hash chains of the partition
+	Firebird::AtomicCounter	bcp_hot_hits;	// Page found in main LRU que
+	Firebird::AtomicCounter	bcp_cold_hits;	// Page found in cold que
+};
+
 class BufferControl : public pool_alloc<type_bcb>
 {
 	BufferControl(MemoryPool& p, Firebird::MemoryStats& parentStats)
 		: bcb_bufferpool(&p),
 		  bcb_memory_stats(&parentStats),
 		  bcb_memory(p),
-		  bcb_writer_fini(p, cache_writer, THREAD_medium)
+		  bcb_retired(p),
+		  bcb_ghosts(p),
+		  bcb_writers(p),
+		  bcb_prefetcher_fini(p, cache_prefetcher, THREAD_medium),
+		  bcb_prefetch_queue(p)
 	{
 		bcb_database = NULL;
 		QUE_INIT(bcb_in_use);
+		QUE_INIT(bcb_cold);
 		QUE_INIT(bcb_pending);
 		QUE_INIT(bcb_empty);
 		QUE_INIT(bcb_dirty);
@@ -103,6 +171,16 @@ class BufferControl : public pool_alloc<type_bcb>
 		bcb_prec_walk_mark = 0;
 		bcb_page_size = 0;
 		bcb_page_incarnation = 0;
+		bcb_policy = 0;
+		bcb_huge_pages = 0;
+		bcb_numa_policy = 0;
+		bcb_numa_nodes = 0;
+		bcb_numa_next = 0;
+		bcb_cold_count = 0;
+		bcb_cold_limit = 0;
+		bcb_prefetch_pages = 0;
+		bcb_warmup_interval = 0;
+		bcb_warmup_error = false;
 #ifdef SUPERSERVER_V2
 		bcb_prefetch = NULL;
 #endif
@@ -110,6 +188,8 @@ class BufferControl : public pool_alloc<type_bcb>
 
 public:
 
+	~BufferControl();
+
 	static BufferControl* create(Database* dbb);
 	static void destroy(BufferControl*);
 
@@ -118,8 +198,14 @@ public:
 	Firebird::MemoryPool* bcb_bufferpool;
 	Firebird::MemoryStats bcb_memory_stats;
 
-	UCharStack	bcb_memory;			// Large block partitioned into buffers
+	Firebird::Stack<bcb_extent>	bcb_memory;	// Large blocks partitioned into buffers
+	Firebird::Array<BufferDesc*>	bcb_retired;	// Descriptors of buffers removed by shrink_buffers
+	int			bcb_huge_pages;		// Memory pages for buffers, see HUGE_PAGES_XXX
+	int			bcb_numa_policy;	// Placement of buffers on NUMA nodes, see NUMA_POLICY_XXX
+	ULONG		bcb_numa_nodes;		// Number of NUMA nodes available
+	ULONG		bcb_numa_next;		// Node for the next extent with NUMA_POLICY_BIND
 	que			bcb_in_use;			// Que of buffers in use, main LRU que
+	que			bcb_cold;			// Que of buffers read once, FIFO (2Q policy only)
 	que			bcb_pending;		// Que of buffers which are going to be freed and reassigned
 	que			bcb_empty;			// Que of empty buffers
 
@@ -140,6 +226,20 @@ public:
 	ULONG		bcb_page_size;		// Database page size in bytes
 	ULONG		bcb_page_incarnation;	// Cache page incarnation counter
 
+	int			bcb_policy;			// Page replacement policy, PAGE_CACHE_LRU or PAGE_CACHE_2Q
+	ULONG		bcb_cold_count;		// Number of buffers in bcb_cold
+	ULONG		bcb_cold_limit;		// Cold que size to start reusing its buffers first
+	GhostPages	bcb_ghosts;			// Pages recently evicted from bcb_cold
+
+	// Page cache efficiency counters, hits are counted per hash partition
+	Firebird::AtomicCounter	bcb_ghost_hits;	// page read again soon after eviction from cold que
+	Firebird::AtomicCounter	bcb_misses;		// page not found in cache
+
+	bcb_partition	bcb_partitions[BCB_HASH_PARTITIONS];
+
+	SINT64 getHotHits() const;
+	SINT64 getColdHits() const;
+
 	Firebird::SyncObject	bcb_syncObject;
 	Firebird::SyncObject	bcb_syncDirtyBdbs;
 	Firebird::SyncObject	bcb_syncPrecedence;
@@ -148,10 +248,34 @@ public:
 
 	typedef ThreadFinishSync<BufferControl*> BcbThreadSync;
 
+	// Cache writers, every one writes its own batch of dirty buffers
 	static void cache_writer(BufferControl* bcb);
 	Firebird::Semaphore bcb_writer_sem;		// Wake up cache writer
 	Firebird::Semaphore bcb_writer_init;	// Cache writer initialization
-	BcbThreadSync bcb_writer_fini;			// Cache writer finalization
+	Firebird::Array<BcbThreadSync*> bcb_writers;	// Cache writers finalization
+	Firebird::AtomicCounter bcb_writer_count;		// Running cache writers
+
+	Firebird::AtomicCounter	bcb_writer_pages;		// pages written by cache writers
+	Firebird::AtomicCounter	bcb_vectored_writes;	// write requests for a run of adjacent pages
+	Firebird::AtomicCounter	bcb_vectored_pages;		// pages written by such requests
+	Firebird::AtomicCounter	bcb_writer_rate;		// pages per second written by cache writers
+	Firebird::AtomicCounter	bcb_writer_rate_pages;	// bcb_writer_pages when the rate was sampled
+	Firebird::AtomicCounter	bcb_writer_rate_stamp;	// time (in seconds) when the rate was sampled
+
+	// Read-ahead. Scans put numbers of pages they are going to read soon
+	// into bcb_prefetch_queue, cache prefetcher reads them in background.
+	static void cache_prefetcher(BufferControl* bcb);
+	Firebird::Semaphore bcb_prefetcher_sem;		// Wake up cache prefetcher
+	Firebird::Semaphore bcb_prefetcher_init;	// Cache prefetcher initialization
+	BcbThreadSync bcb_prefetcher_fini;			// Cache prefetcher finalization
+	Firebird::Mutex bcb_prefetch_mutex;			// Guards bcb_prefetch_queue
+	Firebird::SortedArray<FB_UINT64> bcb_prefetch_queue;	// Page space ID << 32 | page number
+	ULONG		bcb_prefetch_pages;		// Read-ahead window, 0 if read-ahead is disabled
+
+	// Cache warm-up. Cache prefetcher periodically saves numbers of the hottest
+	// pages into a file and reads them back into cache when database is opened.
+	ULONG		bcb_warmup_interval;	// Seconds between saves of hot pages, 0 if warm-up is disabled
+	bool		bcb_warmup_error;		// Failure to save hot pages is already logged
 #ifdef SUPERSERVER_V2
 	static void cache_reader(BufferControl* bcb);
 	// the code in cch.cpp is not tested for semaphore instead event !!!
@@ -168,8 +292,8 @@ public:
 };
 
 const int BCB_keep_pages	= 1;	// set during btc_flush(), pages not removed from dirty binary tree
-const int BCB_cache_writer	= 2;	// cache writer thread has been started
-const int BCB_writer_start  = 4;    // cache writer thread is starting now
+const int BCB_cache_writer	= 2;	// cache writer threads have been started
+const int BCB_writer_start  = 4;    // cache writer threads are starting now
 const int BCB_writer_active	= 8;	// no need to post writer event count
 #ifdef SUPERSERVER_V2
 const int BCB_cache_reader	= 16;	// cache reader thread has been started
@@ -177,6 +301,8 @@ const int BCB_reader_active	= 32;	// cache reader not blocked on event
 #endif
 const int BCB_free_pending	= 64;	// request cache writer to free pages
 const int BCB_exclusive		= 128;	// there is only BCB in whole system
+const int BCB_prefetcher	= 256;	// cache prefetcher thread has been started
+const int BCB_prefetcher_start = 512;	// cache prefetcher thread is starting now
 
 
 // BufferDesc -- Buffer descriptor block
@@ -205,6 +331,7 @@ public:
 		bdb_scan_count = 0;
 		bdb_difference_page = 0;
 		bdb_prec_walk_mark = 0;
+		bdb_cold = false;
 	}
 
 	bool addRef(thread_db* tdbb, Firebird::SyncType syncType, int wait = 1);
@@ -213,6 +340,7 @@ public:
 	void release(thread_db* tdbb, bool repost);
 
 	void lockIO(thread_db*);
+	bool lockIOConditional(thread_db*);
 	void unLockIO(thread_db*);
 
 	bool isLocked() const
@@ -260,6 +388,7 @@ public:
 	Firebird::AtomicCounter	bdb_scan_count;		// concurrent sequential scans
 	ULONG       bdb_difference_page;			// Number of page in difference file, NBAK
 	ULONG		bdb_prec_walk_mark;				// mark value used in precedence graph walk
+	bool		bdb_cold;						// buffer is in bcb_cold que
 };
 
 // bdb_flags
@@ -284,6 +413,7 @@ const int BDB_prefetch			= 0x4000;	// page has been prefetched but not yet refer
 const int BDB_no_blocking_ast	= 0x8000;	// No blocking AST registered with page lock
 const int BDB_lru_chained		= 0x10000;	// buffer is in pending LRU chain
 const int BDB_nbak_state_lock	= 0x20000;	// nbak state lock should be released after buffer is written
+const int BDB_writer_batch		= 0x40000;	// buffer is collected into a cache writer batch
 
 // bdb_ast_flags
 
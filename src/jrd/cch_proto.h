@@ -67,8 +67,10 @@ void		CCH_tra_precedence(Jrd::thread_db*, Jrd::win*, TraNumber traNum);
 void		CCH_prefetch(Jrd::thread_db*, SLONG*, SSHORT);
 bool		CCH_prefetch_pages(Jrd::thread_db*);
 #endif
+void		CCH_read_ahead(Jrd::thread_db*, USHORT, const ULONG*, FB_SIZE_T);
 void		CCH_release(Jrd::thread_db*, Jrd::win*, const bool);
 void		CCH_release_exclusive(Jrd::thread_db*);
+bool		CCH_resize(Jrd::thread_db*, ULONG);
 bool		CCH_rollover_to_shadow(Jrd::thread_db* tdbb, Jrd::Database* dbb, Jrd::jrd_file*, const bool);
 void		CCH_shutdown(Jrd::thread_db*);
 void		CCH_unwind(Jrd::thread_db*, const bool);
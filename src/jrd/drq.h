@@ -244,6 +244,10 @@ enum drq_type_t
 	drq_generator_exist,	// check if generator exists
 	drq_rel_field_exist,	// check if a field of relation or view exists
 	drq_m_coll_attrs,		// modify collation attributes
+	drq_e_col_stats,		// erase column statistics
+	drq_s_col_stats,		// store column statistics
+	drq_e_rel_col_stats,	// erase column statistics of relation
+	drq_e_fld_col_stats,	// erase column statistics of field
 
 	drq_MAX
 };
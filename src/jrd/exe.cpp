@@ -879,6 +879,13 @@ void EXE_start(thread_db* tdbb, jrd_req* request, jrd_tra* transaction)
 	request->req_flags |= req_active;
 	request->req_flags &= ~req_reserved;
 
+	// Let the record sources collect the actual figures for the detailed plan
+
+	request->req_profiles.clear();
+
+	if (request->req_attachment->att_flags & ATT_explain_analyze)
+		request->req_flags |= req_profile;
+
 	// set up to count records affected by request
 
 	request->req_records_selected = 0;
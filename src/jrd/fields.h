@@ -208,4 +208,6 @@
 
 	FIELD(fld_tz_db_version	, nam_tz_db_version	, dtype_varying	, 10						, dsc_text_type_ascii		, NULL		, true)
 
-	FIELD(fld_crypt_state	, nam_crypt_state	, dtype_short	, sizeof(SSHORT)			, 0							, NULL		, true)
\ No newline at end of file
+	FIELD(fld_crypt_state	, nam_crypt_state	, dtype_short	, sizeof(SSHORT)			, 0							, NULL		, true)
+
+	FIELD(fld_histogram		, nam_histogram		, dtype_blob	, BLOB_SIZE					, isc_blob_untyped			, NULL		, true)
\ No newline at end of file
@@ -279,6 +279,38 @@ void INF_database_info(thread_db* tdbb,
 			length = INF_convert(dbb->dbb_page_buffers, buffer);
 			break;
 
+		case fb_info_page_cache_hot_hits:
+			length = INF_convert(dbb->dbb_bcb->getHotHits(), buffer);
+			break;
+
+		case fb_info_page_cache_cold_hits:
+			length = INF_convert(dbb->dbb_bcb->getColdHits(), buffer);
+			break;
+
+		case fb_info_page_cache_ghost_hits:
+			length = INF_convert(dbb->dbb_bcb->bcb_ghost_hits.value(), buffer);
+			break;
+
+		case fb_info_page_cache_misses:
+			length = INF_convert(dbb->dbb_bcb->bcb_misses.value(), buffer);
+			break;
+
+		case fb_info_page_cache_writer_pages:
+			length = INF_convert(dbb->dbb_bcb->bcb_writer_pages.value(), buffer);
+			break;
+
+		case fb_info_page_cache_vectored_writes:
+			length = INF_convert(dbb->dbb_bcb->bcb_vectored_writes.value(), buffer);
+			break;
+
+		case fb_info_page_cache_vectored_pages:
+			length = INF_convert(dbb->dbb_bcb->bcb_vectored_pages.value(), buffer);
+			break;
+
+		case fb_info_page_cache_writer_rate:
+			length = INF_convert(dbb->dbb_bcb->bcb_writer_rate.value(), buffer);
+			break;
+
 		case isc_info_logfile:
 			length = INF_convert(FALSE, buffer);
 			break;
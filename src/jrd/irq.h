@@ -179,6 +179,7 @@ enum irq_type_t
 	irq_linger,				// get database linger value
 	irq_dbb_ss_definer,		// get database sql security value
 	irq_out_proc_param_dep,	// check output procedure parameter dependency
+	irq_l_col_stats,		// lookup column statistics
 
 	irq_MAX
 };
@@ -1760,8 +1760,9 @@ JAttachment* JProvider::internalAttach(CheckStatusWrapper* user_status, const ch
 				PageSpace* pageSpace = dbb->dbb_page_manager.findPageSpace(DB_PAGE_SPACE);
 				pageSpace->file = PIO_open(tdbb, expanded_name, org_filename);
 
-				// Initialize the lock manager
-				dbb->dbb_lock_mgr = LockManager::create(dbb->getUniqueFileId(), dbb->dbb_config);
+				// Initialize the lock manager, it's private unless the file could be shared
+				const bool exclusive = !(pageSpace->file->fil_flags & (FIL_sh_write | FIL_readonly));
+				dbb->dbb_lock_mgr = LockManager::create(dbb->getUniqueFileId(), dbb->dbb_config, exclusive);
 
 				// Initialize locks
 				LCK_init(tdbb, LCK_OWNER_database);
@@ -2100,13 +2101,17 @@ JAttachment* JProvider::internalAttach(CheckStatusWrapper* user_status, const ch
 				if (dbb->dbb_flags & DBB_shared)
 					validateAccess(tdbb, attachment, CHANGE_HEADER_SETTINGS);
 
-				CCH_expand(tdbb, options.dpb_page_buffers);
+				// Any attachment may ask for a bigger cache, but only those
+				// allowed to change the header settings may shrink it
 
 				if (attachment->locksmith(tdbb, CHANGE_HEADER_SETTINGS))
 				{
+					CCH_resize(tdbb, options.dpb_page_buffers);
 					PAG_set_page_buffers(tdbb, options.dpb_page_buffers);
 					dbb->dbb_linger_seconds = 0;
 				}
+				else
+					CCH_expand(tdbb, options.dpb_page_buffers);
 			}
 
 			if (options.dpb_set_db_readonly)
@@ -2957,8 +2962,9 @@ JAttachment* JProvider::createDatabase(CheckStatusWrapper* user_status, const ch
 			os_utils::getUniqueFileId(dbb->dbb_filename.c_str(), dbb->dbb_id);
 #endif
 
-			// Initialize the lock manager
-			dbb->dbb_lock_mgr = LockManager::create(dbb->getUniqueFileId(), dbb->dbb_config);
+			// Initialize the lock manager, it's private unless the file could be shared
+			const bool exclusive = !(pageSpace->file->fil_flags & (FIL_sh_write | FIL_readonly));
+			dbb->dbb_lock_mgr = LockManager::create(dbb->getUniqueFileId(), dbb->dbb_config, exclusive);
 
 			// Initialize locks
 			LCK_init(tdbb, LCK_OWNER_database);
@@ -8825,15 +8831,20 @@ bool thread_db::reschedule(SLONG quantum, bool punt)
 	if (checkCancelState(punt))
 		return true;
 
-	{	// checkout scope
-		EngineCheckout cout(this, FB_FUNCTION);
-		Thread::yield();
-	}
+	// A parallel worker leaves the attachment to the leading thread
 
-	if (checkCancelState(punt))
-		return true;
+	if (!(tdbb_flags & TDBB_parallel_worker))
+	{
+		{	// checkout scope
+			EngineCheckout cout(this, FB_FUNCTION);
+			Thread::yield();
+		}
 
-	Monitoring::checkState(this);
+		if (checkCancelState(punt))
+			return true;
+
+		Monitoring::checkState(this);
+	}
 
 	tdbb_quantum = (tdbb_quantum <= 0) ?
 		(quantum ? quantum : QUANTUM) : tdbb_quantum;
@@ -490,6 +490,7 @@ const ULONG TDBB_reset_stack			= 4096;		// stack should be reset after stack ove
 const ULONG TDBB_dfw_cleanup			= 8192;		// DFW cleanup phase is active
 const ULONG TDBB_repl_sql				= 16384;	// SQL statement is being replicated
 const ULONG TDBB_replicator				= 32768;	// Replicator
+const ULONG TDBB_parallel_worker		= 65536;	// Helper of a parallel scan, the attachment is held by the leading thread
 
 class thread_db : public Firebird::ThreadData
 {
@@ -600,6 +601,14 @@ public:
 
 	void setRequest(jrd_req* val);
 
+	// A parallel worker counts its statistics in the request clone only,
+	// the leading thread adds them to the shared objects when it's done
+	void setWorkerRequest(jrd_req* val)
+	{
+		setRequest(val);
+		traStat = attStat = RuntimeStatistics::getDummy();
+	}
+
 	SSHORT getCharSet() const;
 
 	void bumpStats(const RuntimeStatistics::StatType index, SINT64 delta = 1)
@@ -620,9 +629,10 @@ public:
 
 		const RuntimeStatistics* const dummyStat = RuntimeStatistics::getDummy();
 
-		// We expect that at least attStat is present (not a dummy object)
+		// We expect that at least attStat is present (not a dummy object),
+		// unless the counters of a parallel worker are collected by its request
 
-		fb_assert(attStat != dummyStat);
+		fb_assert(attStat != dummyStat || (tdbb_flags & TDBB_parallel_worker));
 
 		// Relation statistics is a quite complex beast, so a conditional check
 		// does not hurt. It also allows to avoid races while accessing the static
@@ -1047,10 +1057,11 @@ namespace Jrd {
 		{
 			Attachment* const att = tdbb ? tdbb->getAttachment() : NULL;
 
-			if (att)
+			// A parallel worker doesn't own the attachment mutex
+			if (att && !(tdbb->tdbb_flags & TDBB_parallel_worker))
 				m_ref = att->getStable();
 
-			fb_assert(optional || m_ref.hasData());
+			fb_assert(optional || m_ref.hasData() || (tdbb && (tdbb->tdbb_flags & TDBB_parallel_worker)));
 
 			if (m_ref.hasData())
 				m_ref->getMutex()->leave();
@@ -46,6 +46,7 @@ namespace Jrd
 	class DeferredWork;
 	struct FieldInfo;
 	class ExceptionItem;
+	class ColumnStatistics;
 
 	// index status
 	enum IndexStatus
@@ -85,6 +86,7 @@ void		MET_error(const TEXT*, ...);
 Jrd::Format*	MET_format(Jrd::thread_db*, Jrd::jrd_rel*, USHORT);
 bool		MET_get_char_coll_subtype(Jrd::thread_db*, USHORT*, const UCHAR*, USHORT);
 bool		MET_get_char_coll_subtype_info(Jrd::thread_db*, USHORT, SubtypeInfo* info);
+const Jrd::ColumnStatistics*	MET_get_column_statistics(Jrd::thread_db*, Jrd::jrd_rel*, USHORT);
 Jrd::DmlNode*	MET_get_dependencies(Jrd::thread_db*, Jrd::jrd_rel*, const UCHAR*, const ULONG,
 								Jrd::CompilerScratch*, Jrd::bid*, Jrd::JrdStatement**,
 								Jrd::CompilerScratch**, const Firebird::MetaName&, int, USHORT,
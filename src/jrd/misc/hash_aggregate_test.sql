@@ -0,0 +1,98 @@
+/*
+ *	PROGRAM:		JRD Access Method
+ *	MODULE:			hash_aggregate_test.sql
+ *	DESCRIPTION:	Tests for the hashed GROUP BY
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+/*
+ * Run with "isql -q -i hash_aggregate_test.sql", every result should be "passed".
+ *
+ * Unless the order of the groups is needed, GROUP BY collects the groups in a hash table
+ * (the plan shows "Aggregate (hash)"). The groups and the aggregate values are checked
+ * against the values known in advance and against the sort based aggregation.
+ */
+
+set names utf8;
+
+create database 'hash_aggregate_test.fdb' default character set utf8;
+
+create table t
+(
+	id integer,
+	k integer,
+	s varchar(10) collate unicode_ci,
+	l varchar(8000) collate unicode_ci,
+	v integer
+);
+
+set term !;
+
+-- 1000 groups of 100 rows, the group of the key 999 is NULL
+execute block
+as
+	declare i integer = 0;
+begin
+	while (i < 100000) do
+	begin
+		insert into t (id, k, s, l, v)
+			values (:i, nullif(mod(:i, 1000), 999),
+				iif(mod(:i, 2) = 0, 'KEY ', 'key ') || mod(:i, 37),
+				rpad('', 7990, 'abcdefghij') || mod(:i, 5),
+				:i);
+		i = i + 1;
+	end
+end!
+
+set term ;!
+
+commit;
+
+set explain on;
+
+select iif(count(*) = 1000, 'passed', 'failed') as "groups"
+	from (select k from t group by k);
+
+select iif(count(*) = 0, 'passed', 'failed') as "aggregate values"
+	from (select k, count(*) cnt, sum(v) total, min(v) lo, max(v) hi, avg(v) mean
+			from t group by k) g
+	where g.cnt <> 100 or
+		g.total <> 100 * coalesce(g.k, 999) + 4950000 or
+		g.lo <> coalesce(g.k, 999) or
+		g.hi <> coalesce(g.k, 999) + 99000 or
+		g.mean <> coalesce(g.k, 999) + 49500;
+
+-- Case insensitive keys are grouped by their collation keys
+select iif(count(*) = 37 and min(cnt) = 2702 and max(cnt) = 2703, 'passed', 'failed') as "string groups"
+	from (select s, count(*) cnt from t group by s);
+
+-- The keys too long for the hash table are aggregated sorted
+select iif(count(*) = 5 and min(cnt) = 20000 and max(cnt) = 20000, 'passed', 'failed') as "long string groups"
+	from (select l, count(*) cnt from t group by l);
+
+-- The same groups are built by the sort based aggregation
+select iif(count(*) = 0, 'passed', 'failed') as "hash vs sort"
+	from (select k, s, count(*) cnt, sum(v) total, max(v) hi from t group by k, s) h
+	full join
+		(select k, s, count(*) cnt, sum(v) total, max(v) hi from t group by k, s order by k, s) o
+		on h.k is not distinct from o.k and h.s = o.s
+	where h.cnt is distinct from o.cnt or
+		h.total is distinct from o.total or
+		h.hi is distinct from o.hi;
+
+set explain off;
+
+drop database;
@@ -416,6 +416,8 @@ NAME("MON$IDLE_TIMEOUT", nam_idle_timeout)
 NAME("MON$IDLE_TIMER", nam_idle_timer)
 NAME("MON$STATEMENT_TIMEOUT", nam_stmt_timeout)
 NAME("MON$STATEMENT_TIMER", nam_stmt_timer)
+NAME("MON$TEMP_GRANTED", nam_temp_granted)
+NAME("MON$TEMP_SPILLED", nam_temp_spilled)
 
 NAME("MON$WIRE_COMPRESSED", nam_wire_compressed)
 NAME("MON$WIRE_ENCRYPTED", nam_wire_encrypted)
@@ -427,3 +429,9 @@ NAME("RDB$TIME_ZONE_NAME", nam_tz_name)
 NAME("RDB$TIME_ZONE_OFFSET", nam_tz_offset)
 NAME("RDB$TIMESTAMP_TZ", nam_timestamp_tz)
 NAME("RDB$DBTZ_VERSION", nam_tz_db_version)
+
+NAME("RDB$COLUMN_STATISTICS", nam_column_stats)
+NAME("RDB$RECORD_COUNT", nam_record_count)
+NAME("RDB$DISTINCT_VALUES", nam_distinct_values)
+NAME("RDB$NULL_FRACTION", nam_null_fraction)
+NAME("RDB$HISTOGRAM", nam_histogram)
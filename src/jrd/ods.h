@@ -125,7 +125,9 @@ const USHORT ODS_CURRENT12		= 0;
 // Minor versions for ODS 13
 
 const USHORT ODS_CURRENT13_0	= 0;	// Firebird 4.0 features
-const USHORT ODS_CURRENT13		= 0;
+const USHORT ODS_CURRENT13_1	= 1;	// Temporary space counters in MON$STATEMENTS,
+										// RDB$COLUMN_STATISTICS
+const USHORT ODS_CURRENT13		= 1;
 
 // useful ODS macros. These are currently used to flag the version of the
 // system triggers and system indices in ini.e
@@ -146,6 +148,7 @@ const USHORT ODS_11_1		= ENCODE_ODS(ODS_VERSION11, 1);
 const USHORT ODS_11_2		= ENCODE_ODS(ODS_VERSION11, 2);
 const USHORT ODS_12_0		= ENCODE_ODS(ODS_VERSION12, 0);
 const USHORT ODS_13_0		= ENCODE_ODS(ODS_VERSION13, 0);
+const USHORT ODS_13_1		= ENCODE_ODS(ODS_VERSION13, 1);
 
 const USHORT ODS_FIREBIRD_FLAG = 0x8000;
 
@@ -173,7 +176,7 @@ const USHORT ODS_RELEASED = ODS_CURRENT13_0;	// The lowest stable minor version
 const USHORT ODS_CURRENT = ODS_CURRENT13;		// The highest defined minor version
 												// number for this ODS_VERSION!
 
-const USHORT ODS_CURRENT_VERSION = ODS_13_0;	// Current ODS version in use which includes
+const USHORT ODS_CURRENT_VERSION = ODS_13_1;	// Current ODS version in use which includes
 												// both major and minor ODS versions!
 
 
@@ -112,6 +112,15 @@ namespace
 			*node1 = (*node1) ? FB_NEW_POOL(pool) BinaryBoolNode(pool, blr_and, *node1, node2) : node2;
 	}
 
+	// Checks that the FIRST / SKIP value is the same whenever it's evaluated
+	// during the request execution
+
+	inline bool isConstantLimit(const ValueExprNode* node)
+	{
+		return nodeIs<LiteralNode>(node) || nodeIs<ParameterNode>(node) ||
+			nodeIs<VariableNode>(node);
+	}
+
 	class River
 	{
 	public:
@@ -326,11 +335,19 @@ static void gen_join(thread_db* tdbb, OptimizerBlk* opt, const StreamList& strea
 	RiverList& river_list, SortNode** sort_clause, PlanNode* plan_clause);
 static RecordSource* gen_outer(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
 	RiverList& river_list, SortNode** sort_clause);
+static RecordSource* gen_outer_join(thread_db* tdbb, OptimizerBlk* opt, JoinType joinType,
+	RecordSource* outer_rsb, RecordSource* inner_rsb, StreamType inner_stream, BoolExprNode* boolean);
+static RecordSource* gen_probe(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
+	const StreamList& streams, RecordSource* prior_rsb);
 static RecordSource* gen_residual_boolean(thread_db* tdbb, OptimizerBlk* opt, RecordSource* prior_rsb);
 static RecordSource* gen_retrieval(thread_db* tdbb, OptimizerBlk* opt, StreamType stream,
 	SortNode** sort_ptr, bool outer_flag, bool inner_flag, BoolExprNode** return_boolean);
 static bool gen_equi_join(thread_db*, OptimizerBlk*, RiverList&);
 static double get_cardinality(thread_db*, jrd_rel*, const Format*);
+static bool get_hash_keys(thread_db*, OptimizerBlk*, StreamType, NestValueArray**, NestValueArray**);
+static BoolExprNode* get_residual_boolean(thread_db*, OptimizerBlk*);
+static bool is_probe_invariant(const ExprNode*, StreamType);
+static bool make_binary_comparable(thread_db*, CompilerScratch*, ValueExprNode**, ValueExprNode**);
 static BoolExprNode* make_inference_node(CompilerScratch*, BoolExprNode*, ValueExprNode*, ValueExprNode*);
 static bool map_equal(const ValueExprNode*, const ValueExprNode*, const MapNode*);
 static void mark_indices(CompilerScratch::csb_repeat* csbTail, SSHORT relationId);
@@ -435,12 +452,22 @@ string OPT_get_plan(thread_db* tdbb, const jrd_req* request, bool detailed)
  *
  * Functional description
  *	Returns a formatted textual plan for all RseNode's in the specified request.
+ *	The detailed plan of a request executed with EXPLAIN ANALYZE shows
+ *	the actual figures of the record sources as well.
  *
  **************************************/
 	string plan;
 
 	if (request)
 	{
+		// Record sources look for their figures in the current request,
+		// the requests of other attachments are never shown profiled
+		jrd_req* const current = (request->req_attachment == tdbb->getAttachment()) ?
+			const_cast<jrd_req*>(request) : NULL;
+
+		AutoSetRestore2<jrd_req*, thread_db> autoRequest(tdbb,
+			&thread_db::getRequest, &thread_db::setRequest, current);
+
 		const Array<const RecordSource*>& fors = request->getStatement()->fors;
 
 		for (FB_SIZE_T i = 0; i < fors.getCount(); i++)
@@ -784,6 +811,11 @@ RecordSource* OPT_compile(thread_db* tdbb, CompilerScratch* csb, RseNode* rse,
 
 		rsb = CrossJoin(csb, rivers).getRecordSource();
 
+		// A correlated subquery scanning its table for every outer record
+		// may rather probe a hash table built from the table once
+		if (rivers.getCount() == 1 && !orgSortNode && !project)
+			rsb = gen_probe(tdbb, opt, rse, rseStreams, rsb);
+
 		// Pick up any residual boolean that may have fallen thru the cracks
 		rsb = gen_residual_boolean(tdbb, opt, rsb);
 	}
@@ -832,7 +864,22 @@ RecordSource* OPT_compile(thread_db* tdbb, CompilerScratch* csb, RseNode* rse,
 
 		// Handle sort clause if present
 		if (sort)
-			rsb = OPT_gen_sort(tdbb, opt->opt_csb, opt->beds, &opt->keyStreams, rsb, sort, false);
+		{
+			SortedStream* const sortRsb =
+				OPT_gen_sort(tdbb, opt->opt_csb, opt->beds, &opt->keyStreams, rsb, sort, false);
+
+			// If only the first sorted records are fetched, the sort may drop the
+			// others right away. The limits are evaluated again when the sort is
+			// opened, so they must be constants or parameters.
+
+			if (rse->rse_first && isConstantLimit(rse->rse_first) &&
+				(!rse->rse_skip || isConstantLimit(rse->rse_skip)))
+			{
+				sortRsb->setLimit(rse->rse_first, rse->rse_skip);
+			}
+
+			rsb = sortRsb;
+		}
 	}
 
     // Handle first and/or skip.  The skip MUST (if present)
@@ -1083,6 +1130,7 @@ static void check_sorts(CompilerScratch* csb, RseNode* rse)
 			{
 				set_direction(project, group);
 				project = rse->rse_projection = NULL;
+				static_cast<AggregateSourceNode*>(sub_rse)->ordered = true;
 			}
 		}
 
@@ -1119,6 +1167,7 @@ static void check_sorts(CompilerScratch* csb, RseNode* rse)
 				set_direction(sort, group);
 				set_position(sort, group, static_cast<AggregateSourceNode*>(sub_rse)->map);
 				sort = rse->rse_sorted = NULL;
+				static_cast<AggregateSourceNode*>(sub_rse)->ordered = true;
 			}
 		}
 
@@ -2096,22 +2145,21 @@ static RecordSource* gen_outer(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
 												true, false, &boolean);
 		}
 
+		StreamType innerStream = INVALID_STREAM;
+
 		if (!stream_i.stream_rsb)
 		{
 			// AB: the sort clause for the inner stream of an OUTER JOIN
 			//	   should never be used for the index retrieval
 			stream_i.stream_rsb =
 				gen_retrieval(tdbb, opt, stream_i.stream_num, NULL, false, true, NULL);
+			innerStream = stream_i.stream_num;
 		}
 
-		// generate a parent boolean rsb for any remaining booleans that
-		// were not satisfied via an index lookup
-		stream_i.stream_rsb = gen_residual_boolean(tdbb, opt, stream_i.stream_rsb);
-
-		// Allocate and fill in the rsb
-		return FB_NEW_POOL(*tdbb->getDefaultPool())
-			NestedLoopJoin(csb, stream_o.stream_rsb, stream_i.stream_rsb,
-						   boolean, OUTER_JOIN);
+		// Join the sub-streams, any remaining booleans that
+		// were not satisfied via an index lookup are applied there
+		return gen_outer_join(tdbb, opt, OUTER_JOIN, stream_o.stream_rsb, stream_i.stream_rsb,
+							  innerStream, boolean);
 	}
 
 	bool hasOuterRsb = true, hasInnerRsb = true;
@@ -2131,10 +2179,9 @@ static RecordSource* gen_outer(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
 			gen_retrieval(tdbb, opt, stream_i.stream_num, NULL, false, true, NULL);
 	}
 
-	RecordSource* const innerRsb = gen_residual_boolean(tdbb, opt, stream_i.stream_rsb);
-
-	RecordSource* const rsb1 = FB_NEW_POOL(*tdbb->getDefaultPool())
-		NestedLoopJoin(csb, stream_o.stream_rsb, innerRsb, boolean, OUTER_JOIN);
+	RecordSource* const rsb1 = gen_outer_join(tdbb, opt, OUTER_JOIN,
+		stream_o.stream_rsb, stream_i.stream_rsb,
+		hasInnerRsb ? INVALID_STREAM : stream_i.stream_num, boolean);
 
 	for (FB_SIZE_T i = 0; i < opt->opt_conjuncts.getCount(); i++)
 	{
@@ -2166,15 +2213,126 @@ static RecordSource* gen_outer(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
 			gen_retrieval(tdbb, opt, stream_o.stream_num, NULL, false, false, NULL);
 	}
 
-	RecordSource* const outerRsb = gen_residual_boolean(tdbb, opt, stream_o.stream_rsb);
-
-	RecordSource* const rsb2 = FB_NEW_POOL(*tdbb->getDefaultPool())
-		NestedLoopJoin(csb, stream_i.stream_rsb, outerRsb, boolean, ANTI_JOIN);
+	RecordSource* const rsb2 = gen_outer_join(tdbb, opt, ANTI_JOIN,
+		stream_i.stream_rsb, stream_o.stream_rsb,
+		hasOuterRsb ? INVALID_STREAM : stream_o.stream_num, boolean);
 
 	return FB_NEW_POOL(*tdbb->getDefaultPool()) FullOuterJoin(csb, rsb1, rsb2);
 }
 
 
+static RecordSource* gen_outer_join(thread_db* tdbb, OptimizerBlk* opt, JoinType joinType,
+	RecordSource* outer_rsb, RecordSource* inner_rsb, StreamType inner_stream, BoolExprNode* boolean)
+{
+/**************************************
+ *
+ *	g e n _ o u t e r _ j o i n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Join the outer sub-stream to the inner one. If the inner
+ *	stream is a table that is not retrieved via an index
+ *	depending on the outer stream, hash it by the equalities
+ *	with the outer stream rather than scanning it for every
+ *	outer record.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	DEV_BLKCHK(opt, type_opt);
+
+	CompilerScratch* const csb = opt->opt_csb;
+	NestValueArray* outerKeys;
+	NestValueArray* innerKeys;
+
+	if (inner_stream != INVALID_STREAM &&
+		get_hash_keys(tdbb, opt, inner_stream, &outerKeys, &innerKeys))
+	{
+		// The equalities are not exact due to hash collisions and NULLs,
+		// so they are verified along with the other remaining booleans
+		BoolExprNode* const residual = get_residual_boolean(tdbb, opt);
+
+		return FB_NEW_POOL(*tdbb->getDefaultPool())
+			HashJoin(tdbb, csb, joinType, outer_rsb, inner_rsb,
+					 outerKeys, innerKeys, boolean, residual);
+	}
+
+	inner_rsb = gen_residual_boolean(tdbb, opt, inner_rsb);
+
+	return FB_NEW_POOL(*tdbb->getDefaultPool())
+		NestedLoopJoin(csb, outer_rsb, inner_rsb, boolean, joinType);
+}
+
+
+static RecordSource* gen_probe(thread_db* tdbb, OptimizerBlk* opt, RseNode* rse,
+	const StreamList& streams, RecordSource* prior_rsb)
+{
+/**************************************
+ *
+ *	g e n _ p r o b e
+ *
+ **************************************
+ *
+ * Functional description
+ *	A single table RseNode correlated to the outer streams
+ *	by equalities not satisfied via an index scans the table
+ *	whenever it's opened, what is typical for EXISTS, IN or
+ *	NOT EXISTS subqueries. Hash the table just once per open of
+ *	the enclosing top-level cursor instead, the equalities are
+ *	then probed. Subqueries outside of any cursor are evaluated
+ *	once per statement execution, there is nothing to cache.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	DEV_BLKCHK(opt, type_opt);
+
+	CompilerScratch* const csb = opt->opt_csb;
+
+	if (csb->csb_current_nodes.isEmpty() || !nodeIs<RseNode>(csb->csb_current_nodes[0]) ||
+		rse->rse_jointype != blr_inner || rse->rse_plan ||
+		rse->rse_first || rse->rse_skip || rse->rse_aggregate ||
+		(rse->flags & (RseNode::FLAG_WRITELOCK | RseNode::FLAG_SCROLLABLE)) ||
+		streams.getCount() != 1 || rse->rse_relations.getCount() != 1 ||
+		rse->rse_relations[0]->type != RelationSourceNode::TYPE)
+	{
+		return prior_rsb;
+	}
+
+	const StreamType stream = streams[0];
+	const jrd_rel* const relation = csb->csb_rpt[stream].csb_relation;
+
+	if (!relation || relation->rel_file || relation->isVirtual())
+		return prior_rsb;
+
+	// The table is read once per execution, so the statement must not change data
+	// and the booleans applied while reading it must not depend on anything else
+
+	for (StreamType i = 0; i < csb->csb_n_stream; i++)
+	{
+		if (csb->csb_rpt[i].csb_flags & (csb_store | csb_modify | csb_erase | csb_update))
+			return prior_rsb;
+	}
+
+	for (FB_SIZE_T i = 0; i < opt->opt_conjuncts.getCount(); i++)
+	{
+		if ((opt->opt_conjuncts[i].opt_conjunct_flags & opt_conjunct_used) &&
+			!is_probe_invariant(opt->opt_conjuncts[i].opt_conjunct_node, stream))
+		{
+			return prior_rsb;
+		}
+	}
+
+	NestValueArray* outerKeys;
+	NestValueArray* innerKeys;
+
+	if (!get_hash_keys(tdbb, opt, stream, &outerKeys, &innerKeys))
+		return prior_rsb;
+
+	return FB_NEW_POOL(*tdbb->getDefaultPool())
+		HashJoin(tdbb, csb, INNER_JOIN, NULL, prior_rsb, outerKeys, innerKeys, NULL, NULL);
+}
+
+
 static RecordSource* gen_residual_boolean(thread_db* tdbb, OptimizerBlk* opt, RecordSource* prior_rsb)
 {
 /**************************************
@@ -2194,20 +2352,7 @@ static RecordSource* gen_residual_boolean(thread_db* tdbb, OptimizerBlk* opt, Re
 	DEV_BLKCHK(opt, type_opt);
 	DEV_BLKCHK(prior_rsb, type_rsb);
 
-	BoolExprNode* boolean = NULL;
-	const OptimizerBlk::opt_conjunct* const opt_end =
-		opt->opt_conjuncts.begin() + opt->opt_base_conjuncts;
-
-	for (OptimizerBlk::opt_conjunct* tail = opt->opt_conjuncts.begin(); tail < opt_end; tail++)
-	{
-		BoolExprNode* node = tail->opt_conjunct_node;
-
-		if (!(tail->opt_conjunct_flags & opt_conjunct_used))
-		{
-			compose(*tdbb->getDefaultPool(), &boolean, node);
-			tail->opt_conjunct_flags |= opt_conjunct_used;
-		}
-	}
+	BoolExprNode* const boolean = get_residual_boolean(tdbb, opt);
 
 	return boolean ?
 		FB_NEW_POOL(*tdbb->getDefaultPool()) FilteredStream(opt->opt_csb, prior_rsb, boolean) :
@@ -2511,6 +2656,10 @@ SortedStream* OPT_gen_sort(thread_db* tdbb, CompilerScratch* csb, const StreamLi
 	if (sort->unique)
 		map->flags |= SortedStream::FLAG_UNIQUE;
 
+	// The largest stream is a rough guess of the number of records to sort
+	for (const StreamType* ptr = streams.begin(); ptr < end_ptr; ptr++)
+		map->cardinality = MAX(map->cardinality, csb->csb_rpt[*ptr].csb_cardinality);
+
     sort_key_def* prev_key = nullptr;
 
 	// Loop thru sort keys building sort keys.  Actually, to handle null values
@@ -2792,36 +2941,10 @@ static bool gen_equi_join(thread_db* tdbb, OptimizerBlk* opt, RiverList& org_riv
 		ValueExprNode* node1 = cmpNode->arg1;
 		ValueExprNode* node2 = cmpNode->arg2;
 
-		dsc result, desc1, desc2;
-		node1->getDesc(tdbb, csb, &desc1);
-		node2->getDesc(tdbb, csb, &desc2);
-
 		// Ensure that arguments can be compared in the binary form
-		if (!CVT2_get_binary_comparable_desc(&result, &desc1, &desc2))
+		if (!make_binary_comparable(tdbb, csb, &node1, &node2))
 			continue;
 
-		// Cast the arguments, if required
-		if (!DSC_EQUIV(&result, &desc1, true) || !DSC_EQUIV(&result, &desc2, true))
-		{
-			if (!DSC_EQUIV(&result, &desc1, true))
-			{
-				CastNode* cast = FB_NEW_POOL(*tdbb->getDefaultPool()) CastNode(*tdbb->getDefaultPool());
-				cast->source = node1;
-				cast->castDesc = result;
-				cast->impureOffset = CMP_impure(csb, sizeof(impure_value));
-				node1 = cast;
-			}
-
-			if (!DSC_EQUIV(&result, &desc2, true))
-			{
-				CastNode* cast = FB_NEW_POOL(*tdbb->getDefaultPool()) CastNode(*tdbb->getDefaultPool());
-				cast->source = node2;
-				cast->castDesc = result;
-				cast->impureOffset = CMP_impure(csb, sizeof(impure_value));
-				node2 = cast;
-			}
-		}
-
 		USHORT number1 = 0;
 
 		for (River** iter1 = org_rivers.begin(); iter1 < org_rivers.end(); iter1++, number1++)
@@ -3072,6 +3195,205 @@ static double get_cardinality(thread_db* tdbb, jrd_rel* relation, const Format*
 }
 
 
+static bool get_hash_keys(thread_db* tdbb, OptimizerBlk* opt, StreamType stream,
+	NestValueArray** outer_keys, NestValueArray** inner_keys)
+{
+/**************************************
+ *
+ *	g e t _ h a s h _ k e y s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Find the unused equalities between the given stream
+ *	and the other active streams, they're the keys to hash
+ *	the stream with. The equalities are left unused, so
+ *	they're still verified for the hashed records.
+ *
+ **************************************/
+	DEV_BLKCHK(opt, type_opt);
+	SET_TDBB(tdbb);
+
+	MemoryPool& pool = *tdbb->getDefaultPool();
+	CompilerScratch* const csb = opt->opt_csb;
+
+	*outer_keys = *inner_keys = NULL;
+
+	const OptimizerBlk::opt_conjunct* const end =
+		opt->opt_conjuncts.begin() + opt->opt_base_conjuncts;
+
+	for (const OptimizerBlk::opt_conjunct* tail = opt->opt_conjuncts.begin(); tail < end; tail++)
+	{
+		BoolExprNode* const node = tail->opt_conjunct_node;
+
+		if ((tail->opt_conjunct_flags & opt_conjunct_used) || (node->nodFlags & ExprNode::FLAG_RESIDUAL))
+			continue;
+
+		ComparativeBoolNode* const cmpNode = nodeAs<ComparativeBoolNode>(node);
+
+		if (!cmpNode || (cmpNode->blrOp != blr_eql && cmpNode->blrOp != blr_equiv))
+			continue;
+
+		ValueExprNode* inner = cmpNode->arg1;
+		ValueExprNode* outer = cmpNode->arg2;
+
+		if (!inner->findStream(csb, stream))
+		{
+			ValueExprNode* const temp = inner;
+			inner = outer;
+			outer = temp;
+		}
+
+		// One side must depend on the stream alone, the other one must be
+		// computable without it
+
+		SortedStreamList innerStreams;
+		inner->collectStreams(csb, innerStreams);
+
+		if (innerStreams.getCount() != 1 || innerStreams[0] != stream ||
+			!outer->computable(csb, stream, false))
+		{
+			continue;
+		}
+
+		if (!make_binary_comparable(tdbb, csb, &outer, &inner))
+			continue;
+
+		if (!*inner_keys)
+		{
+			*outer_keys = FB_NEW_POOL(pool) NestValueArray(pool);
+			*inner_keys = FB_NEW_POOL(pool) NestValueArray(pool);
+		}
+
+		(*outer_keys)->add(outer);
+		(*inner_keys)->add(inner);
+	}
+
+	return (*inner_keys != NULL);
+}
+
+
+static BoolExprNode* get_residual_boolean(thread_db* tdbb, OptimizerBlk* opt)
+{
+/**************************************
+ *
+ *	g e t _ r e s i d u a l _ b o o l e a n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Compose the base conjuncts not used yet
+ *	and mark them used.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	DEV_BLKCHK(opt, type_opt);
+
+	BoolExprNode* boolean = NULL;
+	const OptimizerBlk::opt_conjunct* const opt_end =
+		opt->opt_conjuncts.begin() + opt->opt_base_conjuncts;
+
+	for (OptimizerBlk::opt_conjunct* tail = opt->opt_conjuncts.begin(); tail < opt_end; tail++)
+	{
+		BoolExprNode* node = tail->opt_conjunct_node;
+
+		if (!(tail->opt_conjunct_flags & opt_conjunct_used))
+		{
+			compose(*tdbb->getDefaultPool(), &boolean, node);
+			tail->opt_conjunct_flags |= opt_conjunct_used;
+		}
+	}
+
+	return boolean;
+}
+
+
+static bool is_probe_invariant(const ExprNode* node, StreamType stream)
+{
+/**************************************
+ *
+ *	i s _ p r o b e _ i n v a r i a n t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Check whether the expression evaluates the same way during
+ *	the whole request execution, given the record of the stream.
+ *	Only the simple expressions are trusted.
+ *
+ **************************************/
+	if (const FieldNode* const fieldNode = nodeAs<FieldNode>(node))
+		return fieldNode->fieldStream == stream;
+
+	if (!nodeIs<LiteralNode>(node) &&
+		!nodeIs<ComparativeBoolNode>(node) &&
+		!nodeIs<BinaryBoolNode>(node) &&
+		!nodeIs<NotBoolNode>(node) &&
+		!nodeIs<MissingBoolNode>(node) &&
+		!nodeIs<ArithmeticNode>(node) &&
+		!nodeIs<NegateNode>(node) &&
+		!nodeIs<CastNode>(node) &&
+		!nodeIs<ConcatenateNode>(node))
+	{
+		return false;
+	}
+
+	NodeRefsHolder holder(*JRD_get_thread_data()->getDefaultPool());
+	const_cast<ExprNode*>(node)->getChildren(holder, false);
+
+	for (ExprNode** const* i = holder.refs.begin(); i != holder.refs.end(); ++i)
+	{
+		if (**i && !is_probe_invariant(**i, stream))
+			return false;
+	}
+
+	return true;
+}
+
+
+static bool make_binary_comparable(thread_db* tdbb, CompilerScratch* csb,
+	ValueExprNode** node1, ValueExprNode** node2)
+{
+/**************************************
+ *
+ *	m a k e _ b i n a r y _ c o m p a r a b l e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Ensure that the arguments can be compared in the
+ *	binary form, casting them if required.
+ *
+ **************************************/
+	dsc result, desc1, desc2;
+	(*node1)->getDesc(tdbb, csb, &desc1);
+	(*node2)->getDesc(tdbb, csb, &desc2);
+
+	if (!CVT2_get_binary_comparable_desc(&result, &desc1, &desc2))
+		return false;
+
+	if (!DSC_EQUIV(&result, &desc1, true))
+	{
+		CastNode* cast = FB_NEW_POOL(*tdbb->getDefaultPool()) CastNode(*tdbb->getDefaultPool());
+		cast->source = *node1;
+		cast->castDesc = result;
+		cast->impureOffset = CMP_impure(csb, sizeof(impure_value));
+		*node1 = cast;
+	}
+
+	if (!DSC_EQUIV(&result, &desc2, true))
+	{
+		CastNode* cast = FB_NEW_POOL(*tdbb->getDefaultPool()) CastNode(*tdbb->getDefaultPool());
+		cast->source = *node2;
+		cast->castDesc = result;
+		cast->impureOffset = CMP_impure(csb, sizeof(impure_value));
+		*node2 = cast;
+	}
+
+	return true;
+}
+
+
 static BoolExprNode* make_inference_node(CompilerScratch* csb, BoolExprNode* boolean,
 	ValueExprNode* arg1, ValueExprNode* arg2)
 {
@@ -93,6 +93,7 @@ const USHORT FIL_readonly			= 4;	// file opened in readonly mode
 const USHORT FIL_sh_write			= 8;	// file opened in shared write mode
 const USHORT FIL_no_fast_extend		= 16;	// file not supports fast extending
 const USHORT FIL_raw_device			= 32;	// file is raw device
+const USHORT FIL_io_uring			= 64;	// batches of pages are submitted via io_uring
 
 // Physical IO trace events
 
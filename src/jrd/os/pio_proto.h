@@ -50,6 +50,10 @@ USHORT	PIO_init_data(Jrd::thread_db*, Jrd::jrd_file*, Jrd::FbStatusVector*, ULON
 Jrd::jrd_file*	PIO_open(Jrd::thread_db*, const Firebird::PathName&,
 						 const Firebird::PathName&);
 bool	PIO_read(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc*, Ods::pag*, Jrd::FbStatusVector*);
+bool	PIO_read_pages(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc* const*, USHORT,
+					   Jrd::FbStatusVector*);
+bool	PIO_read_batch(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc* const*, USHORT,
+					   Jrd::FbStatusVector*);
 
 #ifdef SUPERSERVER_V2
 bool	PIO_read_ahead(Jrd::thread_db*, SLONG, SCHAR*, SLONG,
@@ -67,6 +71,10 @@ inline bool PIO_on_raw_device(const Firebird::PathName&)
 }
 #endif
 bool	PIO_write(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc*, Ods::pag*, Jrd::FbStatusVector*);
+bool	PIO_write_pages(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc* const*, Ods::pag* const*,
+						USHORT, Jrd::FbStatusVector*);
+bool	PIO_write_batch(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc* const*, Ods::pag* const*,
+						USHORT, Jrd::FbStatusVector*);
 
 #endif // JRD_PIO_PROTO_H
 
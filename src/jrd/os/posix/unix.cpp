@@ -48,6 +48,12 @@
 #ifdef HAVE_LINUX_FALLOC_H
 #include <linux/falloc.h>
 #endif
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
 
 #ifdef SUPPORT_RAW_DEVICES
 #include <sys/ioctl.h>
@@ -138,6 +144,100 @@ static int  raw_devices_unlink_database (const PathName&);
 #endif
 static int	openFile(const char*, const bool, const bool, const bool);
 static void	maybeCloseFile(int&);
+static USHORT run_length(BufferDesc* const*, USHORT);
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING
+#endif
+
+#ifdef USE_IO_URING
+namespace
+{
+	// Request to read or write run of adjacent pages of a file
+
+	struct IoRequest
+	{
+		int fd;
+		const iovec* iov;
+		unsigned iovcnt;
+		FB_UINT64 offset;
+		SINT64 size;		// expected number of bytes
+		SINT64 result;		// number of bytes transferred or -errno
+	};
+
+	// Minimal io_uring instance driven by raw system calls, liburing is
+	// not required. Ring is used by single thread at a time.
+
+	class IoRing
+	{
+	public:
+		IoRing()
+			: ring_fd(-1), sq_ptr(MAP_FAILED), cq_ptr(MAP_FAILED), sqe_ptr(MAP_FAILED),
+			  sq_size(0), cq_size(0), sqe_size(0), sq_entries(0)
+		{ }
+
+		~IoRing();
+
+		int init();
+		int submit(IoRequest* requests, unsigned count, bool write);
+
+	private:
+		static const unsigned ENTRIES = 64;
+		static const unsigned MAX_RETRIES = 100;	// io_uring_enter calls without progress
+
+		int ring_fd;
+		void* sq_ptr;
+		void* cq_ptr;
+		void* sqe_ptr;
+		size_t sq_size, cq_size, sqe_size;
+		unsigned sq_entries;
+
+		unsigned* sq_head;
+		unsigned* sq_tail;
+		unsigned* sq_mask;
+		unsigned* sq_array;
+		io_uring_sqe* sqes;
+
+		unsigned* cq_head;
+		unsigned* cq_tail;
+		unsigned* cq_mask;
+		io_uring_cqe* cqes;
+	};
+
+	// Rings are shared by all databases and handed out to the threads
+	// doing batched I/O. If no ring is available I/O is synchronous.
+	// Once kernel refused rings for lack of memory they are not used anymore.
+
+	class IoRingPool
+	{
+	public:
+		explicit IoRingPool(MemoryPool& p)
+			: rings(p), count(0), unsupported(false)
+		{ }
+
+		~IoRingPool()
+		{
+			while (rings.hasData())
+				delete rings.pop();
+		}
+
+		IoRing* get();
+		void put(IoRing* ring, int error);
+
+	private:
+		static const unsigned MAX_RINGS = 64;
+
+		Mutex mutex;
+		Array<IoRing*> rings;
+		unsigned count;
+		bool unsupported;
+	};
+
+	GlobalPtr<IoRingPool> ringPool;
+}
+
+static bool ring_io(thread_db*, jrd_file*, BufferDesc* const*, Ods::pag* const*, USHORT, FbStatusVector*);
+#endif
 
 int PIO_add_file(thread_db* tdbb, jrd_file* main_file, const PathName& file_name, SLONG start)
 {
@@ -797,6 +897,112 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_read_pages(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, USHORT count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a run of adjacent pages into their buffers using
+ *	a single vectored read when possible.
+ *
+ **************************************/
+	fb_assert(count > 0);
+
+#ifdef HAVE_PREADV
+	if (file->fil_desc == -1)
+		return unix_error("read", file, isc_io_read_err, status_vector);
+
+	Database* const dbb = tdbb->getDatabase();
+	const ULONG firstPage = bdbs[0]->bdb_page.getPageNum();
+
+	FB_UINT64 offset;
+	if (!(file = seek_file(file, bdbs[0], &offset, status_vector)))
+		return false;
+
+	// Vectored read is used only when the whole run belongs to the same file
+
+	if (count > 1 && firstPage + count - 1 <= file->fil_max_page)
+	{
+		HalfStaticArray<iovec, 64> iov;
+		iovec* const vector = iov.getBuffer(count);
+
+		for (USHORT n = 0; n < count; n++)
+		{
+			fb_assert(bdbs[n]->bdb_page.getPageNum() == firstPage + n);
+			vector[n].iov_base = bdbs[n]->bdb_buffer;
+			vector[n].iov_len = dbb->dbb_page_size;
+		}
+
+		const SINT64 size = (SINT64) count * dbb->dbb_page_size;
+
+		EngineCheckout cout(tdbb, FB_FUNCTION, true);
+
+		for (int i = 0; i < IO_RETRY; i++)
+		{
+			const SINT64 bytes = os_utils::preadv(file->fil_desc, vector, count, LSEEK_OFFSET_CAST offset);
+			if (bytes == size)
+				return true;
+
+			if (bytes >= 0)
+				break;			// short read, let PIO_read() handle it page by page
+
+			if (!SYSCALL_INTERRUPTED(errno))
+				return unix_error("readv", file, isc_io_read_err, status_vector);
+		}
+	}
+#endif
+
+	for (USHORT n = 0; n < count; n++)
+	{
+		if (!PIO_read(tdbb, file, bdbs[n], bdbs[n]->bdb_buffer, status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
+bool PIO_read_batch(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, USHORT count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read sorted pages of the same page space into their buffers.
+ *	Every run of adjacent pages is read by single request, with
+ *	io_uring backend all requests are submitted at once.
+ *
+ **************************************/
+	fb_assert(count > 0);
+
+#ifdef USE_IO_URING
+	if ((file->fil_flags & FIL_io_uring) && count > 1)
+		return ring_io(tdbb, file, bdbs, NULL, count, status_vector);
+#endif
+
+	for (USHORT n = 0; n < count; )
+	{
+		const USHORT length = run_length(bdbs + n, count - n);
+
+		if (!PIO_read_pages(tdbb, file, bdbs + n, length, status_vector))
+			return false;
+
+		n += length;
+	}
+
+	return true;
+}
+
+
 bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page, FbStatusVector* status_vector)
 {
 /**************************************
@@ -838,6 +1044,451 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_write_pages(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, Ods::pag* const* pages,
+	USHORT count, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a run of adjacent pages using a single
+ *	vectored write when possible.
+ *
+ **************************************/
+	fb_assert(count > 0);
+
+#ifdef HAVE_PWRITEV
+	if (file->fil_desc == -1)
+		return unix_error("write", file, isc_io_write_err, status_vector);
+
+	Database* const dbb = tdbb->getDatabase();
+	const ULONG firstPage = bdbs[0]->bdb_page.getPageNum();
+
+	FB_UINT64 offset;
+	if (!(file = seek_file(file, bdbs[0], &offset, status_vector)))
+		return false;
+
+	// Vectored write is used only when the whole run belongs to the same file
+
+	if (count > 1 && firstPage + count - 1 <= file->fil_max_page)
+	{
+		HalfStaticArray<iovec, 64> iov;
+		iovec* const vector = iov.getBuffer(count);
+
+		for (USHORT n = 0; n < count; n++)
+		{
+			fb_assert(bdbs[n]->bdb_page.getPageNum() == firstPage + n);
+			vector[n].iov_base = pages[n];
+			vector[n].iov_len = dbb->dbb_page_size;
+		}
+
+		const SINT64 size = (SINT64) count * dbb->dbb_page_size;
+
+		EngineCheckout cout(tdbb, FB_FUNCTION, true);
+
+		for (int i = 0; i < IO_RETRY; i++)
+		{
+			const SINT64 bytes = os_utils::pwritev(file->fil_desc, vector, count, LSEEK_OFFSET_CAST offset);
+			if (bytes == size)
+				return true;
+
+			if (bytes >= 0)
+				break;			// short write, let PIO_write() handle it page by page
+
+			if (!SYSCALL_INTERRUPTED(errno))
+				return unix_error("writev", file, isc_io_write_err, status_vector);
+		}
+	}
+#endif
+
+	for (USHORT n = 0; n < count; n++)
+	{
+		if (!PIO_write(tdbb, file, bdbs[n], pages[n], status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
+bool PIO_write_batch(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, Ods::pag* const* pages,
+	USHORT count, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write sorted pages of the same page space. Every run of
+ *	adjacent pages is written by single request, with io_uring
+ *	backend all requests are submitted at once.
+ *
+ **************************************/
+	fb_assert(count > 0);
+
+#ifdef USE_IO_URING
+	if ((file->fil_flags & FIL_io_uring) && count > 1)
+		return ring_io(tdbb, file, bdbs, pages, count, status_vector);
+#endif
+
+	for (USHORT n = 0; n < count; )
+	{
+		const USHORT length = run_length(bdbs + n, count - n);
+
+		if (!PIO_write_pages(tdbb, file, bdbs + n, pages + n, length, status_vector))
+			return false;
+
+		n += length;
+	}
+
+	return true;
+}
+
+
+static USHORT run_length(BufferDesc* const* bdbs, USHORT count)
+{
+/**************************************
+ *
+ *	r u n _ l e n g t h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Return number of adjacent pages at the start of sorted list.
+ *
+ **************************************/
+	const ULONG firstPage = bdbs[0]->bdb_page.getPageNum();
+
+	USHORT length = 1;
+	while (length < count && bdbs[length]->bdb_page.getPageNum() == firstPage + length)
+		length++;
+
+	return length;
+}
+
+
+#ifdef USE_IO_URING
+static bool ring_io(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, Ods::pag* const* pages,
+	USHORT count, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	r i n g _ i o
+ *
+ **************************************
+ *
+ * Functional description
+ *	Submit requests for all runs of adjacent pages at once and wait
+ *	for them. Pages are written if given, else read into buffers.
+ *	Requests failed or not completed by the ring are repeated by
+ *	synchronous I/O, errors are reported there.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	const bool write = (pages != NULL);
+
+	HalfStaticArray<iovec, 64> iov;
+	iovec* const vector = iov.getBuffer(count);
+
+	HalfStaticArray<IoRequest, 16> requests;
+	HalfStaticArray<USHORT, 16> starts;
+
+	for (USHORT n = 0; n < count; )
+	{
+		FB_UINT64 offset;
+		jrd_file* const pageFile = seek_file(file, bdbs[n], &offset, status_vector);
+		if (!pageFile)
+			return false;
+
+		// Request can't cross the boundary of database file
+
+		const ULONG fileRest = pageFile->fil_max_page - bdbs[n]->bdb_page.getPageNum();
+		const USHORT limit = (fileRest < (ULONG) (count - n)) ? fileRest + 1 : count - n;
+		const USHORT length = run_length(bdbs + n, limit);
+
+		for (USHORT i = n; i < n + length; i++)
+		{
+			vector[i].iov_base = write ? (void*) pages[i] : (void*) bdbs[i]->bdb_buffer;
+			vector[i].iov_len = dbb->dbb_page_size;
+		}
+
+		IoRequest& request = requests.add();
+		request.fd = pageFile->fil_desc;
+		request.iov = vector + n;
+		request.iovcnt = length;
+		request.offset = offset;
+		request.size = (SINT64) length * dbb->dbb_page_size;
+		request.result = -1;
+
+		starts.add(n);
+		n += length;
+	}
+
+	{ // scope
+		EngineCheckout cout(tdbb, FB_FUNCTION, true);
+
+		IoRing* const ring = ringPool->get();
+		if (ring)
+		{
+			const int error = ring->submit(requests.begin(), requests.getCount(), write);
+			ringPool->put(ring, error);
+		}
+	}
+
+	for (FB_SIZE_T i = 0; i < requests.getCount(); i++)
+	{
+		if (requests[i].result == requests[i].size)
+			continue;
+
+		const USHORT n = starts[i];
+		const USHORT length = requests[i].iovcnt;
+
+		if (write ? !PIO_write_pages(tdbb, file, bdbs + n, pages + n, length, status_vector) :
+			!PIO_read_pages(tdbb, file, bdbs + n, length, status_vector))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+IoRing::~IoRing()
+{
+	if (sqe_ptr != MAP_FAILED)
+		munmap(sqe_ptr, sqe_size);
+	if (cq_ptr != MAP_FAILED)
+		munmap(cq_ptr, cq_size);
+	if (sq_ptr != MAP_FAILED)
+		munmap(sq_ptr, sq_size);
+	if (ring_fd >= 0)
+		close(ring_fd);
+}
+
+
+int IoRing::init()
+{
+/**************************************
+ *
+ *	I o R i n g :: i n i t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Create the ring and map its queues. Return errno on failure.
+ *
+ **************************************/
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	ring_fd = syscall(__NR_io_uring_setup, ENTRIES, &params);
+	if (ring_fd < 0)
+		return errno;
+
+	sq_entries = params.sq_entries;
+	sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	sqe_size = params.sq_entries * sizeof(io_uring_sqe);
+
+	sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd, IORING_OFF_SQ_RING);
+	if (sq_ptr == MAP_FAILED)
+		return errno;
+
+	cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd, IORING_OFF_CQ_RING);
+	if (cq_ptr == MAP_FAILED)
+		return errno;
+
+	sqe_ptr = mmap(NULL, sqe_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd, IORING_OFF_SQES);
+	if (sqe_ptr == MAP_FAILED)
+		return errno;
+
+	UCHAR* const sq = (UCHAR*) sq_ptr;
+	sq_head = (unsigned*) (sq + params.sq_off.head);
+	sq_tail = (unsigned*) (sq + params.sq_off.tail);
+	sq_mask = (unsigned*) (sq + params.sq_off.ring_mask);
+	sq_array = (unsigned*) (sq + params.sq_off.array);
+	sqes = (io_uring_sqe*) sqe_ptr;
+
+	UCHAR* const cq = (UCHAR*) cq_ptr;
+	cq_head = (unsigned*) (cq + params.cq_off.head);
+	cq_tail = (unsigned*) (cq + params.cq_off.tail);
+	cq_mask = (unsigned*) (cq + params.cq_off.ring_mask);
+	cqes = (io_uring_cqe*) (cq + params.cq_off.cqes);
+
+	return 0;
+}
+
+
+int IoRing::submit(IoRequest* requests, unsigned count, bool write)
+{
+/**************************************
+ *
+ *	I o R i n g :: s u b m i t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Submit requests and wait for all of them to complete, result
+ *	of every request is stored into it. Return errno if the ring
+ *	failed, requests not submitted then have negative result.
+ *	Temporary failures of the kernel are retried a limited number
+ *	of times. Requests already submitted are always waited for as
+ *	the kernel still uses their buffers.
+ *
+ **************************************/
+	for (unsigned first = 0; first < count; first += sq_entries)
+	{
+		const unsigned n = MIN(count - first, sq_entries);
+
+		// Only we move the tail, kernel moves the head
+
+		unsigned tail = *sq_tail;
+		for (unsigned i = first; i < first + n; i++, tail++)
+		{
+			const unsigned index = tail & *sq_mask;
+			io_uring_sqe* const sqe = &sqes[index];
+
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+			sqe->fd = requests[i].fd;
+			sqe->addr = (FB_UINT64) (IPTR) requests[i].iov;
+			sqe->len = requests[i].iovcnt;
+			sqe->off = requests[i].offset;
+			sqe->user_data = i;
+
+			sq_array[index] = index;
+		}
+
+		__atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+		unsigned submitted = 0, completed = 0, retries = 0;
+		int error = 0;
+
+		while (completed < (error ? submitted : n))
+		{
+			const unsigned toSubmit = error ? 0 : n - submitted;
+			const int rc = syscall(__NR_io_uring_enter, ring_fd, toSubmit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+			bool progress = false;
+
+			if (rc > 0)
+			{
+				submitted += rc;
+				progress = true;
+			}
+			else if (rc < 0)
+			{
+				const int errorCode = errno;
+				const bool temporary = SYSCALL_INTERRUPTED(errorCode) ||
+					errorCode == EAGAIN || errorCode == EBUSY;
+
+				if (!error && (!temporary || retries >= MAX_RETRIES))
+				{
+					// Take back requests not consumed by kernel, wait for the rest
+
+					error = temporary ? EAGAIN : errorCode;
+					__atomic_store_n(sq_tail, __atomic_load_n(sq_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+				}
+			}
+
+			unsigned head = *cq_head;
+			const unsigned cqTail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+			for (; head != cqTail; head++)
+			{
+				const io_uring_cqe* const cqe = &cqes[head & *cq_mask];
+				requests[cqe->user_data].result = cqe->res;
+				completed++;
+				progress = true;
+			}
+
+			__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+			if (progress)
+				retries = 0;
+			else if (++retries > MAX_RETRIES)
+				usleep(1000);	// only submitted requests are left, don't spin
+		}
+
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+
+IoRing* IoRingPool::get()
+{
+	MutexLockGuard guard(mutex, FB_FUNCTION);
+
+	if (unsupported)
+		return NULL;
+
+	if (rings.hasData())
+		return rings.pop();
+
+	if (count >= MAX_RINGS)
+		return NULL;
+
+	IoRing* const ring = FB_NEW_POOL(*getDefaultMemoryPool()) IoRing;
+
+	const int rc = ring->init();
+	if (rc)
+	{
+		delete ring;
+
+		// Kernel without io_uring or it's prohibited, don't try again
+
+		if (rc == ENOSYS || rc == EPERM || rc == EINVAL || rc == ENOMEM)
+		{
+			unsupported = true;
+			gds__log("io_uring is not available (errno %d), synchronous I/O is used", rc);
+		}
+
+		return NULL;
+	}
+
+	count++;
+	return ring;
+}
+
+
+void IoRingPool::put(IoRing* ring, int error)
+{
+	MutexLockGuard guard(mutex, FB_FUNCTION);
+
+	if (error)
+	{
+		delete ring;
+		count--;
+
+		// Kernel is short of memory for rings, retrying it every batch
+		// only slows I/O down, so fall back to synchronous I/O for good
+
+		if (error == ENOMEM && !unsupported)
+		{
+			unsupported = true;
+			gds__log("io_uring failed (errno %d), synchronous I/O is used", error);
+		}
+
+		return;
+	}
+
+	rings.push(ring);
+}
+#endif // USE_IO_URING
+
+
 static jrd_file* seek_file(jrd_file* file, BufferDesc* bdb, FB_UINT64* offset,
 	FbStatusVector* status_vector)
 {
@@ -970,6 +1621,10 @@ static jrd_file* setup_file(Database* dbb,
 			file->fil_flags |= FIL_sh_write;
 		if (onRawDev)
 			file->fil_flags |= FIL_raw_device;
+#ifdef USE_IO_URING
+		if (dbb->dbb_config->getIoBackend() == IO_BACKEND_IO_URING)
+			file->fil_flags |= FIL_io_uring;
+#endif
 	}
 	catch (const Exception&)
 	{
@@ -640,6 +640,46 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_read_pages(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, USHORT count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a run of adjacent pages into their buffers.
+ *
+ **************************************/
+	for (USHORT n = 0; n < count; n++)
+	{
+		if (!PIO_read(tdbb, file, bdbs[n], bdbs[n]->bdb_buffer, status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
+bool PIO_read_batch(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, USHORT count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read sorted pages of the same page space into their buffers.
+ *
+ **************************************/
+	return PIO_read_pages(tdbb, file, bdbs, count, status_vector);
+}
+
+
 #ifdef SUPERSERVER_V2
 bool PIO_read_ahead(thread_db*	tdbb,
 				   SLONG	start_page,
@@ -826,6 +866,46 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_write_pages(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, Ods::pag* const* pages,
+	USHORT count, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a run of adjacent pages.
+ *
+ **************************************/
+	for (USHORT n = 0; n < count; n++)
+	{
+		if (!PIO_write(tdbb, file, bdbs[n], pages[n], status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
+bool PIO_write_batch(thread_db* tdbb, jrd_file* file, BufferDesc* const* bdbs, Ods::pag* const* pages,
+	USHORT count, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ b a t c h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write sorted pages of the same page space.
+ *
+ **************************************/
+	return PIO_write_pages(tdbb, file, bdbs, pages, count, status_vector);
+}
+
+
 ULONG PIO_get_number_of_pages(const jrd_file* file, const USHORT pagesize)
 {
 /**************************************
@@ -45,14 +45,15 @@ BaseAggWinStream<ThisType, NextType>::BaseAggWinStream(thread_db* tdbb, Compiler
 	  m_next(next),
 	  m_group(group),
 	  m_groupMap(groupMap),
-	  m_oneRowWhenEmpty(oneRowWhenEmpty)
+	  m_oneRowWhenEmpty(oneRowWhenEmpty),
+	  m_batchInput(false)
 {
 	fb_assert(m_next);
 	m_impure = CMP_impure(csb, sizeof(typename ThisType::Impure));
 }
 
 template <typename ThisType, typename NextType>
-void BaseAggWinStream<ThisType, NextType>::open(thread_db* tdbb) const
+void BaseAggWinStream<ThisType, NextType>::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = getImpure(request);
@@ -71,6 +72,19 @@ void BaseAggWinStream<ThisType, NextType>::open(thread_db* tdbb) const
 		memset(impure->groupValues, 0, sizeof(impure_value) * impureCount);
 	}
 
+	delete impure->batch;
+	impure->batch = NULL;
+
+	if (m_batchInput && m_next->supportsBatch())
+	{
+		MemoryPool& pool = *tdbb->getDefaultPool();
+
+		StreamList streams;
+		m_next->findUsedStreams(streams);
+
+		impure->batch = FB_NEW_POOL(pool) RecordBatch(pool, streams);
+	}
+
 	m_next->open(tdbb);
 }
 
@@ -87,6 +101,9 @@ void BaseAggWinStream<ThisType, NextType>::close(thread_db* tdbb) const
 	{
 		impure->irsb_flags &= ~irsb_open;
 
+		delete impure->batch;
+		impure->batch = NULL;
+
 		m_next->close(tdbb);
 	}
 }
@@ -352,6 +369,8 @@ bool BaseAggWinStream<ThisType, NextType>::getNextRecord(thread_db* tdbb, jrd_re
 		impure->state = STATE_GROUPING;
 		return true;
 	}
+	else if (impure->batch)
+		return impure->batch->fetch(tdbb, m_next);
 	else
 		return m_next->getRecord(tdbb);
 }
@@ -359,6 +378,12 @@ bool BaseAggWinStream<ThisType, NextType>::getNextRecord(thread_db* tdbb, jrd_re
 // Export the template for WindowedStream::WindowStream.
 template class Jrd::BaseAggWinStream<WindowedStream::WindowStream, BaseBufferedStream>;
 
+// Export the template for HashAggregatedStream.
+template class Jrd::BaseAggWinStream<HashAggregatedStream, RecordSource>;
+
+// Export the template for ParallelAggregatedStream.
+template class Jrd::BaseAggWinStream<ParallelAggregatedStream, RecordSource>;
+
 // ------------------------------
 
 AggregatedStream::AggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
@@ -366,9 +391,10 @@ AggregatedStream::AggregatedStream(thread_db* tdbb, CompilerScratch* csb, Stream
 	: BaseAggWinStream(tdbb, csb, stream, group, map, !group, next)
 {
 	fb_assert(map);
+	m_batchInput = RecordBatch::isNarrow(csb, next);
 }
 
-void AggregatedStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void AggregatedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "Aggregate";
@@ -376,7 +402,7 @@ void AggregatedStream::print(thread_db* tdbb, string& plan, bool detailed, unsig
 	m_next->print(tdbb, plan, detailed, level);
 }
 
-bool AggregatedStream::getRecord(thread_db* tdbb) const
+bool AggregatedStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -400,3 +426,30 @@ bool AggregatedStream::getRecord(thread_db* tdbb) const
 	rpb->rpb_number.setValid(true);
 	return true;
 }
+
+ULONG AggregatedStream::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = getImpure(request);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return 0;
+	}
+
+	while (!batch.isFull())
+	{
+		if (!evaluateGroup(tdbb))
+		{
+			rpb->rpb_number.setValid(false);
+			break;
+		}
+
+		rpb->rpb_number.setValid(true);
+		batch.put(request);
+	}
+
+	return batch.getCount();
+}
@@ -22,6 +22,7 @@
 #include "../jrd/btr.h"
 #include "../jrd/req.h"
 #include "../jrd/cmp_proto.h"
+#include "../jrd/dpm_proto.h"
 #include "../jrd/evl_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/rlck_proto.h"
@@ -46,13 +47,14 @@ BitmapTableScan::BitmapTableScan(CompilerScratch* csb, const string& alias,
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void BitmapTableScan::open(thread_db* tdbb) const
+void BitmapTableScan::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
 
 	impure->irsb_flags = irsb_open;
 	impure->irsb_bitmap = EVL_bitmap(tdbb, m_inversion, NULL);
+	impure->irsb_prefetch_number = 0;
 
 	record_param* const rpb = &request->req_rpb[m_stream];
 	RLCK_reserve_relation(tdbb, request->req_transaction, m_relation, false);
@@ -80,7 +82,7 @@ void BitmapTableScan::close(thread_db* tdbb) const
 	}
 }
 
-bool BitmapTableScan::getRecord(thread_db* tdbb) const
+bool BitmapTableScan::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -108,12 +110,22 @@ bool BitmapTableScan::getRecord(thread_db* tdbb) const
 	{
 		do
 		{
-			rpb->rpb_number.setValue(bitmap->current());
+			const FB_UINT64 number = bitmap->current();
+
+			if (number >= impure->irsb_prefetch_number)
+			{
+				impure->irsb_prefetch_number =
+					DPM_prefetch_bitmap(tdbb, m_relation, bitmap, number);
+			}
+
+			rpb->rpb_number.setValue(number);
 
 			if (VIO_get(tdbb, rpb, request->req_transaction, request->req_pool))
 			{
 				rpb->rpb_number.setValid(true);
-				return true;
+
+				if (!m_filter || m_filter->checkFilter(tdbb))
+					return true;
 			}
 		} while (bitmap->getNext());
 	}
@@ -122,8 +134,8 @@ bool BitmapTableScan::getRecord(thread_db* tdbb) const
 	return false;
 }
 
-void BitmapTableScan::print(thread_db* tdbb, string& plan,
-							bool detailed, unsigned level) const
+void BitmapTableScan::internalPrint(thread_db* tdbb, string& plan,
+									bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
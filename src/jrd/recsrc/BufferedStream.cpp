@@ -40,7 +40,7 @@ using namespace Jrd;
 // --------------------------
 
 BufferedStream::BufferedStream(CompilerScratch* csb, RecordSource* next)
-	: m_next(next), m_map(csb->csb_pool)
+	: m_next(next), m_map(csb->csb_pool), m_cardinality(0)
 {
 	fb_assert(m_next);
 
@@ -56,6 +56,8 @@ BufferedStream::BufferedStream(CompilerScratch* csb, RecordSource* next)
 		const StreamType stream = *i;
 		CompilerScratch::csb_repeat* const tail = &csb->csb_rpt[stream];
 
+		m_cardinality = MAX(m_cardinality, tail->csb_cardinality);
+
 		UInt32Bitmap::Accessor accessor(tail->csb_fields);
 
 		if (accessor.getFirst())
@@ -112,7 +114,7 @@ BufferedStream::BufferedStream(CompilerScratch* csb, RecordSource* next)
 	m_format = format;
 }
 
-void BufferedStream::open(thread_db* tdbb) const
+void BufferedStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -124,6 +126,7 @@ void BufferedStream::open(thread_db* tdbb) const
 	delete impure->irsb_buffer;
 	MemoryPool& pool = *tdbb->getDefaultPool();
 	impure->irsb_buffer = FB_NEW_POOL(pool) RecordBuffer(pool, m_format);
+	impure->irsb_buffer->setEstimate((FB_UINT64) m_cardinality);
 
 	impure->irsb_position = 0;
 }
@@ -147,7 +150,7 @@ void BufferedStream::close(thread_db* tdbb) const
 	}
 }
 
-bool BufferedStream::getRecord(thread_db* tdbb) const
+bool BufferedStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -307,7 +310,7 @@ bool BufferedStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void BufferedStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void BufferedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
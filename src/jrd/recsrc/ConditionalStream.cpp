@@ -48,7 +48,7 @@ ConditionalStream::ConditionalStream(CompilerScratch* csb,
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void ConditionalStream::open(thread_db* tdbb) const
+void ConditionalStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -75,7 +75,7 @@ void ConditionalStream::close(thread_db* tdbb) const
 	}
 }
 
-bool ConditionalStream::getRecord(thread_db* tdbb) const
+bool ConditionalStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -111,7 +111,7 @@ bool ConditionalStream::lockRecord(thread_db* tdbb) const
 	return impure->irsb_next->lockRecord(tdbb);
 }
 
-void ConditionalStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void ConditionalStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
@@ -45,7 +45,7 @@ ExternalTableScan::ExternalTableScan(CompilerScratch* csb, const string& alias,
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void ExternalTableScan::open(thread_db* tdbb) const
+void ExternalTableScan::internalOpen(thread_db* tdbb) const
 {
 	Database* const dbb = tdbb->getDatabase();
 	jrd_req* const request = tdbb->getRequest();
@@ -76,7 +76,7 @@ void ExternalTableScan::close(thread_db* tdbb) const
 		impure->irsb_flags &= ~irsb_open;
 }
 
-bool ExternalTableScan::getRecord(thread_db* tdbb) const
+bool ExternalTableScan::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -115,8 +115,8 @@ bool ExternalTableScan::lockRecord(thread_db* tdbb) const
 	return false; // compiler silencer
 }
 
-void ExternalTableScan::print(thread_db* tdbb, string& plan,
-							  bool detailed, unsigned level) const
+void ExternalTableScan::internalPrint(thread_db* tdbb, string& plan,
+									  bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
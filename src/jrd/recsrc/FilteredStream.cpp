@@ -44,7 +44,7 @@ FilteredStream::FilteredStream(CompilerScratch* csb, RecordSource* next, BoolExp
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void FilteredStream::open(thread_db* tdbb) const
+void FilteredStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -70,7 +70,7 @@ void FilteredStream::close(thread_db* tdbb) const
 	}
 }
 
-bool FilteredStream::getRecord(thread_db* tdbb) const
+bool FilteredStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -90,6 +90,44 @@ bool FilteredStream::getRecord(thread_db* tdbb) const
 	return true;
 }
 
+ULONG FilteredStream::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	// ANY/ALL evaluation needs the records one by one
+	if (m_anyBoolean)
+		return RecordSource::internalGetRecords(tdbb, batch);
+
+	jrd_req* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+		return 0;
+
+	// Fill the batch from the underlying stream and compact it to the records
+	// satisfying the boolean, until some of them do
+
+	while (batch.fill(tdbb, m_next))
+	{
+		const ULONG count = batch.getCount();
+		ULONG kept = 0;
+
+		for (ULONG row = 0; row < count; row++)
+		{
+			batch.activate(request, row);
+
+			if (m_boolean->execute(tdbb, request))
+				batch.move(row, kept++);
+		}
+
+		batch.truncate(kept);
+
+		if (kept)
+			return kept;
+	}
+
+	invalidateRecords(request);
+	return 0;
+}
+
 bool FilteredStream::refetchRecord(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
@@ -103,7 +141,7 @@ bool FilteredStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void FilteredStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void FilteredStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "Filter";
@@ -44,7 +44,7 @@ FirstRowsStream::FirstRowsStream(CompilerScratch* csb, RecordSource* next, Value
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void FirstRowsStream::open(thread_db* tdbb) const
+void FirstRowsStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -81,7 +81,7 @@ void FirstRowsStream::close(thread_db* tdbb) const
 	}
 }
 
-bool FirstRowsStream::getRecord(thread_db* tdbb) const
+bool FirstRowsStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -113,7 +113,7 @@ bool FirstRowsStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void FirstRowsStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void FirstRowsStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "First N Records";
@@ -45,7 +45,7 @@ FullOuterJoin::FullOuterJoin(CompilerScratch* csb, RecordSource* arg1, RecordSou
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void FullOuterJoin::open(thread_db* tdbb) const
+void FullOuterJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -74,7 +74,7 @@ void FullOuterJoin::close(thread_db* tdbb) const
 	}
 }
 
-bool FullOuterJoin::getRecord(thread_db* tdbb) const
+bool FullOuterJoin::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -111,7 +111,7 @@ bool FullOuterJoin::lockRecord(thread_db* tdbb) const
 	return false; // compiler silencer
 }
 
-void FullOuterJoin::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void FullOuterJoin::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
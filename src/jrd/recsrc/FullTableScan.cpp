@@ -42,7 +42,7 @@ FullTableScan::FullTableScan(CompilerScratch* csb, const string& alias,
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void FullTableScan::open(thread_db* tdbb) const
+void FullTableScan::internalOpen(thread_db* tdbb) const
 {
 	Database* const dbb = tdbb->getDatabase();
 	Attachment* const attachment = tdbb->getAttachment();
@@ -104,7 +104,7 @@ void FullTableScan::close(thread_db* tdbb) const
 	}
 }
 
-bool FullTableScan::getRecord(thread_db* tdbb) const
+bool FullTableScan::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -119,17 +119,51 @@ bool FullTableScan::getRecord(thread_db* tdbb) const
 		return false;
 	}
 
-	if (VIO_next_record(tdbb, rpb, request->req_transaction, request->req_pool, false))
+	while (VIO_next_record(tdbb, rpb, request->req_transaction, request->req_pool, false))
 	{
 		rpb->rpb_number.setValid(true);
-		return true;
+
+		if (!m_filter || m_filter->checkFilter(tdbb))
+			return true;
 	}
 
 	rpb->rpb_number.setValid(false);
 	return false;
 }
 
-void FullTableScan::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+ULONG FullTableScan::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return 0;
+	}
+
+	while (!batch.isFull())
+	{
+		if (--tdbb->tdbb_quantum < 0)
+			JRD_reschedule(tdbb, 0, true);
+
+		if (!VIO_next_record(tdbb, rpb, request->req_transaction, request->req_pool, false))
+		{
+			rpb->rpb_number.setValid(false);
+			break;
+		}
+
+		rpb->rpb_number.setValid(true);
+
+		if (!m_filter || m_filter->checkFilter(tdbb))
+			batch.put(request);
+	}
+
+	return batch.getCount();
+}
+
+void FullTableScan::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
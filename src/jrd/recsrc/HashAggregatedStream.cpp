@@ -0,0 +1,851 @@
+/*
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../common/classes/Hash.h"
+#include "../jrd/align.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/intl.h"
+#include "../jrd/RecordBuffer.h"
+#include "../dsql/Nodes.h"
+#include "../dsql/ExprNodes.h"
+#include "../jrd/cmp_proto.h"
+#include "../jrd/evl_proto.h"
+#include "../jrd/intl_proto.h"
+#include "../jrd/mov_proto.h"
+#include "../jrd/vio_proto.h"
+
+#include "RecordSource.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+// -------------------------------
+// Data access: hashed aggregation
+// -------------------------------
+
+static const char* const SCRATCH = "fb_group_";
+
+// The number of slots grows with the number of groups,
+// keeping the average number of collisions per slot small
+static const ULONG HASH_LOAD_FACTOR = 2;
+static const ULONG HASH_SIZES[] =
+{
+	1009, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139, 524287,
+	1048573, 2097143, 4194301, 8388593, 16777213
+};
+
+static const ULONG GROUP_BLOCK_SIZE = 64 * 1024;
+static const FB_SIZE_T GROUP_MEMORY_STEP = 1024 * 1024;
+
+// When the temp cache refuses more memory for the groups, the rows of the groups not seen yet
+// are spilled into partitions and aggregated after the groups in memory are returned.
+// A partition too large is split again using the next bits of the hash.
+static const ULONG SPILL_PARTITION_BITS = 4;
+static const ULONG SPILL_PARTITIONS = 1 << SPILL_PARTITION_BITS;
+static const ULONG MAX_SPILL_LEVEL = 3;
+
+namespace
+{
+	// Group entry, followed by the key, the image of the aggregated record
+	// and the states of the aggregate functions
+
+	struct Group
+	{
+		Group* next;		// next group of the same slot
+		ULONG hash;
+
+		UCHAR* getKey()
+		{
+			return reinterpret_cast<UCHAR*>(this + 1);
+		}
+	};
+
+	// Rows of the groups spilled at the same level
+
+	struct Partition
+	{
+		Partition(MemoryPool& pool, const Format* format, ULONG aLevel)
+			: buffer(pool, format), level(aLevel)
+		{}
+
+		RecordBuffer buffer;
+		const ULONG level;
+	};
+}
+
+class HashAggregatedStream::Groups : public PermanentStorage
+{
+public:
+	Groups(MemoryPool& pool, const Format* spillFormat, ULONG keyLength,
+		   ULONG recordLength, ULONG stateLength)
+		: PermanentStorage(pool),
+		  m_spillFormat(spillFormat), m_keyLength(keyLength),
+		  m_recordLength(recordLength),
+		  m_entryLength(FB_ALIGN(sizeof(Group) + keyLength + recordLength + stateLength, FB_ALIGNMENT)),
+		  m_space(pool, SCRATCH), m_reserved(0),
+		  m_blocks(pool), m_groups(pool), m_slots(NULL), m_slotCount(0),
+		  m_free(NULL), m_end(NULL), m_position(0), m_current(NULL), m_level(0),
+		  m_pending(pool), m_key(pool), m_values(pool), m_descs(pool)
+	{
+		memset(m_spilled, 0, sizeof(m_spilled));
+
+		m_key.getBuffer(keyLength);
+		m_values.getBuffer(spillFormat->fmt_count);
+		m_descs.getBuffer(spillFormat->fmt_count);
+	}
+
+	~Groups()
+	{
+		clear();
+
+		for (ULONG i = 0; i < SPILL_PARTITIONS; i++)
+			delete m_spilled[i];
+
+		for (FB_SIZE_T i = 0; i < m_pending.getCount(); i++)
+			delete m_pending[i];
+	}
+
+	Group* find(ULONG hash, const UCHAR* key) const
+	{
+		if (!m_slotCount)
+			return NULL;
+
+		for (Group* group = m_slots[hash % m_slotCount]; group; group = group->next)
+		{
+			if (group->hash == hash && !memcmp(group->getKey(), key, m_keyLength))
+				return group;
+		}
+
+		return NULL;
+	}
+
+	Group* add(ULONG hash, const UCHAR* key)
+	{
+		if (m_groups.getCount() >= (FB_SIZE_T) m_slotCount * HASH_LOAD_FACTOR)
+			grow();
+
+		if (m_free + m_entryLength > m_end)
+		{
+			const ULONG size = MAX(GROUP_BLOCK_SIZE, m_entryLength);
+			m_free = FB_NEW_POOL(getPool()) UCHAR[size];
+			m_end = m_free + size;
+			m_blocks.add(m_free);
+		}
+
+		Group* const group = reinterpret_cast<Group*>(m_free);
+		m_free += m_entryLength;
+
+		group->hash = hash;
+		memcpy(group->getKey(), key, m_keyLength);
+
+		Group** const slot = &m_slots[hash % m_slotCount];
+		group->next = *slot;
+		*slot = group;
+
+		m_groups.add(group);
+
+		return group;
+	}
+
+	UCHAR* getRecord(Group* group) const
+	{
+		return group->getKey() + m_keyLength;
+	}
+
+	UCHAR* getStates(Group* group) const
+	{
+		return group->getKey() + m_keyLength + m_recordLength;
+	}
+
+	// Group which aggregate states are loaded in the request
+	Group* getCurrent() const
+	{
+		return m_current;
+	}
+
+	void setCurrent(Group* group)
+	{
+		m_current = group;
+	}
+
+	Group* getNext()
+	{
+		return (m_position < m_groups.getCount()) ? m_groups[m_position++] : NULL;
+	}
+
+	UCHAR* getKeyBuffer()
+	{
+		return m_key.begin();
+	}
+
+	dsc** getValues()
+	{
+		return m_values.begin();
+	}
+
+	dsc* getDescs()
+	{
+		return m_descs.begin();
+	}
+
+	// Store the row of a new group into its partition if the temp cache
+	// doesn't give more memory for the groups
+	bool spill(thread_db* tdbb, ULONG hash, dsc* const* values)
+	{
+		if (m_level >= MAX_SPILL_LEVEL || reserve())
+			return false;
+
+		// Multiplicative hashing scatters the low-bit keys across the partitions
+		const ULONG scrambled = hash * 2654435761U;
+		const ULONG shift = 32 - SPILL_PARTITION_BITS * (m_level + 1);
+		Partition*& partition = m_spilled[(scrambled >> shift) & (SPILL_PARTITIONS - 1)];
+
+		if (!partition)
+			partition = FB_NEW_POOL(getPool()) Partition(getPool(), m_spillFormat, m_level + 1);
+
+		Record* const record = partition->buffer.getTempRecord();
+		record->nullify();
+
+		for (USHORT i = 0; i < m_spillFormat->fmt_count; i++)
+		{
+			if (values[i])
+			{
+				record->clearNull(i);
+
+				dsc to = m_spillFormat->fmt_desc[i];
+				to.dsc_address = record->getData() + (IPTR) to.dsc_address;
+				MOV_move(tdbb, values[i], &to);
+			}
+		}
+
+		partition->buffer.store(record);
+		return true;
+	}
+
+	// All rows are aggregated, remember the partitions spilled meanwhile
+	void finish()
+	{
+		for (ULONG i = 0; i < SPILL_PARTITIONS; i++)
+		{
+			if (m_spilled[i])
+			{
+				m_pending.push(m_spilled[i]);
+				m_spilled[i] = NULL;
+			}
+		}
+
+		m_current = NULL;
+	}
+
+	// Discard the groups returned so far and switch to the next spilled partition
+	Partition* next()
+	{
+		if (m_pending.isEmpty())
+			return NULL;
+
+		clear();
+
+		Partition* const partition = m_pending.pop();
+		m_level = partition->level;
+
+		return partition;
+	}
+
+private:
+	// Ask the temp cache for the memory taken by the groups,
+	// return false if it refuses to give more
+	bool reserve()
+	{
+		const FB_UINT64 usage = getMemoryUsage();
+
+		if (usage <= m_reserved)
+			return true;
+
+		const FB_SIZE_T size = (FB_SIZE_T) MAX(usage - m_reserved, GROUP_MEMORY_STEP);
+
+		if (!m_space.reserveMemory(size))
+			return false;
+
+		m_reserved += size;
+		return true;
+	}
+
+	void grow()
+	{
+		const ULONG* size = HASH_SIZES;
+		const ULONG* const end = HASH_SIZES + FB_NELEM(HASH_SIZES) - 1;
+		while (size < end && *size <= m_slotCount)
+			size++;
+
+		if (*size == m_slotCount)
+			return;
+
+		delete[] m_slots;
+		m_slotCount = *size;
+		m_slots = FB_NEW_POOL(getPool()) Group*[m_slotCount];
+		memset(m_slots, 0, m_slotCount * sizeof(Group*));
+
+		for (FB_SIZE_T i = 0; i < m_groups.getCount(); i++)
+		{
+			Group* const group = m_groups[i];
+			Group** const slot = &m_slots[group->hash % m_slotCount];
+			group->next = *slot;
+			*slot = group;
+		}
+	}
+
+	void clear()
+	{
+		for (FB_SIZE_T i = 0; i < m_blocks.getCount(); i++)
+			delete[] m_blocks[i];
+
+		m_blocks.clear();
+		m_groups.clear();
+
+		delete[] m_slots;
+		m_slots = NULL;
+		m_slotCount = 0;
+
+		m_free = m_end = NULL;
+		m_position = 0;
+		m_current = NULL;
+	}
+
+	FB_UINT64 getMemoryUsage() const
+	{
+		return (FB_UINT64) m_blocks.getCount() * GROUP_BLOCK_SIZE +
+			(FB_UINT64) m_slotCount * sizeof(Group*) +
+			(FB_UINT64) m_groups.getCapacity() * sizeof(Group*);
+	}
+
+	const Format* const m_spillFormat;
+	const ULONG m_keyLength;
+	const ULONG m_recordLength;
+	const ULONG m_entryLength;
+	TempSpace m_space;				// used to account the memory in the temp cache
+	FB_UINT64 m_reserved;
+	Array<UCHAR*> m_blocks;
+	Array<Group*> m_groups;			// in the order of appearance
+	Group** m_slots;
+	ULONG m_slotCount;
+	UCHAR* m_free;
+	UCHAR* m_end;
+	FB_SIZE_T m_position;			// next group to return
+	Group* m_current;
+	ULONG m_level;					// level of the partition being aggregated
+	Partition* m_spilled[SPILL_PARTITIONS];
+	Array<Partition*> m_pending;
+	Array<UCHAR> m_key;
+	Array<dsc*> m_values;
+	Array<dsc> m_descs;
+};
+
+
+HashAggregatedStream::HashAggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+			const NestValueArray* group, MapNode* map, RecordSource* next, RecordSource* fallback)
+	: BaseAggWinStream(tdbb, csb, stream, group, map, false, next),
+	  m_values(csb->csb_pool), m_aggregates(csb->csb_pool), m_assignments(csb->csb_pool),
+	  m_keyDescs(csb->csb_pool), m_keyLength(0), m_spillFormat(NULL), m_fallback(fallback)
+{
+	fb_assert(group && map && m_fallback);
+	m_batchInput = RecordBatch::isNarrow(csb, next);
+
+	// Every input row is reduced to the values of the grouping keys,
+	// of the aggregate arguments and of the other mapped expressions
+
+	m_values.join(*group);
+
+	const NestConst<ValueExprNode>* const sourceEnd = map->sourceList.end();
+
+	for (const NestConst<ValueExprNode>* source = map->sourceList.begin(),
+			*target = map->targetList.begin();
+		 source != sourceEnd;
+		 ++source, ++target)
+	{
+		const AggNode* const aggNode = nodeAs<AggNode>(*source);
+
+		if (aggNode)
+		{
+			Aggregate aggregate;
+			aggregate.node = aggNode;
+			aggregate.value = NO_VALUE;
+
+			if (aggNode->arg)
+			{
+				aggregate.value = m_values.getCount();
+				m_values.add(aggNode->arg);
+			}
+
+			m_aggregates.add(aggregate);
+		}
+		else if (!nodeIs<LiteralNode>(*source))
+		{
+			Assignment assignment;
+			assignment.target = *target;
+			assignment.value = m_values.getCount();
+			m_values.add(*source);
+
+			m_assignments.add(assignment);
+		}
+	}
+
+	// The key starts with the null flags of the grouping keys
+	// followed by their binary comparable values
+
+	m_keyLength = group->getCount();
+
+	for (FB_SIZE_T i = 0; i < group->getCount(); i++)
+	{
+		dsc desc;
+		m_values[i]->getDesc(tdbb, csb, &desc);
+
+		if (desc.isText())
+		{
+			USHORT keyLength = desc.getStringLength();
+
+			if (IS_INTL_DATA(&desc))
+				keyLength = INTL_key_length(tdbb, INTL_INDEX_TYPE(&desc), keyLength);
+
+			desc.makeText(keyLength, desc.getTextType());
+		}
+		else if (desc.dsc_dtype >= dtype_aligned)
+			m_keyLength = FB_ALIGN(m_keyLength, type_alignments[desc.dsc_dtype]);
+
+		desc.dsc_address = (UCHAR*)(IPTR) m_keyLength;
+		m_keyLength += desc.dsc_length;
+
+		m_keyDescs.add(desc);
+	}
+
+	const FB_SIZE_T count = m_values.getCount();
+	Format* const format = Format::newFormat(csb->csb_pool, count);
+	format->fmt_length = FLAG_BYTES(count);
+
+	for (FB_SIZE_T i = 0; i < count; i++)
+	{
+		dsc& desc = format->fmt_desc[i];
+		m_values[i]->getDesc(tdbb, csb, &desc);
+
+		if (desc.dsc_dtype >= dtype_aligned)
+			format->fmt_length = FB_ALIGN(format->fmt_length, type_alignments[desc.dsc_dtype]);
+
+		desc.dsc_address = (UCHAR*)(IPTR) format->fmt_length;
+		format->fmt_length += desc.dsc_length;
+	}
+
+	m_spillFormat = format;
+}
+
+bool HashAggregatedStream::isSupported(thread_db* tdbb, CompilerScratch* csb,
+	NestValueArray* group, MapNode* map)
+{
+	if (!group || group->isEmpty())
+		return false;
+
+	// Equal keys must have equal binary images
+
+	for (NestConst<ValueExprNode>* ptr = group->begin(); ptr != group->end(); ++ptr)
+	{
+		dsc desc;
+		(*ptr)->getDesc(tdbb, csb, &desc);
+
+		switch (desc.dsc_dtype)
+		{
+			case dtype_text:
+			case dtype_varying:
+			case dtype_cstring:
+			case dtype_short:
+			case dtype_long:
+			case dtype_int64:
+			case dtype_int128:
+			case dtype_sql_date:
+			case dtype_sql_time:
+			case dtype_timestamp:
+			case dtype_boolean:
+				break;
+
+			default:
+				return false;
+		}
+	}
+
+	// The aggregate states are saved and restored by copying the impure values,
+	// so they must not refer to memory allocated separately
+
+	for (NestConst<ValueExprNode>* ptr = map->sourceList.begin();
+		 ptr != map->sourceList.end();
+		 ++ptr)
+	{
+		AggNode* const aggNode = nodeAs<AggNode>(*ptr);
+
+		if (!aggNode)
+			continue;
+
+		if (aggNode->distinct)
+			return false;
+
+		switch (aggNode->aggInfo.blr)
+		{
+			case blr_agg_count2:
+			case blr_agg_total:
+			case blr_agg_average:
+				break;
+
+			case blr_agg_max:
+			case blr_agg_min:
+			{
+				dsc desc;
+				aggNode->arg->getDesc(tdbb, csb, &desc);
+
+				switch (desc.dsc_dtype)
+				{
+					case dtype_short:
+					case dtype_long:
+					case dtype_int64:
+					case dtype_int128:
+					case dtype_real:
+					case dtype_double:
+					case dtype_dec64:
+					case dtype_dec128:
+					case dtype_sql_date:
+					case dtype_sql_time:
+					case dtype_sql_time_tz:
+					case dtype_timestamp:
+					case dtype_timestamp_tz:
+						break;
+
+					default:
+						return false;
+				}
+
+				break;
+			}
+
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void HashAggregatedStream::internalOpen(thread_db* tdbb) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	Impure* const impure = getImpure(request);
+
+	BaseAggWinStream::internalOpen(tdbb);
+
+	delete impure->irsb_groups;
+	impure->irsb_groups = NULL;
+	impure->irsb_fallback = false;
+
+	MemoryPool& pool = *tdbb->getDefaultPool();
+
+	// The groups take as much memory as the temp cache gives them,
+	// the others are aggregated later from the spilled rows
+	Groups* const groups = impure->irsb_groups = FB_NEW_POOL(pool) Groups(pool, m_spillFormat,
+		m_keyLength, m_format->fmt_length, m_aggregates.getCount() * sizeof(impure_value_ex));
+
+	dsc** const values = groups->getValues();
+
+	while (getNextRecord(tdbb, request))
+	{
+		for (FB_SIZE_T i = 0; i < m_values.getCount(); i++)
+		{
+			dsc* const desc = EVL_expr(tdbb, request, m_values[i]);
+			values[i] = (request->req_flags & req_null) ? NULL : desc;
+		}
+
+		if (!aggregate(tdbb, request, groups, values))
+		{
+			// The key of a string doesn't fit the hash table,
+			// so read the input again and aggregate it sorted
+
+			delete impure->irsb_groups;
+			impure->irsb_groups = NULL;
+
+			delete impure->batch;
+			impure->batch = NULL;
+
+			m_next->close(tdbb);
+
+			impure->irsb_fallback = true;
+			m_fallback->open(tdbb);
+			return;
+		}
+	}
+
+	// The input is consumed, so its batch isn't needed anymore
+
+	delete impure->batch;
+	impure->batch = NULL;
+
+	if (groups->getCurrent())
+		saveStates(request, groups->getStates(groups->getCurrent()));
+
+	groups->finish();
+}
+
+void HashAggregatedStream::close(thread_db* tdbb) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	Impure* const impure = getImpure(request);
+
+	if (impure->irsb_flags & irsb_open)
+	{
+		delete impure->irsb_groups;
+		impure->irsb_groups = NULL;
+
+		if (impure->irsb_fallback)
+			m_fallback->close(tdbb);
+	}
+
+	BaseAggWinStream::close(tdbb);
+}
+
+void HashAggregatedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+{
+	if (detailed)
+		plan += printIndent(++level) + "Aggregate (hash)";
+
+	m_next->print(tdbb, plan, detailed, level);
+}
+
+bool HashAggregatedStream::internalGetRecord(thread_db* tdbb) const
+{
+	if (--tdbb->tdbb_quantum < 0)
+		JRD_reschedule(tdbb, 0, true);
+
+	jrd_req* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = getImpure(request);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return false;
+	}
+
+	if (impure->irsb_fallback)
+		return m_fallback->getRecord(tdbb);
+
+	Groups* const groups = impure->irsb_groups;
+	Group* group;
+
+	while (!(group = groups->getNext()))
+	{
+		if (!aggregatePartition(tdbb, request, groups))
+		{
+			rpb->rpb_number.setValid(false);
+			return false;
+		}
+	}
+
+	rpb->rpb_record->copyDataFrom(groups->getRecord(group));
+	loadStates(request, groups->getStates(group));
+
+	aggExecute(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+
+	rpb->rpb_number.setValid(true);
+	return true;
+}
+
+ULONG HashAggregatedStream::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+
+	while (!batch.isFull() && HashAggregatedStream::internalGetRecord(tdbb))
+		batch.put(request);
+
+	return batch.getCount();
+}
+
+void HashAggregatedStream::markRecursive()
+{
+	BaseAggWinStream::markRecursive();
+	m_fallback->markRecursive();
+}
+
+void HashAggregatedStream::invalidateRecords(jrd_req* request) const
+{
+	BaseAggWinStream::invalidateRecords(request);
+	m_fallback->invalidateRecords(request);
+}
+
+// Build the key of the row, return false if it doesn't fit the key length
+bool HashAggregatedStream::makeKey(thread_db* tdbb, dsc* const* values, UCHAR* key, ULONG& hash) const
+{
+	memset(key, 0, m_keyLength);
+
+	for (FB_SIZE_T i = 0; i < m_keyDescs.getCount(); i++)
+	{
+		const dsc* const value = values[i];
+
+		if (!value)
+		{
+			key[i] = 1;
+			continue;
+		}
+
+		dsc to = m_keyDescs[i];
+		to.dsc_address = key + (IPTR) to.dsc_address;
+
+		// Convert the INTL string into the binary comparable form,
+		// other values are converted to the type of the key
+		if (IS_INTL_DATA(&to))
+		{
+			if (INTL_string_to_key(tdbb, INTL_INDEX_TYPE(&to), value, &to, INTL_KEY_UNIQUE) ==
+					INTL_BAD_KEY_LENGTH)
+			{
+				return false;
+			}
+		}
+		else
+			MOV_move(tdbb, const_cast<dsc*>(value), &to);
+	}
+
+	hash = InternalHash::hash(m_keyLength, key);
+	return true;
+}
+
+// Accumulate the row values into their group, the new group may be postponed.
+// Return false if the key of the row can't be built.
+bool HashAggregatedStream::aggregate(thread_db* tdbb, jrd_req* request, Groups* groups,
+	dsc* const* values) const
+{
+	UCHAR* const key = groups->getKeyBuffer();
+	ULONG hash;
+
+	if (!makeKey(tdbb, values, key, hash))
+		return false;
+
+	Group* group = groups->find(hash, key);
+	Group* const current = groups->getCurrent();
+
+	if (!group || group != current)
+	{
+		if (!group && groups->spill(tdbb, hash, values))
+			return true;
+
+		if (current)
+			saveStates(request, groups->getStates(current));
+
+		if (group)
+			loadStates(request, groups->getStates(group));
+		else
+		{
+			// New group: initialize the aggregates and build the record image
+			// with the values which are the same for the whole group
+
+			group = groups->add(hash, key);
+
+			aggInit(tdbb, request, m_groupMap);
+
+			Record* const record = request->req_rpb[m_stream].rpb_record;
+
+			for (const Assignment* assignment = m_assignments.begin();
+				 assignment != m_assignments.end();
+				 ++assignment)
+			{
+				const FieldNode* const field = nodeAs<FieldNode>(assignment->target);
+				dsc* const value = values[assignment->value];
+
+				if (!value)
+					record->setNull(field->fieldId);
+				else
+				{
+					MOV_move(tdbb, value, EVL_assign_to(tdbb, assignment->target));
+					record->clearNull(field->fieldId);
+				}
+			}
+
+			record->copyDataTo(groups->getRecord(group));
+		}
+
+		groups->setCurrent(group);
+	}
+
+	for (const Aggregate* aggregate = m_aggregates.begin(); aggregate != m_aggregates.end(); ++aggregate)
+	{
+		dsc* desc = NULL;
+
+		if (aggregate->value != NO_VALUE && !(desc = values[aggregate->value]))
+			continue;
+
+		aggregate->node->aggPass(tdbb, request, desc);
+	}
+
+	return true;
+}
+
+// Aggregate the rows spilled into the next partition, if any
+bool HashAggregatedStream::aggregatePartition(thread_db* tdbb, jrd_req* request, Groups* groups) const
+{
+	AutoPtr<Partition> partition(groups->next());
+
+	if (!partition)
+		return false;
+
+	Record* const record = partition->buffer.getTempRecord();
+	dsc** const values = groups->getValues();
+	dsc* const descs = groups->getDescs();
+
+	for (offset_t position = 0; partition->buffer.fetch(position, record); position++)
+	{
+		if (--tdbb->tdbb_quantum < 0)
+			JRD_reschedule(tdbb, 0, true);
+
+		for (USHORT i = 0; i < m_spillFormat->fmt_count; i++)
+			values[i] = EVL_field(NULL, record, i, &descs[i]) ? &descs[i] : NULL;
+
+		// The keys of the spilled rows were built already
+		aggregate(tdbb, request, groups, values);
+	}
+
+	if (groups->getCurrent())
+		saveStates(request, groups->getStates(groups->getCurrent()));
+
+	groups->finish();
+	return true;
+}
+
+// Copy the aggregate states from the request into the group entry
+void HashAggregatedStream::saveStates(jrd_req* request, UCHAR* state) const
+{
+	for (const Aggregate* aggregate = m_aggregates.begin(); aggregate != m_aggregates.end(); ++aggregate)
+	{
+		memcpy(state, request->getImpure<impure_value_ex>(aggregate->node->impureOffset),
+			sizeof(impure_value_ex));
+		state += sizeof(impure_value_ex);
+	}
+}
+
+// Copy the aggregate states of the group entry into the request
+void HashAggregatedStream::loadStates(jrd_req* request, const UCHAR* state) const
+{
+	for (const Aggregate* aggregate = m_aggregates.begin(); aggregate != m_aggregates.end(); ++aggregate)
+	{
+		memcpy(request->getImpure<impure_value_ex>(aggregate->node->impureOffset), state,
+			sizeof(impure_value_ex));
+		state += sizeof(impure_value_ex);
+	}
+}
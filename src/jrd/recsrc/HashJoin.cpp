@@ -32,6 +32,8 @@
 
 #include "RecordSource.h"
 
+#include <algorithm>
+
 using namespace Firebird;
 using namespace Jrd;
 
@@ -39,46 +41,205 @@ using namespace Jrd;
 // Data access: hash join
 // ----------------------
 
-// NS: FIXME - Why use static hash table here??? Hash table shall support dynamic resizing
-static const ULONG HASH_SIZE = 1009;
-static const ULONG BUCKET_PREALLOCATE_SIZE = 32;	// 256 bytes per slot
+const char* const SCRATCH = "fb_hash_";
 
-class HashJoin::HashTable : public PermanentStorage
+// The hash table is sized from the number of collected records,
+// keeping the average number of collisions per slot small
+static const ULONG HASH_LOAD_FACTOR = 2;
+static const ULONG HASH_SIZES[] =
 {
-	class CollisionList
+	1009, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139, 524287,
+	1048573, 2097143, 4194301, 8388593, 16777213
+};
+
+// When the temp cache refuses memory for the hash table, the join is processed
+// in partitions, hashed positions of both inner and leading records are kept
+// in the temporary space meanwhile, separately for every bucket of hash values.
+// Partition consists of one or more adjacent buckets.
+static const ULONG MAX_PARTITIONS = 64;
+static const ULONG ENTRY_BUFFER_SIZE = 1024;	// entries read or written at once
+
+// Memory of the hash table is asked from the temp cache by these steps at least
+static const FB_SIZE_T HASH_MEMORY_STEP = 1024 * 1024;
+
+// The bloom filter pushed down to the scan of the leading stream lets a few
+// percent of the non-matching records pass, given the bits per inner record
+static const ULONG FILTER_BITS_PER_KEY = 8;
+static const ULONG FILTER_HASHES = 3;
+static const ULONG MAX_FILTER_BITS = 1 << 27;
+
+// The filter bits are addressed by double hashing
+static inline ULONG filterStep(ULONG hash)
+{
+	return ((hash >> 17) | (hash << 15)) | 1;
+}
+
+namespace
+{
+	struct Entry
 	{
-		static const FB_SIZE_T INVALID_ITERATOR = FB_SIZE_T(~0);
+		Entry()
+			: hash(0), position(0)
+		{}
+
+		Entry(ULONG h, ULONG pos)
+			: hash(h), position(pos)
+		{}
 
-		struct Entry
+		bool operator<(const Entry& other) const
 		{
-			Entry()
-				: hash(0), position(0)
-			{}
+			return (hash != other.hash) ? hash < other.hash : position < other.position;
+		}
+
+		ULONG hash;
+		ULONG position;
+	};
+
+	// Memory taken by a sorted collision, including the temporary copy and the slot
+	const ULONG ENTRY_MEMORY = 2 * sizeof(Entry) + sizeof(ULONG);
+
+	// Bucket of the hash value, multiplicative hashing scatters
+	// the low-bit keys across the buckets
+
+	inline ULONG getBucket(ULONG hash)
+	{
+		const ULONG scrambled = hash * 2654435761U;
+		return (ULONG) (((FB_UINT64) scrambled * MAX_PARTITIONS) >> 32);
+	}
+
+	// File of hashed record positions split by buckets. Buckets are
+	// written by chunks into the common temporary space and each of
+	// them is read back on its own.
+
+	class EntryFile
+	{
+		struct Chunk
+		{
+			FB_UINT64 offset;
+			ULONG count;
+		};
 
-			Entry(ULONG h, ULONG pos)
-				: hash(h), position(pos)
+		struct Bucket
+		{
+			explicit Bucket(MemoryPool& pool)
+				: chunks(pool), count(0)
 			{}
 
-			static const ULONG generate(const Entry& item)
+			Array<Chunk> chunks;
+			Entry buffer[ENTRY_BUFFER_SIZE];
+			ULONG count;
+		};
+
+	public:
+		explicit EntryFile(MemoryPool& pool)
+			: m_pool(pool), m_space(pool, SCRATCH), m_size(0), m_current(NULL),
+			  m_chunk(0), m_bufferCount(0), m_bufferPosition(0)
+		{
+			memset(m_buckets, 0, sizeof(m_buckets));
+		}
+
+		~EntryFile()
+		{
+			for (ULONG i = 0; i < MAX_PARTITIONS; i++)
+				delete m_buckets[i];
+		}
+
+		void put(ULONG hash, ULONG position)
+		{
+			const ULONG number = getBucket(hash);
+			Bucket* bucket = m_buckets[number];
+
+			if (!bucket)
+				bucket = m_buckets[number] = FB_NEW_POOL(m_pool) Bucket(m_pool);
+
+			if (bucket->count == ENTRY_BUFFER_SIZE)
+				flush(bucket);
+
+			bucket->buffer[bucket->count++] = Entry(hash, position);
+		}
+
+		// Start reading the bucket, entries not flushed yet are read last
+		void rewind(ULONG number)
+		{
+			m_current = m_buckets[number];
+			m_chunk = 0;
+			m_bufferCount = m_bufferPosition = 0;
+		}
+
+		bool get(Entry& entry)
+		{
+			if (m_bufferPosition == m_bufferCount)
 			{
-				return item.hash;
+				if (!m_current)
+					return false;
+
+				if (m_chunk < m_current->chunks.getCount())
+				{
+					const Chunk& chunk = m_current->chunks[m_chunk++];
+					m_space.read(chunk.offset, m_buffer, chunk.count * sizeof(Entry));
+					m_bufferCount = chunk.count;
+				}
+				else
+				{
+					memcpy(m_buffer, m_current->buffer, m_current->count * sizeof(Entry));
+					m_bufferCount = m_current->count;
+					m_current = NULL;
+				}
+
+				m_bufferPosition = 0;
+
+				if (!m_bufferCount)
+					return false;
 			}
 
-			ULONG hash;
-			ULONG position;
-		};
+			entry = m_buffer[m_bufferPosition++];
+			return true;
+		}
 
-	public:
-		CollisionList(MemoryPool& pool)
-			: m_collisions(pool, BUCKET_PREALLOCATE_SIZE),
-			  m_iterator(INVALID_ITERATOR)
+	private:
+		void flush(Bucket* bucket)
 		{
-			m_collisions.setSortMode(FB_ARRAY_SORT_MANUAL);
+			const FB_SIZE_T length = bucket->count * sizeof(Entry);
+
+			m_space.spill();
+			m_space.write(m_size, bucket->buffer, length);
+
+			Chunk& chunk = bucket->chunks.add();
+			chunk.offset = m_size;
+			chunk.count = bucket->count;
+
+			m_size += length;
+			bucket->count = 0;
 		}
 
-		void sort()
+		MemoryPool& m_pool;
+		TempSpace m_space;
+		FB_UINT64 m_size;
+		Bucket* m_buckets[MAX_PARTITIONS];
+		const Bucket* m_current;
+		FB_SIZE_T m_chunk;
+		Entry m_buffer[ENTRY_BUFFER_SIZE];
+		ULONG m_bufferCount;
+		ULONG m_bufferPosition;
+	};
+}
+
+class HashJoin::HashTable : public PermanentStorage
+{
+	// Collisions of the stream ordered by slot and then by hash,
+	// every slot refers the range of its collisions
+
+	class CollisionList
+	{
+	public:
+		explicit CollisionList(MemoryPool& pool)
+			: m_collisions(pool), m_slots(NULL), m_tableSize(0),
+			  m_first(0), m_iterator(0)
+		{}
+
+		~CollisionList()
 		{
-			m_collisions.sort();
+			delete[] m_slots;
 		}
 
 		void add(ULONG hash, ULONG position)
@@ -86,13 +247,84 @@ class HashJoin::HashTable : public PermanentStorage
 			m_collisions.add(Entry(hash, position));
 		}
 
+		FB_SIZE_T getCount() const
+		{
+			return m_collisions.getCount();
+		}
+
+		const Entry* begin() const
+		{
+			return m_collisions.begin();
+		}
+
+		void clear()
+		{
+			m_collisions.clear();
+			delete[] m_slots;
+			m_slots = NULL;
+			m_tableSize = 0;
+		}
+
+		void sort(MemoryPool& pool)
+		{
+			const FB_SIZE_T count = m_collisions.getCount();
+
+			const ULONG* size = HASH_SIZES;
+			const ULONG* const end = HASH_SIZES + FB_NELEM(HASH_SIZES) - 1;
+			while (size < end && *size < count / HASH_LOAD_FACTOR)
+				size++;
+
+			delete[] m_slots;
+			m_tableSize = *size;
+			m_slots = FB_NEW_POOL(pool) ULONG[m_tableSize + 1];
+			memset(m_slots, 0, (m_tableSize + 1) * sizeof(ULONG));
+
+			// Distribute the collisions among the slots
+
+			for (const Entry* entry = m_collisions.begin(); entry < m_collisions.end(); entry++)
+				m_slots[entry->hash % m_tableSize + 1]++;
+
+			for (ULONG i = 0; i < m_tableSize; i++)
+				m_slots[i + 1] += m_slots[i];
+
+			Array<Entry> sorted(pool);
+			Entry* const target = sorted.getBuffer(count);
+
+			{	// scope
+				AutoPtr<ULONG, ArrayDelete> next(FB_NEW_POOL(pool) ULONG[m_tableSize]);
+				memcpy(next, m_slots, m_tableSize * sizeof(ULONG));
+
+				for (const Entry* entry = m_collisions.begin(); entry < m_collisions.end(); entry++)
+					target[next[entry->hash % m_tableSize]++] = *entry;
+			}
+
+			for (ULONG i = 0; i < m_tableSize; i++)
+			{
+				if (m_slots[i + 1] - m_slots[i] > 1)
+					std::sort(target + m_slots[i], target + m_slots[i + 1]);
+			}
+
+			memcpy(m_collisions.begin(), target, count * sizeof(Entry));
+		}
+
 		bool locate(ULONG hash)
 		{
-			if (m_collisions.find(hash, m_iterator))
-				return true;
+			const ULONG slot = hash % m_tableSize;
+			const Entry* const begin = m_collisions.begin();
+			const Entry* const end = begin + m_slots[slot + 1];
 
-			m_iterator = INVALID_ITERATOR;
-			return false;
+			const Entry* const entry = std::lower_bound(begin + m_slots[slot], end, Entry(hash, 0));
+
+			if (entry == end || entry->hash != hash)
+				return false;
+
+			m_first = m_iterator = (ULONG) (entry - begin);
+			return true;
+		}
+
+		void reset()
+		{
+			m_iterator = m_first;
 		}
 
 		bool iterate(ULONG hash, ULONG& position)
@@ -100,115 +332,269 @@ class HashJoin::HashTable : public PermanentStorage
 			if (m_iterator >= m_collisions.getCount())
 				return false;
 
-			const Entry& collision = m_collisions[m_iterator++];
+			const Entry& collision = m_collisions[m_iterator];
 
 			if (hash != collision.hash)
-			{
-				m_iterator = INVALID_ITERATOR;
 				return false;
-			}
 
+			m_iterator++;
 			position = collision.position;
 			return true;
 		}
 
 	private:
-		SortedArray<Entry, EmptyStorage<Entry>, ULONG, Entry> m_collisions;
-		FB_SIZE_T m_iterator;
+		Array<Entry> m_collisions;
+		ULONG* m_slots;
+		ULONG m_tableSize;
+		ULONG m_first;
+		ULONG m_iterator;
 	};
 
 public:
-	HashTable(MemoryPool& pool, ULONG streamCount, ULONG tableSize = HASH_SIZE)
-		: PermanentStorage(pool), m_streamCount(streamCount),
-		  m_tableSize(tableSize), m_slot(0)
+	HashTable(MemoryPool& pool, ULONG streamCount)
+		: PermanentStorage(pool), m_streams(pool), m_space(pool, SCRATCH), m_reserved(0)
 	{
-		m_collisions = FB_NEW_POOL(pool) CollisionList*[streamCount * tableSize];
-		memset(m_collisions, 0, streamCount * tableSize * sizeof(CollisionList*));
+		for (ULONG i = 0; i < streamCount; i++)
+			m_streams.add(FB_NEW_POOL(pool) CollisionList(pool));
 	}
 
 	~HashTable()
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
-			delete m_collisions[i];
-
-		delete[] m_collisions;
+		for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+			delete m_streams[i];
 	}
 
 	void put(ULONG stream, ULONG hash, ULONG position)
 	{
-		const ULONG slot = hash % m_tableSize;
+		m_streams[stream]->add(hash, position);
+	}
+
+	bool setup(ULONG hash)
+	{
+		for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+		{
+			if (!m_streams[i]->locate(hash))
+				return false;
+		}
+
+		return true;
+	}
+
+	void reset(ULONG stream, ULONG /*hash*/)
+	{
+		m_streams[stream]->reset();
+	}
+
+	bool iterate(ULONG stream, ULONG hash, ULONG& position)
+	{
+		return m_streams[stream]->iterate(hash, position);
+	}
+
+	void sort()
+	{
+		for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+			m_streams[i]->sort(getPool());
+	}
+
+	void clear()
+	{
+		for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+			m_streams[i]->clear();
+	}
+
+	FB_SIZE_T getCount(ULONG stream) const
+	{
+		return m_streams[stream]->getCount();
+	}
+
+	const Entry* getEntries(ULONG stream) const
+	{
+		return m_streams[stream]->begin();
+	}
+
+	// Approximate memory taken by the collisions once they're sorted
+	FB_UINT64 getMemoryUsage() const
+	{
+		FB_UINT64 usage = 0;
+
+		for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+			usage += (FB_UINT64) m_streams[i]->getCount() * ENTRY_MEMORY;
+
+		return usage;
+	}
+
+	// Ask the temp cache for the memory taken by the collisions,
+	// return false if it refuses to give more
+	bool reserve()
+	{
+		const FB_UINT64 usage = getMemoryUsage();
+
+		if (usage <= m_reserved)
+			return true;
+
+		const FB_SIZE_T size = (FB_SIZE_T) MAX(usage - m_reserved, HASH_MEMORY_STEP);
+
+		if (!m_space.reserveMemory(size))
+			return false;
+
+		m_reserved += size;
+		return true;
+	}
+
+	FB_UINT64 getReserved() const
+	{
+		return m_reserved;
+	}
+
+private:
+	Array<CollisionList*> m_streams;
+	TempSpace m_space;		// used to account the memory in the temp cache
+	FB_UINT64 m_reserved;
+};
+
+
+// Hashed positions of the records not belonging to the partition being joined
+
+class HashJoin::Partitions : public PermanentStorage
+{
+public:
+	Partitions(MemoryPool& pool, ULONG streamCount)
+		: PermanentStorage(pool), m_inner(pool), m_leader(pool),
+		  m_count(1), m_current(0), m_leaderBucket(0), m_memory(0)
+	{
+		for (ULONG i = 0; i < streamCount; i++)
+			m_inner.add(FB_NEW_POOL(pool) EntryFile(pool));
+	}
 
-		fb_assert(stream < m_streamCount);
-		fb_assert(slot < m_tableSize);
+	~Partitions()
+	{
+		for (FB_SIZE_T i = 0; i < m_inner.getCount(); i++)
+			delete m_inner[i];
+	}
 
-		CollisionList* collisions = m_collisions[stream * m_tableSize + slot];
+	// Move the collected collisions out of the hash table
+	void spill(HashTable* table)
+	{
+		m_memory += table->getMemoryUsage();
 
-		if (!collisions)
+		for (FB_SIZE_T i = 0; i < m_inner.getCount(); i++)
 		{
-			collisions = FB_NEW_POOL(getPool()) CollisionList(getPool());
-			m_collisions[stream * m_tableSize + slot] = collisions;
+			const Entry* const entries = table->getEntries(i);
+			const FB_SIZE_T count = table->getCount(i);
+
+			for (FB_SIZE_T j = 0; j < count; j++)
+				m_inner[i]->put(entries[j].hash, entries[j].position);
 		}
 
-		collisions->add(hash, position);
+		table->clear();
 	}
 
-	bool setup(ULONG hash)
+	void putInner(ULONG stream, ULONG hash, ULONG position)
 	{
-		const ULONG slot = hash % m_tableSize;
+		m_inner[stream]->put(hash, position);
+		m_memory += ENTRY_MEMORY;
+	}
 
-		for (ULONG i = 0; i < m_streamCount; i++)
-		{
-			CollisionList* const collisions = m_collisions[i * m_tableSize + slot];
+	// All inner records are collected, choose the number of partitions
+	// so that every of them fits the budget and load the first one
+	void start(HashTable* table, FB_UINT64 budget)
+	{
+		m_count = (ULONG) MIN(m_memory / MAX(budget, 1) + 1, MAX_PARTITIONS);
+		m_current = 0;
+		load(table);
+	}
 
-			if (!collisions)
-				return false;
+	bool isCurrent(ULONG hash) const
+	{
+		return (getBucket(hash) * m_count / MAX_PARTITIONS == m_current);
+	}
+
+	bool isFirst() const
+	{
+		return (m_current == 0);
+	}
 
-			if (!collisions->locate(hash))
+	void putLeader(ULONG hash, ULONG position)
+	{
+		m_leader.put(hash, position);
+	}
+
+	// Fetch the next leading record of the current partition
+	bool getLeader(ULONG& hash, ULONG& position)
+	{
+		Entry entry;
+
+		while (!m_leader.get(entry))
+		{
+			if (++m_leaderBucket >= getFirstBucket(m_current + 1))
 				return false;
+
+			m_leader.rewind(m_leaderBucket);
 		}
 
-		m_slot = slot;
+		hash = entry.hash;
+		position = entry.position;
 		return true;
 	}
 
-	void reset(ULONG stream, ULONG hash)
+	// Switch to the next partition, if any
+	bool next(HashTable* table)
 	{
-		fb_assert(stream < m_streamCount);
+		if (++m_current >= m_count)
+			return false;
 
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		collisions->locate(hash);
+		load(table);
+
+		m_leaderBucket = getFirstBucket(m_current);
+		m_leader.rewind(m_leaderBucket);
+		return true;
 	}
 
-	bool iterate(ULONG stream, ULONG hash, ULONG& position)
+private:
+	// Partition consists of the buckets from the first one up to the first one of the next
+	ULONG getFirstBucket(ULONG partition) const
 	{
-		fb_assert(stream < m_streamCount);
-
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		return collisions->iterate(hash, position);
+		return (partition * MAX_PARTITIONS + m_count - 1) / m_count;
 	}
 
-	void sort()
+	// Every inner entry is read just once, with its partition
+	void load(HashTable* table)
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
+		table->clear();
+
+		const ULONG last = getFirstBucket(m_current + 1);
+
+		for (FB_SIZE_T i = 0; i < m_inner.getCount(); i++)
 		{
-			CollisionList* const collisions = m_collisions[i];
+			EntryFile* const file = m_inner[i];
 
-			if (collisions)
-				collisions->sort();
+			for (ULONG bucket = getFirstBucket(m_current); bucket < last; bucket++)
+			{
+				file->rewind(bucket);
+
+				Entry entry;
+				while (file->get(entry))
+					table->put(i, entry.hash, entry.position);
+			}
 		}
+
+		table->sort();
 	}
 
-private:
-	const ULONG m_streamCount;
-	const ULONG m_tableSize;
-	CollisionList** m_collisions;
-	ULONG m_slot;
+	Array<EntryFile*> m_inner;
+	EntryFile m_leader;
+	ULONG m_count;
+	ULONG m_current;
+	ULONG m_leaderBucket;
+	FB_UINT64 m_memory;
 };
 
 
 HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 				   RecordSource* const* args, NestValueArray* const* keys)
-	: m_args(csb->csb_pool, count - 1)
+	: m_args(csb->csb_pool, count - 1), m_joinType(INNER_JOIN),
+	  m_boolean(NULL), m_matchBoolean(NULL), m_invariant(0), m_filtered(false),
+	  m_leaderBatch(false)
 {
 	fb_assert(count >= 2);
 
@@ -216,23 +602,9 @@ HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 
 	m_leader.source = args[0];
 	m_leader.keys = keys[0];
-	const FB_SIZE_T leaderKeyCount = m_leader.keys->getCount();
-	m_leader.keyLengths = FB_NEW_POOL(csb->csb_pool) ULONG[leaderKeyCount];
-	m_leader.totalKeyLength = 0;
-
-	for (FB_SIZE_T j = 0; j < leaderKeyCount; j++)
-	{
-		dsc desc;
-		(*m_leader.keys)[j]->getDesc(tdbb, csb, &desc);
-
-		USHORT keyLength = desc.isText() ? desc.getStringLength() : desc.dsc_length;
-
-		if (IS_INTL_DATA(&desc))
-			keyLength = INTL_key_length(tdbb, INTL_INDEX_TYPE(&desc), keyLength);
-
-		m_leader.keyLengths[j] = keyLength;
-		m_leader.totalKeyLength += keyLength;
-	}
+	m_leaderBuffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, m_leader.source);
+	m_leaderBatch = RecordBatch::isNarrow(csb, m_leader.source);
+	setupKeys(tdbb, csb, m_leader);
 
 	for (FB_SIZE_T i = 1; i < count; i++)
 	{
@@ -242,37 +614,140 @@ HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 		SubStream sub;
 		sub.buffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, sub_rsb);
 		sub.keys = keys[i];
-		const FB_SIZE_T subKeyCount = sub.keys->getCount();
-		sub.keyLengths = FB_NEW_POOL(csb->csb_pool) ULONG[subKeyCount];
-		sub.totalKeyLength = 0;
+		setupKeys(tdbb, csb, sub);
 
-		for (FB_SIZE_T j = 0; j < subKeyCount; j++)
-		{
-			dsc desc;
-			(*sub.keys)[j]->getDesc(tdbb, csb, &desc);
+		m_args.add(sub);
+	}
+
+	setupFilter(csb);
+}
+
+HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, JoinType joinType,
+				   RecordSource* outer, RecordSource* inner,
+				   NestValueArray* outerKeys, NestValueArray* innerKeys,
+				   BoolExprNode* boolean, BoolExprNode* matchBoolean)
+	: m_args(csb->csb_pool, 1), m_joinType(joinType),
+	  m_boolean(boolean), m_matchBoolean(matchBoolean), m_invariant(0), m_filtered(false),
+	  m_leaderBatch(false)
+{
+	fb_assert(inner && outerKeys && innerKeys);
+
+	m_impure = CMP_impure(csb, sizeof(Impure));
+
+	// Without the outer stream, the join probes the keys of the current context.
+	// Used for correlated subqueries, the hash table is built once per open of
+	// the enclosing top-level cursor, like invariants bound to it are computed.
+	// Data changed by the procedures, triggers or other statements executed
+	// meanwhile could make the table stale, so it's not kept any longer.
+
+	m_leader.source = outer;
+	m_leader.keys = outerKeys;
+	m_leaderBuffer = NULL;
+	setupKeys(tdbb, csb, m_leader);
+
+	if (outer)
+	{
+		m_leaderBuffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, outer);
+		m_leaderBatch = RecordBatch::isNarrow(csb, outer);
+	}
+	else
+	{
+		fb_assert(joinType == INNER_JOIN);
 
-			USHORT keyLength = desc.isText() ? desc.getStringLength() : desc.dsc_length;
+		m_invariant = CMP_impure(csb, sizeof(impure_value));
+		csb->csb_invariants.push(&m_invariant);
 
-			if (IS_INTL_DATA(&desc))
-				keyLength = INTL_key_length(tdbb, INTL_INDEX_TYPE(&desc), keyLength);
+		fb_assert(csb->csb_current_nodes.hasData());
+		RseNode* const topRseNode = nodeAs<RseNode>(csb->csb_current_nodes[0]);
+		fb_assert(topRseNode);
 
-			sub.keyLengths[j] = keyLength;
-			sub.totalKeyLength += keyLength;
+		if (!topRseNode->rse_invariants)
+		{
+			topRseNode->rse_invariants =
+				FB_NEW_POOL(*tdbb->getDefaultPool()) VarInvariantArray(*tdbb->getDefaultPool());
 		}
 
-		m_args.add(sub);
+		topRseNode->rse_invariants->add(m_invariant);
+	}
+
+	SubStream sub;
+	sub.buffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, inner);
+	sub.keys = innerKeys;
+	setupKeys(tdbb, csb, sub);
+
+	m_args.add(sub);
+
+	setupFilter(csb);
+}
+
+void HashJoin::setupKeys(thread_db* tdbb, CompilerScratch* csb, SubStream& sub)
+{
+	const FB_SIZE_T keyCount = sub.keys->getCount();
+	sub.keyLengths = FB_NEW_POOL(csb->csb_pool) ULONG[keyCount];
+	sub.totalKeyLength = 0;
+
+	for (FB_SIZE_T j = 0; j < keyCount; j++)
+	{
+		dsc desc;
+		(*sub.keys)[j]->getDesc(tdbb, csb, &desc);
+
+		USHORT keyLength = desc.isText() ? desc.getStringLength() : desc.dsc_length;
+
+		if (IS_INTL_DATA(&desc))
+			keyLength = INTL_key_length(tdbb, INTL_INDEX_TYPE(&desc), keyLength);
+
+		sub.keyLengths[j] = keyLength;
+		sub.totalKeyLength += keyLength;
 	}
 }
 
-void HashJoin::open(thread_db* tdbb) const
+void HashJoin::setupFilter(CompilerScratch* csb)
+{
+	// Leading records matching no inner record are useless for inner and semi joins,
+	// so the scan of the leading stream may reject them checking a bloom filter
+	// of the inner keys. That's possible when the keys depend on a single stream.
+
+	if (!m_leader.source || (m_joinType != INNER_JOIN && m_joinType != SEMI_JOIN))
+		return;
+
+	SortedStreamList streams;
+
+	for (FB_SIZE_T i = 0; i < m_leader.keys->getCount(); i++)
+		(*m_leader.keys)[i]->collectStreams(csb, streams);
+
+	if (streams.getCount() == 1)
+		m_filtered = m_leader.source->pushFilter(streams[0], this);
+}
+
+void HashJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
 
 	impure->irsb_flags = irsb_open | irsb_mustread;
+	impure->irsb_probed = false;
+
+	impure_value* const invariant =
+		m_leader.source ? NULL : request->getImpure<impure_value>(m_invariant);
+
+	if (invariant)
+	{
+		// Probe mode: reuse the hash table built since the enclosing cursor was opened
+
+		if (invariant->vlu_flags & VLU_computed)
+			return;
+
+		m_args[0].buffer->close(tdbb);
+	}
 
 	delete impure->irsb_hash_table;
 	delete[] impure->irsb_leader_buffer;
+	delete impure->irsb_partitions;
+	impure->irsb_partitions = NULL;
+	delete[] impure->irsb_filter;
+	impure->irsb_filter = NULL;
+	delete impure->irsb_leader_batch;
+	impure->irsb_leader_batch = NULL;
 
 	MemoryPool& pool = *tdbb->getDefaultPool();
 
@@ -281,6 +756,8 @@ void HashJoin::open(thread_db* tdbb) const
 	impure->irsb_hash_table = FB_NEW_POOL(pool) HashTable(pool, argCount);
 	impure->irsb_leader_buffer = FB_NEW_POOL(pool) UCHAR[m_leader.totalKeyLength];
 
+	HashTable* const hashTable = impure->irsb_hash_table;
+
 	UCharBuffer buffer(pool);
 
 	for (FB_SIZE_T i = 0; i < argCount; i++)
@@ -296,13 +773,43 @@ void HashJoin::open(thread_db* tdbb) const
 		while (m_args[i].buffer->getRecord(tdbb))
 		{
 			const ULONG hash = computeHash(tdbb, request, m_args[i], keyBuffer);
-			impure->irsb_hash_table->put(i, hash, counter++);
+
+			if (impure->irsb_partitions)
+			{
+				impure->irsb_partitions->putInner(i, hash, counter++);
+				continue;
+			}
+
+			hashTable->put(i, hash, counter++);
+
+			// The hash table grows while the temp cache gives it memory,
+			// larger joins are processed in partitions fitting that much
+
+			if (m_leader.source && !hashTable->reserve())
+			{
+				impure->irsb_partitions = FB_NEW_POOL(pool) Partitions(pool, argCount);
+				impure->irsb_partitions->spill(hashTable);
+			}
 		}
 	}
 
-	impure->irsb_hash_table->sort();
+	if (impure->irsb_partitions)
+	{
+		impure->irsb_partitions->start(hashTable, hashTable->getReserved());
+		m_leaderBuffer->open(tdbb);
+	}
+	else
+	{
+		hashTable->sort();
+
+		if (m_filtered)
+			buildFilter(tdbb, impure);
 
-	m_leader.source->open(tdbb);
+		if (m_leader.source)
+			m_leader.source->open(tdbb);
+		else
+			invariant->vlu_flags |= VLU_computed;
+	}
 }
 
 void HashJoin::close(thread_db* tdbb) const
@@ -316,20 +823,38 @@ void HashJoin::close(thread_db* tdbb) const
 	{
 		impure->irsb_flags &= ~irsb_open;
 
+		// Probe mode keeps the hash table and the inner stream buffered
+		if (!m_leader.source)
+			return;
+
 		delete impure->irsb_hash_table;
 		impure->irsb_hash_table = NULL;
 
 		delete[] impure->irsb_leader_buffer;
 		impure->irsb_leader_buffer = NULL;
 
+		delete[] impure->irsb_filter;
+		impure->irsb_filter = NULL;
+
+		delete impure->irsb_leader_batch;
+		impure->irsb_leader_batch = NULL;
+
 		for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 			m_args[i].buffer->close(tdbb);
 
-		m_leader.source->close(tdbb);
+		if (impure->irsb_partitions)
+		{
+			delete impure->irsb_partitions;
+			impure->irsb_partitions = NULL;
+
+			m_leaderBuffer->close(tdbb);
+		}
+		else
+			m_leader.source->close(tdbb);
 	}
 }
 
-bool HashJoin::getRecord(thread_db* tdbb) const
+bool HashJoin::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -340,20 +865,19 @@ bool HashJoin::getRecord(thread_db* tdbb) const
 	if (!(impure->irsb_flags & irsb_open))
 		return false;
 
+	if (m_joinType != INNER_JOIN || !m_leader.source)
+		return fetchMatch(tdbb, request, impure);
+
 	while (true)
 	{
 		if (impure->irsb_flags & irsb_mustread)
 		{
-			// Fetch the record from the leading stream
+			// Fetch the record from the leading stream,
+			// compute and hash the comparison keys
 
-			if (!m_leader.source->getRecord(tdbb))
+			if (!fetchLeader(tdbb, request, impure))
 				return false;
 
-			// Compute and hash the comparison keys
-
-			impure->irsb_leader_hash =
-				computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
-
 			// Ensure the every inner stream having matches for this hash slot.
 			// Setup the hash table for the iteration through collisions.
 
@@ -399,6 +923,33 @@ bool HashJoin::getRecord(thread_db* tdbb) const
 	return true;
 }
 
+ULONG HashJoin::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+		return 0;
+
+	// The batch consumer neither refetches nor locks the records, so the leading
+	// stream may be fetched by batches too, unless it's replayed in partitions
+
+	if (m_leaderBatch && !impure->irsb_leader_batch && !impure->irsb_partitions && supportsBatch())
+	{
+		MemoryPool& pool = *tdbb->getDefaultPool();
+
+		StreamList streams;
+		m_leader.source->findUsedStreams(streams);
+
+		impure->irsb_leader_batch = FB_NEW_POOL(pool) RecordBatch(pool, streams);
+	}
+
+	while (!batch.isFull() && HashJoin::internalGetRecord(tdbb))
+		batch.put(request);
+
+	return batch.getCount();
+}
+
 bool HashJoin::refetchRecord(thread_db* /*tdbb*/) const
 {
 	return true;
@@ -410,13 +961,36 @@ bool HashJoin::lockRecord(thread_db* /*tdbb*/) const
 	return false; // compiler silencer
 }
 
-void HashJoin::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void HashJoin::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
-		plan += printIndent(++level) + "Hash Join (inner)";
+		plan += printIndent(++level) + "Hash Join ";
+
+		switch (m_joinType)
+		{
+			case INNER_JOIN:
+				plan += m_leader.source ? "(inner)" : "(probe)";
+				break;
 
-		m_leader.source->print(tdbb, plan, true, level);
+			case OUTER_JOIN:
+				plan += "(outer)";
+				break;
+
+			case SEMI_JOIN:
+				plan += "(semi)";
+				break;
+
+			case ANTI_JOIN:
+				plan += "(anti)";
+				break;
+
+			default:
+				fb_assert(false);
+		}
+
+		if (m_leader.source)
+			m_leader.source->print(tdbb, plan, true, level);
 
 		for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 			m_args[i].source->print(tdbb, plan, true, level);
@@ -425,8 +999,11 @@ void HashJoin::print(thread_db* tdbb, string& plan, bool detailed, unsigned leve
 	{
 		level++;
 		plan += "HASH (";
-		m_leader.source->print(tdbb, plan, false, level);
-		plan += ", ";
+		if (m_leader.source)
+		{
+			m_leader.source->print(tdbb, plan, false, level);
+			plan += ", ";
+		}
 		for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 		{
 			if (i)
@@ -440,7 +1017,8 @@ void HashJoin::print(thread_db* tdbb, string& plan, bool detailed, unsigned leve
 
 void HashJoin::markRecursive()
 {
-	m_leader.source->markRecursive();
+	if (m_leader.source)
+		m_leader.source->markRecursive();
 
 	for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 		m_args[i].source->markRecursive();
@@ -448,7 +1026,8 @@ void HashJoin::markRecursive()
 
 void HashJoin::findUsedStreams(StreamList& streams, bool expandAll) const
 {
-	m_leader.source->findUsedStreams(streams, expandAll);
+	if (m_leader.source)
+		m_leader.source->findUsedStreams(streams, expandAll);
 
 	for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 		m_args[i].source->findUsedStreams(streams, expandAll);
@@ -456,7 +1035,8 @@ void HashJoin::findUsedStreams(StreamList& streams, bool expandAll) const
 
 void HashJoin::invalidateRecords(jrd_req* request) const
 {
-	m_leader.source->invalidateRecords(request);
+	if (m_leader.source)
+		m_leader.source->invalidateRecords(request);
 
 	for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 		m_args[i].source->invalidateRecords(request);
@@ -464,12 +1044,38 @@ void HashJoin::invalidateRecords(jrd_req* request) const
 
 void HashJoin::nullRecords(thread_db* tdbb) const
 {
-	m_leader.source->nullRecords(tdbb);
+	if (m_leader.source)
+		m_leader.source->nullRecords(tdbb);
 
 	for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 		m_args[i].source->nullRecords(tdbb);
 }
 
+bool HashJoin::checkFilter(thread_db* tdbb) const
+{
+	jrd_req* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	const ULONG* const filter = impure->irsb_filter;
+
+	if (!filter)
+		return true;
+
+	const ULONG hash = computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
+	const ULONG step = filterStep(hash);
+	ULONG bit = hash;
+
+	for (ULONG i = 0; i < FILTER_HASHES; i++, bit += step)
+	{
+		const ULONG position = bit & impure->irsb_filter_mask;
+
+		if (!(filter[position >> 5] & (1U << (position & 31))))
+			return false;
+	}
+
+	return true;
+}
+
 ULONG HashJoin::computeHash(thread_db* tdbb,
 							jrd_req* request,
 						    const SubStream& sub,
@@ -520,6 +1126,122 @@ ULONG HashJoin::computeHash(thread_db* tdbb,
 	return InternalHash::hash(sub.totalKeyLength, keyBuffer);
 }
 
+bool HashJoin::fetchLeader(thread_db* tdbb, jrd_req* request, Impure* impure) const
+{
+	Partitions* const partitions = impure->irsb_partitions;
+
+	if (!partitions)
+	{
+		if (!m_leader.source)
+		{
+			// Probe mode: the only leading "record" is the current context
+
+			if (impure->irsb_probed)
+				return false;
+
+			impure->irsb_probed = true;
+		}
+		else if (impure->irsb_leader_batch)
+		{
+			if (!impure->irsb_leader_batch->fetch(tdbb, m_leader.source))
+				return false;
+		}
+		else if (!m_leader.source->getRecord(tdbb))
+			return false;
+
+		impure->irsb_leader_hash =
+			computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
+
+		return true;
+	}
+
+	// While joining the first partition, the leading stream is read and buffered.
+	// Records of the other partitions are put aside to be joined later.
+
+	if (partitions->isFirst())
+	{
+		while (m_leaderBuffer->getRecord(tdbb))
+		{
+			const ULONG hash = computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
+
+			if (partitions->isCurrent(hash))
+			{
+				impure->irsb_leader_hash = hash;
+				return true;
+			}
+
+			const FB_UINT64 position = m_leaderBuffer->getPosition(request) - 1;
+			partitions->putLeader(hash, (ULONG) position);
+		}
+	}
+
+	// Then the leading records put aside are replayed partition by partition
+
+	while (true)
+	{
+		ULONG hash, position;
+
+		if (!partitions->isFirst() && partitions->getLeader(hash, position))
+		{
+			m_leaderBuffer->locate(tdbb, position);
+
+			if (!m_leaderBuffer->getRecord(tdbb))
+				fb_assert(false);
+
+			impure->irsb_leader_hash = hash;
+			return true;
+		}
+
+		if (!partitions->next(impure->irsb_hash_table))
+			return false;
+	}
+}
+
+void HashJoin::buildFilter(thread_db* tdbb, Impure* impure) const
+{
+	const HashTable* const hashTable = impure->irsb_hash_table;
+
+	// Any inner stream is fine to filter by, the smallest one rejects the most
+
+	FB_SIZE_T stream = 0;
+
+	for (FB_SIZE_T i = 1; i < m_args.getCount(); i++)
+	{
+		if (hashTable->getCount(i) < hashTable->getCount(stream))
+			stream = i;
+	}
+
+	const FB_SIZE_T count = hashTable->getCount(stream);
+
+	if (count > MAX_FILTER_BITS / FILTER_BITS_PER_KEY)
+		return;
+
+	ULONG bits = 64;
+	while (bits < count * FILTER_BITS_PER_KEY)
+		bits <<= 1;
+
+	ULONG* const filter = FB_NEW_POOL(*tdbb->getDefaultPool()) ULONG[bits >> 5];
+	memset(filter, 0, (bits >> 5) * sizeof(ULONG));
+
+	const Entry* const entries = hashTable->getEntries(stream);
+
+	for (FB_SIZE_T i = 0; i < count; i++)
+	{
+		const ULONG hash = entries[i].hash;
+		const ULONG step = filterStep(hash);
+		ULONG bit = hash;
+
+		for (ULONG j = 0; j < FILTER_HASHES; j++, bit += step)
+		{
+			const ULONG position = bit & (bits - 1);
+			filter[position >> 5] |= 1U << (position & 31);
+		}
+	}
+
+	impure->irsb_filter = filter;
+	impure->irsb_filter_mask = bits - 1;
+}
+
 bool HashJoin::fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) const
 {
 	HashTable* const hashTable = impure->irsb_hash_table;
@@ -551,3 +1273,75 @@ bool HashJoin::fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) co
 		}
 	}
 }
+
+bool HashJoin::fetchMatch(thread_db* tdbb, jrd_req* request, Impure* impure) const
+{
+	// Join a single inner stream, outer, semi and anti joins are processed here
+
+	fb_assert(m_args.getCount() == 1);
+
+	HashTable* const hashTable = impure->irsb_hash_table;
+	const BufferedStream* const inner = m_args[0].buffer;
+
+	while (true)
+	{
+		if (impure->irsb_flags & irsb_mustread)
+		{
+			if (!fetchLeader(tdbb, request, impure))
+				return false;
+
+			impure->irsb_flags &= ~(irsb_mustread | irsb_joined | irsb_first);
+
+			if (m_boolean && !m_boolean->execute(tdbb, request))
+			{
+				// The boolean pertaining to the leading stream is false,
+				// so the record cannot be joined to anything
+
+				impure->irsb_flags |= irsb_mustread;
+
+				if (m_joinType == INNER_JOIN || m_joinType == SEMI_JOIN)
+					continue;
+
+				inner->nullRecords(tdbb);
+				return true;
+			}
+
+			if (hashTable->setup(impure->irsb_leader_hash))
+				impure->irsb_flags |= irsb_first;
+		}
+
+		// Iterate through the collisions, verifying them to be real matches
+
+		ULONG position;
+		while ((impure->irsb_flags & irsb_first) &&
+			hashTable->iterate(0, impure->irsb_leader_hash, position))
+		{
+			inner->locate(tdbb, position);
+
+			if (!inner->getRecord(tdbb))
+				continue;
+
+			if (m_matchBoolean && !m_matchBoolean->execute(tdbb, request))
+				continue;
+
+			impure->irsb_flags |= irsb_joined;
+
+			if (m_joinType == INNER_JOIN || m_joinType == OUTER_JOIN)
+				return true;
+
+			// A single match is enough to decide about semi and anti joins
+			break;
+		}
+
+		impure->irsb_flags |= irsb_mustread;
+
+		const bool joined = (impure->irsb_flags & irsb_joined);
+
+		if ((m_joinType == SEMI_JOIN && joined) ||
+			((m_joinType == OUTER_JOIN || m_joinType == ANTI_JOIN) && !joined))
+		{
+			inner->nullRecords(tdbb);
+			return true;
+		}
+	}
+}
@@ -60,7 +60,7 @@ IndexTableScan::IndexTableScan(CompilerScratch* csb, const string& alias,
 	m_impure = CMP_impure(csb, static_cast<ULONG>(size));
 }
 
-void IndexTableScan::open(thread_db* tdbb) const
+void IndexTableScan::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -109,7 +109,7 @@ void IndexTableScan::close(thread_db* tdbb) const
 	}
 }
 
-bool IndexTableScan::getRecord(thread_db* tdbb) const
+bool IndexTableScan::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -231,7 +231,9 @@ bool IndexTableScan::getRecord(thread_db* tdbb) const
 						rpb->rpb_number.getValue());
 
 				rpb->rpb_number.setValid(true);
-				return true;
+
+				if (!m_filter || m_filter->checkFilter(tdbb))
+					return true;
 			}
 		}
 
@@ -250,7 +252,7 @@ bool IndexTableScan::getRecord(thread_db* tdbb) const
 	return false;
 }
 
-void IndexTableScan::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void IndexTableScan::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
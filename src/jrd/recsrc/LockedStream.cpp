@@ -42,7 +42,7 @@ LockedStream::LockedStream(CompilerScratch* csb, RecordSource* next)
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void LockedStream::open(thread_db* tdbb) const
+void LockedStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -68,7 +68,7 @@ void LockedStream::close(thread_db* tdbb) const
 	}
 }
 
-bool LockedStream::getRecord(thread_db* tdbb) const
+bool LockedStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -103,7 +103,7 @@ bool LockedStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void LockedStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void LockedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "Write Lock";
@@ -57,7 +57,7 @@ NestedLoopJoin::NestedLoopJoin(CompilerScratch* csb, RecordSource* outer, Record
 	m_args.add(inner);
 }
 
-void NestedLoopJoin::open(thread_db* tdbb) const
+void NestedLoopJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -82,7 +82,7 @@ void NestedLoopJoin::close(thread_db* tdbb) const
 	}
 }
 
-bool NestedLoopJoin::getRecord(thread_db* tdbb) const
+bool NestedLoopJoin::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -197,7 +197,7 @@ bool NestedLoopJoin::lockRecord(thread_db* /*tdbb*/) const
 	return false; // compiler silencer
 }
 
-void NestedLoopJoin::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void NestedLoopJoin::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (m_args.hasData())
 	{
@@ -270,6 +270,21 @@ void NestedLoopJoin::nullRecords(thread_db* tdbb) const
 		m_args[i]->nullRecords(tdbb);
 }
 
+bool NestedLoopJoin::pushFilter(StreamType stream, const HashJoin* join)
+{
+	// Records not joined to anything may be rejected for inner joins only
+	if (m_joinType != INNER_JOIN)
+		return false;
+
+	for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
+	{
+		if (m_args[i]->pushFilter(stream, join))
+			return true;
+	}
+
+	return false;
+}
+
 bool NestedLoopJoin::fetchRecord(thread_db* tdbb, FB_SIZE_T n) const
 {
 	fb_assert(m_joinType == INNER_JOIN);
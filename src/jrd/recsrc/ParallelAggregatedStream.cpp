@@ -0,0 +1,583 @@
+/*
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../common/classes/auto.h"
+#include "../common/classes/fb_atomic.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/tra.h"
+#include "../jrd/intl.h"
+#include "../jrd/WorkerPool.h"
+#include "../dsql/Nodes.h"
+#include "../dsql/BoolNodes.h"
+#include "../dsql/ExprNodes.h"
+#include "../dsql/StmtNodes.h"
+#include "../jrd/cch_proto.h"
+#include "../jrd/cmp_proto.h"
+#include "../jrd/evl_proto.h"
+#include "../jrd/exe_proto.h"
+#include "../jrd/intl_proto.h"
+#include "../jrd/met_proto.h"
+#include "../jrd/tra_proto.h"
+#include "../jrd/vio_proto.h"
+
+#include "RecordSource.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+// ---------------------------------
+// Data access: parallel aggregation
+// ---------------------------------
+
+namespace
+{
+	// The expressions evaluated by the workers may refer only to the scanned record,
+	// the parameters and the literals, so they don't touch the state shared by the
+	// attachment. The parameters and the collations used are collected on the way.
+
+	class ExpressionChecker
+	{
+	public:
+		ExpressionChecker(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+				Array<const ParameterNode*>& parameters, SortedArray<USHORT>& textTypes)
+			: m_tdbb(tdbb), m_csb(csb), m_stream(stream),
+			  m_parameters(parameters), m_textTypes(textTypes)
+		{}
+
+		bool check(const ExprNode* node)
+		{
+			if (const FieldNode* const fieldNode = nodeAs<FieldNode>(node))
+			{
+				if (fieldNode->fieldStream != m_stream || fieldNode->cursorNumber.specified)
+					return false;
+			}
+			else if (const ParameterNode* const paramNode = nodeAs<ParameterNode>(node))
+			{
+				if (!m_parameters.exist(paramNode))
+					m_parameters.add(paramNode);
+			}
+			else if (!nodeIs<LiteralNode>(node) &&
+				!nodeIs<NullNode>(node) &&
+				!nodeIs<ArithmeticNode>(node) &&
+				!nodeIs<NegateNode>(node) &&
+				!nodeIs<CastNode>(node) &&
+				!nodeIs<CoalesceNode>(node) &&
+				!nodeIs<ConcatenateNode>(node) &&
+				!nodeIs<ValueIfNode>(node) &&
+				!nodeIs<ComparativeBoolNode>(node) &&
+				!nodeIs<BinaryBoolNode>(node) &&
+				!nodeIs<NotBoolNode>(node) &&
+				!nodeIs<MissingBoolNode>(node))
+			{
+				return false;
+			}
+
+			ExprNode* const exprNode = const_cast<ExprNode*>(node);
+
+			if (exprNode->getKind() == DmlNode::KIND_VALUE)
+			{
+				dsc desc;
+				static_cast<ValueExprNode*>(exprNode)->getDesc(m_tdbb, m_csb, &desc);
+
+				// Blobs and arrays are read through the attachment
+				if (desc.isBlob() || desc.dsc_dtype == dtype_array)
+					return false;
+
+				if (desc.isText() && !m_textTypes.exist(desc.getTextType()))
+					m_textTypes.add(desc.getTextType());
+			}
+
+			NodeRefsHolder holder(*m_tdbb->getDefaultPool());
+			exprNode->getChildren(holder, false);
+
+			for (ExprNode** const* i = holder.refs.begin(); i != holder.refs.end(); ++i)
+			{
+				if (**i && !check(**i))
+					return false;
+			}
+
+			return true;
+		}
+
+	private:
+		thread_db* const m_tdbb;
+		CompilerScratch* const m_csb;
+		const StreamType m_stream;
+		Array<const ParameterNode*>& m_parameters;
+		SortedArray<USHORT>& m_textTypes;
+	};
+
+	bool checkMap(thread_db* tdbb, CompilerScratch* csb, MapNode* map, const ParallelScan& scan,
+		Array<const ParameterNode*>& parameters, SortedArray<USHORT>& textTypes)
+	{
+		ExpressionChecker checker(tdbb, csb, scan.stream, parameters, textTypes);
+
+		if (scan.boolean && !checker.check(scan.boolean))
+			return false;
+
+		// The partial states of the aggregates are combined without allocating memory,
+		// see HashAggregatedStream::isSupported()
+
+		for (NestConst<ValueExprNode>* ptr = map->sourceList.begin();
+			 ptr != map->sourceList.end();
+			 ++ptr)
+		{
+			if (nodeIs<LiteralNode>(*ptr))
+				continue;
+
+			AggNode* const aggNode = nodeAs<AggNode>(*ptr);
+
+			if (!aggNode || aggNode->distinct || aggNode->indexed)
+				return false;
+
+			switch (aggNode->aggInfo.blr)
+			{
+				case blr_agg_count2:
+				case blr_agg_total:
+				case blr_agg_average:
+					break;
+
+				case blr_agg_max:
+				case blr_agg_min:
+				{
+					dsc desc;
+					aggNode->arg->getDesc(tdbb, csb, &desc);
+
+					switch (desc.dsc_dtype)
+					{
+						case dtype_short:
+						case dtype_long:
+						case dtype_int64:
+						case dtype_int128:
+						case dtype_real:
+						case dtype_double:
+						case dtype_dec64:
+						case dtype_dec128:
+						case dtype_sql_date:
+						case dtype_sql_time:
+						case dtype_sql_time_tz:
+						case dtype_timestamp:
+						case dtype_timestamp_tz:
+							break;
+
+						default:
+							return false;
+					}
+
+					break;
+				}
+
+				default:
+					return false;
+			}
+
+			if (aggNode->arg && !checker.check(aggNode->arg))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+
+// Scan of the pointer pages given to the workers. Every part of the job
+// aggregates the records of the pointer pages it takes into its own clone
+// of the request, the clones run in the transaction of the request.
+
+class ParallelAggregatedStream::ScanJob : public WorkerJob
+{
+public:
+	ScanJob(thread_db* tdbb, const ParallelAggregatedStream* stream, jrd_req* request, ULONG pages)
+		: m_stream(stream), m_request(request),
+		  m_database(tdbb->getDatabase()), m_attachment(tdbb->getAttachment()),
+		  m_transaction(request->req_transaction),
+		  m_timer(const_cast<TimeoutTimer*>(tdbb->getTimeoutTimer())),
+		  m_pages(pages), m_clones(*tdbb->getDefaultPool())
+	{}
+
+	void attach(thread_db* tdbb);
+	void detach(thread_db* tdbb);
+	void merge(thread_db* tdbb);
+
+	void execute(unsigned part);
+
+private:
+	const ParallelAggregatedStream* const m_stream;
+	jrd_req* const m_request;
+	Database* const m_database;
+	Attachment* const m_attachment;
+	jrd_tra* const m_transaction;
+	TimeoutTimer* const m_timer;
+	const ULONG m_pages;
+	AtomicCounter m_next;			// next pointer page to scan
+	HalfStaticArray<jrd_req*, 8> m_clones;
+};
+
+void ParallelAggregatedStream::ScanJob::attach(thread_db* tdbb)
+{
+	JrdStatement* const statement = m_request->getStatement();
+
+	for (unsigned n = 0; n < m_stream->m_degree; n++)
+	{
+		jrd_req* const clone = statement->findRequest(tdbb);
+		m_clones.add(clone);
+
+		fb_assert(clone->req_caller == NULL);
+		clone->req_caller = m_request;
+
+		clone->req_flags &= req_in_use;
+		clone->req_flags |= req_active;
+		TRA_attach_request(m_transaction, clone);
+
+		clone->req_gmt_timestamp = m_request->req_gmt_timestamp;
+
+		// The parameters are validated already, copy the messages as they are
+
+		for (const ParameterNode* const* i = m_stream->m_parameters.begin();
+			 i != m_stream->m_parameters.end();
+			 ++i)
+		{
+			const MessageNode* const message = (*i)->message;
+			const Format* const format = message->format;
+
+			memcpy(clone->getImpure<UCHAR>(message->impureOffset),
+				m_request->getImpure<UCHAR>(message->impureOffset), format->fmt_length);
+			memcpy(clone->getImpure<UCHAR>(message->impureFlags),
+				m_request->getImpure<UCHAR>(message->impureFlags), format->fmt_count * sizeof(USHORT));
+		}
+
+		record_param* const rpb = &clone->req_rpb[m_stream->m_scan.stream];
+		rpb->getWindow(tdbb).win_flags = 0;
+	}
+}
+
+void ParallelAggregatedStream::ScanJob::detach(thread_db* tdbb)
+{
+	for (jrd_req** i = m_clones.begin(); i != m_clones.end(); ++i)
+	{
+		jrd_req* const clone = *i;
+
+		EXE_unwind(tdbb, clone);
+
+		clone->req_caller = NULL;
+		clone->req_flags &= ~req_in_use;
+		clone->req_attachment = NULL;
+		clone->req_gmt_timestamp.invalidate();
+	}
+
+	m_clones.clear();
+}
+
+// Combine the partial states of the aggregates into the request
+
+void ParallelAggregatedStream::ScanJob::merge(thread_db* tdbb)
+{
+	const NestValueArray& sourceList = m_stream->m_groupMap->sourceList;
+	const RuntimeStatistics base;
+
+	for (jrd_req** i = m_clones.begin(); i != m_clones.end(); ++i)
+	{
+		jrd_req* const clone = *i;
+
+		for (const NestConst<ValueExprNode>* source = sourceList.begin();
+			 source != sourceList.end();
+			 ++source)
+		{
+			const AggNode* const aggNode = nodeAs<AggNode>(*source);
+
+			if (!aggNode)
+				continue;
+
+			impure_value_ex* const target = m_request->getImpure<impure_value_ex>(aggNode->impureOffset);
+			impure_value_ex* const partial = clone->getImpure<impure_value_ex>(aggNode->impureOffset);
+
+			if (aggNode->aggInfo.blr == blr_agg_count2)
+			{
+				if (aggNode->dialect1)
+					target->vlu_misc.vlu_long += partial->vlu_misc.vlu_long;
+				else
+					target->vlu_misc.vlu_int64 += partial->vlu_misc.vlu_int64;
+			}
+			else if (partial->vlux_count)
+			{
+				// The partial result is passed as a single value, then its values are counted
+				aggNode->aggPass(tdbb, m_request, &partial->vlu_desc);
+				target->vlux_count += partial->vlux_count - 1;
+			}
+		}
+
+		// The workers counted their statistics in the clones only
+
+		m_request->req_stats.adjust(base, clone->req_stats);
+		m_transaction->tra_stats.adjust(base, clone->req_stats);
+		m_attachment->att_stats.adjust(base, clone->req_stats);
+	}
+}
+
+void ParallelAggregatedStream::ScanJob::execute(unsigned part)
+{
+	jrd_req* const clone = m_clones[part];
+
+	FbLocalStatus status;
+	ThreadContextHolder tdbb(m_database, m_attachment, &status);
+	tdbb->tdbb_flags |= TDBB_parallel_worker;
+	tdbb->setTransaction(m_transaction);
+	tdbb->setWorkerRequest(clone);
+
+	thread_db::TimerGuard timerGuard(tdbb, m_timer, false);
+	Jrd::ContextPoolHolder context(tdbb, clone->req_pool);
+
+	const NestValueArray& sourceList = m_stream->m_groupMap->sourceList;
+	const BoolExprNode* const boolean = m_stream->m_scan.boolean;
+	record_param* const rpb = &clone->req_rpb[m_stream->m_scan.stream];
+
+	// Records of a pointer page
+	const SINT64 range = (SINT64) m_database->dbb_dp_per_pp * m_database->dbb_max_records;
+
+	try
+	{
+		for (const NestConst<ValueExprNode>* source = sourceList.begin();
+			 source != sourceList.end();
+			 ++source)
+		{
+			if (const AggNode* const aggNode = nodeAs<AggNode>(*source))
+				aggNode->aggInit(tdbb, clone);
+		}
+
+		ULONG sequence;
+
+		while ((sequence = (ULONG) m_next.exchangeAdd(1)) < m_pages)
+		{
+			const SINT64 last = (sequence + 1) * range;
+			rpb->rpb_number.setValue(sequence * range - 1);
+
+			// The last record fetched may belong to the next pointer page already
+
+			while (VIO_next_record(tdbb, rpb, m_transaction, clone->req_pool, false) &&
+				rpb->rpb_number.getValue() < last)
+			{
+				if (--tdbb->tdbb_quantum < 0)
+					JRD_reschedule(tdbb, 0, true);
+
+				rpb->rpb_number.setValid(true);
+
+				if (boolean && !boolean->execute(tdbb, clone))
+					continue;
+
+				for (const NestConst<ValueExprNode>* source = sourceList.begin();
+					 source != sourceList.end();
+					 ++source)
+				{
+					if (const AggNode* const aggNode = nodeAs<AggNode>(*source))
+						aggNode->aggPass(tdbb, clone);
+				}
+			}
+
+			rpb->rpb_number.setValid(false);
+		}
+	}
+	catch (const Exception&)
+	{
+		CCH_unwind(tdbb, false);
+		throw;
+	}
+}
+
+
+ParallelAggregatedStream::ParallelAggregatedStream(thread_db* tdbb, CompilerScratch* csb,
+			StreamType stream, MapNode* map, RecordSource* next)
+	: BaseAggWinStream(tdbb, csb, stream, NULL, map, true, next),
+	  m_parameters(csb->csb_pool), m_textTypes(csb->csb_pool), m_degree(getDegree(tdbb))
+{
+	fb_assert(map);
+
+	if (!next->getParallelScan(m_scan) ||
+		!checkMap(tdbb, csb, map, m_scan, m_parameters, m_textTypes))
+	{
+		fb_assert(false);
+	}
+}
+
+bool ParallelAggregatedStream::isSupported(thread_db* tdbb, CompilerScratch* csb,
+	MapNode* map, RecordSource* next)
+{
+	ParallelScan scan;
+
+	if (getDegree(tdbb) < 2 || (csb->csb_g_flags & csb_internal) || !next->getParallelScan(scan))
+		return false;
+
+	const jrd_rel* const relation = scan.relation;
+
+	if (relation->isVirtual() || relation->isTemporary() || relation->isView() || relation->rel_file)
+		return false;
+
+	Array<const ParameterNode*> parameters(*tdbb->getDefaultPool());
+	SortedArray<USHORT> textTypes(*tdbb->getDefaultPool());
+
+	return checkMap(tdbb, csb, map, scan, parameters, textTypes);
+}
+
+void ParallelAggregatedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+{
+	if (detailed)
+	{
+		string extras;
+		extras.printf(" (parallel, %u workers)", m_degree);
+
+		plan += printIndent(++level) + "Aggregate" + extras;
+	}
+
+	m_next->print(tdbb, plan, detailed, level);
+}
+
+bool ParallelAggregatedStream::internalGetRecord(thread_db* tdbb) const
+{
+	if (--tdbb->tdbb_quantum < 0)
+		JRD_reschedule(tdbb, 0, true);
+
+	jrd_req* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = getImpure(request);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return false;
+	}
+
+	ULONG pages;
+
+	if (impure->state != STATE_EOF && (pages = getSplitPages(tdbb, request)))
+		aggregateParallel(tdbb, request, pages);
+	else if (!evaluateGroup(tdbb))
+	{
+		rpb->rpb_number.setValid(false);
+		return false;
+	}
+
+	rpb->rpb_number.setValid(true);
+	return true;
+}
+
+// Number of the leading pointer pages of the table given to the workers,
+// zero if the table is scanned as usual
+
+ULONG ParallelAggregatedStream::getSplitPages(thread_db* tdbb, jrd_req* request) const
+{
+	const Database* const dbb = tdbb->getDatabase();
+	const jrd_tra* const transaction = request->req_transaction;
+
+	// The workers share the page cache of the server and read the snapshot
+	// of the transaction without waiting for the concurrent ones. The changes
+	// of the transaction itself are left to the usual scan.
+
+	if (!(dbb->dbb_flags & DBB_shared) || !transaction ||
+		(transaction->tra_flags & (TRA_system | TRA_write)))
+	{
+		return 0;
+	}
+
+	if ((transaction->tra_flags & TRA_read_committed) &&
+		!(transaction->tra_flags & (TRA_rec_version | TRA_read_consistency)))
+	{
+		return 0;
+	}
+
+	// The last pointer page known is scanned by the leading thread,
+	// as the scan past it may need to extend the vector of the pages
+
+	const vcl* const vector = m_scan.relation->getPages(tdbb)->rel_pages;
+
+	return (vector && vector->count() > 2) ? vector->count() - 1 : 0;
+}
+
+void ParallelAggregatedStream::aggregateParallel(thread_db* tdbb, jrd_req* request, ULONG pages) const
+{
+	Database* const dbb = tdbb->getDatabase();
+	Attachment* const attachment = tdbb->getAttachment();
+	Impure* const impure = getImpure(request);
+	jrd_rel* const relation = m_scan.relation;
+
+	// Validate the parameters and look up the collations and the older formats
+	// of the records, the workers find them ready
+
+	for (const ParameterNode* const* i = m_parameters.begin(); i != m_parameters.end(); ++i)
+		EVL_expr(tdbb, request, *i);
+
+	for (const USHORT* i = m_textTypes.begin(); i != m_textTypes.end(); ++i)
+		INTL_texttype_lookup(tdbb, *i);
+
+	const Format* const format = MET_current(tdbb, relation);
+
+	for (USHORT n = 0; n < format->fmt_version; n++)
+		MET_format(tdbb, relation, n);
+
+	aggInit(tdbb, request, m_groupMap);
+
+	ScanJob job(tdbb, this, request, pages);
+
+	try
+	{
+		job.attach(tdbb);
+
+		{	// The garbage is left to the usual scans
+			AutoSetRestoreFlag<ULONG> noCleanup(&attachment->att_flags, ATT_no_cleanup, true);
+
+			WorkerPool::run(&job, m_degree, m_degree);
+		}
+
+		job.merge(tdbb);
+		job.detach(tdbb);
+
+		// Aggregate the rest of the table past the pointer pages of the workers
+
+		record_param* const scanRpb = &request->req_rpb[m_scan.stream];
+		scanRpb->rpb_number.setValue((SINT64) pages * dbb->dbb_dp_per_pp * dbb->dbb_max_records - 1);
+
+		while (getNextRecord(tdbb, request) &&
+			aggPass(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList))
+		{}
+
+		impure->state = STATE_EOF;
+
+		aggExecute(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+	}
+	catch (const Exception&)
+	{
+		job.detach(tdbb);
+		aggFinish(tdbb, request, m_groupMap);
+		throw;
+	}
+}
+
+unsigned ParallelAggregatedStream::getDegree(thread_db* tdbb)
+{
+	const Attachment* const attachment = tdbb->getAttachment();
+	const Database* const dbb = tdbb->getDatabase();
+
+	// SET PARALLEL WORKERS of the session overrides the setting of the database
+	unsigned workers = attachment ? attachment->getParallelWorkers() : 0;
+
+	if (!workers)
+		workers = dbb->dbb_config->getParallelWorkers();
+
+	return MIN(workers, WorkerPool::MAX_WORKERS + 1);
+}
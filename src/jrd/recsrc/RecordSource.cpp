@@ -34,6 +34,7 @@
 #include "../jrd/rlck_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/DataTypeUtil.h"
+#include "../common/utils_proto.h"
 
 #include "RecordSource.h"
 
@@ -41,6 +42,55 @@ using namespace Firebird;
 using namespace Jrd;
 
 
+namespace
+{
+	const char* const PROFILE_PREFIX = " (actual: ";
+
+	// Measures the time and the page accesses spent in a call of the record source, including
+	// its children, and adds them to the figures of the source in the profiled request
+
+	class ProfileCounter
+	{
+	public:
+		explicit ProfileCounter(jrd_req* request)
+			: m_request(request),
+			  m_fetches(request->req_stats.getValue(RuntimeStatistics::PAGE_FETCHES)),
+			  m_reads(request->req_stats.getValue(RuntimeStatistics::PAGE_READS)),
+			  m_ticks(fb_utils::query_performance_counter())
+		{}
+
+		RecordSourceProfile& stop(ULONG impure) const
+		{
+			RecordSourceProfiles& profiles = m_request->req_profiles;
+			FB_SIZE_T pos;
+
+			if (!profiles.find(impure, pos))
+			{
+				RecordSourceProfile profile;
+				memset(&profile, 0, sizeof(profile));
+				profile.rsp_impure = impure;
+				profiles.insert(pos, profile);
+			}
+
+			RecordSourceProfile& profile = profiles[pos];
+			profile.rsp_ticks += fb_utils::query_performance_counter() - m_ticks;
+			profile.rsp_fetches +=
+				m_request->req_stats.getValue(RuntimeStatistics::PAGE_FETCHES) - m_fetches;
+			profile.rsp_reads +=
+				m_request->req_stats.getValue(RuntimeStatistics::PAGE_READS) - m_reads;
+
+			return profile;
+		}
+
+	private:
+		jrd_req* const m_request;
+		const SINT64 m_fetches;
+		const SINT64 m_reads;
+		const SINT64 m_ticks;
+	};
+}
+
+
 // Record source class
 // -------------------
 
@@ -195,12 +245,284 @@ RecordSource::~RecordSource()
 {
 }
 
+void RecordSource::open(thread_db* tdbb) const
+{
+	jrd_req* const request = tdbb->getRequest();
+
+	if (!(request->req_flags & req_profile))
+	{
+		internalOpen(tdbb);
+		return;
+	}
+
+	const ProfileCounter counter(request);
+	internalOpen(tdbb);
+
+	RecordSourceProfile& profile = counter.stop(m_impure);
+	profile.rsp_opens++;
+}
+
+bool RecordSource::getRecord(thread_db* tdbb) const
+{
+	jrd_req* const request = tdbb->getRequest();
+
+	if (!(request->req_flags & req_profile))
+		return internalGetRecord(tdbb);
+
+	const ProfileCounter counter(request);
+	const bool found = internalGetRecord(tdbb);
+
+	RecordSourceProfile& profile = counter.stop(m_impure);
+
+	if (found)
+		profile.rsp_records++;
+
+	return found;
+}
+
+ULONG RecordSource::getRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+
+	if (!(request->req_flags & req_profile))
+		return internalGetRecords(tdbb, batch);
+
+	const ULONG count = batch.getCount();
+
+	const ProfileCounter counter(request);
+	const ULONG total = internalGetRecords(tdbb, batch);
+
+	RecordSourceProfile& profile = counter.stop(m_impure);
+	profile.rsp_records += total - count;
+
+	return total;
+}
+
+ULONG RecordSource::internalGetRecords(thread_db* tdbb, RecordBatch& batch) const
+{
+	jrd_req* const request = tdbb->getRequest();
+
+	while (!batch.isFull() && internalGetRecord(tdbb))
+		batch.put(request);
+
+	return batch.getCount();
+}
+
+void RecordSource::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+{
+	const FB_SIZE_T start = plan.length();
+
+	internalPrint(tdbb, plan, detailed, level);
+
+	// Append the actual figures of a profiled request to the first line printed by the source.
+	// A source printing no line of its own leaves it to its first child, which marked it already.
+
+	const jrd_req* const request = tdbb->getRequest();
+
+	if (!detailed || !request || !(request->req_flags & req_profile) || plan.length() == start)
+		return;
+
+	FB_SIZE_T end = plan.find('\n', start + 1);
+
+	if (end == string::npos)
+		end = plan.length();
+
+	if (plan.find(PROFILE_PREFIX, start) < end)
+		return;
+
+	string figures(PROFILE_PREFIX);
+	FB_SIZE_T pos;
+
+	if (request->req_profiles.find(m_impure, pos))
+	{
+		const RecordSourceProfile& profile = request->req_profiles[pos];
+		const double ms = (double) profile.rsp_ticks * 1000 / fb_utils::query_performance_frequency();
+
+		string buffer;
+		buffer.printf("opens %" UQUADFORMAT", rows %" UQUADFORMAT", time %.3f ms, "
+					  "fetches %" SQUADFORMAT", reads %" SQUADFORMAT")",
+			profile.rsp_opens, profile.rsp_records, ms, profile.rsp_fetches, profile.rsp_reads);
+		figures += buffer;
+	}
+	else
+		figures += "never executed)";
+
+	plan.insert(end, figures);
+}
+
+
+// RecordBatch class
+// -----------------
+
+RecordBatch::RecordBatch(MemoryPool& pool, const StreamList& streams, ULONG capacity)
+	: m_pool(pool), m_streams(pool), m_capacity(capacity), m_slots(pool),
+	  m_count(0), m_position(0), m_saves(0)
+{
+	fb_assert(capacity && streams.hasData());
+
+	m_streams.assign(streams);
+
+	// The extra row keeps the records left current by the source
+
+	const FB_SIZE_T count = (capacity + 1) * streams.getCount();
+	Slot* const slots = m_slots.getBuffer(count);
+
+	for (FB_SIZE_T i = 0; i < count; i++)
+	{
+		slots[i].record = NULL;
+		slots[i].transaction = 0;
+	}
+}
+
+RecordBatch::~RecordBatch()
+{
+	for (Slot* slot = m_slots.begin(); slot < m_slots.end(); slot++)
+		delete slot->record;
+}
+
+// Check whether the rows of the source are narrow enough to be copied into a batch
+bool RecordBatch::isNarrow(CompilerScratch* csb, const RecordSource* source)
+{
+	StreamList streams;
+	source->findUsedStreams(streams);
+
+	ULONG length = 0;
+
+	for (const StreamType* stream = streams.begin(); stream != streams.end(); ++stream)
+	{
+		const Format* const format = csb->csb_rpt[*stream].csb_format;
+
+		if (!format)
+			return false;
+
+		length += format->fmt_length;
+
+		if (length > MAX_ROW_LENGTH)
+			return false;
+	}
+
+	return streams.hasData();
+}
+
+bool RecordBatch::fill(thread_db* tdbb, const RecordSource* source)
+{
+	jrd_req* const request = tdbb->getRequest();
+	Slot* const left = m_slots.begin() + m_capacity * m_streams.getCount();
+
+	// Give the source back the records made current by the consumer meanwhile
+
+	if (m_saves)
+		restore(request, left);
+
+	m_count = m_position = 0;
+
+	const ULONG saves = m_saves;
+
+	source->getRecords(tdbb, *this);
+
+	// A filtering source fills the batch from its own source, then the records
+	// left current by the innermost source are saved already
+
+	if (m_saves == saves)
+	{
+		save(request, left);
+		m_saves++;
+	}
+
+	return (m_count != 0);
+}
+
+bool RecordBatch::fetch(thread_db* tdbb, const RecordSource* source)
+{
+	if (m_position >= m_count && !fill(tdbb, source))
+		return false;
+
+	activate(tdbb->getRequest(), m_position++);
+	return true;
+}
+
+void RecordBatch::put(jrd_req* request)
+{
+	fb_assert(m_count < m_capacity);
+
+	save(request, m_slots.begin() + m_count++ * m_streams.getCount());
+}
+
+void RecordBatch::activate(jrd_req* request, ULONG row) const
+{
+	fb_assert(row < m_count);
+
+	restore(request, m_slots.begin() + row * m_streams.getCount());
+}
+
+void RecordBatch::move(ULONG from, ULONG to)
+{
+	fb_assert(from < m_count && to < m_count);
+
+	if (from == to)
+		return;
+
+	const FB_SIZE_T streamCount = m_streams.getCount();
+	Slot* const source = m_slots.begin() + from * streamCount;
+	Slot* const target = m_slots.begin() + to * streamCount;
+
+	for (FB_SIZE_T i = 0; i < streamCount; i++)
+	{
+		const Slot temp = target[i];
+		target[i] = source[i];
+		source[i] = temp;
+	}
+}
+
+void RecordBatch::truncate(ULONG count)
+{
+	fb_assert(count <= m_count);
+
+	m_count = count;
+}
+
+void RecordBatch::save(const jrd_req* request, Slot* slots)
+{
+	for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+	{
+		const record_param* const rpb = &request->req_rpb[m_streams[i]];
+		Slot* const slot = &slots[i];
+
+		slot->number = rpb->rpb_number;
+		slot->transaction = rpb->rpb_transaction_nr;
+
+		if (!rpb->rpb_record)
+			continue;
+
+		if (slot->record)
+			slot->record->copyFrom(rpb->rpb_record);
+		else
+			slot->record = FB_NEW_POOL(m_pool) Record(m_pool, rpb->rpb_record);
+	}
+}
+
+void RecordBatch::restore(jrd_req* request, const Slot* slots) const
+{
+	for (FB_SIZE_T i = 0; i < m_streams.getCount(); i++)
+	{
+		record_param* const rpb = &request->req_rpb[m_streams[i]];
+		const Slot* const slot = &slots[i];
+
+		rpb->rpb_number = slot->number;
+		rpb->rpb_transaction_nr = slot->transaction;
+
+		if (rpb->rpb_record && slot->record)
+			rpb->rpb_record->copyFrom(slot->record);
+	}
+}
+
 
 // RecordStream class
 // ------------------
 
 RecordStream::RecordStream(CompilerScratch* csb, StreamType stream, const Format* format)
-	: m_stream(stream), m_format(format ? format : csb->csb_rpt[stream].csb_format)
+	: m_stream(stream), m_format(format ? format : csb->csb_rpt[stream].csb_format),
+	  m_filter(NULL)
 {
 	fb_assert(m_format);
 }
@@ -256,6 +578,15 @@ void RecordStream::invalidateRecords(jrd_req* request) const
 	rpb->rpb_number.setValid(false);
 }
 
+bool RecordStream::setFilter(StreamType stream, const HashJoin* join)
+{
+	if (stream != m_stream || m_filter)
+		return false;
+
+	m_filter = join;
+	return true;
+}
+
 void RecordStream::nullRecords(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
@@ -39,6 +39,7 @@ namespace Jrd
 	class jrd_prc;
 	class AggNode;
 	class BoolExprNode;
+	class ParameterNode;
 	class Sort;
 	class CompilerScratch;
 	class RecordBuffer;
@@ -49,23 +50,35 @@ namespace Jrd
 	struct win;
 	class BaseBufferedStream;
 	class BufferedStream;
+	class HashJoin;
+	class RecordBatch;
 
 	enum JoinType { INNER_JOIN, OUTER_JOIN, SEMI_JOIN, ANTI_JOIN };
 
+	// Table scan which may be split between parallel workers, see ParallelAggregatedStream
+
+	struct ParallelScan
+	{
+		jrd_rel* relation;
+		StreamType stream;
+		const BoolExprNode* boolean;	// filter of the scanned records, if any
+	};
+
 	// Abstract base class
 
 	class RecordSource
 	{
 	public:
-		virtual void open(thread_db* tdbb) const = 0;
+		// Open, fetch and print go through the base class which counts the activity
+		// of the source for the detailed plan when the request is profiled (req_profile)
+		void open(thread_db* tdbb) const;
 		virtual void close(thread_db* tdbb) const = 0;
 
-		virtual bool getRecord(thread_db* tdbb) const = 0;
+		bool getRecord(thread_db* tdbb) const;
 		virtual bool refetchRecord(thread_db* tdbb) const = 0;
 		virtual bool lockRecord(thread_db* tdbb) const = 0;
 
-		virtual void print(thread_db* tdbb, Firebird::string& plan,
-						   bool detailed, unsigned level) const = 0;
+		void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
 
 		virtual void markRecursive() = 0;
 		virtual void invalidateRecords(jrd_req* request) const = 0;
@@ -78,6 +91,28 @@ namespace Jrd
 			fb_assert(false);
 		}
 
+		// Let the scan of the stream reject the records that cannot be joined by the hash join
+		virtual bool pushFilter(StreamType /*stream*/, const HashJoin* /*join*/)
+		{
+			return false;
+		}
+
+		// Fetch the records by batches, see RecordBatch. Consumers use it only when
+		// the whole subtree supports it, otherwise the records are fetched one by one.
+		virtual bool supportsBatch() const
+		{
+			return false;
+		}
+
+		ULONG getRecords(thread_db* tdbb, RecordBatch& batch) const;
+
+		// Describe the stream if it's a plain table scan, optionally filtered,
+		// which the parallel workers may execute by themselves
+		virtual bool getParallelScan(ParallelScan& /*scan*/) const
+		{
+			return false;
+		}
+
 		virtual ~RecordSource();
 
 		static bool rejectDuplicate(const UCHAR* /*data1*/, const UCHAR* /*data2*/, void* /*userArg*/)
@@ -92,6 +127,12 @@ namespace Jrd
 			ULONG irsb_flags;
 		};
 
+		virtual void internalOpen(thread_db* tdbb) const = 0;
+		virtual bool internalGetRecord(thread_db* tdbb) const = 0;
+		virtual ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const;
+		virtual void internalPrint(thread_db* tdbb, Firebird::string& plan,
+								   bool detailed, unsigned level) const = 0;
+
 		static const ULONG irsb_open = 1;
 		static const ULONG irsb_first = 2;
 		static const ULONG irsb_joined = 4;
@@ -119,6 +160,63 @@ namespace Jrd
 	};
 
 
+	// Records fetched at once by RecordSource::getRecords(). Every row keeps a copy
+	// of the records of the streams produced by the source and the consumer makes
+	// them current one by one. The records left current by the source are restored
+	// before fetching the next batch, so the source may rely on them as usual.
+	// Copying the records costs more than the batch saves unless they are narrow,
+	// so the consumers check the streams with isNarrow() before batching them.
+
+	class RecordBatch
+	{
+		struct Slot
+		{
+			Record* record;
+			RecordNumber number;
+			TraNumber transaction;
+		};
+
+	public:
+		static const ULONG DEFAULT_CAPACITY = 64;
+		static const ULONG MAX_ROW_LENGTH = 512;	// total length of the records of a row
+
+		RecordBatch(MemoryPool& pool, const StreamList& streams, ULONG capacity = DEFAULT_CAPACITY);
+		~RecordBatch();
+
+		static bool isNarrow(CompilerScratch* csb, const RecordSource* source);
+
+		ULONG getCount() const
+		{
+			return m_count;
+		}
+
+		bool isFull() const
+		{
+			return m_count >= m_capacity;
+		}
+
+		bool fill(thread_db* tdbb, const RecordSource* source);
+		bool fetch(thread_db* tdbb, const RecordSource* source);
+
+		void put(jrd_req* request);
+		void activate(jrd_req* request, ULONG row) const;
+		void move(ULONG from, ULONG to);
+		void truncate(ULONG count);
+
+	private:
+		void save(const jrd_req* request, Slot* slots);
+		void restore(jrd_req* request, const Slot* slots) const;
+
+		MemoryPool& m_pool;
+		StreamList m_streams;
+		const ULONG m_capacity;
+		Firebird::Array<Slot> m_slots;		// rows of the batch followed by the records left by the source
+		ULONG m_count;
+		ULONG m_position;					// next row made current by fetch()
+		ULONG m_saves;						// times the records left by the source were saved
+	};
+
+
 	// Helper class implementing some common methods
 
 	class RecordStream : public RecordSource
@@ -136,8 +234,11 @@ namespace Jrd
 		void nullRecords(thread_db* tdbb) const override;
 
 	protected:
+		bool setFilter(StreamType stream, const HashJoin* join);
+
 		const StreamType m_stream;
 		const Format* const m_format;
+		const HashJoin* m_filter;		// rejects records of table scans, see pushFilter()
 	};
 
 
@@ -149,13 +250,33 @@ namespace Jrd
 		FullTableScan(CompilerScratch* csb, const Firebird::string& alias,
 					  StreamType stream, jrd_rel* relation);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
+
+		bool pushFilter(StreamType stream, const HashJoin* join) override
+		{
+			return setFilter(stream, join);
+		}
+
+		bool supportsBatch() const override
+		{
+			return true;
+		}
+
+		ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const override;
+
+		bool getParallelScan(ParallelScan& scan) const override
+		{
+			scan.relation = m_relation;
+			scan.stream = m_stream;
+			scan.boolean = NULL;
+			return !m_filter;
+		}
 
 	private:
 		const Firebird::string m_alias;
@@ -167,19 +288,25 @@ namespace Jrd
 		struct Impure : public RecordSource::Impure
 		{
 			RecordBitmap** irsb_bitmap;
+			FB_UINT64 irsb_prefetch_number;		// record number to queue read-ahead of data pages at
 		};
 
 	public:
 		BitmapTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						StreamType stream, jrd_rel* relation, InversionNode* inversion);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
+
+		bool pushFilter(StreamType stream, const HashJoin* join) override
+		{
+			return setFilter(stream, join);
+		}
 
 	private:
 		const Firebird::string m_alias;
@@ -208,13 +335,18 @@ namespace Jrd
 					   StreamType stream, jrd_rel* relation,
 					   InversionNode* index, USHORT keyLength);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
+
+		bool pushFilter(StreamType stream, const HashJoin* join) override
+		{
+			return setFilter(stream, join);
+		}
 
 		void setInversion(InversionNode* inversion, BoolExprNode* condition)
 		{
@@ -253,15 +385,15 @@ namespace Jrd
 		ExternalTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						  StreamType stream, jrd_rel* relation);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 	private:
 		jrd_rel* const m_relation;
@@ -274,15 +406,15 @@ namespace Jrd
 		VirtualTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						 StreamType stream, jrd_rel* relation);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 	protected:
 		virtual const Format* getFormat(thread_db* tdbb, jrd_rel* relation) const = 0;
@@ -307,15 +439,15 @@ namespace Jrd
 					  const jrd_prc* procedure, const ValueListNode* sourceList,
 					  const ValueListNode* targetList, MessageNode* message);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 	private:
 		void assignParams(thread_db* tdbb, const dsc* from_desc, const dsc* flag_desc,
@@ -336,15 +468,15 @@ namespace Jrd
 	public:
 		SingularStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -364,15 +496,15 @@ namespace Jrd
 	public:
 		LockedStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -394,15 +526,15 @@ namespace Jrd
 	public:
 		FirstRowsStream(CompilerScratch* csb, RecordSource* next, ValueExprNode* value);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -430,15 +562,15 @@ namespace Jrd
 	public:
 		SkipRowsStream(CompilerScratch* csb, RecordSource* next, ValueExprNode* value);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -461,15 +593,15 @@ namespace Jrd
 	public:
 		FilteredStream(CompilerScratch* csb, RecordSource* next, BoolExprNode* boolean);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -487,6 +619,27 @@ namespace Jrd
 			m_ansiNot = ansiNot;
 		}
 
+		bool pushFilter(StreamType stream, const HashJoin* join) override
+		{
+			return !m_anyBoolean && m_next->pushFilter(stream, join);
+		}
+
+		bool supportsBatch() const override
+		{
+			return !m_anyBoolean && m_next->supportsBatch();
+		}
+
+		ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const override;
+
+		bool getParallelScan(ParallelScan& scan) const override
+		{
+			if (m_anyBoolean || !m_next->getParallelScan(scan) || scan.boolean)
+				return false;
+
+			scan.boolean = m_boolean;
+			return true;
+		}
+
 	private:
 		bool evaluateBoolean(thread_db* tdbb) const;
 
@@ -541,6 +694,7 @@ namespace Jrd
 				  length(0),
 				  keyLength(0),
 				  flags(0),
+				  cardinality(0),
 				  keyItems(p),
 				  items(p)
 			{
@@ -549,21 +703,22 @@ namespace Jrd
 			ULONG length;			// sort record length
 			ULONG keyLength;		// key length
 			USHORT flags;			// misc sort flags
+			double cardinality;		// estimated number of records, zero if unknown
 			Firebird::Array<sort_key_def> keyItems;	// address of key descriptors
 			Firebird::Array<Item> items;
 		};
 
 		SortedStream(CompilerScratch* csb, RecordSource* next, SortMap* map);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -591,11 +746,19 @@ namespace Jrd
 		UCHAR* getData(thread_db* tdbb) const;
 		void mapData(thread_db* tdbb, jrd_req* request, UCHAR* data) const;
 
+		void setLimit(ValueExprNode* first, ValueExprNode* skip)
+		{
+			m_first = first;
+			m_skip = skip;
+		}
+
 	private:
 		Sort* init(thread_db* tdbb) const;
 
 		NestConst<RecordSource> m_next;
 		const SortMap* const m_map;
+		NestConst<ValueExprNode> m_first;	// Only so many records are fetched
+		NestConst<ValueExprNode> m_skip;	// after skipping that many
 	};
 
 	// Make moves in a window without going out of partition boundaries.
@@ -670,6 +833,7 @@ namespace Jrd
 		struct Impure : public RecordSource::Impure
 		{
 			impure_value* groupValues;
+			RecordBatch* batch;			// input fetched by batches, if any
 			State state;
 		};
 
@@ -685,7 +849,7 @@ namespace Jrd
 			const NestValueArray* group, MapNode* groupMap, bool oneRowWhenEmpty, NextType* next);
 
 	public:
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
 		bool refetchRecord(thread_db* tdbb) const override;
@@ -744,7 +908,6 @@ namespace Jrd
 		int lookForChange(thread_db* tdbb, jrd_req* request,
 			const NestValueArray* group, const SortNode* sort, impure_value* values) const;
 
-	private:
 		bool getNextRecord(thread_db* tdbb, jrd_req* request) const;
 
 	protected:
@@ -752,6 +915,7 @@ namespace Jrd
 		const NestValueArray* const m_group;
 		NestConst<MapNode> m_groupMap;
 		bool m_oneRowWhenEmpty;
+		bool m_batchInput;		// the input may be fetched by batches
 	};
 
 	class AggregatedStream : public BaseAggWinStream<AggregatedStream, RecordSource>
@@ -761,8 +925,119 @@ namespace Jrd
 			const NestValueArray* group, MapNode* map, RecordSource* next);
 
 	public:
-		void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
-		bool getRecord(thread_db* tdbb) const;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
+		bool internalGetRecord(thread_db* tdbb) const;
+
+		bool supportsBatch() const override
+		{
+			return m_next->supportsBatch();
+		}
+
+		ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const override;
+	};
+
+	// Aggregation collecting the groups in a hash table instead of reading the sorted input,
+	// the groups are returned in no particular order
+
+	class HashAggregatedStream : public BaseAggWinStream<HashAggregatedStream, RecordSource>
+	{
+		class Groups;
+
+		struct Aggregate
+		{
+			const AggNode* node;
+			ULONG value;			// argument position in m_values, NO_VALUE for COUNT(*)
+		};
+
+		struct Assignment
+		{
+			const ValueExprNode* target;
+			ULONG value;			// source position in m_values
+		};
+
+	public:
+		struct Impure : public BaseAggWinStream::Impure
+		{
+			Groups* irsb_groups;
+			bool irsb_fallback;		// the input is aggregated by m_fallback
+		};
+
+		static const ULONG NO_VALUE = MAX_ULONG;
+
+	public:
+		HashAggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+			const NestValueArray* group, MapNode* map, RecordSource* next, RecordSource* fallback);
+
+		static bool isSupported(thread_db* tdbb, CompilerScratch* csb,
+			NestValueArray* group, MapNode* map);
+
+	public:
+		void internalOpen(thread_db* tdbb) const;
+		void close(thread_db* tdbb) const;
+
+		void internalPrint(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
+		bool internalGetRecord(thread_db* tdbb) const;
+
+		bool supportsBatch() const override
+		{
+			return m_next->supportsBatch();
+		}
+
+		ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const override;
+
+		void markRecursive() override;
+		void invalidateRecords(jrd_req* request) const override;
+
+	protected:
+		Impure* getImpure(jrd_req* request) const
+		{
+			return request->getImpure<Impure>(m_impure);
+		}
+
+	private:
+		bool makeKey(thread_db* tdbb, dsc* const* values, UCHAR* key, ULONG& hash) const;
+		bool aggregate(thread_db* tdbb, jrd_req* request, Groups* groups, dsc* const* values) const;
+		bool aggregatePartition(thread_db* tdbb, jrd_req* request, Groups* groups) const;
+		void saveStates(jrd_req* request, UCHAR* state) const;
+		void loadStates(jrd_req* request, const UCHAR* state) const;
+
+		NestValueArray m_values;					// grouping keys, then aggregate arguments and other sources
+		Firebird::Array<Aggregate> m_aggregates;
+		Firebird::Array<Assignment> m_assignments;
+		Firebird::Array<dsc> m_keyDescs;			// addresses are offsets inside the key
+		ULONG m_keyLength;
+		const Format* m_spillFormat;				// values of the rows spilled into partitions
+		NestConst<RecordSource> m_fallback;			// sort based aggregation of the same input
+	};
+
+	// Aggregation without grouping which splits the scan of a large table between
+	// parallel workers. Every worker aggregates the records of its pointer pages
+	// into a clone of the request, the partial results are combined at the end.
+
+	class ParallelAggregatedStream : public BaseAggWinStream<ParallelAggregatedStream, RecordSource>
+	{
+		class ScanJob;
+
+	public:
+		ParallelAggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+			MapNode* map, RecordSource* next);
+
+		static bool isSupported(thread_db* tdbb, CompilerScratch* csb, MapNode* map, RecordSource* next);
+
+	public:
+		void internalPrint(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
+		bool internalGetRecord(thread_db* tdbb) const;
+
+	private:
+		ULONG getSplitPages(thread_db* tdbb, jrd_req* request) const;
+		void aggregateParallel(thread_db* tdbb, jrd_req* request, ULONG pages) const;
+
+		static unsigned getDegree(thread_db* tdbb);
+
+		ParallelScan m_scan;
+		Firebird::Array<const ParameterNode*> m_parameters;	// copied into the clones
+		Firebird::SortedArray<USHORT> m_textTypes;			// looked up before the workers start
+		const unsigned m_degree;
 	};
 
 	class WindowedStream : public RecordSource
@@ -821,12 +1096,12 @@ namespace Jrd
 				WindowClause::Exclusion exclusion);
 
 		public:
-			void open(thread_db* tdbb) const;
+			void internalOpen(thread_db* tdbb) const;
 			void close(thread_db* tdbb) const;
 
-			bool getRecord(thread_db* tdbb) const;
+			bool internalGetRecord(thread_db* tdbb) const;
 
-			void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
+			void internalPrint(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
 			void findUsedStreams(StreamList& streams, bool expandAll = false) const;
 			void nullRecords(thread_db* tdbb) const;
 
@@ -858,15 +1133,15 @@ namespace Jrd
 		WindowedStream(thread_db* tdbb, CompilerScratch* csb,
 			Firebird::ObjectsArray<WindowSourceNode::Window>& windows, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-			bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+					bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -918,15 +1193,15 @@ namespace Jrd
 	public:
 		BufferedStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -947,6 +1222,7 @@ namespace Jrd
 		NestConst<RecordSource> m_next;
 		Firebird::HalfStaticArray<FieldMap, OPT_STATIC_ITEMS> m_map;
 		const Format* m_format;
+		double m_cardinality;	// estimated number of records, zero if unknown
 	};
 
 	// Multiplexing (many -> one) access methods
@@ -958,15 +1234,15 @@ namespace Jrd
 		NestedLoopJoin(CompilerScratch* csb, RecordSource* outer, RecordSource* inner,
 					   BoolExprNode* boolean, JoinType joinType);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -974,6 +1250,8 @@ namespace Jrd
 		void findUsedStreams(StreamList& streams, bool expandAll = false) const override;
 		void nullRecords(thread_db* tdbb) const override;
 
+		bool pushFilter(StreamType stream, const HashJoin* join) override;
+
 	private:
 		bool fetchRecord(thread_db*, FB_SIZE_T) const;
 
@@ -987,15 +1265,15 @@ namespace Jrd
 	public:
 		FullOuterJoin(CompilerScratch* csb, RecordSource* arg1, RecordSource* arg2);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -1011,6 +1289,7 @@ namespace Jrd
 	class HashJoin : public RecordSource
 	{
 		class HashTable;
+		class Partitions;
 
 		struct SubStream
 		{
@@ -1030,21 +1309,30 @@ namespace Jrd
 			HashTable* irsb_hash_table;
 			UCHAR* irsb_leader_buffer;
 			ULONG irsb_leader_hash;
+			Partitions* irsb_partitions;	// NULL unless the join is processed in partitions
+			bool irsb_probed;				// probe mode: keys of the context were looked up
+			ULONG* irsb_filter;				// bloom filter of the inner keys, if pushed down
+			ULONG irsb_filter_mask;			// filter size in bits, minus one
+			RecordBatch* irsb_leader_batch;	// leading stream fetched by batches, if any
 		};
 
 	public:
 		HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 				 RecordSource* const* args, NestValueArray* const* keys);
+		HashJoin(thread_db* tdbb, CompilerScratch* csb, JoinType joinType,
+				 RecordSource* outer, RecordSource* inner,
+				 NestValueArray* outerKeys, NestValueArray* innerKeys,
+				 BoolExprNode* boolean, BoolExprNode* matchBoolean);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -1052,13 +1340,35 @@ namespace Jrd
 		void findUsedStreams(StreamList& streams, bool expandAll = false) const override;
 		void nullRecords(thread_db* tdbb) const override;
 
+		bool supportsBatch() const override
+		{
+			return m_leader.source && m_leader.source->supportsBatch();
+		}
+
+		ULONG internalGetRecords(thread_db* tdbb, RecordBatch& batch) const override;
+
+		bool checkFilter(thread_db* tdbb) const;
+
 	private:
+		static void setupKeys(thread_db* tdbb, CompilerScratch* csb, SubStream& sub);
+
 		ULONG computeHash(thread_db* tdbb, jrd_req* request,
 						  const SubStream& sub, UCHAR* buffer) const;
+		bool fetchLeader(thread_db* tdbb, jrd_req* request, Impure* impure) const;
 		bool fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) const;
+		bool fetchMatch(thread_db* tdbb, jrd_req* request, Impure* impure) const;
+		void buildFilter(thread_db* tdbb, Impure* impure) const;
+		void setupFilter(CompilerScratch* csb);
 
-		SubStream m_leader;
+		SubStream m_leader;				// without source, keys of the context are probed
+		BufferedStream* m_leaderBuffer;	// replays the leading stream joined in partitions
 		Firebird::Array<SubStream> m_args;
+		const JoinType m_joinType;
+		BoolExprNode* const m_boolean;		// pertains to the leading stream only
+		BoolExprNode* const m_matchBoolean;	// verifies the joined records
+		ULONG m_invariant;				// probe mode: the hash table is built once per execution
+		bool m_filtered;				// the leading stream scan checks the bloom filter
+		bool m_leaderBatch;				// the leading records are narrow enough to be batched
 	};
 
 	class MergeJoin : public RecordSource
@@ -1096,15 +1406,15 @@ namespace Jrd
 				  SortedStream* const* args,
 				  const NestValueArray* const* keys);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -1135,15 +1445,15 @@ namespace Jrd
 			  FB_SIZE_T argCount, RecordSource* const* args, NestConst<MapNode>* maps,
 			  FB_SIZE_T streamCount, const StreamType* streams);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -1176,15 +1486,15 @@ namespace Jrd
 					    FB_SIZE_T streamCount, const StreamType* innerStreams,
 					    ULONG saveOffset);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -1214,15 +1524,15 @@ namespace Jrd
 		ConditionalStream(CompilerScratch* csb, RecordSource* first, RecordSource* second,
 						  BoolExprNode* boolean);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
-		void print(thread_db* tdbb, Firebird::string& plan,
-				   bool detailed, unsigned level) const override;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan,
+						   bool detailed, unsigned level) const override;
 
 		void markRecursive() override;
 		void invalidateRecords(jrd_req* request) const override;
@@ -66,7 +66,7 @@ RecursiveStream::RecursiveStream(CompilerScratch* csb, StreamType stream, Stream
 	m_inner->markRecursive();
 }
 
-void RecursiveStream::open(thread_db* tdbb) const
+void RecursiveStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -115,7 +115,7 @@ void RecursiveStream::close(thread_db* tdbb) const
 	}
 }
 
-bool RecursiveStream::getRecord(thread_db* tdbb) const
+bool RecursiveStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -244,7 +244,7 @@ bool RecursiveStream::lockRecord(thread_db* /*tdbb*/) const
 	return false; // compiler silencer
 }
 
-void RecursiveStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void RecursiveStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
@@ -42,7 +42,7 @@ SingularStream::SingularStream(CompilerScratch* csb, RecordSource* next)
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void SingularStream::open(thread_db* tdbb) const
+void SingularStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -68,7 +68,7 @@ void SingularStream::close(thread_db* tdbb) const
 	}
 }
 
-bool SingularStream::getRecord(thread_db* tdbb) const
+bool SingularStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -143,7 +143,7 @@ bool SingularStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void SingularStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void SingularStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "Singularity Check";
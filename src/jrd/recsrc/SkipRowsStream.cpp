@@ -44,7 +44,7 @@ SkipRowsStream::SkipRowsStream(CompilerScratch* csb, RecordSource* next, ValueEx
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void SkipRowsStream::open(thread_db* tdbb) const
+void SkipRowsStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -80,7 +80,7 @@ void SkipRowsStream::close(thread_db* tdbb) const
 	}
 }
 
-bool SkipRowsStream::getRecord(thread_db* tdbb) const
+bool SkipRowsStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -114,7 +114,7 @@ bool SkipRowsStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void SkipRowsStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void SkipRowsStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 		plan += printIndent(++level) + "Skip N Records";
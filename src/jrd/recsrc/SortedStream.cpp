@@ -40,14 +40,14 @@ using namespace Jrd;
 // -----------------------------
 
 SortedStream::SortedStream(CompilerScratch* csb, RecordSource* next, SortMap* map)
-	: m_next(next), m_map(map)
+	: m_next(next), m_map(map), m_first(NULL), m_skip(NULL)
 {
 	fb_assert(m_next && m_map);
 
 	m_impure = CMP_impure(csb, sizeof(Impure));
 }
 
-void SortedStream::open(thread_db* tdbb) const
+void SortedStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -81,7 +81,7 @@ void SortedStream::close(thread_db* tdbb) const
 	}
 }
 
-bool SortedStream::getRecord(thread_db* tdbb) const
+bool SortedStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -112,8 +112,8 @@ bool SortedStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
-void SortedStream::print(thread_db* tdbb, string& plan,
-						 bool detailed, unsigned level) const
+void SortedStream::internalPrint(thread_db* tdbb, string& plan,
+								 bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
@@ -162,6 +162,29 @@ Sort* SortedStream::init(thread_db* tdbb) const
 	m_next->open(tdbb);
 	ULONG records = 0;
 
+	// If the records are fetched by FIRST / SKIP, only the first
+	// first + skip records have to be returned. Their values are
+	// already validated by the upper streams.
+
+	FB_UINT64 limit = 0;
+
+	if (m_first)
+	{
+		const dsc* desc = EVL_expr(tdbb, request, m_first);
+		const SINT64 first = (desc && !(request->req_flags & req_null)) ? MOV_get_int64(tdbb, desc, 0) : 0;
+
+		SINT64 skip = 0;
+
+		if (m_skip)
+		{
+			desc = EVL_expr(tdbb, request, m_skip);
+			skip = (desc && !(request->req_flags & req_null)) ? MOV_get_int64(tdbb, desc, 0) : 0;
+		}
+
+		if (first > 0 && skip >= 0 && first <= MAX_SINT64 - skip)
+			limit = first + skip;
+	}
+
 	// Initialize for sort. If this is really a project operation,
 	// establish a callback routine to reject duplicate records.
 
@@ -169,7 +192,9 @@ Sort* SortedStream::init(thread_db* tdbb) const
 		Sort(tdbb->getDatabase(), &request->req_sorts,
 			 m_map->length, m_map->keyItems.getCount(), m_map->keyItems.getCount(),
 			 m_map->keyItems.begin(),
-			 ((m_map->flags & FLAG_PROJECT) ? rejectDuplicate : NULL), 0));
+			 ((m_map->flags & FLAG_PROJECT) ? rejectDuplicate : NULL), 0, limit));
+
+	scb->setEstimate((FB_UINT64) m_map->cardinality);
 
 	// Pump the input stream dry while pushing records into sort. For
 	// each record, map all fields into the sort record. The reverse
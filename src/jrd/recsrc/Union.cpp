@@ -59,7 +59,7 @@ Union::Union(CompilerScratch* csb, StreamType stream,
 		m_streams[i] = streams[i];
 }
 
-void Union::open(thread_db* tdbb) const
+void Union::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -97,7 +97,7 @@ void Union::close(thread_db* tdbb) const
 	}
 }
 
-bool Union::getRecord(thread_db* tdbb) const
+bool Union::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -165,7 +165,7 @@ bool Union::lockRecord(thread_db* tdbb) const
 	return m_args[impure->irsb_count]->lockRecord(tdbb);
 }
 
-void Union::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void Union::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	if (detailed)
 	{
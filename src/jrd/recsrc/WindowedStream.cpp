@@ -50,14 +50,14 @@ namespace
 	public:
 		BufferedStreamWindow(CompilerScratch* csb, BufferedStream* next);
 
-		void open(thread_db* tdbb) const;
+		void internalOpen(thread_db* tdbb) const;
 		void close(thread_db* tdbb) const;
 
-		bool getRecord(thread_db* tdbb) const;
+		bool internalGetRecord(thread_db* tdbb) const;
 		bool refetchRecord(thread_db* tdbb) const;
 		bool lockRecord(thread_db* tdbb) const;
 
-		void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
+		void internalPrint(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
 
 		void markRecursive();
 		void invalidateRecords(jrd_req* request) const;
@@ -95,7 +95,7 @@ namespace
 		m_impure = CMP_impure(csb, sizeof(Impure));
 	}
 
-	void BufferedStreamWindow::open(thread_db* tdbb) const
+	void BufferedStreamWindow::internalOpen(thread_db* tdbb) const
 	{
 		jrd_req* const request = tdbb->getRequest();
 		Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -116,7 +116,7 @@ namespace
 			impure->irsb_flags &= ~irsb_open;
 	}
 
-	bool BufferedStreamWindow::getRecord(thread_db* tdbb) const
+	bool BufferedStreamWindow::internalGetRecord(thread_db* tdbb) const
 	{
 		jrd_req* const request = tdbb->getRequest();
 		Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -142,7 +142,7 @@ namespace
 		return m_next->lockRecord(tdbb);
 	}
 
-	void BufferedStreamWindow::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+	void BufferedStreamWindow::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 	{
 		m_next->print(tdbb, plan, detailed, level);
 	}
@@ -333,7 +333,7 @@ WindowedStream::WindowedStream(thread_db* tdbb, CompilerScratch* csb,
 	}
 }
 
-void WindowedStream::open(thread_db* tdbb) const
+void WindowedStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -360,7 +360,7 @@ void WindowedStream::close(thread_db* tdbb) const
 	}
 }
 
-bool WindowedStream::getRecord(thread_db* tdbb) const
+bool WindowedStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -388,7 +388,7 @@ bool WindowedStream::lockRecord(thread_db* /*tdbb*/) const
 	return false; // compiler silencer
 }
 
-void WindowedStream::print(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
+void WindowedStream::internalPrint(thread_db* tdbb, string& plan, bool detailed, unsigned level) const
 {
 	m_joinedStream->print(tdbb, plan, detailed, level);
 }
@@ -506,9 +506,9 @@ WindowedStream::WindowStream::WindowStream(thread_db* tdbb, CompilerScratch* csb
 	(void) m_exclusion;	// avoid warning
 }
 
-void WindowedStream::WindowStream::open(thread_db* tdbb) const
+void WindowedStream::WindowStream::internalOpen(thread_db* tdbb) const
 {
-	BaseAggWinStream::open(tdbb);
+	BaseAggWinStream::internalOpen(tdbb);
 
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = getImpure(request);
@@ -543,7 +543,7 @@ void WindowedStream::WindowStream::close(thread_db* tdbb) const
 	BaseAggWinStream::close(tdbb);
 }
 
-bool WindowedStream::WindowStream::getRecord(thread_db* tdbb) const
+bool WindowedStream::WindowStream::internalGetRecord(thread_db* tdbb) const
 {
 	if (--tdbb->tdbb_quantum < 0)
 		JRD_reschedule(tdbb, 0, true);
@@ -880,7 +880,7 @@ bool WindowedStream::WindowStream::getRecord(thread_db* tdbb) const
 	return true;
 }
 
-void WindowedStream::WindowStream::print(thread_db* tdbb, string& plan, bool detailed,
+void WindowedStream::WindowStream::internalPrint(thread_db* tdbb, string& plan, bool detailed,
 	unsigned level) const
 {
 	if (detailed)
@@ -554,6 +554,8 @@ RELATION(nam_mon_statements, rel_mon_statements, ODS_11_1, rel_virtual)
 	FIELD(f_mon_stmt_expl_plan, nam_mon_expl_plan, fld_source, 0, ODS_11_1)
 	FIELD(f_mon_stmt_timeout, nam_stmt_timeout, fld_stmt_timeout, 0, ODS_13_0)
 	FIELD(f_mon_stmt_timer, nam_stmt_timer, fld_stmt_timer, 0, ODS_13_0)
+	FIELD(f_mon_stmt_temp_granted, nam_temp_granted, fld_counter, 0, ODS_13_1)
+	FIELD(f_mon_stmt_temp_spilled, nam_temp_spilled, fld_counter, 0, ODS_13_1)
 END_RELATION
 
 // Relation 37 (MON$CALL_STACK)
@@ -703,3 +705,13 @@ RELATION(nam_time_zones, rel_time_zones, ODS_13_0, rel_virtual)
 	FIELD(f_tz_id, nam_tz_id, fld_tz_id, 0, ODS_13_0)
 	FIELD(f_tz_name, nam_tz_name, fld_tz_name, 0, ODS_13_0)
 END_RELATION
+
+// Relation 51 (RDB$COLUMN_STATISTICS)
+RELATION(nam_column_stats, rel_column_stats, ODS_13_1, rel_persistent)
+	FIELD(f_cst_rel_name, nam_r_name, fld_r_name, 1, ODS_13_1)
+	FIELD(f_cst_fld_name, nam_f_name, fld_f_name, 1, ODS_13_1)
+	FIELD(f_cst_records, nam_record_count, fld_counter, 0, ODS_13_1)
+	FIELD(f_cst_distinct, nam_distinct_values, fld_statistics, 0, ODS_13_1)
+	FIELD(f_cst_null_frac, nam_null_fraction, fld_statistics, 0, ODS_13_1)
+	FIELD(f_cst_histogram, nam_histogram, fld_histogram, 0, ODS_13_1)
+END_RELATION
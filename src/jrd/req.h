@@ -161,6 +161,27 @@ private:
 	int modifiedRows;
 };
 
+// Actual figures of a record source collected while the request runs with req_profile,
+// the source is identified by its impure offset
+
+struct RecordSourceProfile
+{
+	ULONG rsp_impure;
+	FB_UINT64 rsp_opens;
+	FB_UINT64 rsp_records;
+	SINT64 rsp_ticks;
+	SINT64 rsp_fetches;
+	SINT64 rsp_reads;
+
+	static const ULONG& generate(const RecordSourceProfile& item)
+	{
+		return item.rsp_impure;
+	}
+};
+
+typedef Firebird::SortedArray<RecordSourceProfile, Firebird::EmptyStorage<RecordSourceProfile>,
+	ULONG, RecordSourceProfile> RecordSourceProfiles;
+
 // request block
 
 class jrd_req : public pool_alloc<type_req>
@@ -177,6 +198,7 @@ public:
 		  req_ext_stmt(NULL),
 		  req_cursors(*req_pool),
 		  req_ext_resultset(NULL),
+		  req_profiles(*req_pool),
 		  req_timeout(0),
 		  req_domain_validation(NULL),
 		  req_sorts(*req_pool),
@@ -262,6 +284,7 @@ public:
 	EDS::Statement*	req_ext_stmt;		// head of list of active dynamic statements
 	Firebird::Array<const Cursor*>	req_cursors;	// named cursors
 	ExtEngineManager::ResultSet*	req_ext_resultset;	// external result set
+	RecordSourceProfiles	req_profiles;	// actual figures of the record sources, if req_profile
 	USHORT		req_label;				// label for leave
 	ULONG		req_flags;				// misc request flags
 	Savepoint*	req_savepoints;			// Looper savepoint list
@@ -397,6 +420,7 @@ const ULONG req_continue_loop	= 0x100L;		// PSQL continue statement
 const ULONG req_proc_fetch		= 0x200L;		// Fetch from procedure in progress
 const ULONG req_same_tx_upd		= 0x400L;		// record was updated by same transaction
 const ULONG req_reserved		= 0x800L;		// Request reserved for client
+const ULONG req_profile			= 0x1000L;		// Record sources count their activity (EXPLAIN ANALYZE)
 
 
 // Index lock block
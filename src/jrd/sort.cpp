@@ -41,7 +41,9 @@
 #include "../jrd/rse.h"
 #include "../jrd/val.h"
 #include "../jrd/err_proto.h"
+#include "../jrd/WorkerPool.h"
 #include "../yvalve/gds_proto.h"
+#include <algorithm>
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -86,6 +88,18 @@ void SortOwner::unlinkAll()
 const ULONG MAX_SORT_BUFFER_SIZE = 1024 * 128;	// 128KB
 const ULONG MIN_RECORDS_TO_ALLOC = 8;
 
+// Sort buffer is split between the workers in pieces of at least this many records
+const ULONG MIN_PARALLEL_SORT_RECORDS = 4096;
+
+// Fewer records are sorted by comparisons rather than by radix sort
+const ULONG MIN_RADIX_SORT_RECORDS = 256;
+
+// Biggest buffer allocated to keep the first records of a limited sort
+const ULONG MAX_TOP_SORT_BUFFER_SIZE = MAX_SORT_BUFFER_SIZE * 8;
+
+// Packed runs are written and read by chunks of this size
+const ULONG PACKED_RUN_BUFFER_SIZE = 1024 * 64;
+
 // the size of sr_bckptr (everything before sort_record) in bytes
 #define SIZEOF_SR_BCKPTR offsetof(sr, sr_sort_record)
 // the size of sr_bckptr in # of 32 bit longwords
@@ -154,6 +168,534 @@ namespace
 		*a = *b;
 		*b = temp;
 	}
+
+	// Orders record pointers by their keys
+
+	class KeyLess
+	{
+	public:
+		explicit KeyLess(ULONG length)
+			: m_length(length)
+		{}
+
+		bool operator()(const SORTP* p, const SORTP* q) const
+		{
+			for (ULONG l = m_length; l; l--, p++, q++)
+			{
+				if (*p != *q)
+					return *p < *q;
+			}
+
+			return false;
+		}
+
+	private:
+		const ULONG m_length;
+	};
+
+	// Moves the pointer at the given position of the max-heap up to its place
+
+	void heapUp(SORTP** heap, ULONG position, const KeyLess& less)
+	{
+		while (position)
+		{
+			const ULONG parent = (position - 1) / 2;
+
+			if (!less(heap[parent], heap[position]))
+				break;
+
+			swap(heap + parent, heap + position);
+			position = parent;
+		}
+	}
+
+	// Moves the top pointer of the max-heap down to its place
+
+	void heapDown(SORTP** heap, ULONG count, const KeyLess& less)
+	{
+		ULONG position = 0;
+
+		while (true)
+		{
+			ULONG child = 2 * position + 1;
+
+			if (child >= count)
+				break;
+
+			if (child + 1 < count && less(heap[child], heap[child + 1]))
+				child++;
+
+			if (!less(heap[position], heap[child]))
+				break;
+
+			swap(heap + position, heap + child);
+			position = child;
+		}
+	}
+
+	// Worst case length of the packed record
+
+	inline ULONG packedLength(ULONG length)
+	{
+		return length + length / 127 + 2;
+	}
+
+	// Packs the sort record as the differences against the prior one. Sorted
+	// records share the leading key bytes with their neighbours, as well as the
+	// zero padding of strings, so only the differing bytes are stored. Packed
+	// record is a sequence of control bytes: positive one is followed by so
+	// many bytes of the record, negative one means that so many bytes are the
+	// same as in the prior record. Returns the length of the packed record.
+
+	ULONG packRecord(const UCHAR* prior, const UCHAR* record, ULONG length, UCHAR* output)
+	{
+		UCHAR* const start = output;
+		ULONG i = 0;
+
+		while (i < length)
+		{
+			ULONG j = i;
+			while (j < length && record[j] == prior[j])
+				j++;
+
+			// Single equal byte is cheaper to store as is, unless it's the last one
+
+			if (j - i > 1 || (j > i && j == length))
+			{
+				for (ULONG n = j - i; n; )
+				{
+					const ULONG count = MIN(n, 127);
+					*output++ = (UCHAR) -(SCHAR) count;
+					n -= count;
+				}
+
+				i = j;
+				continue;
+			}
+
+			j = i + 1;
+			while (j < length && j - i < 127 &&
+				(record[j] != prior[j] || j + 1 == length || record[j + 1] != prior[j + 1]))
+			{
+				j++;
+			}
+
+			*output++ = (UCHAR) (j - i);
+			memcpy(output, record + i, j - i);
+			output += j - i;
+			i = j;
+		}
+
+		return output - start;
+	}
+
+	// Unpacks the record packed by packRecord(). Returns the address of
+	// the next packed record.
+
+	const UCHAR* unpackRecord(const UCHAR* input, const UCHAR* end,
+		const UCHAR* prior, UCHAR* output, ULONG length)
+	{
+		for (ULONG i = 0; i < length; )
+		{
+			if (input >= end)
+				BUGCHECK(179);	// msg 179 decompression overran buffer
+
+			const int control = (SCHAR) *input++;
+			const ULONG count = (control < 0) ? -control : control;
+
+			if (!count || i + count > length || (control > 0 && input + count > end))
+				BUGCHECK(179);	// msg 179 decompression overran buffer
+
+			if (control > 0)
+			{
+				memcpy(output + i, input, count);
+				input += count;
+			}
+			else if (output != prior)
+				memcpy(output + i, prior + i, count);
+
+			i += count;
+		}
+
+		return input;
+	}
+
+	// Writes records of a run to temporary space packing them by packRecord()
+
+	class RunPacker
+	{
+	public:
+		RunPacker(MemoryPool& pool, TempSpace* space, FB_UINT64 seek, ULONG length)
+			: m_space(space), m_seek(seek), m_length(length),
+			  m_size(MAX(PACKED_RUN_BUFFER_SIZE, 2 * packedLength(length))),
+			  m_buffer(pool)
+		{
+			// The prior record of the first one is all zeroes
+
+			m_prior = m_buffer.getBuffer(m_length + m_size);
+			memset(m_prior, 0, m_length);
+			m_data = m_next = m_prior + m_length;
+		}
+
+		void put(const UCHAR* record)
+		{
+			if ((ULONG) (m_next - m_data) + packedLength(m_length) > m_size)
+				flush();
+
+			m_next += packRecord(m_prior, record, m_length, m_next);
+			memcpy(m_prior, record, m_length);
+		}
+
+		// Returns the position after the last record written
+		FB_UINT64 flush()
+		{
+			if (m_next > m_data)
+			{
+				m_seek = Sort::writeBlock(m_space, m_seek, m_data, m_next - m_data);
+				m_next = m_data;
+			}
+
+			return m_seek;
+		}
+
+	private:
+		TempSpace* const m_space;
+		FB_UINT64 m_seek;
+		const ULONG m_length;
+		const ULONG m_size;
+		Firebird::Array<UCHAR> m_buffer;
+		UCHAR* m_prior;
+		UCHAR* m_data;
+		UCHAR* m_next;
+	};
+
+	// Record pointer along with the first two longwords of its key, so the
+	// radix sort doesn't have to touch the record to get the next digit
+
+	struct RadixEntry
+	{
+		FB_UINT64 prefix;
+		SORTP* record;
+	};
+
+	// Orders radix entries with equal prefixes by the rest of their keys
+
+	class SuffixLess
+	{
+	public:
+		explicit SuffixLess(ULONG length)
+			: m_less(length - RADIX_PREFIX_LONGS)
+		{}
+
+		bool operator()(const RadixEntry& a, const RadixEntry& b) const
+		{
+			return m_less(a.record + RADIX_PREFIX_LONGS, b.record + RADIX_PREFIX_LONGS);
+		}
+
+		static const ULONG RADIX_PREFIX_LONGS = sizeof(FB_UINT64) / sizeof(SORTP);
+
+	private:
+		const KeyLess m_less;
+	};
+
+	// Sorts the array of record pointers by LSD radix sort of the key prefixes.
+	// Keys are already diddled to be compared as unsigned longwords, so the
+	// prefix made of the first two longwords is compared as a number. Bytes
+	// equal in all the prefixes, e.g. high bytes of small integers, are skipped.
+	// Records with equal prefixes and longer keys are then ordered by comparing
+	// the rest of their keys. Back pointers are not maintained. Both arrays
+	// of entries must have room for count entries.
+
+	void sortByRadix(SORTP** pointers, ULONG count, ULONG length,
+		RadixEntry* entries, RadixEntry* temp)
+	{
+		const unsigned DIGITS = sizeof(FB_UINT64);
+		const unsigned RADIX = 256;
+
+		ULONG counts[DIGITS][RADIX];
+		memset(counts, 0, sizeof(counts));
+
+		// Load the prefixes and count all the digits at once
+
+		for (ULONG i = 0; i < count; i++)
+		{
+			SORTP* const key = pointers[i];
+
+			FB_UINT64 prefix = (FB_UINT64) key[0] << 32;
+			if (length > 1)
+				prefix |= key[1];
+
+			entries[i].prefix = prefix;
+			entries[i].record = key;
+
+			for (unsigned digit = 0; digit < DIGITS; digit++)
+				counts[digit][(prefix >> (digit * 8)) & 0xFF]++;
+		}
+
+		RadixEntry* source = entries;
+		RadixEntry* target = temp;
+
+		for (unsigned digit = 0; digit < DIGITS; digit++)
+		{
+			ULONG* const slots = counts[digit];
+			const unsigned shift = digit * 8;
+
+			if (slots[(source[0].prefix >> shift) & 0xFF] == count)
+				continue;
+
+			ULONG offset = 0;
+			for (unsigned i = 0; i < RADIX; i++)
+			{
+				const ULONG n = slots[i];
+				slots[i] = offset;
+				offset += n;
+			}
+
+			for (const RadixEntry* entry = source, *end = source + count; entry < end; entry++)
+				target[slots[(entry->prefix >> shift) & 0xFF]++] = *entry;
+
+			RadixEntry* const swapped = source;
+			source = target;
+			target = swapped;
+		}
+
+		// Keys longer than the prefix are compared if the prefixes are equal
+
+		if (length > SuffixLess::RADIX_PREFIX_LONGS)
+		{
+			const SuffixLess less(length);
+
+			for (ULONG i = 0; i < count; )
+			{
+				ULONG j = i + 1;
+				while (j < count && source[j].prefix == source[i].prefix)
+					j++;
+
+				if (j - i > 1)
+					std::sort(source + i, source + j, less);
+
+				i = j;
+			}
+		}
+
+		for (ULONG i = 0; i < count; i++)
+			pointers[i] = source[i].record;
+	}
+
+	// Sorts the array of record pointers by several threads. The array is split
+	// into pieces which are sorted independently, then sorted pieces are merged
+	// pairwise, level by level. Every merge is split further at the points found
+	// by binary search, so all the workers are busy even at the last level.
+	// Pieces are sorted by radix sort if the entries are given, they must have
+	// room for twice as many entries as there are pointers. Pointers are moved
+	// without maintaining the back pointers of the records, they are fixed in
+	// the end.
+
+	class ParallelSortJob : public WorkerJob
+	{
+		struct MergeTask
+		{
+			ULONG a_begin, a_end;		// Part of the first run
+			ULONG b_begin, b_end;		// Part of the second run
+			ULONG output;				// Where merged pointers are stored
+		};
+
+	public:
+		ParallelSortJob(MemoryPool& pool, SORTP** pointers, SORTP** temp, RadixEntry* entries,
+						ULONG count, ULONG length, unsigned workers)
+			: m_pointers(pointers), m_source(pointers), m_target(temp), m_entries(entries),
+			  m_count(count), m_length(length), m_less(length), m_workers(workers), m_pieces(0),
+			  m_runs(pool), m_tasks(pool)
+		{}
+
+		void sort()
+		{
+			// Pieces are not smaller than MIN_PARALLEL_SORT_RECORDS
+
+			m_pieces = MIN(m_workers, m_count / MIN_PARALLEL_SORT_RECORDS);
+			for (ULONG i = 0; i <= m_pieces; i++)
+				m_runs.add(pieceBound(i));
+
+			m_phase = PHASE_SORT;
+			WorkerPool::run(this, m_pieces, m_workers);
+
+			while (m_runs.getCount() > 2)
+			{
+				prepareMerge();
+
+				m_phase = PHASE_MERGE;
+				WorkerPool::run(this, m_tasks.getCount(), m_workers);
+
+				SORTP** const temp = m_source;
+				m_source = m_target;
+				m_target = temp;
+			}
+
+			if (m_source != m_pointers)
+				memcpy(m_pointers, m_source, m_count * sizeof(SORTP*));
+
+			m_phase = PHASE_BACK_POINTERS;
+			WorkerPool::run(this, m_pieces, m_workers);
+		}
+
+		void execute(unsigned part)
+		{
+			switch (m_phase)
+			{
+			case PHASE_SORT:
+			{
+				const ULONG begin = m_runs[part], end = m_runs[part + 1];
+
+				if (m_entries)
+				{
+					sortByRadix(m_pointers + begin, end - begin, m_length,
+							  m_entries + begin, m_entries + m_count + begin);
+				}
+				else
+					std::sort(m_pointers + begin, m_pointers + end, m_less);
+				break;
+			}
+
+			case PHASE_MERGE:
+				merge(m_tasks[part]);
+				break;
+
+			case PHASE_BACK_POINTERS:
+				for (ULONG i = pieceBound(part), end = pieceBound(part + 1); i < end; i++)
+					((SORTP***) m_pointers[i])[BACK_OFFSET] = m_pointers + i;
+				break;
+			}
+		}
+
+	private:
+		enum Phase { PHASE_SORT, PHASE_MERGE, PHASE_BACK_POINTERS };
+
+		ULONG pieceBound(ULONG piece) const
+		{
+			return (ULONG) ((FB_UINT64) m_count * piece / m_pieces);
+		}
+
+		void prepareMerge()
+		{
+			// Merge neighbour runs pairwise, the odd run is just copied
+
+			const ULONG pairs = (m_runs.getCount() - 1) / 2;
+			const ULONG splits = MAX(1, (2 * m_workers + pairs - 1) / pairs);
+
+			m_tasks.clear();
+
+			Firebird::HalfStaticArray<ULONG, 64> runs;
+			FB_SIZE_T i = 0;
+			for (; i + 2 < m_runs.getCount(); i += 2)
+			{
+				const ULONG begin = m_runs[i], middle = m_runs[i + 1], end = m_runs[i + 2];
+
+				ULONG a = begin, b = middle;
+				for (ULONG split = 1; split <= splits; split++)
+				{
+					MergeTask task;
+					task.a_begin = a;
+					task.b_begin = b;
+					task.output = a + b - middle;
+
+					if (split == splits)
+					{
+						task.a_end = middle;
+						task.b_end = end;
+					}
+					else
+					{
+						// Find how many pointers of each run precede the split point
+
+						const ULONG output = begin + (ULONG) ((FB_UINT64) (end - begin) * split / splits);
+						task.a_end = coRank(output - begin, begin, middle, middle, end);
+						task.b_end = middle + (output - begin) - (task.a_end - begin);
+					}
+
+					m_tasks.add(task);
+
+					a = task.a_end;
+					b = task.b_end;
+				}
+
+				runs.add(begin);
+			}
+
+			if (i + 1 < m_runs.getCount())
+			{
+				// Odd run
+
+				MergeTask task;
+				task.a_begin = m_runs[i];
+				task.a_end = m_runs[i + 1];
+				task.b_begin = task.b_end = m_runs[i + 1];
+				task.output = m_runs[i];
+				m_tasks.add(task);
+
+				runs.add(m_runs[i]);
+			}
+
+			runs.add(m_count);
+
+			m_runs.clear();
+			m_runs.add(runs.begin(), runs.getCount());
+		}
+
+		ULONG coRank(ULONG rank, ULONG a_begin, ULONG a_end, ULONG b_begin, ULONG b_end) const
+		{
+			// Returns the position in the first run such that the pointers before it,
+			// together with rank minus their number first pointers of the second run,
+			// are the first rank pointers of the merge. Ties are taken from the first run.
+
+			const ULONG a_count = a_end - a_begin, b_count = b_end - b_begin;
+			ULONG low = (rank > b_count) ? rank - b_count : 0;
+			ULONG high = MIN(rank, a_count);
+
+			while (low < high)
+			{
+				const ULONG i = low + (high - low) / 2;
+				const ULONG j = rank - i;
+
+				if (j > 0 && !m_less(m_source[b_begin + j - 1], m_source[a_begin + i]))
+					low = i + 1;
+				else
+					high = i;
+			}
+
+			return a_begin + low;
+		}
+
+		void merge(const MergeTask& task) const
+		{
+			SORTP** a = m_source + task.a_begin;
+			SORTP** const a_end = m_source + task.a_end;
+			SORTP** b = m_source + task.b_begin;
+			SORTP** const b_end = m_source + task.b_end;
+			SORTP** output = m_target + task.output;
+
+			while (a < a_end && b < b_end)
+				*output++ = m_less(*b, *a) ? *b++ : *a++;
+
+			while (a < a_end)
+				*output++ = *a++;
+
+			while (b < b_end)
+				*output++ = *b++;
+		}
+
+		SORTP** const m_pointers;
+		SORTP** m_source;
+		SORTP** m_target;
+		RadixEntry* const m_entries;
+		const ULONG m_count;
+		const ULONG m_length;
+		const KeyLess m_less;
+		const unsigned m_workers;
+		ULONG m_pieces;
+		Phase m_phase;
+		Firebird::Array<ULONG> m_runs;			// Bounds of sorted runs
+		Firebird::Array<MergeTask> m_tasks;
+	};
 } // namespace
 
 
@@ -207,6 +749,24 @@ Sort::Sort(Database* dbb,
 		m_dup_callback_arg = user_arg;
 		m_max_records = max_records;
 
+		m_workers = MIN((ULONG) dbb->dbb_config->getSortWorkers(), WorkerPool::MAX_WORKERS + 1);
+
+		// If only the first records are wanted, they are kept in a heap while the
+		// others are dropped, so the sort never spills. This requires the buffer
+		// to hold all of them plus the one being put and the guard pointers.
+		// Duplicates elimination could leave less records than wanted.
+
+		ULONG top_size = 0;
+
+		if (max_records && !call_back)
+		{
+			const FB_UINT64 size = (max_records + 2) * (record_size + sizeof(sort_record*)) +
+				2 * sizeof(sort_record*);
+
+			if (size <= MAX_TOP_SORT_BUFFER_SIZE)
+				top_size = (ULONG) size;
+		}
+
 		for (FB_SIZE_T i = 0; i < keys; i++)
 		{
 			m_description.add(key_description[i]);
@@ -226,8 +786,16 @@ Sort::Sort(Database* dbb,
 
 		// Next, try to allocate a "big block". How big? Big enough!
 
+		const ULONG max_alloc_size = m_max_alloc_size;
+		m_max_alloc_size = MAX(m_max_alloc_size, top_size);
+
 		allocateBuffer(pool);
 
+		m_max_alloc_size = max_alloc_size;
+
+		if (top_size && top_size <= m_size_memory)
+			m_flags |= scb_top;
+
 		m_end_memory = m_memory + m_size_memory;
 		m_first_pointer = (sort_record**) m_memory;
 
@@ -286,6 +854,7 @@ Sort::~Sort()
 		m_runs = run->run_next;
 		if (run->run_buff_alloc)
 			delete[] run->run_buffer;
+		delete[] run->run_pack_buffer;
 		delete run;
 	}
 
@@ -296,6 +865,7 @@ Sort::~Sort()
 		m_free_runs = run->run_next;
 		if (run->run_buff_alloc)
 			delete[] run->run_buffer;
+		delete[] run->run_pack_buffer;
 		delete run;
 	}
 
@@ -380,6 +950,15 @@ void Sort::put(thread_db* tdbb, ULONG** record_address)
 		if (record != (SR*) m_end_memory)
 		{
 			diddleKey((UCHAR*) (record->sr_sort_record.sort_record_key), true, false);
+
+			// If the heap of the first records is full, the space of the last
+			// record is reused for the next one
+
+			if ((m_flags & scb_top) && !pushTop())
+			{
+				*record_address = (ULONG*) record->sr_sort_record.sort_record_key;
+				return;
+			}
 		}
 
 		// If there isn't room for the record, sort and write the run.
@@ -402,6 +981,7 @@ void Sort::put(thread_db* tdbb, ULONG** record_address)
 				if (count < RUN_GROUP)
 					break;
 				mergeRuns(count);
+				tdbb->bumpStats(RuntimeStatistics::SORT_MERGES);
 			}
 			init();
 			record = m_last_record;
@@ -451,8 +1031,19 @@ void Sort::sort(thread_db* tdbb)
 		if (m_last_record != (SR*) m_end_memory)
 		{
 			diddleKey((UCHAR*) KEYOF(m_last_record), true, false);
+
+			// Forget the spare record if the heap of the first records is full
+
+			if ((m_flags & scb_top) && !pushTop())
+			{
+				m_next_pointer--;
+				m_last_record = (SR*) ((SORTP*) m_last_record + m_longs);
+				m_records--;
+			}
 		}
 
+		tdbb->bumpStats(RuntimeStatistics::SORT_RECORDS, m_records);
+
 		// If there aren't any runs, things fit nicely in memory. Just sort the mess
 		// and we're ready for output.
 		if (!m_runs)
@@ -483,6 +1074,7 @@ void Sort::sort(thread_db* tdbb)
 		if (low_depth_cnt > 1 && low_depth_cnt < run_count)
 		{
 			mergeRuns(low_depth_cnt);
+			tdbb->bumpStats(RuntimeStatistics::SORT_MERGES);
 			CHECK_FILE(NULL);
 		}
 
@@ -629,6 +1221,21 @@ void Sort::sort(thread_db* tdbb)
 }
 
 
+void Sort::setEstimate(FB_UINT64 records)
+{
+/**************************************
+ *
+ * Tell the scratch space how much data the sort expects,
+ * it weighs the space's share of the temp cache.
+ *
+ **************************************/
+	if (m_max_records && records > m_max_records)
+		records = m_max_records;
+
+	m_space->setEstimate(records * m_longs * sizeof(ULONG));
+}
+
+
 void Sort::allocateBuffer(MemoryPool& pool)
 {
 	if (m_dbb->dbb_sort_buffers.hasData() && m_max_alloc_size <= MAX_SORT_BUFFER_SIZE)
@@ -1257,10 +1864,15 @@ sort_record* Sort::getMerge(merge_control* merge)
 			// There are records remaining, but the buffer is full.
 			// Read a buffer full.
 
-			l = (ULONG) (run->run_end_buffer - run->run_buffer);
-			n = run->run_records * m_longs * sizeof(ULONG);
-			l = MIN(l, n);
-			run->run_seek = readBlock(m_space, run->run_seek, run->run_buffer, l);
+			if (run->run_packed)
+				readPacked(run);
+			else
+			{
+				l = (ULONG) (run->run_end_buffer - run->run_buffer);
+				n = run->run_records * m_longs * sizeof(ULONG);
+				l = MIN(l, n);
+				run->run_seek = readBlock(m_space, run->run_seek, run->run_buffer, l);
+			}
 
 			record = reinterpret_cast<sort_record*>(run->run_buffer);
 			run->run_record =
@@ -1383,6 +1995,64 @@ sort_record* Sort::getMerge(merge_control* merge)
 }
 
 
+void Sort::readPacked(run_control* run)
+{
+/**************************************
+ *
+ * Fill the buffer of the packed run with unpacked records.
+ * Packed records are read by big chunks into the separate
+ * buffer, which also keeps the prior record, the last one of
+ * the previous buffer full.
+ *
+ **************************************/
+	const ULONG rec_size = m_longs << SHIFTLONG;
+	const ULONG max_length = packedLength(rec_size);
+	const ULONG size = MAX(PACKED_RUN_BUFFER_SIZE, 2 * max_length);
+
+	if (!run->run_pack_buffer)
+	{
+		// The prior record of the first one is all zeroes
+
+		run->run_pack_buffer = FB_NEW_POOL(m_owner->getPool()) UCHAR[rec_size + size];
+		memset(run->run_pack_buffer, 0, rec_size);
+		run->run_pack_record = run->run_pack_end = run->run_pack_buffer + rec_size;
+		run->run_pack_left = run->run_size;
+	}
+	else
+		memcpy(run->run_pack_buffer, (UCHAR*) run->run_record - rec_size, rec_size);
+
+	UCHAR* const data = run->run_pack_buffer + rec_size;
+	const UCHAR* prior = run->run_pack_buffer;
+	UCHAR* output = run->run_buffer;
+
+	for (ULONG count = MIN((ULONG) (run->run_end_buffer - run->run_buffer) / rec_size, run->run_records);
+		 count; count--)
+	{
+		// Make sure the whole packed record is in the buffer
+
+		ULONG length = run->run_pack_end - run->run_pack_record;
+
+		if (length < max_length && run->run_pack_left)
+		{
+			memmove(data, run->run_pack_record, length);
+
+			const ULONG chunk = (ULONG) MIN(size - length, run->run_pack_left);
+			run->run_seek = readBlock(m_space, run->run_seek, data + length, chunk);
+			run->run_pack_left -= chunk;
+
+			run->run_pack_record = data;
+			run->run_pack_end = data + length + chunk;
+		}
+
+		run->run_pack_record = unpackRecord(run->run_pack_record, run->run_pack_end,
+			prior, output, rec_size);
+
+		prior = output;
+		output += rec_size;
+	}
+}
+
+
 void Sort::init()
 {
 /**************************************
@@ -1397,28 +2067,58 @@ void Sort::init()
 	// At this point we already allocated some memory for temp space so
 	// growing sort buffer space is not a big compared to that
 
-	if (m_size_memory <= m_max_alloc_size && m_runs &&
-		m_runs->run_depth == MAX_MERGE_LEVEL)
+	// The same is done at the first run when the buffer is sorted by several
+	// workers, they need more records to split them between themselves. Memory
+	// for the extra workers is taken from the temp cache, if it can't give
+	// enough less workers are used.
+
+	const bool deep = m_runs && m_runs->run_depth == MAX_MERGE_LEVEL;
+	const bool parallel = m_runs && m_workers > 1 && m_max_alloc_size == MAX_SORT_BUFFER_SIZE;
+
+	if (m_size_memory <= m_max_alloc_size && (deep || parallel))
 	{
-		const ULONG mem_size = m_max_alloc_size * RUN_GROUP;
+		const ULONG chunk_size = m_max_alloc_size * RUN_GROUP;
+		ULONG workers = 1;
 
-		try
+		if (parallel)
 		{
-			UCHAR* const mem = FB_NEW_POOL(m_owner->getPool()) UCHAR[mem_size];
+			for (workers = m_workers; workers > 1; workers--)
+			{
+				if (m_space->reserveMemory(chunk_size * (workers - 1)))
+					break;
+			}
 
-			releaseBuffer();
+			m_workers = workers;
+		}
 
-			m_size_memory = mem_size;
-			m_memory = mem;
+		const ULONG mem_size = chunk_size * workers;
 
-			m_end_memory = m_memory + m_size_memory;
-			m_first_pointer = (sort_record**) m_memory;
+		if (deep || workers > 1)
+		{
+			try
+			{
+				UCHAR* const mem = FB_NEW_POOL(m_owner->getPool()) UCHAR[mem_size];
 
-			for (run_control *run = m_runs; run; run = run->run_next)
-				run->run_depth--;
+				releaseBuffer();
+
+				m_size_memory = mem_size;
+				m_memory = mem;
+
+				m_end_memory = m_memory + m_size_memory;
+				m_first_pointer = (sort_record**) m_memory;
+
+				if (deep)
+				{
+					for (run_control *run = m_runs; run; run = run->run_next)
+						run->run_depth--;
+				}
+			}
+			catch (const BadAlloc&)
+			{
+				if (workers > 1)
+					m_space->releaseMemory(chunk_size * (workers - 1));
+			}
 		}
-		catch (const BadAlloc&)
-		{} // no-op
 	}
 
 	m_next_pointer = m_first_pointer;
@@ -1469,7 +2169,9 @@ ULONG Sort::allocate(ULONG n, ULONG chunkSize, bool useFreeSpace)
 	{
 		run->run_buffer = NULL;
 
-		UCHAR* const mem = m_space->inMemory(run->run_seek, run->run_size);
+		// Packed records can't be used in place
+
+		UCHAR* const mem = run->run_packed ? NULL : m_space->inMemory(run->run_seek, run->run_size);
 
 		if (mem)
 		{
@@ -1549,6 +2251,8 @@ void Sort::mergeRuns(USHORT n)
 	temp_run.run_size = 0;
 	temp_run.run_buff_alloc = false;
 
+	FB_UINT64 records = 0;
+
 	run_merge_hdr* streams[RUN_GROUP * MAX_MERGE_LEVEL];
 	run_merge_hdr** m1 = streams;
 
@@ -1561,12 +2265,12 @@ void Sort::mergeRuns(USHORT n)
 	const USHORT allocated = allocate(n, m_max_alloc_size, (run->run_depth > 0));
 	CHECK_FILE(NULL);
 
-	const USHORT buffers = m_size_memory / rec_size;
+	const ULONG buffers = m_size_memory / rec_size;
 	USHORT count;
 	ULONG size = 0;
 
 	if (n > allocated)
-		size = rec_size * (buffers / (USHORT) (2 * (n - allocated)));
+		size = rec_size * (buffers / (2 * (n - allocated)));
 
 	for (run = m_runs, count = 0; count < n; run = run->run_next, count++)
 	{
@@ -1596,7 +2300,7 @@ void Sort::mergeRuns(USHORT n)
 				run->run_record = reinterpret_cast<sort_record*>(run->run_end_buffer);
 			}
 		}
-		temp_run.run_size += run->run_size;
+		records += run->run_records;
 	}
 	temp_run.run_record = reinterpret_cast<sort_record*>(buffer);
 	temp_run.run_buffer = reinterpret_cast<UCHAR*>(temp_run.run_record);
@@ -1644,34 +2348,62 @@ void Sort::mergeRuns(USHORT n)
 	CHECK_FILE(NULL);
 
 	sort_record* q = reinterpret_cast<sort_record*>(temp_run.run_buffer);
+	temp_run.run_size = records * rec_size;
 	FB_UINT64 seek = temp_run.run_seek = m_space->allocateSpace(temp_run.run_size);
 	temp_run.run_records = 0;
 
+	// If the new run doesn't fit in memory, its records are packed
+
+	if (!m_space->inMemory(temp_run.run_seek, temp_run.run_size))
+	{
+		m_space->releaseSpace(temp_run.run_seek, temp_run.run_size);
+		temp_run.run_size = records * packedLength(rec_size);
+		seek = temp_run.run_seek = m_space->allocateSpace(temp_run.run_size);
+		temp_run.run_packed = true;
+	}
+
 	CHECK_FILE(&temp_run);
 
 	const sort_record* p;
-	while ( (p = getMerge(merge)) )
+
+	if (temp_run.run_packed)
 	{
-		if (q >= (sort_record*) temp_run.run_end_buffer)
+		RunPacker packer(m_owner->getPool(), m_space, seek, rec_size);
+
+		while ( (p = getMerge(merge)) )
 		{
-			size = (UCHAR*) q - temp_run.run_buffer;
-			seek = writeBlock(m_space, seek, temp_run.run_buffer, size);
-			q = reinterpret_cast<sort_record*>(temp_run.run_buffer);
+			packer.put((const UCHAR*) p);
+			++temp_run.run_records;
 		}
-		ULONG longs_count = m_longs;
-		do {
-			*q++ = *p++;
-		} while (--longs_count);
-		++temp_run.run_records;
+
+		seek = packer.flush();
 	}
+	else
+	{
+		while ( (p = getMerge(merge)) )
+		{
+			if (q >= (sort_record*) temp_run.run_end_buffer)
+			{
+				size = (UCHAR*) q - temp_run.run_buffer;
+				seek = writeBlock(m_space, seek, temp_run.run_buffer, size);
+				q = reinterpret_cast<sort_record*>(temp_run.run_buffer);
+			}
+			ULONG longs_count = m_longs;
+			do {
+				*q++ = *p++;
+			} while (--longs_count);
+			++temp_run.run_records;
+		}
 
-	// Write the tail of the new run and return any unused space
+		// Write the tail of the new run
 
-	if ( (size = (UCHAR*) q - temp_run.run_buffer) )
-		seek = writeBlock(m_space, seek, temp_run.run_buffer, size);
+		if ( (size = (UCHAR*) q - temp_run.run_buffer) )
+			seek = writeBlock(m_space, seek, temp_run.run_buffer, size);
+	}
 
 	// If the records did not fill the allocated run (such as when duplicates are
-	// rejected), then free the remainder and diminish the size of the run accordingly
+	// rejected or records are packed), then free the remainder and diminish the
+	// size of the run accordingly
 
 	if (seek - temp_run.run_seek < temp_run.run_size)
 	{
@@ -1706,6 +2438,9 @@ void Sort::mergeRuns(USHORT n)
 		}
 		run->run_buffer = NULL;
 
+		delete[] run->run_pack_buffer;
+		run->run_pack_buffer = NULL;
+
 		// Add run descriptor to list of unused run descriptor blocks
 
 		run->run_next = m_free_runs;
@@ -1865,92 +2600,6 @@ void Sort::quick(SLONG size, SORTP** pointers, ULONG length)
 }
 
 
-ULONG Sort::order()
-{
-/**************************************
- *
- * The memoryfull of record pointers have been sorted, but more
- * records remain, so the run will have to be written to disk.  To
- * speed this up, re-arrange the records in physical order so they
- * can be written with a single disk write.
- *
- **************************************/
-	sort_record** ptr = m_first_pointer + 1;	// 1st ptr is low key
-
-	// Last inserted record, also the top of the memory where SORT_RECORDS can
-	// be written
-	sort_record* output = reinterpret_cast<sort_record*>(m_last_record);
-	sort_ptr_t* lower_limit = reinterpret_cast<sort_ptr_t*>(output);
-
-	HalfStaticArray<ULONG, 1024> record_buffer(m_owner->getPool());
-	SORTP* buffer = record_buffer.getBuffer(m_longs);
-
-	// Length of the key part of the record
-	const ULONG length = m_longs - SIZEOF_SR_BCKPTR_IN_LONGS;
-
-	// m_next_pointer points to the end of pointer memory or the beginning of
-	// records
-	while (ptr < m_next_pointer)
-	{
-		// If the next pointer is null, it's record has been eliminated as a
-		// duplicate. This is the only easy case.
-
-		SR* record = reinterpret_cast<SR*>(*ptr++);
-		if (!record)
-			continue;
-
-		// Make record point back to the starting of SR struct,
-		// as all scb* pointer point to the key_id locations!
-		record = reinterpret_cast<SR*>(((SORTP*) record) - SIZEOF_SR_BCKPTR_IN_LONGS);
-
-		// If the lower limit of live records points to a deleted or used record,
-		// advance the lower limit
-
-		while (!*(lower_limit) && (lower_limit < (sort_ptr_t*) m_end_memory))
-		{
-			lower_limit = reinterpret_cast<sort_ptr_t*>(((SORTP*) lower_limit) + m_longs);
-		}
-
-		// If the record we want to move won't interfere with lower active
-		// record, just move the record into position
-
-		if (record->sr_sort_record.sort_record_key == (ULONG*) lower_limit)
-		{
-			MOVE_32(length, record->sr_sort_record.sort_record_key, output);
-			output = reinterpret_cast<sort_record*>((SORTP*) output + length);
-			continue;
-		}
-
-		if (((SORTP*) output) + m_longs - 1 <= (SORTP*) lower_limit)
-		{
-			// null the bckptr for this record
-			record->sr_bckptr = NULL;
-			MOVE_32(length, record->sr_sort_record.sort_record_key, output);
-			output = reinterpret_cast<sort_record*>((SORTP*) output + length);
-			continue;
-		}
-
-		// There's another record sitting where we want to put our record. Move
-		// the next logical record to a temp, move the lower limit record to the
-		// next record's old position (adjusting pointers as we go), then move
-		// the current record to output.
-
-		MOVE_32(length, (SORTP*) record->sr_sort_record.sort_record_key, buffer);
-
-		**((sort_ptr_t***) lower_limit) =
-			reinterpret_cast<sort_ptr_t*>(record->sr_sort_record.sort_record_key);
-		MOVE_32(m_longs, lower_limit, record);
-		lower_limit = (sort_ptr_t*) ((SORTP*) lower_limit + m_longs);
-
-		MOVE_32(length, buffer, output);
-		output = reinterpret_cast<sort_record*>((sort_ptr_t*) ((SORTP*) output + length));
-	}
-
-	return (((SORTP*) output) -
-			((SORTP*) m_last_record)) / (m_longs - SIZEOF_SR_BCKPTR_IN_LONGS);
-}
-
-
 void Sort::orderAndSave(thread_db* tdbb)
 {
 /**************************************
@@ -1958,9 +2607,8 @@ void Sort::orderAndSave(thread_db* tdbb)
  * The memory full of record pointers has been sorted, but more
  * records remain, so the run will have to be written to scratch file.
  * If target run can be allocated in contiguous chunk of memory then
- * just memcpy records into it. Else call more expensive order() to
- * physically rearrange records in sort space and write its run into
- * scratch file as one big chunk
+ * just memcpy records into it. Else pack records one by one in their
+ * order and write them by big chunks.
  *
  **************************************/
 	EngineCheckout(tdbb, FB_FUNCTION);
@@ -1986,7 +2634,32 @@ void Sort::orderAndSave(thread_db* tdbb)
 
 	UCHAR* mem = m_space->inMemory(run->run_seek, run->run_size);
 
-	if (mem)
+	if (!mem)
+	{
+		// The run doesn't fit in memory, write its records packed
+
+		m_space->releaseSpace(run->run_seek, run->run_size);
+		run->run_size = run->run_records * packedLength(key_length);
+		run->run_seek = m_space->allocateSpace(run->run_size);
+		run->run_packed = true;
+
+		RunPacker packer(m_owner->getPool(), m_space, run->run_seek, key_length);
+
+		for (ptr = m_first_pointer + 1; ptr < m_next_pointer; ptr++)
+		{
+			if (*ptr)
+				packer.put((const UCHAR*) *ptr);
+		}
+
+		const FB_UINT64 seek = packer.flush();
+
+		if (seek - run->run_seek < run->run_size)
+		{
+			m_space->releaseSpace(seek, run->run_seek + run->run_size - seek);
+			run->run_size = seek - run->run_seek;
+		}
+	}
+	else
 	{
 		ptr = m_first_pointer + 1;
 		while (ptr < m_next_pointer)
@@ -2004,11 +2677,115 @@ void Sort::orderAndSave(thread_db* tdbb)
 			mem += key_length;
 		}
 	}
-	else
+}
+
+
+bool Sort::parallelSort(SORTP** pointers, ULONG count)
+{
+/**************************************
+ *
+ * Sort an array of record pointers by several threads, if
+ * it's big enough to be worth it. Unlike quick(), the result
+ * is ordered completely and back pointers are maintained.
+ * Returns false if the array was not sorted.
+ *
+ **************************************/
+	if (m_workers <= 1 || count < 2 * MIN_PARALLEL_SORT_RECORDS)
+		return false;
+
+	HalfStaticArray<SORTP*, 1> temp(m_owner->getPool());
+	HalfStaticArray<RadixEntry, 1> entries(m_owner->getPool());
+
+	try
+	{
+		temp.getBuffer(count);
+	}
+	catch (const BadAlloc&)
+	{
+		return false;
+	}
+
+	// Without memory for radix sort, pieces are sorted by comparisons
+
+	try
+	{
+		entries.getBuffer(2 * count);
+	}
+	catch (const BadAlloc&)
+	{
+		entries.free();
+	}
+
+	ParallelSortJob job(m_owner->getPool(), pointers, temp.begin(),
+		entries.hasData() ? entries.begin() : NULL, count, m_key_length, m_workers);
+	job.sort();
+
+	return true;
+}
+
+
+bool Sort::radixSort(SORTP** pointers, ULONG count)
+{
+/**************************************
+ *
+ * Sort an array of record pointers by radix sort of their
+ * key prefixes. Unlike quick(), the result is ordered completely
+ * and back pointers are maintained. Returns false if the array
+ * is too small to be worth it or memory is short.
+ *
+ **************************************/
+	if (count < MIN_RADIX_SORT_RECORDS)
+		return false;
+
+	HalfStaticArray<RadixEntry, 1> entries(m_owner->getPool());
+
+	try
 	{
-		order();
-		writeBlock(m_space, run->run_seek, (UCHAR*) m_last_record, run->run_size);
+		entries.getBuffer(2 * count);
 	}
+	catch (const BadAlloc&)
+	{
+		return false;
+	}
+
+	sortByRadix(pointers, count, m_key_length, entries.begin(), entries.begin() + count);
+
+	for (ULONG i = 0; i < count; i++)
+		((SORTP***) pointers[i])[BACK_OFFSET] = pointers + i;
+
+	return true;
+}
+
+
+bool Sort::pushTop()
+{
+/**************************************
+ *
+ * Add the last record put into the heap of the first
+ * m_max_records records. If the heap is full, the last record
+ * replaces the greatest one in the heap, if it's less, and
+ * false is returned, the space of the last record is spare then.
+ *
+ **************************************/
+	SORTP** const heap = (SORTP**) (m_first_pointer + 1);
+	const ULONG count = (SORTP**) m_next_pointer - heap;
+	const KeyLess less(m_key_length);
+
+	if (count <= m_max_records)
+	{
+		heapUp(heap, count - 1, less);
+		return true;
+	}
+
+	SORTP* const last = heap[count - 1];
+
+	if (less(last, heap[0]))
+	{
+		MOVE_32(m_longs - SIZEOF_SR_BCKPTR_IN_LONGS, last, heap[0]);
+		heapDown(heap, count - 1, less);
+	}
+
+	return false;
 }
 
 
@@ -2037,6 +2814,13 @@ void Sort::putRun(thread_db* tdbb)
 	run->run_header.rmh_type = RMH_TYPE_RUN;
 	run->run_depth = 0;
 
+	tdbb->bumpStats(RuntimeStatistics::SORT_RUNS);
+
+	// No pointers into the scratch space are kept between the runs, so it's
+	// the time to give the temp cache memory back if others need it
+
+	m_space->spill();
+
 	// Do the in-core sort. The first phase a duplicate handling we be performed
 	// in "sort".
 
@@ -2071,7 +2855,10 @@ void Sort::sortBuffer(thread_db* tdbb)
 	SORTP** j = (SORTP**) (m_first_pointer) + 1;
 	const ULONG n = (SORTP**) (m_next_pointer) - j;	// calculate # of records
 
-	quick(n, j, m_longs);
+	if (parallelSort(j, n))
+		tdbb->bumpStats(RuntimeStatistics::SORT_PARALLEL);
+	else if (!radixSort(j, n))
+		quick(n, j, m_longs);
 
 	// Scream through and correct any out of order pairs
 	// hvlad: don't compare user keys against high_key
@@ -232,6 +232,11 @@ struct run_control
 	bool			run_buff_cache;		// run buffer is already in cache
 	FB_UINT64		run_mem_seek;		// position of run's buffer in in-memory part of sort file
 	ULONG			run_mem_size;		// size of run's buffer in in-memory part of sort file
+	bool			run_packed;			// records are packed against the prior ones
+	UCHAR*			run_pack_buffer;	// ALLOC: prior record and packed records read
+	const UCHAR*	run_pack_record;	// Next packed record
+	const UCHAR*	run_pack_end;		// End of packed records read
+	FB_UINT64		run_pack_left;		// Length of packed records not read yet
 };
 
 // Merge control block
@@ -261,6 +266,7 @@ public:
 	void get(Jrd::thread_db*, ULONG**);
 	void put(Jrd::thread_db*, ULONG**);
 	void sort(Jrd::thread_db*);
+	void setEstimate(FB_UINT64);
 
 	static FB_UINT64 readBlock(TempSpace* space, FB_UINT64 seek, UCHAR* address, ULONG length)
 	{
@@ -282,11 +288,14 @@ private:
 
 	void diddleKey(UCHAR*, bool, bool);
 	sort_record* getMerge(merge_control*);
+	void readPacked(run_control*);
 	ULONG allocate(ULONG, ULONG, bool);
 	void init();
 	void mergeRuns(USHORT);
-	ULONG order();
 	void orderAndSave(Jrd::thread_db*);
+	bool parallelSort(SORTP**, ULONG);
+	bool radixSort(SORTP**, ULONG);
+	bool pushTop();
 	void putRun(Jrd::thread_db*);
 	void sortBuffer(Jrd::thread_db*);
 	void sortRunsBySeek(int);
@@ -309,7 +318,7 @@ private:
 	ULONG m_key_length;							// Key length
 	ULONG m_unique_length;						// Unique key length, used when duplicates eliminated
 	FB_UINT64 m_records;						// Number of records
-	FB_UINT64 m_max_records;					// Maximum number of records to store, assigned but unused.
+	FB_UINT64 m_max_records;					// Maximum number of records to return, zero if unlimited
 	TempSpace* m_space;							// temporary space for scratch file
 	run_control* m_runs;						// ALLOC: Run on scratch file, if any
 	merge_control* m_merge;						// Top level merge block
@@ -321,6 +330,7 @@ private:
 
 	ULONG m_min_alloc_size;						// MIN and MAX values
 	ULONG m_max_alloc_size;						// for the run buffer size
+	ULONG m_workers;							// Threads sorting the buffer
 
 	Firebird::Array<sort_key_def> m_description;
 };
@@ -328,6 +338,7 @@ private:
 // flags as set in m_flags
 
 const int scb_sorted = 1;	// stream has been sorted
+const int scb_top = 2;		// only the first m_max_records records are kept
 
 class SortOwner
 {
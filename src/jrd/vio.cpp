@@ -1537,6 +1537,12 @@ void VIO_erase(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 				protect_system_table_delupd(tdbb, relation, "DELETE");
 			break;
 
+		case rel_column_stats:
+			protect_system_table_delupd(tdbb, relation, "DELETE");
+			EVL_field(0, rpb->rpb_record, f_cst_rel_name, &desc);
+			DFW_post_work(transaction, dfw_column_statistics, &desc, 0);
+			break;
+
 		case rel_pages:
 		case rel_formats:
 		case rel_trans:
@@ -2879,6 +2885,12 @@ void VIO_modify(thread_db* tdbb, record_param* org_rpb, record_param* new_rpb, j
 				protect_system_table_delupd(tdbb, relation, "UPDATE");
 			break;
 
+		case rel_column_stats:
+			protect_system_table_delupd(tdbb, relation, "UPDATE");
+			EVL_field(0, new_rpb->rpb_record, f_cst_rel_name, &desc1);
+			DFW_post_work(transaction, dfw_column_statistics, &desc1, 0);
+			break;
+
 		case rel_pages:
 		case rel_formats:
 		case rel_msgs:
@@ -3526,6 +3538,12 @@ void VIO_store(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 				protect_system_table_insert(tdbb, request, relation);
 			break;
 
+		case rel_column_stats:
+			protect_system_table_insert(tdbb, request, relation);
+			EVL_field(0, rpb->rpb_record, f_cst_rel_name, &desc);
+			DFW_post_work(transaction, dfw_column_statistics, &desc, 0);
+			break;
+
 		case rel_types:
 			if (!(tdbb->getDatabase()->dbb_flags & DBB_creating))
 			{
@@ -0,0 +1,1754 @@
+/*
+ *	PROGRAM:	JRD Lock Manager
+ *	MODULE:		local_lock.cpp
+ *	DESCRIPTION:	Process-local lock table
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../lock/local_lock.h"
+#include "../jrd/jrd.h"
+#include "gen/iberror.h"
+#include "../common/gdsassert.h"
+#include "../common/config/config.h"
+#include "../common/classes/Hash.h"
+#include "../common/utils_proto.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef DEV_BUILD
+#define CHECK(x)	do { if (!(x)) bug(NULL, "consistency check"); } while (false)
+#else
+#define CHECK(x)	do { } while (false)
+#endif
+
+#define BLOCK(fld_ptr, type, fld) (type*)((UCHAR*) fld_ptr - offsetof(type, fld))
+
+using namespace Firebird;
+
+namespace {
+
+const ULONG HASH_MIN_SLOTS	= 101;
+const ULONG HASH_MAX_SLOTS	= 65521;
+
+const bool compatibility[LCK_max][LCK_max] =
+{
+/*							Shared	Prot	Shared	Prot
+			none	null	Read	Read	Write	Write	Exclusive */
+
+/* none */	{true,	true,	true,	true,	true,	true,	true},
+/* null */	{true,	true,	true,	true,	true,	true,	true},
+/* SR */	{true,	true,	true,	true,	true,	true,	false},
+/* PR */	{true,	true,	true,	true,	false,	false,	false},
+/* SW */	{true,	true,	true,	false,	true,	false,	false},
+/* PW */	{true,	true,	true,	false,	false,	false,	false},
+/* EX */	{true,	true,	false,	false,	false,	false,	false}
+};
+
+} // namespace
+
+
+namespace Jrd {
+
+LocalLockManager::LocalLockManager(RefPtr<const Config> conf)
+	: m_ownerHandles(getPool()),
+	  m_requestHandles(getPool()),
+	  m_hash(getPool()),
+	  m_scanInterval(conf->getDeadlockTimeout()),
+	  m_bugcheck(false)
+{
+	ULONG hash_slots = conf->getLockHashSlots();
+	if (hash_slots < HASH_MIN_SLOTS)
+		hash_slots = HASH_MIN_SLOTS;
+	if (hash_slots > HASH_MAX_SLOTS)
+		hash_slots = HASH_MAX_SLOTS;
+
+	que* const hash = m_hash.getBuffer(hash_slots);
+	for (ULONG i = 0; i < hash_slots; i++)
+		QUE_INIT(hash[i]);
+
+	QUE_INIT(m_owners);
+	QUE_INIT(m_freeOwners);
+	QUE_INIT(m_freeRequests);
+	QUE_INIT(m_freeLocks);
+
+	for (int i = 0; i < LCK_MAX_SERIES; i++)
+		QUE_INIT(m_data[i]);
+
+	// Handle zero means "no owner" / "no request"
+
+	m_ownerHandles.add(NULL);
+	m_requestHandles.add(NULL);
+}
+
+
+LocalLockManager::~LocalLockManager()
+{
+	for (FB_SIZE_T i = 0; i < m_hash.getCount(); i++)
+	{
+		que* const hash = &m_hash[i];
+		while (QUE_NOT_EMPTY(*hash))
+		{
+			LockBlock* const lock = BLOCK(hash->que_forward, LockBlock, lbl_hash);
+			QUE_DELETE(lock->lbl_hash);
+			delete[] lock->lbl_key;
+			delete lock;
+		}
+	}
+
+	while (QUE_NOT_EMPTY(m_freeLocks))
+	{
+		LockBlock* const lock = BLOCK(m_freeLocks.que_forward, LockBlock, lbl_hash);
+		QUE_DELETE(lock->lbl_hash);
+		delete[] lock->lbl_key;
+		delete lock;
+	}
+
+	for (FB_SIZE_T i = 0; i < m_requestHandles.getCount(); i++)
+		delete m_requestHandles[i];
+
+	for (FB_SIZE_T i = 0; i < m_ownerHandles.getCount(); i++)
+		delete m_ownerHandles[i];
+}
+
+
+bool LocalLockManager::initializeOwner(CheckStatusWrapper* /*statusVector*/,
+									   LOCK_OWNER_T owner_id,
+									   UCHAR owner_type,
+									   SRQ_PTR* owner_handle)
+{
+/**************************************
+ *
+ *	i n i t i a l i z e O w n e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Initialize an owner block, if not already initialized.
+ *	Return the handle of the owner block through owner_handle.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	if (*owner_handle)
+	{
+		// If everything is already initialized, just bump the use count
+
+		get_owner(*owner_handle)->own_count++;
+		return true;
+	}
+
+	// Look for a previous instance of owner.  If we find one, get rid of it.
+
+	for (que* q = m_owners.que_forward; q != &m_owners; q = q->que_forward)
+	{
+		Owner* const owner = BLOCK(q, Owner, own_owners);
+		if (owner->own_owner_id == owner_id && owner->own_owner_type == owner_type)
+		{
+			purge_owner(owner);
+			break;
+		}
+	}
+
+	// Allocate or reuse an owner block
+
+	Owner* owner;
+	if (QUE_EMPTY(m_freeOwners))
+	{
+		owner = FB_NEW_POOL(getPool()) Owner;
+		owner->own_handle = (SRQ_PTR) m_ownerHandles.add(owner);
+	}
+	else
+	{
+		owner = BLOCK(m_freeOwners.que_forward, Owner, own_owners);
+		QUE_DELETE(owner->own_owners);
+	}
+
+	owner->own_owner_type = owner_type;
+	owner->own_owner_id = owner_id;
+	owner->own_flags = 0;
+	owner->own_count = 1;
+	owner->own_waits = 0;
+	owner->own_wakeups = 0;
+	owner->own_ast_count = 0;
+	QUE_INIT(owner->own_requests);
+	QUE_INIT(owner->own_blocks);
+	QUE_INIT(owner->own_pending);
+	QUE_APPEND(m_owners, owner->own_owners);
+
+	*owner_handle = owner->own_handle;
+	return true;
+}
+
+
+void LocalLockManager::shutdownOwner(thread_db* tdbb, SRQ_PTR* owner_handle)
+{
+/**************************************
+ *
+ *	s h u t d o w n O w n e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release the owner block and any outstanding locks.
+ *
+ **************************************/
+	if (!*owner_handle)
+		return;
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Owner* const owner = get_owner(*owner_handle);
+	if (!owner->own_count)
+		return;
+
+	if (--owner->own_count > 0)
+		return;
+
+	while (owner->own_ast_count)
+	{
+		MutexUnlockGuard checkout(m_mutex, FB_FUNCTION);
+		EngineCheckout cout(tdbb, FB_FUNCTION, true);
+		Thread::sleep(10);
+	}
+
+	// All the granted locks are expected to be released explicitly
+	// before destroying the lock owner, see LockManager::shutdownOwner()
+	fb_assert(QUE_EMPTY(owner->own_requests));
+
+	purge_owner(owner);
+
+	*owner_handle = 0;
+}
+
+
+SRQ_PTR LocalLockManager::enqueue(thread_db* tdbb,
+								  CheckStatusWrapper* statusVector,
+								  SRQ_PTR prior_request,
+								  const USHORT series,
+								  const UCHAR* value,
+								  const USHORT length,
+								  UCHAR type,
+								  lock_ast_t ast_routine,
+								  void* ast_argument,
+								  LOCK_DATA_T data,
+								  SSHORT lck_wait,
+								  SRQ_PTR owner_handle)
+{
+/**************************************
+ *
+ *	e n q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Enque on a lock.  If the lock can't be granted immediately,
+ *	wait for it if asked to.  If the lock can't be granted,
+ *	return zero.
+ *
+ **************************************/
+	if (!owner_handle)
+		return 0;
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Owner* const owner = get_owner(owner_handle);
+	if (!owner->own_count)
+		return 0;
+
+	if (prior_request)
+		internal_dequeue(get_request(prior_request));
+
+	const ULONG hash_slot = InternalHash::hash(length, value, m_hash.getCount());
+
+	// Allocate or reuse a lock request block
+
+	Request* const request = alloc_request();
+
+	request->lrq_type = type_lrq;
+	request->lrq_flags = 0;
+	request->lrq_requested = type;
+	request->lrq_state = LCK_none;
+	request->lrq_data = 0;
+	request->lrq_owner = owner;
+	request->lrq_ast_routine = ast_routine;
+	request->lrq_ast_argument = ast_argument;
+	QUE_APPEND(owner->own_requests, request->lrq_own_requests);
+	QUE_INIT(request->lrq_own_blocks);
+	QUE_INIT(request->lrq_own_pending);
+
+	// See if the lock already exists
+
+	LockBlock* lock = find_lock(hash_slot, series, value, length);
+	if (lock)
+	{
+		QUE_APPEND(lock->lbl_requests, request->lrq_lbl_requests);
+		request->lrq_data = data;
+
+		const SRQ_PTR request_handle = request->lrq_handle;
+		if (grant_or_que(tdbb, request, lock, lck_wait))
+			return request_handle;
+
+		Arg::Gds(lck_wait > 0 ? isc_deadlock : lck_wait < 0 ? isc_lock_timeout :
+			isc_lock_conflict).copyTo(statusVector);
+
+		return 0;
+	}
+
+	// Lock doesn't exist. Allocate lock block and set it up.
+
+	lock = alloc_lock(length);
+
+	lock->lbl_state = type;
+	fb_assert(series <= MAX_UCHAR);
+	lock->lbl_series = (UCHAR) series;
+
+	// Maintain lock series data queue
+
+	QUE_INIT(lock->lbl_data);
+	if ( (lock->lbl_data_value = data) )
+		insert_data_que(lock);
+
+	lock->lbl_pending_lrq_count = 0;
+	memset(lock->lbl_counts, 0, sizeof(lock->lbl_counts));
+
+	lock->lbl_length = length;
+	memcpy(lock->lbl_key, value, length);
+
+	QUE_INIT(lock->lbl_requests);
+	QUE_APPEND(m_hash[hash_slot], lock->lbl_hash);
+	QUE_APPEND(lock->lbl_requests, request->lrq_lbl_requests);
+	request->lrq_lock = lock;
+	grant(request, lock);
+
+	return request->lrq_handle;
+}
+
+
+bool LocalLockManager::convert(thread_db* tdbb,
+							   CheckStatusWrapper* statusVector,
+							   SRQ_PTR request_handle,
+							   UCHAR type,
+							   SSHORT lck_wait,
+							   lock_ast_t ast_routine,
+							   void* ast_argument)
+{
+/**************************************
+ *
+ *	c o n v e r t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Perform a lock conversion, if possible.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Request* const request = get_request(request_handle);
+	if (!request->lrq_owner->own_count)
+		return false;
+
+	return internal_convert(tdbb, statusVector, request, type, lck_wait,
+							ast_routine, ast_argument);
+}
+
+
+UCHAR LocalLockManager::downgrade(thread_db* tdbb,
+								  CheckStatusWrapper* statusVector,
+								  const SRQ_PTR request_handle)
+{
+/**************************************
+ *
+ *	d o w n g r a d e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Downgrade an existing lock returning
+ *	its new state.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Request* const request = get_request(request_handle);
+	if (!request->lrq_owner->own_count)
+		return LCK_none;
+
+	const LockBlock* const lock = request->lrq_lock;
+	UCHAR pending_state = LCK_none;
+
+	// Loop thru requests looking for pending conversions
+	// and find the highest requested state
+
+	for (const que* q = lock->lbl_requests.que_forward; q != &lock->lbl_requests; q = q->que_forward)
+	{
+		const Request* const pending = BLOCK(q, Request, lrq_lbl_requests);
+		if ((pending->lrq_flags & LRQ_pending) && pending != request)
+		{
+			pending_state = MAX(pending->lrq_requested, pending_state);
+			if (pending_state == LCK_EX)
+				break;
+		}
+	}
+
+	UCHAR state = request->lrq_state;
+	while (state > LCK_none && !compatibility[pending_state][state])
+		--state;
+
+	if (state == LCK_none || state == LCK_null)
+	{
+		internal_dequeue(request);
+		state = LCK_none;
+	}
+	else
+	{
+		internal_convert(tdbb, statusVector, request, state, LCK_NO_WAIT,
+						 request->lrq_ast_routine, request->lrq_ast_argument);
+	}
+
+	return state;
+}
+
+
+bool LocalLockManager::dequeue(const SRQ_PTR request_handle)
+{
+/**************************************
+ *
+ *	d e q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release an outstanding lock.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Request* const request = get_request(request_handle);
+	if (!request->lrq_owner->own_count)
+		return false;
+
+	internal_dequeue(request);
+	return true;
+}
+
+
+void LocalLockManager::repost(thread_db* tdbb, lock_ast_t ast, void* arg, SRQ_PTR owner_handle)
+{
+/**************************************
+ *
+ *	r e p o s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Re-post an AST that was previously blocked.
+ *
+ **************************************/
+	if (!owner_handle)
+		return;
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Owner* const owner = get_owner(owner_handle);
+
+	Request* const request = alloc_request();
+
+	request->lrq_type = type_lrq;
+	request->lrq_flags = LRQ_repost;
+	request->lrq_ast_routine = ast;
+	request->lrq_ast_argument = arg;
+	request->lrq_requested = LCK_none;
+	request->lrq_state = LCK_none;
+	request->lrq_owner = owner;
+	request->lrq_lock = NULL;
+
+	QUE_APPEND(owner->own_blocks, request->lrq_own_blocks);
+	QUE_INIT(request->lrq_own_pending);
+
+	if (!(owner->own_flags & OWN_signaled))
+	{
+		owner->own_flags |= OWN_signaled;
+		blocking_action(tdbb, owner);
+	}
+}
+
+
+bool LocalLockManager::cancelWait(SRQ_PTR owner_handle)
+{
+/**************************************
+ *
+ *	c a n c e l W a i t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Wakeup waiting owner to make it check if wait should be cancelled.
+ *	As this routine could be called asyncronous, take extra care and
+ *	don't trust the input params blindly.
+ *
+ **************************************/
+	if (!owner_handle)
+		return false;
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	if (owner_handle < 0 || (FB_SIZE_T) owner_handle >= m_ownerHandles.getCount())
+		return false;
+
+	Owner* const owner = m_ownerHandles[owner_handle];
+	if (!owner->own_count)
+		return false;
+
+	post_wakeup(owner);
+	return true;
+}
+
+
+LOCK_DATA_T LocalLockManager::queryData(const USHORT series, const USHORT aggregate)
+{
+/**************************************
+ *
+ *	q u e r y D a t a
+ *
+ **************************************
+ *
+ * Functional description
+ *	Query lock series data with respect to a rooted
+ *	lock hierarchy calculating aggregates as we go.
+ *
+ **************************************/
+	if (series >= LCK_MAX_SERIES)
+	{
+		CHECK(false);
+		return 0;
+	}
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	const que& data_header = m_data[series];
+	LOCK_DATA_T data = 0, count = 0;
+
+	// Simply walk the lock series data queue forward for the minimum
+	// and backward for the maximum -- it's maintained in sorted order.
+
+	switch (aggregate)
+	{
+	case LCK_CNT:
+	case LCK_AVG:
+	case LCK_SUM:
+		for (const que* q = data_header.que_forward; q != &data_header; q = q->que_forward)
+		{
+			const LockBlock* const lock = BLOCK(q, LockBlock, lbl_data);
+			CHECK(lock->lbl_series == series);
+
+			switch (aggregate)
+			{
+			case LCK_CNT:
+				++count;
+				break;
+
+			case LCK_AVG:
+				++count;
+
+			case LCK_SUM:
+				data += lock->lbl_data_value;
+				break;
+			}
+		}
+
+		if (aggregate == LCK_CNT)
+			data = count;
+		else if (aggregate == LCK_AVG)
+			data = count ? data / count : 0;
+		break;
+
+	case LCK_ANY:
+		if (QUE_NOT_EMPTY(data_header))
+			data = 1;
+		break;
+
+	case LCK_MIN:
+		if (QUE_NOT_EMPTY(data_header))
+		{
+			const LockBlock* const lock = BLOCK(data_header.que_forward, LockBlock, lbl_data);
+			CHECK(lock->lbl_series == series);
+
+			data = lock->lbl_data_value;
+		}
+		break;
+
+	case LCK_MAX:
+		if (QUE_NOT_EMPTY(data_header))
+		{
+			const LockBlock* const lock = BLOCK(data_header.que_backward, LockBlock, lbl_data);
+			CHECK(lock->lbl_series == series);
+
+			data = lock->lbl_data_value;
+		}
+		break;
+
+	default:
+		CHECK(false);
+	}
+
+	return data;
+}
+
+
+LOCK_DATA_T LocalLockManager::readData(SRQ_PTR request_handle)
+{
+/**************************************
+ *
+ *	r e a d D a t a
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read data associated with a lock.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	return get_request(request_handle)->lrq_lock->lbl_data_value;
+}
+
+
+LOCK_DATA_T LocalLockManager::readData2(USHORT series,
+										const UCHAR* value,
+										USHORT length,
+										SRQ_PTR owner_handle)
+{
+/**************************************
+ *
+ *	r e a d D a t a 2
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read data associated with transient locks.
+ *
+ **************************************/
+	if (!owner_handle)
+		return 0;
+
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	const ULONG hash_slot = InternalHash::hash(length, value, m_hash.getCount());
+	const LockBlock* const lock = find_lock(hash_slot, series, value, length);
+
+	return lock ? lock->lbl_data_value : 0;
+}
+
+
+LOCK_DATA_T LocalLockManager::writeData(SRQ_PTR request_handle, LOCK_DATA_T data)
+{
+/**************************************
+ *
+ *	w r i t e D a t a
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a longword into the lock block.
+ *
+ **************************************/
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	LockBlock* const lock = get_request(request_handle)->lrq_lock;
+	QUE_DELETE(lock->lbl_data);
+	QUE_INIT(lock->lbl_data);
+	if ( (lock->lbl_data_value = data) )
+		insert_data_que(lock);
+
+	return data;
+}
+
+
+LocalLockManager::LockBlock* LocalLockManager::alloc_lock(USHORT length)
+{
+/**************************************
+ *
+ *	a l l o c _ l o c k
+ *
+ **************************************
+ *
+ * Functional description
+ *	Allocate a lock for a key of a given length.  Look first to see
+ *	if a spare of the right size is sitting around.  If not, allocate
+ *	one.
+ *
+ **************************************/
+	length = FB_ALIGN(length, 8);
+
+	for (que* q = m_freeLocks.que_forward; q != &m_freeLocks; q = q->que_forward)
+	{
+		LockBlock* const lock = BLOCK(q, LockBlock, lbl_hash);
+
+		// "First fit", see LockManager::alloc_lock()
+		if (lock->lbl_size >= length)
+		{
+			QUE_DELETE(lock->lbl_hash);
+			lock->lbl_type = type_lbl;
+			return lock;
+		}
+	}
+
+	LockBlock* const lock = FB_NEW_POOL(getPool()) LockBlock;
+	lock->lbl_key = length ? FB_NEW_POOL(getPool()) UCHAR[length] : NULL;
+	lock->lbl_size = length;
+	lock->lbl_type = type_lbl;
+
+	return lock;
+}
+
+
+LocalLockManager::Request* LocalLockManager::alloc_request()
+{
+/**************************************
+ *
+ *	a l l o c _ r e q u e s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Allocate or reuse a lock request block.  The block keeps
+ *	its handle for the whole lifetime of the lock table.
+ *
+ **************************************/
+	if (QUE_NOT_EMPTY(m_freeRequests))
+	{
+		Request* const request = BLOCK(m_freeRequests.que_forward, Request, lrq_lbl_requests);
+		QUE_DELETE(request->lrq_lbl_requests);
+		return request;
+	}
+
+	Request* const request = FB_NEW_POOL(getPool()) Request;
+	request->lrq_handle = (SRQ_PTR) m_requestHandles.add(request);
+	request->lrq_wakeup = NULL;
+	request->lrq_woken = false;
+
+	return request;
+}
+
+
+void LocalLockManager::blocking_action(thread_db* tdbb, Owner* owner)
+{
+/**************************************
+ *
+ *	b l o c k i n g _ a c t i o n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Deliver blocking ASTs pending for the owner.  As all the
+ *	owners live in this process, ASTs are called synchronously,
+ *	exactly like LockManager::signal_owner() does for the owners
+ *	of the current process.
+ *
+ **************************************/
+	while (owner->own_count && QUE_NOT_EMPTY(owner->own_blocks))
+	{
+		Request* const request = BLOCK(owner->own_blocks.que_forward, Request, lrq_own_blocks);
+		lock_ast_t routine = request->lrq_ast_routine;
+		void* arg = request->lrq_ast_argument;
+		QUE_DELETE(request->lrq_own_blocks);
+
+		if (request->lrq_flags & LRQ_blocking)
+		{
+			request->lrq_flags &= ~LRQ_blocking;
+			request->lrq_flags |= LRQ_blocking_seen;
+		}
+		else if (request->lrq_flags & LRQ_repost)
+		{
+			request->lrq_type = type_null;
+			QUE_APPEND(m_freeRequests, request->lrq_lbl_requests);
+		}
+
+		if (routine)
+		{
+			owner->own_ast_count++;
+
+			{ // checkout scope
+				MutexUnlockGuard checkout(m_mutex, FB_FUNCTION);
+				EngineCheckout cout(tdbb, FB_FUNCTION, true);
+				(*routine)(arg);
+			}
+
+			owner->own_ast_count--;
+		}
+	}
+
+	owner->own_flags &= ~OWN_signaled;
+}
+
+
+void LocalLockManager::bug(CheckStatusWrapper* statusVector, const TEXT* string)
+{
+/**************************************
+ *
+ *	b u g
+ *
+ **************************************
+ *
+ * Functional description
+ *	Disastrous lock manager bug.  Issue message and abort process.
+ *
+ **************************************/
+	if (!m_bugcheck)
+	{
+		m_bugcheck = true;
+
+		if (statusVector)
+		{
+			(Arg::Gds(isc_lockmanerr) <<
+				Arg::Gds(isc_random) << Arg::Str(string) <<
+				Arg::StatusVector(statusVector)).copyTo(statusVector);
+
+			return;
+		}
+	}
+
+	TEXT s[BUFFER_SMALL];
+	fb_utils::snprintf(s, sizeof(s), "Fatal lock manager error: %s", string);
+	fb_utils::logAndDie(s);
+}
+
+
+void LocalLockManager::deadlock_clear()
+{
+/**************************************
+ *
+ *	d e a d l o c k _ c l e a r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Clear deadlock and scanned bits for pending requests
+ *	in preparation for a deadlock scan.
+ *
+ **************************************/
+	for (que* q = m_owners.que_forward; q != &m_owners; q = q->que_forward)
+	{
+		Owner* const owner = BLOCK(q, Owner, own_owners);
+
+		for (que* q2 = owner->own_pending.que_forward; q2 != &owner->own_pending; q2 = q2->que_forward)
+		{
+			Request* const request = BLOCK(q2, Request, lrq_own_pending);
+			fb_assert(request->lrq_flags & LRQ_pending);
+			request->lrq_flags &= ~(LRQ_deadlock | LRQ_scanned);
+		}
+	}
+}
+
+
+LocalLockManager::Request* LocalLockManager::deadlock_scan(Owner* owner, Request* request)
+{
+/**************************************
+ *
+ *	d e a d l o c k _ s c a n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Given an owner block that has been stalled for some time, find
+ *	a deadlock cycle if there is one.  If a deadlock is found, return
+ *	the address of a pending lock request in the deadlock request.
+ *	If no deadlock is found, return null.
+ *
+ **************************************/
+	deadlock_clear();
+
+	bool maybe_deadlock = false;
+	Request* const victim = deadlock_walk(request, &maybe_deadlock);
+
+	// Only when it is certain that this request is not part of a deadlock do we
+	// mark this request as 'scanned' so that we will not check this request again.
+
+	if (!victim && !maybe_deadlock)
+		owner->own_flags |= OWN_scanned;
+
+	return victim;
+}
+
+
+LocalLockManager::Request* LocalLockManager::deadlock_walk(Request* request, bool* maybe_deadlock)
+{
+/**************************************
+ *
+ *	d e a d l o c k _ w a l k
+ *
+ **************************************
+ *
+ * Functional description
+ *	Given a request that is waiting, determine whether a deadlock has
+ *	occurred.  See LockManager::deadlock_walk() for the details.
+ *
+ **************************************/
+
+	// If this request was scanned for deadlock earlier than don't visit it again
+
+	if (request->lrq_flags & LRQ_scanned)
+		return NULL;
+
+	// If this request has been seen already during this deadlock-walk, then we
+	// detected a circle in the wait-for graph.  Return "deadlock".
+
+	if (request->lrq_flags & LRQ_deadlock)
+		return request;
+
+	// Remember that this request is part of the wait-for graph
+
+	request->lrq_flags |= LRQ_deadlock;
+
+	const bool conversion = (request->lrq_state > LCK_null);
+	LockBlock* const lock = request->lrq_lock;
+
+	// Loop thru the requests granted against the lock.  If any granted request is
+	// blocking the request we're handling, recurse to find what's blocking it.
+
+	for (que* q = lock->lbl_requests.que_forward; q != &lock->lbl_requests; q = q->que_forward)
+	{
+		Request* const block = BLOCK(q, Request, lrq_lbl_requests);
+
+		if (conversion)
+		{
+			// Only granted lock requests could block the conversion
+
+			if (request == block)
+				continue;
+
+			if (compatibility[request->lrq_requested][block->lrq_state])
+				continue;
+		}
+		else
+		{
+			// Granted locks and waiting requests that arrived
+			// before our request could block us
+
+			if (request == block)
+				break;
+
+			const UCHAR max_state = MAX(block->lrq_state, block->lrq_requested);
+
+			if (compatibility[request->lrq_requested][max_state])
+				continue;
+		}
+
+		// Don't pursue lock owners that still have to finish processing their AST,
+		// but remember that they still might be part of a deadlock
+
+		Owner* const owner = block->lrq_owner;
+
+		if ((owner->own_flags & OWN_signaled) || owner->own_wakeups || QUE_NOT_EMPTY(owner->own_blocks) ||
+			(block->lrq_flags & LRQ_just_granted))
+		{
+			*maybe_deadlock = true;
+			continue;
+		}
+
+		for (que* q2 = owner->own_pending.que_forward; q2 != &owner->own_pending; q2 = q2->que_forward)
+		{
+			Request* target = BLOCK(q2, Request, lrq_own_pending);
+			fb_assert(target->lrq_flags & LRQ_pending);
+
+			// Requests that are waiting with a timeout break the circle themselves
+
+			if (target->lrq_flags & LRQ_wait_timeout)
+				continue;
+
+			if ( (target = deadlock_walk(target, maybe_deadlock)) )
+				return target;
+		}
+	}
+
+	// This branch of the wait-for graph is exhausted, the current waiting
+	// request is not part of a deadlock
+
+	request->lrq_flags &= ~LRQ_deadlock;
+	request->lrq_flags |= LRQ_scanned;
+	return NULL;
+}
+
+
+LocalLockManager::LockBlock* LocalLockManager::find_lock(USHORT hash_slot,
+														 USHORT series,
+														 const UCHAR* value,
+														 USHORT length)
+{
+/**************************************
+ *
+ *	f i n d _ l o c k
+ *
+ **************************************
+ *
+ * Functional description
+ *	Find a lock block in the given hash slot.
+ *
+ **************************************/
+	que* const hash_header = &m_hash[hash_slot];
+
+	for (que* q = hash_header->que_forward; q != hash_header; q = q->que_forward)
+	{
+		LockBlock* const lock = BLOCK(q, LockBlock, lbl_hash);
+		if (lock->lbl_series != series || lock->lbl_length != length)
+			continue;
+
+		if (!length || !memcmp(value, lock->lbl_key, length))
+			return lock;
+	}
+
+	return NULL;
+}
+
+
+LocalLockManager::Owner* LocalLockManager::get_owner(SRQ_PTR handle)
+{
+/**************************************
+ *
+ *	g e t _ o w n e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Locate and validate user supplied owner handle.
+ *
+ **************************************/
+	if (handle <= 0 || (FB_SIZE_T) handle >= m_ownerHandles.getCount())
+	{
+		TEXT s[BUFFER_TINY];
+		sprintf(s, "invalid lock owner (%" SLONGFORMAT")", handle);
+		bug(NULL, s);
+	}
+
+	return m_ownerHandles[handle];
+}
+
+
+LocalLockManager::Request* LocalLockManager::get_request(SRQ_PTR handle)
+{
+/**************************************
+ *
+ *	g e t _ r e q u e s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Locate and validate user supplied request handle.
+ *
+ **************************************/
+	TEXT s[BUFFER_TINY];
+
+	if (handle <= 0 || (FB_SIZE_T) handle >= m_requestHandles.getCount() ||
+		m_requestHandles[handle]->lrq_type != type_lrq)
+	{
+		sprintf(s, "invalid lock id (%" SLONGFORMAT")", handle);
+		bug(NULL, s);
+	}
+
+	Request* const request = m_requestHandles[handle];
+
+	if (!request->lrq_lock || request->lrq_lock->lbl_type != type_lbl)
+	{
+		sprintf(s, "invalid lock (%" SLONGFORMAT")", handle);
+		bug(NULL, s);
+	}
+
+	return request;
+}
+
+
+void LocalLockManager::grant(Request* request, LockBlock* lock)
+{
+/**************************************
+ *
+ *	g r a n t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Grant a lock request.  If the lock is a conversion, assume the caller
+ *	has already decremented the former lock type count in the lock block.
+ *
+ **************************************/
+
+	// Request must be for THIS lock
+	CHECK(request->lrq_lock == lock);
+
+	++lock->lbl_counts[request->lrq_requested];
+	request->lrq_state = request->lrq_requested;
+	if (request->lrq_data)
+	{
+		QUE_DELETE(lock->lbl_data);
+		QUE_INIT(lock->lbl_data);
+		if ( (lock->lbl_data_value = request->lrq_data) )
+			insert_data_que(lock);
+		request->lrq_data = 0;
+	}
+
+	lock->lbl_state = lock_state(lock);
+
+	if (request->lrq_flags & LRQ_pending)
+	{
+		QUE_DELETE(request->lrq_own_pending);
+		request->lrq_flags &= ~LRQ_pending;
+		lock->lbl_pending_lrq_count--;
+	}
+
+	post_wakeup(request);
+}
+
+
+bool LocalLockManager::grant_or_que(thread_db* tdbb, Request* request, LockBlock* lock, SSHORT lck_wait)
+{
+/**************************************
+ *
+ *	g r a n t _ o r _ q u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	There is a request against an existing lock.  If the request
+ *	is compatible with the lock, grant it.  Otherwise wait for it,
+ *	if asked to.
+ *
+ **************************************/
+	request->lrq_lock = lock;
+
+	// Compatible requests are easy to satify.  Just post the request to the lock,
+	// update the lock state, release the data structure, and we're done.
+
+	if (compatibility[request->lrq_requested][lock->lbl_state])
+	{
+		if (request->lrq_requested == LCK_null || lock->lbl_pending_lrq_count == 0)
+		{
+			grant(request, lock);
+			post_pending(lock);
+			return true;
+		}
+	}
+
+	// The request isn't compatible with the current state of the lock.
+	// If we haven't be asked to wait for the lock, return now.
+
+	if (lck_wait)
+	{
+		wait_for_request(tdbb, request, lck_wait);
+
+		if (!(request->lrq_flags & LRQ_rejected))
+			return true;
+	}
+
+	release_request(request);
+
+	return false;
+}
+
+
+void LocalLockManager::insert_data_que(LockBlock* lock)
+{
+/**************************************
+ *
+ *	i n s e r t _ d a t a _ q u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Insert a node in the lock series data queue
+ *	in sorted (ascending) order by lock data.
+ *
+ **************************************/
+	if (lock->lbl_series < LCK_MAX_SERIES && lock->lbl_data_value)
+	{
+		que* const data_header = &m_data[lock->lbl_series];
+
+		que* q;
+		for (q = data_header->que_forward; q != data_header; q = q->que_forward)
+		{
+			const LockBlock* const lock2 = BLOCK(q, LockBlock, lbl_data);
+			CHECK(lock2->lbl_series == lock->lbl_series);
+
+			if (lock->lbl_data_value <= lock2->lbl_data_value)
+				break;
+		}
+
+		QUE_APPEND(*q, lock->lbl_data);
+	}
+}
+
+
+bool LocalLockManager::internal_convert(thread_db* tdbb,
+										CheckStatusWrapper* statusVector,
+										Request* request,
+										UCHAR type,
+										SSHORT lck_wait,
+										lock_ast_t ast_routine,
+										void* ast_argument)
+{
+/**************************************
+ *
+ *	i n t e r n a l _ c o n v e r t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Perform a lock conversion, if possible.  If the lock cannot be
+ *	granted immediately, either return immediately or wait depending
+ *	on a wait flag.  If the lock is granted return true, otherwise
+ *	return false.
+ *
+ **************************************/
+	LockBlock* const lock = request->lrq_lock;
+	request->lrq_requested = type;
+	request->lrq_flags &= ~LRQ_blocking_seen;
+
+	// Compute the state of the lock without the request
+
+	--lock->lbl_counts[request->lrq_state];
+	const UCHAR temp = lock_state(lock);
+
+	// If the requested lock level is compatible with the current state
+	// of the lock, just grant the request.  Easy enough.
+
+	if (compatibility[type][temp])
+	{
+		request->lrq_ast_routine = ast_routine;
+		request->lrq_ast_argument = ast_argument;
+		grant(request, lock);
+		post_pending(lock);
+		return true;
+	}
+
+	++lock->lbl_counts[request->lrq_state];
+
+	// If we weren't requested to wait, just forget about the whole thing.
+	// Otherwise wait for the request to be granted or rejected.
+
+	if (lck_wait)
+	{
+		wait_for_request(tdbb, request, lck_wait);
+
+		if (!(request->lrq_flags & LRQ_rejected))
+		{
+			request->lrq_ast_routine = ast_routine;
+			request->lrq_ast_argument = ast_argument;
+			return true;
+		}
+
+		post_pending(lock);
+	}
+
+	request->lrq_requested = request->lrq_state;
+
+	(Arg::Gds(lck_wait > 0 ? isc_deadlock : lck_wait < 0 ? isc_lock_timeout :
+		isc_lock_conflict)).copyTo(statusVector);
+
+	return false;
+}
+
+
+void LocalLockManager::internal_dequeue(Request* request)
+{
+/**************************************
+ *
+ *	i n t e r n a l _ d e q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release an outstanding lock.
+ *
+ **************************************/
+	request->lrq_ast_routine = NULL;
+	release_request(request);
+}
+
+
+UCHAR LocalLockManager::lock_state(const LockBlock* lock)
+{
+/**************************************
+ *
+ *	l o c k _ s t a t e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Compute the current state of a lock.
+ *
+ **************************************/
+	for (UCHAR state = LCK_EX; state > LCK_none; --state)
+	{
+		if (lock->lbl_counts[state])
+			return state;
+	}
+
+	return LCK_none;
+}
+
+
+void LocalLockManager::post_blockage(thread_db* tdbb, Request* request, LockBlock* lock)
+{
+/**************************************
+ *
+ *	p o s t _ b l o c k a g e
+ *
+ **************************************
+ *
+ * Functional description
+ *	The current request is blocked.  Deliver blocking
+ *	notices to any owner blocking the request.
+ *
+ **************************************/
+	const Owner* const owner = request->lrq_owner;
+
+	CHECK(request->lrq_flags & LRQ_pending);
+
+	HalfStaticArray<Owner*, 16> blocking_owners;
+
+	for (que* q = lock->lbl_requests.que_forward; q != &lock->lbl_requests; q = q->que_forward)
+	{
+		Request* const block = BLOCK(q, Request, lrq_lbl_requests);
+		Owner* const blocking_owner = block->lrq_owner;
+
+		// Our own request cannot block ourselves, compatible requests don't
+		// block us, requests without AST cannot be notified and owners that
+		// have seen the blocking AST already promised to release the lock
+
+		if (block == request ||
+			blocking_owner == owner ||
+			compatibility[request->lrq_requested][block->lrq_state] ||
+			!block->lrq_ast_routine ||
+			(block->lrq_flags & LRQ_blocking_seen))
+		{
+			continue;
+		}
+
+		if (!(block->lrq_flags & LRQ_blocking))
+		{
+			QUE_APPEND(blocking_owner->own_blocks, block->lrq_own_blocks);
+			block->lrq_flags |= LRQ_blocking;
+			block->lrq_flags &= ~(LRQ_blocking_seen | LRQ_just_granted);
+		}
+
+		blocking_owners.add(blocking_owner);
+
+		if (block->lrq_state == LCK_EX)
+			break;
+	}
+
+	for (Owner** iter = blocking_owners.begin(); iter != blocking_owners.end(); ++iter)
+	{
+		Owner* const blocking_owner = *iter;
+
+		if (blocking_owner->own_count && !(blocking_owner->own_flags & OWN_signaled))
+		{
+			blocking_owner->own_flags |= OWN_signaled;
+			blocking_action(tdbb, blocking_owner);
+		}
+	}
+}
+
+
+void LocalLockManager::post_pending(LockBlock* lock)
+{
+/**************************************
+ *
+ *	p o s t _ p e n d i n g
+ *
+ **************************************
+ *
+ * Functional description
+ *	There has been a change in state of a lock.  Check pending
+ *	requests to see if something can be granted.  If so, do it.
+ *
+ **************************************/
+	if (lock->lbl_pending_lrq_count == 0)
+		return;
+
+	// Loop thru granted requests looking for pending conversions.  If one
+	// is found, check to see if it can be granted.  Even if a request cannot
+	// be granted for compatibility reason, post_wakeup () that owner so that
+	// it can post_blockage() to the newly granted owner of the lock.
+
+	que* q;
+	for (q = lock->lbl_requests.que_forward; q != &lock->lbl_requests; q = q->que_forward)
+	{
+		Request* const request = BLOCK(q, Request, lrq_lbl_requests);
+		if (!(request->lrq_flags & LRQ_pending))
+			continue;
+
+		if (request->lrq_state)
+		{
+			--lock->lbl_counts[request->lrq_state];
+			const UCHAR temp_state = lock_state(lock);
+			if (compatibility[request->lrq_requested][temp_state])
+				grant(request, lock);
+			else
+			{
+				++lock->lbl_counts[request->lrq_state];
+				post_wakeup(request);
+				break;
+			}
+		}
+		else if (compatibility[request->lrq_requested][lock->lbl_state])
+			grant(request, lock);
+		else
+		{
+			post_wakeup(request);
+			break;
+		}
+	}
+
+	if (lock->lbl_pending_lrq_count)
+	{
+		for (q = lock->lbl_requests.que_forward; q != &lock->lbl_requests; q = q->que_forward)
+		{
+			Request* const request = BLOCK(q, Request, lrq_lbl_requests);
+			if (request->lrq_flags & LRQ_pending)
+				break;
+
+			if (!(request->lrq_flags & (LRQ_blocking | LRQ_blocking_seen)) &&
+				request->lrq_ast_routine)
+			{
+				request->lrq_flags |= LRQ_just_granted;
+			}
+		}
+	}
+}
+
+
+void LocalLockManager::post_wakeup(Owner* owner)
+{
+/**************************************
+ *
+ *	p o s t _ w a k e u p
+ *
+ **************************************
+ *
+ * Functional description
+ *	Wakeup all threads of the owner waiting on locks,
+ *	each of them checks the state of its own request.
+ *
+ **************************************/
+	for (que* q = owner->own_pending.que_forward; q != &owner->own_pending; q = q->que_forward)
+		post_wakeup(BLOCK(q, Request, lrq_own_pending));
+}
+
+
+void LocalLockManager::post_wakeup(Request* request)
+{
+/**************************************
+ *
+ *	p o s t _ w a k e u p
+ *
+ **************************************
+ *
+ * Functional description
+ *	Wakeup the thread waiting on the request, if any.
+ *
+ **************************************/
+	if (request->lrq_wakeup && !request->lrq_woken)
+	{
+		request->lrq_woken = true;
+		request->lrq_owner->own_wakeups++;
+		request->lrq_wakeup->release();
+	}
+}
+
+
+void LocalLockManager::purge_owner(Owner* owner)
+{
+/**************************************
+ *
+ *	p u r g e _ o w n e r
+ *
+ **************************************
+ *
+ * Functional description
+ *	Purge an owner and all of its associated locks.
+ *
+ **************************************/
+
+	// Release any locks that are active
+
+	while (QUE_NOT_EMPTY(owner->own_requests))
+		release_request(BLOCK(owner->own_requests.que_forward, Request, lrq_own_requests));
+
+	// Release any repost requests left dangling on blocking queue
+
+	while (QUE_NOT_EMPTY(owner->own_blocks))
+	{
+		Request* const request = BLOCK(owner->own_blocks.que_forward, Request, lrq_own_blocks);
+		QUE_DELETE(request->lrq_own_blocks);
+		request->lrq_type = type_null;
+		QUE_APPEND(m_freeRequests, request->lrq_lbl_requests);
+	}
+
+	// Release owner block
+
+	QUE_DELETE(owner->own_owners);
+	QUE_APPEND(m_freeOwners, owner->own_owners);
+
+	owner->own_owner_type = 0;
+	owner->own_owner_id = 0;
+	owner->own_count = 0;
+	owner->own_flags = 0;
+}
+
+
+void LocalLockManager::release_request(Request* request)
+{
+/**************************************
+ *
+ *	r e l e a s e _ r e q u e s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release a request.  This is called both by release lock
+ *	and by the cleanup handler.
+ *
+ **************************************/
+
+	// Start by disconnecting request from both lock and owner
+
+	QUE_DELETE(request->lrq_lbl_requests);
+	QUE_DELETE(request->lrq_own_requests);
+
+	LockBlock* const lock = request->lrq_lock;
+
+	request->lrq_type = type_null;
+	QUE_APPEND(m_freeRequests, request->lrq_lbl_requests);
+
+	// If the request is marked as blocking, clean it up
+
+	if (request->lrq_flags & LRQ_blocking)
+	{
+		QUE_DELETE(request->lrq_own_blocks);
+		request->lrq_flags &= ~LRQ_blocking;
+	}
+
+	// Update counts if we are cleaning up something we're waiting on
+
+	if (request->lrq_flags & LRQ_pending)
+	{
+		QUE_DELETE(request->lrq_own_pending);
+		request->lrq_flags &= ~LRQ_pending;
+		lock->lbl_pending_lrq_count--;
+	}
+
+	request->lrq_flags &= ~(LRQ_blocking_seen | LRQ_just_granted);
+
+	// If there are no outstanding requests, release the lock
+
+	if (QUE_EMPTY(lock->lbl_requests))
+	{
+		CHECK(lock->lbl_pending_lrq_count == 0);
+
+		QUE_DELETE(lock->lbl_hash);
+		QUE_DELETE(lock->lbl_data);
+		lock->lbl_type = type_null;
+
+		QUE_APPEND(m_freeLocks, lock->lbl_hash);
+		return;
+	}
+
+	// Re-compute the state of the lock and post any compatible pending requests
+
+	if ((request->lrq_state != LCK_none) && !(--lock->lbl_counts[request->lrq_state]))
+		lock->lbl_state = lock_state(lock);
+
+	post_pending(lock);
+}
+
+
+void LocalLockManager::wait_for_request(thread_db* tdbb, Request* request, SSHORT lck_wait)
+{
+/**************************************
+ *
+ *	w a i t _ f o r _ r e q u e s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	There is a request that needs satisfaction, but is waiting for
+ *	somebody else.  Mark the request as pending and go to sleep until
+ *	the lock gets poked.  When we wake up, see if somebody else has
+ *	cleared the pending flag.  If not, go back to sleep.
+ *
+ **************************************/
+
+	// lrq_count will be off if we wait for a pending request
+	CHECK(!(request->lrq_flags & LRQ_pending));
+
+	Owner* const owner = request->lrq_owner;
+	owner->own_flags &= ~OWN_scanned;
+	owner->own_waits++;
+
+	// Every waiting thread has its own semaphore, so wakeups
+	// meant for other requests of the owner are never stolen
+
+	Semaphore wakeup;
+	AutoSetRestore<Semaphore*> setWakeup(&request->lrq_wakeup, &wakeup);
+	request->lrq_woken = false;
+
+	request->lrq_flags &= ~LRQ_rejected;
+	request->lrq_flags |= LRQ_pending;
+	QUE_APPEND(owner->own_pending, request->lrq_own_pending);
+
+	LockBlock* const lock = request->lrq_lock;
+	lock->lbl_pending_lrq_count++;
+
+	if (!request->lrq_state)
+	{
+		// If this is a conversion of an existing lock in LCK_none state -
+		// put the lock to the end of the list so it's not taking cuts in the lineup
+		QUE_DELETE(request->lrq_lbl_requests);
+		QUE_APPEND(lock->lbl_requests, request->lrq_lbl_requests);
+	}
+
+	if (lck_wait <= 0)
+		request->lrq_flags |= LRQ_wait_timeout;
+
+	// Post blockage. ASTs are delivered synchronously, so the
+	// blockage may be cleared already when we get back here.
+
+	post_blockage(tdbb, request, lock);
+
+	time_t current_time = time(NULL);
+
+	const time_t lock_timeout = (lck_wait < 0) ? current_time + (-lck_wait) : 0;
+	time_t deadlock_timeout = current_time + m_scanInterval;
+
+	// Wait in a loop until the lock becomes available
+
+	while (request->lrq_flags & LRQ_pending)
+	{
+		time_t timeout = deadlock_timeout;
+		if (lck_wait < 0 && lock_timeout < deadlock_timeout)
+			timeout = lock_timeout;
+
+		if (!request->lrq_woken)
+		{
+			// post_wakeup() is called under the mutex, thus no wakeup
+			// could be lost between the check above and the wait
+
+			MutexUnlockGuard checkout(m_mutex, FB_FUNCTION);
+			EngineCheckout cout(tdbb, FB_FUNCTION, true);
+
+			const int seconds = (timeout > current_time) ? (int) (timeout - current_time) : 0;
+			wakeup.tryEnter(seconds);
+		}
+
+		// If somebody else has resolved the lock, we're done
+
+		if (!(request->lrq_flags & LRQ_pending))
+			break;
+
+		const bool woken = request->lrq_woken;
+
+		current_time = time(NULL);
+
+		// Go back to sleep after a bogus wakeup, i.e. if we were not
+		// deliberately woken up and it's not yet time for a deadlock
+		// scan or for the lock timeout to expire
+
+		if (!woken && current_time + 1 < timeout)
+			continue;
+
+		if (woken)
+		{
+			request->lrq_woken = false;
+			owner->own_wakeups--;
+		}
+
+		const bool cancelled = (tdbb->checkCancelState() != FB_SUCCESS);
+
+		if (cancelled || (lck_wait < 0 && lock_timeout <= current_time))
+		{
+			// Reject our lock - the caller cleans up and calls post_pending()
+			// to wakeup other owners we might be blocking
+
+			request->lrq_flags |= LRQ_rejected;
+			QUE_DELETE(request->lrq_own_pending);
+			request->lrq_flags &= ~LRQ_pending;
+			lock->lbl_pending_lrq_count--;
+			break;
+		}
+
+		deadlock_timeout = current_time + m_scanInterval;
+
+		// Someone posted our wakeup but didn't grant our request, the lock
+		// could be granted to another request - tell its owner about us
+
+		if (woken)
+		{
+			post_blockage(tdbb, request, lock);
+			continue;
+		}
+
+		// If we've not previously been scanned for a deadlock and going to wait
+		// forever, go do a deadlock scan
+
+		Request* blocking_request;
+		if (!(owner->own_flags & OWN_scanned) &&
+			!(request->lrq_flags & LRQ_wait_timeout) &&
+			(blocking_request = deadlock_scan(owner, request)))
+		{
+			// Something has been selected for rejection to prevent a
+			// deadlock. We still have to wait for our request to be resolved.
+
+			blocking_request->lrq_flags |= LRQ_rejected;
+			QUE_DELETE(blocking_request->lrq_own_pending);
+			blocking_request->lrq_flags &= ~LRQ_pending;
+			blocking_request->lrq_lock->lbl_pending_lrq_count--;
+
+			Owner* const blocking_owner = blocking_request->lrq_owner;
+			blocking_owner->own_flags &= ~OWN_scanned;
+			if (blocking_request != request)
+				post_wakeup(blocking_request);
+		}
+		else
+		{
+			// No deadlock -- remind the owners we're waiting for, the
+			// ownership of the lock could have changed meanwhile
+
+			post_blockage(tdbb, request, lock);
+		}
+	}
+
+	CHECK(!(request->lrq_flags & LRQ_pending));
+
+	if (request->lrq_woken)
+	{
+		request->lrq_woken = false;
+		owner->own_wakeups--;
+	}
+
+	request->lrq_flags &= ~LRQ_wait_timeout;
+	owner->own_waits--;
+}
+
+} // namespace Jrd
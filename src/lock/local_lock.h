@@ -0,0 +1,163 @@
+/*
+ *	PROGRAM:	JRD Lock Manager
+ *	MODULE:		local_lock.h
+ *	DESCRIPTION:	Process-local lock table
+ *
+ * The contents of this file are subject to the Interbase Public
+ * License Version 1.0 (the "License"); you may not use this file
+ * except in compliance with the License. You may obtain a copy
+ * of the License at http://www.Inprise.com/IPL.html
+ *
+ * Software distributed under the License is distributed on an
+ * "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * rights and limitations under the License.
+ *
+ * The Original Code was created by Inprise Corporation
+ * and its predecessors. Portions created by Inprise Corporation are
+ * Copyright (C) Inprise Corporation.
+ *
+ * All Rights Reserved.
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef LOCK_LOCAL_LOCK_H
+#define LOCK_LOCAL_LOCK_H
+
+#include "../lock/lock_proto.h"
+#include "../common/classes/locks.h"
+
+namespace Jrd {
+
+// Lock table which is never shared with another process. It's used by the
+// SuperServer when the database file is opened exclusively, i.e. nobody else
+// could ever attach the same lock table. Algorithms are the same as in the
+// shared lock table, but blocks are addressed by native pointers and waits
+// are done on the process-local semaphores, one per waiting request as an
+// owner may have several waiting threads. Handles returned to the caller
+// are indices of the owner and request blocks, they are never reused for
+// the blocks of other type.
+
+class LocalLockManager : public Firebird::GlobalStorage
+{
+	struct LockBlock;
+	struct Request;
+
+	struct Owner
+	{
+		que own_owners;					// Active or free owners
+		que own_requests;				// Lock requests granted or pending
+		que own_blocks;					// Lock requests blocking
+		que own_pending;				// Lock requests pending
+		LOCK_OWNER_T own_owner_id;		// Owner ID
+		SRQ_PTR own_handle;				// Handle given to the caller
+		SLONG own_count;				// Init count for the owner
+		USHORT own_flags;				// Misc stuff (OWN_*)
+		USHORT own_waits;				// Number of requests we are waiting on
+		USHORT own_ast_count;			// Number of ASTs being delivered
+		USHORT own_wakeups;				// Number of waiting requests woken up
+		UCHAR own_owner_type;			// Type of owner
+	};
+
+	struct Request
+	{
+		que lrq_lbl_requests;			// Locks granted or pending, free requests
+		que lrq_own_requests;			// Locks granted for owner
+		que lrq_own_blocks;				// Owner block que
+		que lrq_own_pending;			// Owner pending que
+		Owner* lrq_owner;				// Owner making request
+		LockBlock* lrq_lock;			// Lock requested
+		SRQ_PTR lrq_handle;				// Handle given to the caller
+		lock_ast_t lrq_ast_routine;		// Block ast routine
+		void* lrq_ast_argument;			// Ast argument
+		Firebird::Semaphore* lrq_wakeup;	// Wakeup semaphore of the waiting thread
+		LOCK_DATA_T lrq_data;			// Lock data requested
+		USHORT lrq_flags;				// Misc crud (LRQ_*)
+		UCHAR lrq_type;					// type_lrq or type_null
+		UCHAR lrq_requested;			// Level requested
+		UCHAR lrq_state;				// State of lock request
+		bool lrq_woken;					// Waiting thread has been awoken
+	};
+
+	struct LockBlock
+	{
+		que lbl_hash;					// Hash chain or free locks
+		que lbl_requests;				// Requests granted
+		que lbl_data;					// Lock series data que
+		LOCK_DATA_T lbl_data_value;		// User data
+		UCHAR* lbl_key;					// Key value
+		USHORT lbl_size;				// Key bytes allocated
+		USHORT lbl_length;				// Key bytes used
+		USHORT lbl_pending_lrq_count;	// Count of lbl_requests with LRQ_pending
+		USHORT lbl_counts[LCK_max];		// Counts of granted locks
+		UCHAR lbl_type;					// type_lbl or type_null
+		UCHAR lbl_state;				// High state granted
+		UCHAR lbl_series;				// Lock series
+	};
+
+public:
+	explicit LocalLockManager(Firebird::RefPtr<const Config>);
+	~LocalLockManager();
+
+	bool initializeOwner(Firebird::CheckStatusWrapper*, LOCK_OWNER_T, UCHAR, SRQ_PTR*);
+	void shutdownOwner(thread_db*, SRQ_PTR*);
+
+	SRQ_PTR enqueue(thread_db*, Firebird::CheckStatusWrapper*, SRQ_PTR, const USHORT,
+		const UCHAR*, const USHORT, UCHAR, lock_ast_t, void*, LOCK_DATA_T, SSHORT, SRQ_PTR);
+	bool convert(thread_db*, Firebird::CheckStatusWrapper*, SRQ_PTR, UCHAR, SSHORT, lock_ast_t, void*);
+	UCHAR downgrade(thread_db*, Firebird::CheckStatusWrapper*, const SRQ_PTR);
+	bool dequeue(const SRQ_PTR);
+
+	void repost(thread_db*, lock_ast_t, void*, SRQ_PTR);
+	bool cancelWait(SRQ_PTR);
+
+	LOCK_DATA_T queryData(const USHORT, const USHORT);
+	LOCK_DATA_T readData(SRQ_PTR);
+	LOCK_DATA_T readData2(USHORT, const UCHAR*, USHORT, SRQ_PTR);
+	LOCK_DATA_T writeData(SRQ_PTR, LOCK_DATA_T);
+
+private:
+	LockBlock* alloc_lock(USHORT);
+	Request* alloc_request();
+	void blocking_action(thread_db*, Owner*);
+	void bug(Firebird::CheckStatusWrapper*, const TEXT*);
+	void deadlock_clear();
+	Request* deadlock_scan(Owner*, Request*);
+	Request* deadlock_walk(Request*, bool*);
+	LockBlock* find_lock(USHORT, USHORT, const UCHAR*, USHORT);
+	Owner* get_owner(SRQ_PTR);
+	Request* get_request(SRQ_PTR);
+	void grant(Request*, LockBlock*);
+	bool grant_or_que(thread_db*, Request*, LockBlock*, SSHORT);
+	void insert_data_que(LockBlock*);
+	bool internal_convert(thread_db*, Firebird::CheckStatusWrapper*, Request*, UCHAR, SSHORT,
+		lock_ast_t, void*);
+	void internal_dequeue(Request*);
+	static UCHAR lock_state(const LockBlock*);
+	void post_blockage(thread_db*, Request*, LockBlock*);
+	void post_pending(LockBlock*);
+	void post_wakeup(Owner*);
+	void post_wakeup(Request*);
+	void purge_owner(Owner*);
+	void release_request(Request*);
+	void wait_for_request(thread_db*, Request*, SSHORT);
+
+	Firebird::Mutex m_mutex;
+
+	Firebird::Array<Owner*> m_ownerHandles;
+	Firebird::Array<Request*> m_requestHandles;
+	Firebird::Array<que> m_hash;
+
+	que m_owners;
+	que m_freeOwners;
+	que m_freeRequests;
+	que m_freeLocks;
+	que m_data[LCK_MAX_SERIES];
+
+	const ULONG m_scanInterval;
+	bool m_bugcheck;
+};
+
+} // namespace
+
+#endif // LOCK_LOCAL_LOCK_H
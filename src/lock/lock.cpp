@@ -40,6 +40,7 @@
 
 #include "firebird.h"
 #include "../lock/lock_proto.h"
+#include "../lock/local_lock.h"
 #include "../common/ThreadStart.h"
 #include "../jrd/jrd.h"
 #include "../jrd/Attachment.h"
@@ -141,11 +142,63 @@ const SRQ_PTR DUMMY_OWNER = -1;
 
 const SLONG HASH_MIN_SLOTS	= 101;
 const SLONG HASH_MAX_SLOTS	= 65521;
+const ULONG HASH_GROW_MAX_SLOTS	= 8388593;	// limit of automatic growth
+const ULONG HASH_MAX_CHAIN	= 1024;
 const USHORT HISTORY_BLOCKS	= 256;
 
 // SRQ_ABS_PTR uses this macro.
 #define SRQ_BASE                    ((UCHAR*) m_sharedMemory->getHeader())
 
+#ifdef USE_LOCK_STRIPES
+static int init_stripe_mutex(Firebird::mtx* mutex)
+{
+/**************************************
+ *
+ *	i n i t _ s t r i p e _ m u t e x
+ *
+ **************************************
+ *
+ * Functional description
+ *	Initialize process-shared mutex of the lock table stripe.
+ *
+ **************************************/
+	pthread_mutexattr_t mattr;
+
+	int state = pthread_mutexattr_init(&mattr);
+	if (state)
+		return state;
+
+	state = pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+
+#ifdef USE_ROBUST_MUTEX
+	if (!state)
+		state = pthread_mutexattr_setrobust_np(&mattr, PTHREAD_MUTEX_ROBUST_NP);
+#endif
+
+	if (!state)
+		state = pthread_mutex_init(mutex->mtx_mutex, &mattr);
+
+#ifdef USE_ROBUST_MUTEX
+	if (state == ENOTSUP)
+	{
+		// Some kernels can't do robust mutexes, see SharedMemoryBase::SharedMemoryBase()
+		pthread_mutexattr_destroy(&mattr);
+
+		state = pthread_mutexattr_init(&mattr);
+		if (state)
+			return state;
+
+		state = pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+		if (!state)
+			state = pthread_mutex_init(mutex->mtx_mutex, &mattr);
+	}
+#endif
+
+	pthread_mutexattr_destroy(&mattr);
+	return state;
+}
+#endif // USE_LOCK_STRIPES
+
 static const bool compatibility[LCK_max][LCK_max] =
 {
 /*							Shared	Prot	Shared	Prot
@@ -161,20 +214,64 @@ static const bool compatibility[LCK_max][LCK_max] =
 };
 
 
+static ULONG hash_limit(ULONG hash_slots, ULONG max_chain)
+{
+/**************************************
+ *
+ *	h a s h _ l i m i t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Return the number of locks at which the hash table
+ *	should grow, or zero if it should not grow anymore.
+ *
+ **************************************/
+	if (!max_chain || hash_slots >= HASH_GROW_MAX_SLOTS)
+		return 0;
+
+	return hash_slots * MIN(max_chain, HASH_MAX_CHAIN);
+}
+
+
+static ULONG hash_prime(ULONG number)
+{
+/**************************************
+ *
+ *	h a s h _ p r i m e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Return the smallest prime not less than the number.
+ *
+ **************************************/
+	for (number |= 1; ; number += 2)
+	{
+		ULONG divisor = 3;
+		while (divisor * divisor <= number && number % divisor)
+			divisor += 2;
+
+		if (divisor * divisor > number)
+			return number;
+	}
+}
+
+
 namespace Jrd {
 
 GlobalPtr<LockManager::DbLockMgrMap> LockManager::g_lmMap;
 GlobalPtr<Mutex> LockManager::g_mapMutex;
 
 
-LockManager* LockManager::create(const string& id, RefPtr<const Config> conf)
+LockManager* LockManager::create(const string& id, RefPtr<const Config> conf, bool exclusive)
 {
 	MutexLockGuard guard(g_mapMutex, FB_FUNCTION);
 
 	LockManager* lockMgr = NULL;
 	if (!g_lmMap->get(id, lockMgr))
 	{
-		lockMgr = FB_NEW LockManager(id, conf);
+		lockMgr = FB_NEW LockManager(id, conf, exclusive);
 
 		if (g_lmMap->put(id, lockMgr))
 		{
@@ -208,23 +305,39 @@ void LockManager::destroy(LockManager* lockMgr)
 }
 
 
-LockManager::LockManager(const string& id, RefPtr<const Config> conf)
+LockManager::LockManager(const string& id, RefPtr<const Config> conf, bool exclusive)
 	: PID(getpid()),
 	  m_bugcheck(false),
 	  m_process(NULL),
 	  m_processOffset(0),
 	  m_cleanupSync(getPool(), blocking_action_thread, THREAD_high),
+	  m_deadlockSync(getPool(), deadlock_thread, THREAD_medium),
+	  m_deadlockThread(false),
 	  m_sharedMemory(NULL),
 	  m_blockage(false),
+	  m_stripesAcquired(false),
+#ifdef USE_LOCK_STRIPES
+	  m_stripes(NULL),
+#endif
 	  m_dbId(getPool(), id),
 	  m_config(conf),
 	  m_acquireSpins(m_config->getLockAcquireSpins()),
 	  m_memorySize(m_config->getLockMemSize()),
+	  m_hashMaxChain(m_config->getLockHashMaxChain()),
 	  m_useBlockingThread(m_config->getServerMode() != MODE_SUPER)
 #ifdef USE_SHMEM_EXT
 	  , m_extents(getPool())
 #endif
 {
+	// Nobody else could attach the lock table of the database opened
+	// exclusively by the SuperServer, keep the whole table in process memory
+
+	if (exclusive && m_config->getServerMode() == MODE_SUPER && m_config->getLocalLockTable())
+	{
+		m_localTable = FB_NEW LocalLockManager(m_config);
+		return;
+	}
+
 	LocalStatus ls;
 	CheckStatusWrapper localStatus(&ls);
 	if (!init_shared_file(&localStatus))
@@ -237,6 +350,9 @@ LockManager::LockManager(const string& id, RefPtr<const Config> conf)
 
 LockManager::~LockManager()
 {
+	if (m_localTable)
+		return;
+
 	const SRQ_PTR process_offset = m_processOffset;
 
 	{ // guardian's scope
@@ -247,6 +363,15 @@ LockManager::~LockManager()
 	LocalStatus ls;
 	CheckStatusWrapper localStatus(&ls);
 
+	if (m_deadlockThread)
+	{
+		// Deadlock detector exits as soon as it sees no process block
+
+		m_deadlockSemaphore.release();
+		m_deadlockSync.waitForCompletion();
+		m_deadlockThread = false;
+	}
+
 	if (m_process)
 	{
 		if (m_useBlockingThread)
@@ -298,6 +423,10 @@ LockManager::~LockManager()
 		m_extents[i].unmapFile(&localStatus);
 	}
 #endif //USE_SHMEM_EXT
+
+#ifdef USE_LOCK_STRIPES
+	unmap_stripes();
+#endif
 }
 
 
@@ -359,6 +488,11 @@ bool LockManager::init_shared_file(CheckStatusWrapper* statusVector)
 	m_extents[0] = *this;
 #endif
 
+#ifdef USE_LOCK_STRIPES
+	if (!map_stripes(statusVector))
+		return false;
+#endif
+
 	return true;
 }
 
@@ -399,6 +533,9 @@ bool LockManager::initializeOwner(CheckStatusWrapper* statusVector,
  **************************************/
 	LOCK_TRACE(("LM::init (ownerid=%ld)\n", owner_id));
 
+	if (m_localTable)
+		return m_localTable->initializeOwner(statusVector, owner_id, owner_type, owner_handle);
+
 	SRQ_PTR owner_offset = *owner_handle;
 
 	if (owner_offset)
@@ -439,6 +576,12 @@ void LockManager::shutdownOwner(thread_db* tdbb, SRQ_PTR* owner_handle)
  **************************************/
 	LOCK_TRACE(("LM::fini (%ld)\n", *owner_handle));
 
+	if (m_localTable)
+	{
+		m_localTable->shutdownOwner(tdbb, owner_handle);
+		return;
+	}
+
 	const SRQ_PTR owner_offset = *owner_handle;
 	if (!owner_offset)
 		return;
@@ -466,7 +609,10 @@ void LockManager::shutdownOwner(thread_db* tdbb, SRQ_PTR* owner_handle)
 	// This assert expects that all the granted locks have been explicitly
 	// released before destroying the lock owner. This is not strictly required,
 	// but it enforces the proper object lifetime discipline through the codebase.
-	fb_assert(SRQ_EMPTY(owner->own_requests));
+#ifdef DEV_BUILD
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+		fb_assert(SRQ_EMPTY(owner->own_requests[i]));
+#endif
 
 	purge_owner(owner_offset, owner);
 
@@ -501,9 +647,24 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
  **************************************/
 	LOCK_TRACE(("LM::enqueue (%ld)\n", owner_offset));
 
+	if (m_localTable)
+		return m_localTable->enqueue(tdbb, statusVector, prior_request, series, value, length, type,
+			ast_routine, ast_argument, data, lck_wait, owner_offset);
+
 	if (!owner_offset)
 		return 0;
 
+#ifdef USE_LOCK_STRIPES
+	if (!prior_request && !data)
+	{
+		const SRQ_PTR request_offset =
+			fast_enqueue(series, value, length, type, ast_routine, ast_argument, owner_offset);
+
+		if (request_offset)
+			return request_offset;
+	}
+#endif
+
 	LockTableGuard guard(this, FB_FUNCTION, owner_offset);
 
 	own* owner = (own*) SRQ_ABS_PTR(owner_offset);
@@ -521,26 +682,30 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 	if (prior_request)
 		internal_dequeue(prior_request);
 
-	// Allocate or reuse a lock request block
-
-	lrq* request;
+	// Grow the hash table when its chains became too long on average
 
-	ASSERT_ACQUIRED;
-	if (SRQ_EMPTY(m_sharedMemory->getHeader()->lhb_free_requests))
+	if (m_sharedMemory->getHeader()->lhb_hash_limit)
 	{
-		if (!(request = (lrq*) alloc(sizeof(lrq), statusVector)))
-			return 0;
+		ULONG locks = 0;
+		for (USHORT i = 0; i < LCK_STRIPES; i++)
+			locks += get_stripe(i)->lst_locks;
 
-		owner = (own*) SRQ_ABS_PTR(owner_offset);
-	}
-	else
-	{
-		ASSERT_ACQUIRED;
-		request = (lrq*) ((UCHAR*) SRQ_NEXT(m_sharedMemory->getHeader()->lhb_free_requests) -
-						 offsetof(lrq, lrq_lbl_requests));
-		remove_que(&request->lrq_lbl_requests);
+		if (locks >= m_sharedMemory->getHeader()->lhb_hash_limit)
+			grow_hash(m_sharedMemory->getHeader()->lhb_hash_slots * 2);
 	}
 
+	const ULONG hash_slot =
+		InternalHash::hash(length, value, m_sharedMemory->getHeader()->lhb_hash_slots);
+	const USHORT stripe = hash_slot % LCK_STRIPES;
+
+	// Allocate or reuse a lock request block
+
+	lrq* request = alloc_request(stripe, statusVector);
+	if (!request)
+		return 0;
+
+	owner = (own*) SRQ_ABS_PTR(owner_offset);
+
 	post_history(his_enq, owner_offset, (SRQ_PTR)0, SRQ_REL_PTR(request), true);
 
 	request->lrq_type = type_lrq;
@@ -551,7 +716,7 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 	request->lrq_owner = owner_offset;
 	request->lrq_ast_routine = ast_routine;
 	request->lrq_ast_argument = ast_argument;
-	insert_tail(&owner->own_requests, &request->lrq_own_requests);
+	insert_tail(&owner->own_requests[stripe], &request->lrq_own_requests);
 	SRQ_INIT(request->lrq_own_blocks);
 	SRQ_INIT(request->lrq_own_pending);
 
@@ -559,8 +724,7 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 
 	// See if the lock already exists
 
-	USHORT hash_slot;
-	lbl* lock = find_lock(series, value, length, &hash_slot);
+	lbl* lock = find_lock_in_slot(hash_slot, series, value, length);
 	if (lock)
 	{
 		if (series < LCK_MAX_SERIES)
@@ -582,12 +746,13 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 
 	// Lock doesn't exist. Allocate lock block and set it up.
 
-	if (!(lock = alloc_lock(length, statusVector)))
+	if (!(lock = alloc_lock(length, stripe, statusVector)))
 	{
 		// lock table is exhausted: release request gracefully
+		request = (lrq*) SRQ_ABS_PTR(request_offset);
 		remove_que(&request->lrq_own_requests);
 		request->lrq_type = type_null;
-		insert_tail(&m_sharedMemory->getHeader()->lhb_free_requests, &request->lrq_lbl_requests);
+		insert_tail(&get_stripe(stripe)->lst_free_requests, &request->lrq_lbl_requests);
 		return 0;
 	}
 
@@ -608,6 +773,7 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 
 	lock->lbl_flags = 0;
 	lock->lbl_pending_lrq_count = 0;
+	lock->lbl_hash_slot = hash_slot;
 
 	memset(lock->lbl_counts, 0, sizeof(lock->lbl_counts));
 
@@ -618,7 +784,8 @@ SRQ_PTR LockManager::enqueue(thread_db* tdbb,
 
 	SRQ_INIT(lock->lbl_requests);
 	ASSERT_ACQUIRED;
-	insert_tail(&m_sharedMemory->getHeader()->lhb_hash[hash_slot], &lock->lbl_lhb_hash);
+	insert_tail(get_hash_slot(hash_slot), &lock->lbl_lhb_hash);
+	++get_stripe(stripe)->lst_locks;
 	insert_tail(&lock->lbl_requests, &request->lrq_lbl_requests);
 	request->lrq_lock = SRQ_REL_PTR(lock);
 	grant(request, lock);
@@ -647,6 +814,15 @@ bool LockManager::convert(thread_db* tdbb,
  **************************************/
 	LOCK_TRACE(("LM::convert (%d, %d)\n", type, lck_wait));
 
+	if (m_localTable)
+		return m_localTable->convert(tdbb, statusVector, request_offset, type, lck_wait,
+			ast_routine, ast_argument);
+
+#ifdef USE_LOCK_STRIPES
+	if (fast_convert(request_offset, type, ast_routine, ast_argument))
+		return true;
+#endif
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	lrq* const request = get_request(request_offset);
@@ -690,6 +866,9 @@ UCHAR LockManager::downgrade(thread_db* tdbb,
  **************************************/
 	LOCK_TRACE(("LM::downgrade (%ld)\n", request_offset));
 
+	if (m_localTable)
+		return m_localTable->downgrade(tdbb, statusVector, request_offset);
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	lrq* const request = get_request(request_offset);
@@ -753,6 +932,14 @@ bool LockManager::dequeue(const SRQ_PTR request_offset)
  **************************************/
 	LOCK_TRACE(("LM::dequeue (%ld)\n", request_offset));
 
+	if (m_localTable)
+		return m_localTable->dequeue(request_offset);
+
+#ifdef USE_LOCK_STRIPES
+	if (fast_dequeue(request_offset))
+		return true;
+#endif
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	lrq* const request = get_request(request_offset);
@@ -792,6 +979,12 @@ void LockManager::repost(thread_db* tdbb, lock_ast_t ast, void* arg, SRQ_PTR own
  **************************************/
 	LOCK_TRACE(("LM::repost (%ld)\n", owner_offset));
 
+	if (m_localTable)
+	{
+		m_localTable->repost(tdbb, ast, arg, owner_offset);
+		return;
+	}
+
 	if (!owner_offset)
 		return;
 
@@ -853,6 +1046,9 @@ bool LockManager::cancelWait(SRQ_PTR owner_offset)
  **************************************/
 	LOCK_TRACE(("LM::cancelWait (%ld)\n", owner_offset));
 
+	if (m_localTable)
+		return m_localTable->cancelWait(owner_offset);
+
 	if (!owner_offset)
 		return false;
 
@@ -888,6 +1084,9 @@ LOCK_DATA_T LockManager::queryData(const USHORT series, const USHORT aggregate)
 
 	LOCK_TRACE(("LM::queryData (%ld)\n", owner_offset));
 
+	if (m_localTable)
+		return m_localTable->queryData(series, aggregate);
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	++(m_sharedMemory->getHeader()->lhb_query_data);
@@ -979,6 +1178,9 @@ LOCK_DATA_T LockManager::readData(SRQ_PTR request_offset)
  **************************************/
 	LOCK_TRACE(("LM::readData (%ld)\n", request_offset));
 
+	if (m_localTable)
+		return m_localTable->readData(request_offset);
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	const lrq* const request = get_request(request_offset);
@@ -1014,6 +1216,9 @@ LOCK_DATA_T LockManager::readData2(USHORT series,
  **************************************/
 	LOCK_TRACE(("LM::readData2 (%ld)\n", owner_offset));
 
+	if (m_localTable)
+		return m_localTable->readData2(series, value, length, owner_offset);
+
 	if (!owner_offset)
 		return 0;
 
@@ -1026,7 +1231,7 @@ LOCK_DATA_T LockManager::readData2(USHORT series,
 	else
 		++(m_sharedMemory->getHeader()->lhb_operations[0]);
 
-	USHORT junk;
+	ULONG junk;
 	const lbl* const lock = find_lock(series, value, length, &junk);
 
 	return lock ? lock->lbl_data : 0;
@@ -1047,6 +1252,9 @@ LOCK_DATA_T LockManager::writeData(SRQ_PTR request_offset, LOCK_DATA_T data)
  **************************************/
 	LOCK_TRACE(("LM::writeData (%ld)\n", request_offset));
 
+	if (m_localTable)
+		return m_localTable->writeData(request_offset, data);
+
 	LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
 	const lrq* const request = get_request(request_offset);
@@ -1118,6 +1326,9 @@ void LockManager::acquire_shmem(SRQ_PTR owner_offset)
 
 		// Someone is going to delete shared file? Reattach.
 		m_sharedMemory->mutexUnlock();
+#ifdef USE_LOCK_STRIPES
+		unmap_stripes();
+#endif
 		m_sharedMemory.reset();
 
 		Thread::yield();
@@ -1196,24 +1407,94 @@ void LockManager::acquire_shmem(SRQ_PTR owner_offset)
 	{
 		post_history(his_active, owner_offset, prior_active, (SRQ_PTR) 0, false);
 		shb* const recover = (shb*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_secondary);
-		if (recover->shb_remove_node)
+		recover_queue(&recover->shb_remove_node, &recover->shb_insert_que,
+			&recover->shb_insert_prior, NULL);
+	}
+
+	acquire_stripes(owner_offset);
+}
+
+
+void LockManager::acquire_stripes(SRQ_PTR owner_offset)
+{
+/**************************************
+ *
+ *	a c q u i r e _ s t r i p e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Acquire all the lock table stripes, thus waiting
+ *	for the fast path operations in progress.
+ *	Lock table mutex is already acquired.
+ *
+ **************************************/
+	fb_assert(!m_stripesAcquired);
+
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+#ifdef USE_LOCK_STRIPES
+		mtx* const mutex = &((lst*) (m_stripes + i * LST_SIZE))->lst_mutex;
+		int state = pthread_mutex_lock(mutex->mtx_mutex);
+#ifdef USE_ROBUST_MUTEX
+		if (state == EOWNERDEAD)
 		{
-			// There was a remove_que operation in progress when the prior_owner died
-			DEBUG_MSG(0, ("Got to the funky shb_remove_node code\n"));
-			remove_que((SRQ) SRQ_ABS_PTR(recover->shb_remove_node));
+			// The stripe is checked for unfinished work below
+			state = pthread_mutex_consistent_np(mutex->mtx_mutex);
 		}
-		else if (recover->shb_insert_que && recover->shb_insert_prior)
+#endif
+		if (state)
+			mutexBug(state, "pthread_mutex_lock");
+#endif
+
+		lst* const stripe = get_stripe(i);
+
+		if (stripe->lst_active_owner)
 		{
-			// There was a insert_que operation in progress when the prior_owner died
-			DEBUG_MSG(0, ("Got to the funky shb_insert_que code\n"));
+			// Someone died while holding the stripe, finish the work
 
-			SRQ lock_srq = (SRQ) SRQ_ABS_PTR(recover->shb_insert_que);
-			lock_srq->srq_backward = recover->shb_insert_prior;
-			lock_srq = (SRQ) SRQ_ABS_PTR(recover->shb_insert_prior);
-			lock_srq->srq_forward = recover->shb_insert_que;
-			recover->shb_insert_que = 0;
-			recover->shb_insert_prior = 0;
+			recover_queue(&stripe->lst_remove_node, &stripe->lst_insert_que,
+				&stripe->lst_insert_prior, stripe);
 		}
+
+		stripe->lst_active_owner = owner_offset;
+	}
+
+	m_stripesAcquired = true;
+}
+
+
+void LockManager::recover_queue(SRQ_PTR* remove_node, SRQ_PTR* insert_que, SRQ_PTR* insert_prior,
+	lst* stripe)
+{
+/**************************************
+ *
+ *	r e c o v e r _ q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Complete or undo queue operation which was in progress
+ *	when the prior owner of the lock table (or its stripe) died.
+ *
+ **************************************/
+	if (*remove_node)
+	{
+		// There was a remove_que operation in progress when the prior_owner died
+		DEBUG_MSG(0, ("Got to the funky shb_remove_node code\n"));
+		remove_que((SRQ) SRQ_ABS_PTR(*remove_node), stripe);
+	}
+	else if (*insert_que && *insert_prior)
+	{
+		// There was a insert_que operation in progress when the prior_owner died
+		DEBUG_MSG(0, ("Got to the funky shb_insert_que code\n"));
+
+		SRQ lock_srq = (SRQ) SRQ_ABS_PTR(*insert_que);
+		lock_srq->srq_backward = *insert_prior;
+		lock_srq = (SRQ) SRQ_ABS_PTR(*insert_prior);
+		lock_srq->srq_forward = *insert_que;
+		*insert_que = 0;
+		*insert_prior = 0;
 	}
 }
 
@@ -1246,7 +1527,7 @@ bool LockManager::createExtent(CheckStatusWrapper* statusVector)
 #endif
 
 
-UCHAR* LockManager::alloc(USHORT size, CheckStatusWrapper* statusVector)
+UCHAR* LockManager::alloc(ULONG size, CheckStatusWrapper* statusVector)
 {
 /**************************************
  *
@@ -1285,7 +1566,8 @@ UCHAR* LockManager::alloc(USHORT size, CheckStatusWrapper* statusVector)
 		// Post remapping notifications
 		remap_local_owners();
 		// Remap the shared memory region
-		const ULONG new_length = m_sharedMemory->sh_mem_length_mapped + m_memorySize;
+		const ULONG extension = (size + m_memorySize - 1) / m_memorySize * m_memorySize;
+		const ULONG new_length = m_sharedMemory->sh_mem_length_mapped + extension;
 		if (m_sharedMemory->remapFile(statusVector, new_length, true))
 		{
 			ASSERT_ACQUIRED;
@@ -1317,7 +1599,7 @@ UCHAR* LockManager::alloc(USHORT size, CheckStatusWrapper* statusVector)
 }
 
 
-lbl* LockManager::alloc_lock(USHORT length, CheckStatusWrapper* statusVector)
+lbl* LockManager::alloc_lock(USHORT length, USHORT stripe, CheckStatusWrapper* statusVector)
 {
 /**************************************
  *
@@ -1328,26 +1610,34 @@ lbl* LockManager::alloc_lock(USHORT length, CheckStatusWrapper* statusVector)
  * Functional description
  *	Allocate a lock for a key of a given length.  Look first to see
  *	if a spare of the right size is sitting around.  If not, allocate
- *	one.
+ *	one.  Spares of the given stripe are preferred as they are the
+ *	only ones available for the fast path.
  *
  **************************************/
 	length = FB_ALIGN(length, 8);
 
 	ASSERT_ACQUIRED;
-	srq* lock_srq;
-	SRQ_LOOP(m_sharedMemory->getHeader()->lhb_free_locks, lock_srq)
+	for (USHORT i = 0; i <= LCK_STRIPES; i++)
 	{
-		lbl* lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
-		// Here we use the "first fit" approach which costs us some memory,
-		// but works fast. The "best fit" one is proven to be unacceptably slow.
-		// Maybe there could be some compromise, e.g. limiting the number of "best fit"
-		// iterations before defaulting to a "first fit" match. Another idea could be
-		// to introduce yet another hash table for the free locks queue.
-		if (lock->lbl_size >= length)
+		srq* const free_locks = (i == 0) ? &get_stripe(stripe)->lst_free_locks :
+			(i == 1) ? &m_sharedMemory->getHeader()->lhb_free_locks :
+			&get_stripe((stripe + i - 1) % LCK_STRIPES)->lst_free_locks;
+
+		srq* lock_srq;
+		SRQ_LOOP((*free_locks), lock_srq)
 		{
-			remove_que(&lock->lbl_lhb_hash);
-			lock->lbl_type = type_lbl;
-			return lock;
+			lbl* lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
+			// Here we use the "first fit" approach which costs us some memory,
+			// but works fast. The "best fit" one is proven to be unacceptably slow.
+			// Maybe there could be some compromise, e.g. limiting the number of "best fit"
+			// iterations before defaulting to a "first fit" match. Another idea could be
+			// to introduce yet another hash table for the free locks queue.
+			if (lock->lbl_size >= length)
+			{
+				remove_que(&lock->lbl_lhb_hash);
+				lock->lbl_type = type_lbl;
+				return lock;
+			}
 		}
 	}
 
@@ -1367,6 +1657,39 @@ lbl* LockManager::alloc_lock(USHORT length, CheckStatusWrapper* statusVector)
 }
 
 
+lrq* LockManager::alloc_request(USHORT stripe, CheckStatusWrapper* statusVector)
+{
+/**************************************
+ *
+ *	a l l o c _ r e q u e s t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Allocate a lock request.  Reuse a free one if possible,
+ *	preferring the given stripe like alloc_lock() does.
+ *
+ **************************************/
+	ASSERT_ACQUIRED;
+	for (USHORT i = 0; i <= LCK_STRIPES; i++)
+	{
+		srq* const free_requests = (i == 0) ? &get_stripe(stripe)->lst_free_requests :
+			(i == 1) ? &m_sharedMemory->getHeader()->lhb_free_requests :
+			&get_stripe((stripe + i - 1) % LCK_STRIPES)->lst_free_requests;
+
+		if (!SRQ_EMPTY((*free_requests)))
+		{
+			lrq* const request = (lrq*) ((UCHAR*) SRQ_NEXT((*free_requests)) -
+				offsetof(lrq, lrq_lbl_requests));
+			remove_que(&request->lrq_lbl_requests);
+			return request;
+		}
+	}
+
+	return (lrq*) alloc(sizeof(lrq), statusVector);
+}
+
+
 void LockManager::blocking_action(thread_db* tdbb, SRQ_PTR blocking_owner_offset)
 {
 /**************************************
@@ -1704,6 +2027,12 @@ SRQ_PTR LockManager::create_owner(CheckStatusWrapper* statusVector,
 		}
 	}
 
+	// Apply the larger hash table size if it was configured since the table was created
+
+	const ULONG hash_slots = MIN(MAX(m_config->getLockHashSlots(), HASH_MIN_SLOTS), HASH_MAX_SLOTS);
+	if (hash_slots > m_sharedMemory->getHeader()->lhb_hash_slots)
+		grow_hash(hash_slots);
+
 	// Allocate an owner block
 
 	own* owner = 0;
@@ -1794,19 +2123,23 @@ bool LockManager::create_process(CheckStatusWrapper* statusVector)
 	if (!m_process)
 		return false;
 
-	if (m_useBlockingThread)
+	try
 	{
-		try
-		{
+		if (m_useBlockingThread)
 			m_cleanupSync.run(this);
-		}
-		catch (const Exception& ex)
-		{
-			(Arg::Gds(isc_lockmanerr) << Arg::StatusVector(ex)).copyTo(statusVector);
 
-			return false;
+		if (!m_deadlockThread)
+		{
+			m_deadlockSync.run(this);
+			m_deadlockThread = true;
 		}
 	}
+	catch (const Exception& ex)
+	{
+		(Arg::Gds(isc_lockmanerr) << Arg::StatusVector(ex)).copyTo(statusVector);
+
+		return false;
+	}
 
 	return true;
 }
@@ -2032,75 +2365,814 @@ lrq* LockManager::deadlock_walk(lrq* request, bool* maybe_deadlock)
 }
 
 
-#ifdef DEBUG_LM
-
-static ULONG delay_count = 0;
-static ULONG last_signal_line = 0;
-static ULONG last_delay_line = 0;
-
-void LockManager::debug_delay(ULONG lineno)
+void LockManager::deadlock_thread()
 {
 /**************************************
  *
- *	d e b u g _ d e l a y
+ *	d e a d l o c k _ t h r e a d
  *
  **************************************
  *
  * Functional description
- *	This is a debugging routine, the purpose of which is to slow
- *	down operations in order to expose windows of critical
- *	sections.
+ *	Thread to detect deadlocks among the owners of this process.
+ *	Waiting owners do not scan the wait-for graph themselves,
+ *	they are woken up when their request was chosen as a victim.
  *
  **************************************/
-	ULONG i;
+	try
+	{
+		while (m_processOffset)
+		{
+			m_deadlockSemaphore.tryEnter(1);
 
-	// Delay for a while
+			if (m_processOffset && m_waitingOwners.value())
+				detect_deadlocks();
+		}
+	}
+	catch (const Exception& x)
+	{
+		iscLogException("Error in deadlock detector thread\n", x);
+	}
+}
 
-	last_delay_line = lineno;
-	for (i = 0; i < 10000; i++)
-		; // Nothing
 
-	// Occasionally crash for robustness testing
-/*
-	if ((delay_count % 500) == 0)
-		exit (-1);
-*/
+// Pending request in the copy of the wait-for graph. Its edges are
+// the owners of the requests blocking it.
 
-	for (i = 0; i < 10000; i++)
-		; // Nothing
-}
-#endif
+struct LockManager::WaitNode
+{
+	SRQ_PTR wn_request;
+	SRQ_PTR wn_owner;
+	FB_SIZE_T wn_edges;			// First edge
+	FB_SIZE_T wn_count;			// Number of edges
+};
 
-lbl* LockManager::find_lock(USHORT series,
-							const UCHAR* value,
-							USHORT length,
-							USHORT* slot)
+void LockManager::detect_deadlocks()
 {
 /**************************************
  *
- *	f i n d _ l o c k
+ *	d e t e c t _ d e a d l o c k s
  *
  **************************************
  *
  * Functional description
- *	Find a lock block given a resource
- *	name. If it doesn't exist, the hash
- *	slot will be useful for enqueing a
- *	lock.
+ *	Scan the owners of this process which have been waiting
+ *	longer than the deadlock scan interval. The wait-for graph
+ *	is copied holding one lock table stripe at a time and walked
+ *	with nothing locked. Only a deadlock found in the copy is
+ *	checked again in the lock table before its victim is chosen.
  *
  **************************************/
+	HalfStaticArray<SRQ_PTR, 16> owners;
 
-	// See if the lock already exists
+	{ // guardian's scope
+		LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
 
-	const USHORT hash_slot = *slot =
-		(USHORT) InternalHash::hash(length, value, m_sharedMemory->getHeader()->lhb_hash_slots);
+		if (!m_processOffset)
+			return;
 
-	ASSERT_ACQUIRED;
-	srq* const hash_header = &m_sharedMemory->getHeader()->lhb_hash[hash_slot];
+		const SINT64 current_time = time(NULL);
+		const prc* const process = (prc*) SRQ_ABS_PTR(m_processOffset);
+
+		srq* lock_srq;
+		SRQ_LOOP(process->prc_owners, lock_srq)
+		{
+			own* const owner = (own*) ((UCHAR*) lock_srq - offsetof(own, own_prc_owners));
+
+			if (owner->own_waits && !(owner->own_flags & OWN_scanned) &&
+				owner->own_scan_time <= current_time)
+			{
+				owner->own_scan_time = current_time + m_sharedMemory->getHeader()->lhb_scan_interval;
+				owners.add(SRQ_REL_PTR(owner));
+			}
+		}
+
+		m_sharedMemory->getHeader()->lhb_scans += owners.getCount();
+	}
+
+	if (owners.isEmpty())
+		return;
+
+	Array<WaitNode> nodes(getPool());
+	Array<SRQ_PTR> edges(getPool());
+
+	if (!snapshot_waits(nodes, edges) || nodes.isEmpty())
+		return;
+
+	struct OwnerOrder
+	{
+		static int compare(const void* n1, const void* n2)
+		{
+			const SRQ_PTR owner1 = ((const WaitNode*) n1)->wn_owner;
+			const SRQ_PTR owner2 = ((const WaitNode*) n2)->wn_owner;
+
+			return (owner1 > owner2) ? 1 : (owner1 < owner2) ? -1 : 0;
+		}
+	};
+
+	qsort(nodes.begin(), nodes.getCount(), sizeof(WaitNode), OwnerOrder::compare);
+
+	// Walk state of the nodes: 0 - not visited, 1 - on the current path,
+	// 2 - known to be not a part of a deadlock
+
+	HalfStaticArray<UCHAR, 256> states;
+	UCHAR* const state = states.getBuffer(nodes.getCount());
+	memset(state, 0, nodes.getCount());
+
+	for (FB_SIZE_T i = 0; i < owners.getCount(); i++)
+	{
+		for (FB_SIZE_T n = 0; n < nodes.getCount(); n++)
+		{
+			if (nodes[n].wn_owner != owners[i])
+				continue;
+
+			const FB_SIZE_T candidate = snapshot_walk(nodes, edges, state, n);
+			if (candidate == nodes.getCount())
+				continue;
+
+			// Copy of the graph is not consistent as a whole, see whether the
+			// candidate is really deadlocked walking the lock table from it
+
+			LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
+
+			if (!m_processOffset)
+				return;
+
+			lrq* const request = (lrq*) SRQ_ABS_PTR(nodes[candidate].wn_request);
+			own* const owner = (own*) SRQ_ABS_PTR(nodes[candidate].wn_owner);
+
+			lrq* const victim =
+				(request->lrq_type == type_lrq && request->lrq_owner == nodes[candidate].wn_owner &&
+					(request->lrq_flags & LRQ_pending) && !(request->lrq_flags & LRQ_wait_timeout)) ?
+				deadlock_scan(owner, request) : NULL;
+
+			if (victim)
+			{
+				// Something has been selected for rejection to prevent a
+				// deadlock. Its owner will find the request rejected when
+				// it wakes up and start cleaning up.
+
+				DEBUG_MSG(0, ("detect_deadlocks: selecting something for deadlock kill\n"));
+
+				++(m_sharedMemory->getHeader()->lhb_deadlocks);
+				victim->lrq_flags |= LRQ_rejected;
+				remove_que(&victim->lrq_own_pending);
+				victim->lrq_flags &= ~LRQ_pending;
+				lbl* const victim_lock = (lbl*) SRQ_ABS_PTR(victim->lrq_lock);
+				victim_lock->lbl_pending_lrq_count--;
+
+				own* const victim_owner = (own*) SRQ_ABS_PTR(victim->lrq_owner);
+				victim_owner->own_flags &= ~OWN_scanned;
+				post_wakeup(victim_owner);
+			}
+
+			// Cut the circle in the copy and start walking it anew
+
+			nodes[candidate].wn_count = 0;
+			memset(state, 0, nodes.getCount());
+			break;
+		}
+	}
+}
+
+
+bool LockManager::snapshot_waits(Array<WaitNode>& nodes, Array<SRQ_PTR>& edges)
+{
+/**************************************
+ *
+ *	s n a p s h o t _ w a i t s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Copy the wait-for graph holding one lock table stripe
+ *	at a time. Locks having pending requests are changed
+ *	under the lock table mutex only, which takes all the
+ *	stripes, so every stripe gives a consistent part of the
+ *	graph. Return false if the copy can't be made now.
+ *
+ **************************************/
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+#ifdef USE_LOCK_STRIPES
+		StripeGuard guard(this, FB_FUNCTION);
+
+		// Stripe left by the dead process or lock table extended
+		// by another one - let the regular path handle it first
+
+		if (!guard.enter(i, DUMMY_OWNER, true))
+			return false;
+#else
+		LockTableGuard guard(this, FB_FUNCTION, DUMMY_OWNER);
+#endif
+
+		if (!m_processOffset)
+			return false;
+
+		snapshot_stripe(i, nodes, edges);
+	}
+
+	return true;
+}
+
+
+void LockManager::snapshot_stripe(USHORT number, Array<WaitNode>& nodes, Array<SRQ_PTR>& edges)
+{
+/**************************************
+ *
+ *	s n a p s h o t _ s t r i p e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Copy pending requests of the locks hashed into the stripe
+ *	and the owners blocking them. The rules are those of
+ *	deadlock_walk(), requests waited on with a timeout and
+ *	owners still processing their ASTs are left out.
+ *
+ **************************************/
+	const ULONG slots = m_sharedMemory->getHeader()->lhb_hash_slots;
+
+	for (ULONG slot = number; slot < slots; slot += LCK_STRIPES)
+	{
+		srq* const hash_header = get_hash_slot(slot);
+
+		srq* lock_srq;
+		SRQ_LOOP((*hash_header), lock_srq)
+		{
+			lbl* const lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
+
+			if (!lock->lbl_pending_lrq_count)
+				continue;
+
+			srq* lock_srq2;
+			SRQ_LOOP(lock->lbl_requests, lock_srq2)
+			{
+				lrq* const request = (lrq*) ((UCHAR*) lock_srq2 - offsetof(lrq, lrq_lbl_requests));
+
+				if (!(request->lrq_flags & LRQ_pending) || (request->lrq_flags & LRQ_wait_timeout))
+					continue;
+
+				WaitNode node;
+				node.wn_request = SRQ_REL_PTR(request);
+				node.wn_owner = request->lrq_owner;
+				node.wn_edges = edges.getCount();
+
+				const bool conversion = (request->lrq_state > LCK_null);
+
+				srq* lock_srq3;
+				SRQ_LOOP(lock->lbl_requests, lock_srq3)
+				{
+					const lrq* const block = (lrq*) ((UCHAR*) lock_srq3 - offsetof(lrq, lrq_lbl_requests));
+
+					if (request == block)
+					{
+						if (conversion)
+							continue;
+						break;
+					}
+
+					const UCHAR state = conversion ? block->lrq_state :
+						MAX(block->lrq_state, block->lrq_requested);
+
+					if (compatibility[request->lrq_requested][state])
+						continue;
+
+					const own* const owner = (own*) SRQ_ABS_PTR(block->lrq_owner);
+
+					if ((owner->own_flags & (OWN_signaled | OWN_wakeup)) || !SRQ_EMPTY(owner->own_blocks) ||
+						(block->lrq_flags & LRQ_just_granted))
+					{
+						continue;
+					}
+
+					edges.add(block->lrq_owner);
+				}
+
+				node.wn_count = edges.getCount() - node.wn_edges;
+				nodes.add(node);
+			}
+		}
+	}
+}
+
+
+FB_SIZE_T LockManager::snapshot_walk(const Array<WaitNode>& nodes, const Array<SRQ_PTR>& edges,
+	UCHAR* state, FB_SIZE_T node)
+{
+/**************************************
+ *
+ *	s n a p s h o t _ w a l k
+ *
+ **************************************
+ *
+ * Functional description
+ *	Walk the copy of the wait-for graph, sorted by owners, like
+ *	deadlock_walk() does. Return the node where a circle closes,
+ *	or number of nodes if there is no deadlock.
+ *
+ **************************************/
+	const FB_SIZE_T count = nodes.getCount();
+
+	if (state[node] == 2)
+		return count;
+
+	if (state[node] == 1)
+		return node;
+
+	state[node] = 1;
+
+	const WaitNode& waiter = nodes[node];
+
+	for (FB_SIZE_T e = waiter.wn_edges; e < waiter.wn_edges + waiter.wn_count; e++)
+	{
+		const SRQ_PTR owner = edges[e];
+
+		// Find the first pending request of the blocking owner
+
+		FB_SIZE_T lo = 0, hi = count;
+		while (lo < hi)
+		{
+			const FB_SIZE_T mid = (lo + hi) / 2;
+			if (nodes[mid].wn_owner < owner)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		for (FB_SIZE_T target = lo; target < count && nodes[target].wn_owner == owner; target++)
+		{
+			const FB_SIZE_T found = snapshot_walk(nodes, edges, state, target);
+			if (found != count)
+				return found;
+		}
+	}
+
+	state[node] = 2;
+	return count;
+}
+
+
+#ifdef DEBUG_LM
+
+static ULONG delay_count = 0;
+static ULONG last_signal_line = 0;
+static ULONG last_delay_line = 0;
+
+void LockManager::debug_delay(ULONG lineno)
+{
+/**************************************
+ *
+ *	d e b u g _ d e l a y
+ *
+ **************************************
+ *
+ * Functional description
+ *	This is a debugging routine, the purpose of which is to slow
+ *	down operations in order to expose windows of critical
+ *	sections.
+ *
+ **************************************/
+	ULONG i;
+
+	// Delay for a while
+
+	last_delay_line = lineno;
+	for (i = 0; i < 10000; i++)
+		; // Nothing
+
+	// Occasionally crash for robustness testing
+/*
+	if ((delay_count % 500) == 0)
+		exit (-1);
+*/
+
+	for (i = 0; i < 10000; i++)
+		; // Nothing
+}
+#endif
+
+#ifdef USE_LOCK_STRIPES
+lst* LockManager::enter_stripe(USHORT number, SRQ_PTR owner_offset, bool wait)
+{
+/**************************************
+ *
+ *	e n t e r _ s t r i p e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Try to acquire the lock table stripe for the fast path.
+ *	Return NULL if the stripe is busy (unless asked to wait
+ *	for it), was left unfinished by the dead process or the
+ *	lock table was extended by another process - all that is
+ *	for the regular path.
+ *
+ **************************************/
+	lst* const view = (lst*) (m_stripes + number * LST_SIZE);
+
+	const ULONG spins_to_try = m_acquireSpins ? m_acquireSpins : 1;
+	ULONG spins = 0;
+
+	int state;
+	while ((state = pthread_mutex_trylock(view->lst_mutex.mtx_mutex)) == EBUSY)
+	{
+		if (++spins >= spins_to_try)
+		{
+			if (!wait)
+				return NULL;
+
+			state = pthread_mutex_lock(view->lst_mutex.mtx_mutex);
+			break;
+		}
+	}
+
+#ifdef USE_ROBUST_MUTEX
+	if (state == EOWNERDEAD)
+	{
+		// Unfinished work is detected below and left for acquire_stripes()
+		state = pthread_mutex_consistent_np(view->lst_mutex.mtx_mutex);
+	}
+#endif
+
+	if (state)
+		mutexBug(state, "pthread_mutex_trylock");
+
+	lst* const stripe = get_stripe(number);
+
+	if (stripe->lst_active_owner ||
+		m_sharedMemory->getHeader()->lhb_length > m_sharedMemory->sh_mem_length_mapped)
+	{
+		state = pthread_mutex_unlock(view->lst_mutex.mtx_mutex);
+		if (state)
+			mutexBug(state, "pthread_mutex_unlock");
+
+		return NULL;
+	}
+
+	stripe->lst_active_owner = owner_offset;
+	++stripe->lst_acquires;
+
+	if (spins)
+		++stripe->lst_acquire_blocks;
+
+	return stripe;
+}
+
+
+bool LockManager::fast_convert(SRQ_PTR request_offset,
+							   UCHAR type,
+							   lock_ast_t ast_routine,
+							   void* ast_argument)
+{
+/**************************************
+ *
+ *	f a s t _ c o n v e r t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Try to convert an existing lock request holding the
+ *	lock table stripe only. It's possible when nobody waits
+ *	for the lock and the requested level is compatible with
+ *	other granted requests. Return false if the regular path
+ *	is needed.
+ *
+ **************************************/
+	if (request_offset <= 0)
+		return false;
+
+	StripeGuard guard(this, FB_FUNCTION);
+
+	lrq* const request = (lrq*) SRQ_ABS_PTR(request_offset);
+	if (request->lrq_type != type_lrq)
+		return false;
+
+	lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+	const USHORT number = lock->lbl_hash_slot % LCK_STRIPES;
+
+	lst* const stripe = guard.enter(number, request->lrq_owner);
+	if (!stripe)
+		return false;
+
+	// Ensure that nothing has changed before the stripe was acquired
+
+	if (request->lrq_type != type_lrq || lock != (lbl*) SRQ_ABS_PTR(request->lrq_lock) ||
+		lock->lbl_type != type_lbl || lock->lbl_hash_slot % LCK_STRIPES != number)
+	{
+		return false;
+	}
+
+	const own* const owner = (own*) SRQ_ABS_PTR(request->lrq_owner);
+
+	if (!owner->own_count || owner->own_waits || request->lrq_data ||
+		(request->lrq_flags & LRQ_pending) || lock->lbl_pending_lrq_count)
+	{
+		return false;
+	}
+
+	// Compute the state of the lock without the request
+
+	--lock->lbl_counts[request->lrq_state];
+
+	if (!compatibility[type][lock_state(lock)])
+	{
+		++lock->lbl_counts[request->lrq_state];
+		return false;
+	}
+
+	request->lrq_requested = type;
+	request->lrq_flags &= ~LRQ_blocking_seen;
+	request->lrq_ast_routine = ast_routine;
+	request->lrq_ast_argument = ast_argument;
+
+	// Grant the request, see grant()
+
+	++lock->lbl_counts[type];
+	request->lrq_state = type;
+	lock->lbl_state = lock_state(lock);
+
+	++stripe->lst_converts;
+
+	if (lock->lbl_series < LCK_MAX_SERIES)
+		++stripe->lst_operations[lock->lbl_series];
+
+	return true;
+}
+
+
+bool LockManager::fast_dequeue(SRQ_PTR request_offset)
+{
+/**************************************
+ *
+ *	f a s t _ d e q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Try to release a lock request holding the lock table
+ *	stripe only. It's possible when nobody waits for the lock
+ *	and no lock data is maintained. Return false if the
+ *	regular path is needed.
+ *
+ **************************************/
+	if (request_offset <= 0)
+		return false;
+
+	StripeGuard guard(this, FB_FUNCTION);
+
+	lrq* const request = (lrq*) SRQ_ABS_PTR(request_offset);
+	if (request->lrq_type != type_lrq)
+		return false;
+
+	lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+	const USHORT number = lock->lbl_hash_slot % LCK_STRIPES;
+
+	lst* const stripe = guard.enter(number, request->lrq_owner);
+	if (!stripe)
+		return false;
+
+	// Ensure that nothing has changed before the stripe was acquired
+
+	if (request->lrq_type != type_lrq || lock != (lbl*) SRQ_ABS_PTR(request->lrq_lock) ||
+		lock->lbl_type != type_lbl || lock->lbl_hash_slot % LCK_STRIPES != number)
+	{
+		return false;
+	}
+
+	const own* const owner = (own*) SRQ_ABS_PTR(request->lrq_owner);
+
+	if (!owner->own_count || (request->lrq_flags & (LRQ_blocking | LRQ_pending)) ||
+		lock->lbl_pending_lrq_count)
+	{
+		return false;
+	}
+
+	// The last request releases the lock, it should not be kept in the data queue
+
+	const SRQ_PTR node = SRQ_REL_PTR(&request->lrq_lbl_requests);
+	const bool last = (lock->lbl_requests.srq_forward == node &&
+		lock->lbl_requests.srq_backward == node);
+
+	if (last && !SRQ_EMPTY(lock->lbl_lhb_data))
+		return false;
+
+	// Release the request, see release_request()
+
+	remove_que(&request->lrq_lbl_requests, stripe);
+	remove_que(&request->lrq_own_requests, stripe);
+
+	request->lrq_type = type_null;
+	request->lrq_ast_routine = NULL;
+	request->lrq_flags &= ~(LRQ_blocking_seen | LRQ_just_granted);
+	insert_tail(&stripe->lst_free_requests, &request->lrq_lbl_requests, stripe);
+
+	if (last)
+	{
+		remove_que(&lock->lbl_lhb_hash, stripe);
+		lock->lbl_type = type_null;
+		insert_tail(&stripe->lst_free_locks, &lock->lbl_lhb_hash, stripe);
+		--stripe->lst_locks;
+	}
+	else if (request->lrq_state != LCK_none && !--lock->lbl_counts[request->lrq_state])
+		lock->lbl_state = lock_state(lock);
+
+	++stripe->lst_deqs;
+
+	if (lock->lbl_series < LCK_MAX_SERIES)
+		++stripe->lst_operations[lock->lbl_series];
+
+	return true;
+}
+
+
+SRQ_PTR LockManager::fast_enqueue(USHORT series,
+								  const UCHAR* value,
+								  USHORT length,
+								  UCHAR type,
+								  lock_ast_t ast_routine,
+								  void* ast_argument,
+								  SRQ_PTR owner_offset)
+{
+/**************************************
+ *
+ *	f a s t _ e n q u e u e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Try to enqueue on a lock holding the lock table stripe
+ *	only. It's possible when the request could be granted
+ *	at once, no lock data is maintained and the stripe has
+ *	spare blocks to reuse. Return zero if the regular path
+ *	is needed.
+ *
+ **************************************/
+	StripeGuard guard(this, FB_FUNCTION);
+
+	lhb* const header = m_sharedMemory->getHeader();
+	const ULONG hash_slots = header->lhb_hash_slots;
+	const ULONG hash_slot = InternalHash::hash(length, value, hash_slots);
+	const USHORT number = hash_slot % LCK_STRIPES;
+
+	lst* const stripe = guard.enter(number, owner_offset);
+	if (!stripe || header->lhb_hash_slots != hash_slots)
+		return 0;
+
+	own* const owner = (own*) SRQ_ABS_PTR(owner_offset);
+	if (!owner->own_count || owner->own_waits)
+		return 0;
+
+	lbl* lock = find_lock_in_slot(hash_slot, series, value, length);
+
+	// Compatible requests are granted at once unless somebody waits for the lock
+
+	if (lock && (!compatibility[type][lock->lbl_state] || lock->lbl_pending_lrq_count))
+		return 0;
+
+	if (SRQ_EMPTY(stripe->lst_free_requests))
+		return 0;
+
+	if (!lock)
+	{
+		// Hash table growth is left for the regular path
+
+		if (header->lhb_hash_limit && (stripe->lst_locks + 1) * LCK_STRIPES > header->lhb_hash_limit)
+			return 0;
+
+		const USHORT size = FB_ALIGN(length, 8);
+
+		srq* lock_srq;
+		SRQ_LOOP(stripe->lst_free_locks, lock_srq)
+		{
+			lbl* const free_lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
+
+			if (free_lock->lbl_size >= size)
+			{
+				lock = free_lock;
+				break;
+			}
+		}
+
+		if (!lock)
+			return 0;
+
+		remove_que(&lock->lbl_lhb_hash, stripe);
+		lock->lbl_type = type_lbl;
+
+		// Initialize the lock, see enqueue()
+
+		lock->lbl_state = type;
+		lock->lbl_pending_lrq_count = 0;
+		lock->lbl_hash_slot = hash_slot;
+		memset(lock->lbl_counts, 0, sizeof(lock->lbl_counts));
+		lock->lbl_series = (UCHAR) series;
+		lock->lbl_flags = 0;
+
+		SRQ_INIT(lock->lbl_lhb_data);
+		lock->lbl_data = 0;
+
+		insert_tail(get_hash_slot(hash_slot), &lock->lbl_lhb_hash, stripe);
+		++stripe->lst_locks;
+
+		lock->lbl_length = length;
+		memcpy(lock->lbl_key, value, length);
+
+		SRQ_INIT(lock->lbl_requests);
+	}
+
+	lrq* const request = (lrq*) ((UCHAR*) SRQ_NEXT(stripe->lst_free_requests) -
+		offsetof(lrq, lrq_lbl_requests));
+	remove_que(&request->lrq_lbl_requests, stripe);
+
+	request->lrq_type = type_lrq;
+	request->lrq_flags = 0;
+	request->lrq_requested = type;
+	request->lrq_state = LCK_none;
+	request->lrq_data = 0;
+	request->lrq_owner = owner_offset;
+	request->lrq_lock = SRQ_REL_PTR(lock);
+	request->lrq_ast_routine = ast_routine;
+	request->lrq_ast_argument = ast_argument;
+	insert_tail(&owner->own_requests[number], &request->lrq_own_requests, stripe);
+	SRQ_INIT(request->lrq_own_blocks);
+	SRQ_INIT(request->lrq_own_pending);
+
+	insert_tail(&lock->lbl_requests, &request->lrq_lbl_requests, stripe);
+
+	// Grant the request, see grant()
+
+	++lock->lbl_counts[type];
+	request->lrq_state = type;
+	lock->lbl_state = lock_state(lock);
+
+	++stripe->lst_enqs;
+
+	if (series < LCK_MAX_SERIES)
+		++stripe->lst_operations[series];
+	else
+		++stripe->lst_operations[0];
+
+	return SRQ_REL_PTR(request);
+}
+#endif
+
+
+lbl* LockManager::find_lock(USHORT series,
+							const UCHAR* value,
+							USHORT length,
+							ULONG* slot)
+{
+/**************************************
+ *
+ *	f i n d _ l o c k
+ *
+ **************************************
+ *
+ * Functional description
+ *	Find a lock block given a resource
+ *	name. If it doesn't exist, the hash
+ *	slot will be useful for enqueing a
+ *	lock.
+ *
+ **************************************/
+
+	// See if the lock already exists
+
+	const ULONG hash_slot = *slot =
+		InternalHash::hash(length, value, m_sharedMemory->getHeader()->lhb_hash_slots);
+
+	ASSERT_ACQUIRED;
+	return find_lock_in_slot(hash_slot, series, value, length);
+}
+
+
+lbl* LockManager::find_lock_in_slot(ULONG hash_slot,
+									USHORT series,
+									const UCHAR* value,
+									USHORT length)
+{
+/**************************************
+ *
+ *	f i n d _ l o c k _ i n _ s l o t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Find a lock block in the given hash slot.
+ *	Caller holds either the lock table or
+ *	the stripe of the slot.
+ *
+ **************************************/
+	srq* const hash_header = get_hash_slot(hash_slot);
+	lst* const stripe = get_stripe(hash_slot % LCK_STRIPES);
+	++stripe->lst_hash_lookups;
+
+	for (srq* lock_srq = (SRQ) SRQ_ABS_PTR(hash_header->srq_forward);
+		 lock_srq != hash_header; lock_srq = (SRQ) SRQ_ABS_PTR(lock_srq->srq_forward))
+	{
+		++stripe->lst_hash_steps;
 
-	for (srq* lock_srq = (SRQ) SRQ_ABS_PTR(hash_header->srq_forward);
-		 lock_srq != hash_header; lock_srq = (SRQ) SRQ_ABS_PTR(lock_srq->srq_forward))
-	{
 		lbl* lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
 		if (lock->lbl_series != series || lock->lbl_length != length)
 		{
@@ -2115,6 +3187,24 @@ lbl* LockManager::find_lock(USHORT series,
 }
 
 
+srq* LockManager::get_hash_slot(ULONG slot)
+{
+/**************************************
+ *
+ *	g e t _ h a s h _ s l o t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Locate the head of lock hash chain.
+ *
+ **************************************/
+	fb_assert(slot < m_sharedMemory->getHeader()->lhb_hash_slots);
+
+	return (srq*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_hash) + slot;
+}
+
+
 lrq* LockManager::get_request(SRQ_PTR offset)
 {
 /**************************************
@@ -2147,6 +3237,25 @@ lrq* LockManager::get_request(SRQ_PTR offset)
 }
 
 
+lst* LockManager::get_stripe(USHORT number)
+{
+/**************************************
+ *
+ *	g e t _ s t r i p e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Locate lock table stripe.
+ *
+ **************************************/
+	fb_assert(number < LCK_STRIPES);
+
+	return (lst*) ((UCHAR*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_stripes) +
+		number * LST_SIZE);
+}
+
+
 void LockManager::grant(lrq* request, lbl* lock)
 {
 /**************************************
@@ -2246,6 +3355,97 @@ bool LockManager::grant_or_que(thread_db* tdbb, lrq* request, lbl* lock, SSHORT
 }
 
 
+void LockManager::grow_hash(ULONG hash_slots)
+{
+/**************************************
+ *
+ *	g r o w _ h a s h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Rebuild the lock hash table with the larger number of slots.
+ *	Locks are moved into their new chains and requests follow the
+ *	stripe of their lock.  Memory of the old table is not reused.
+ *
+ **************************************/
+	ASSERT_ACQUIRED;
+
+	hash_slots = hash_prime(MIN(hash_slots, HASH_GROW_MAX_SLOTS));
+
+	const ULONG old_slots = m_sharedMemory->getHeader()->lhb_hash_slots;
+	if (hash_slots <= old_slots)
+		return;
+
+	const SRQ_PTR old_offset = m_sharedMemory->getHeader()->lhb_hash;
+
+	// Table could be remapped here, do not keep pointers to it before
+
+	LocalStatus ls;
+	CheckStatusWrapper localStatus(&ls);
+	SRQ hash_table = (SRQ) alloc(hash_slots * sizeof(srq), &localStatus);
+	if (!hash_table)
+	{
+		// Keep the current hash table and stop trying
+
+		m_sharedMemory->getHeader()->lhb_hash_limit = 0;
+		return;
+	}
+
+	for (ULONG slot = 0; slot < hash_slots; slot++)
+		SRQ_INIT(hash_table[slot]);
+
+	lhb* const header = m_sharedMemory->getHeader();
+
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+		get_stripe(i)->lst_locks = 0;
+
+	srq* const old_table = (srq*) SRQ_ABS_PTR(old_offset);
+	for (ULONG old_slot = 0; old_slot < old_slots; old_slot++)
+	{
+		srq* const hash_header = &old_table[old_slot];
+		srq* lock_srq;
+
+		while ((lock_srq = SRQ_NEXT((*hash_header))) != hash_header)
+		{
+			lbl* const lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
+			const ULONG slot = InternalHash::hash(lock->lbl_length, lock->lbl_key, hash_slots);
+
+			remove_que(&lock->lbl_lhb_hash);
+			insert_tail(&hash_table[slot], &lock->lbl_lhb_hash);
+
+			const USHORT old_stripe = lock->lbl_hash_slot % LCK_STRIPES;
+			const USHORT new_stripe = slot % LCK_STRIPES;
+			lock->lbl_hash_slot = slot;
+			++get_stripe(new_stripe)->lst_locks;
+
+			if (old_stripe == new_stripe)
+				continue;
+
+			srq* que_inst;
+			SRQ_LOOP(lock->lbl_requests, que_inst)
+			{
+				lrq* const request = (lrq*) ((UCHAR*) que_inst - offsetof(lrq, lrq_lbl_requests));
+				own* const owner = (own*) SRQ_ABS_PTR(request->lrq_owner);
+
+				remove_que(&request->lrq_own_requests);
+				insert_tail(&owner->own_requests[new_stripe], &request->lrq_own_requests);
+			}
+		}
+	}
+
+	++header->lhb_hash_resizes;
+	header->lhb_hash_prior_slots = old_slots;
+	header->lhb_hash_resize_locks = 0;
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+		header->lhb_hash_resize_locks += get_stripe(i)->lst_locks;
+
+	header->lhb_hash = SRQ_REL_PTR(hash_table);
+	header->lhb_hash_slots = hash_slots;
+	header->lhb_hash_limit = hash_limit(hash_slots, m_hashMaxChain);
+}
+
+
 bool LockManager::init_owner_block(CheckStatusWrapper* statusVector, own* owner, UCHAR owner_type,
 	LOCK_OWNER_T owner_id)
 {
@@ -2269,7 +3469,8 @@ bool LockManager::init_owner_block(CheckStatusWrapper* statusVector, own* owner,
 	owner->own_thread_id = 0;
 	SRQ_INIT(owner->own_lhb_owners);
 	SRQ_INIT(owner->own_prc_owners);
-	SRQ_INIT(owner->own_requests);
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+		SRQ_INIT(owner->own_requests[i]);
 	SRQ_INIT(owner->own_blocks);
 	SRQ_INIT(owner->own_pending);
 	owner->own_acquire_time = 0;
@@ -2337,11 +3538,12 @@ bool LockManager::initialize(SharedMemoryBase* sm, bool initializeMemory)
 	if (hash_slots > HASH_MAX_SLOTS)
 		hash_slots = HASH_MAX_SLOTS;
 
-	hdr->lhb_hash_slots = (USHORT) hash_slots;
+	hdr->lhb_hash_slots = hash_slots;
+	hdr->lhb_hash_limit = hash_limit(hash_slots, m_hashMaxChain);
 	hdr->lhb_scan_interval = m_config->getDeadlockTimeout();
 	hdr->lhb_acquire_spins = m_acquireSpins;
 
-	// Initialize lock series data queues and lock hash chains
+	// Initialize lock series data queues
 
 	USHORT i;
 	SRQ lock_srq;
@@ -2349,16 +3551,23 @@ bool LockManager::initialize(SharedMemoryBase* sm, bool initializeMemory)
 	{
 		SRQ_INIT((*lock_srq));
 	}
-	for (i = 0, lock_srq = hdr->lhb_hash; i < hdr->lhb_hash_slots; i++, lock_srq++)
+
+	hdr->lhb_length = m_sharedMemory->sh_mem_length_mapped;
+	hdr->lhb_used = FB_ALIGN(sizeof(lhb), FB_ALIGNMENT);
+
+	// Allocate lock hash chains, the table could be moved when it grows
+
+	SRQ hash_table = (SRQ) alloc(hdr->lhb_hash_slots * sizeof(srq), NULL);
+	if (!hash_table)
 	{
-		SRQ_INIT((*lock_srq));
+		fb_utils::logAndDie("Fatal lock manager error: lock manager out of room");
 	}
 
-	// Set lock_ordering flag for the first time
-
-	const ULONG length = sizeof(lhb) + (hdr->lhb_hash_slots * sizeof(hdr->lhb_hash[0]));
-	hdr->lhb_length = m_sharedMemory->sh_mem_length_mapped;
-	hdr->lhb_used = FB_ALIGN(length, FB_ALIGNMENT);
+	hdr->lhb_hash = SRQ_REL_PTR(hash_table);
+	for (ULONG slot = 0; slot < hdr->lhb_hash_slots; slot++, hash_table++)
+	{
+		SRQ_INIT((*hash_table));
+	}
 
 	shb* secondary_header = (shb*) alloc(sizeof(shb), NULL);
 	if (!secondary_header)
@@ -2394,6 +3603,30 @@ bool LockManager::initialize(SharedMemoryBase* sm, bool initializeMemory)
 		history->his_next = (j == 0) ? hdr->lhb_history : secondary_header->shb_history;
 	}
 
+	// Allocate lock table stripes, cache line aligned
+
+	UCHAR* const stripes = alloc(LCK_STRIPES * LST_SIZE + 64, NULL);
+	if (!stripes)
+	{
+		fb_utils::logAndDie("Fatal lock manager error: lock manager out of room");
+	}
+
+	hdr->lhb_stripes = FB_ALIGN(SRQ_REL_PTR(stripes), 64);
+
+	for (i = 0; i < LCK_STRIPES; i++)
+	{
+		lst* const stripe = get_stripe(i);
+		memset(stripe, 0, sizeof(lst));
+		SRQ_INIT(stripe->lst_free_locks);
+		SRQ_INIT(stripe->lst_free_requests);
+
+#ifdef USE_LOCK_STRIPES
+		const int state = init_stripe_mutex(&stripe->lst_mutex);
+		if (state)
+			mutexBug(state, "pthread_mutex_init");
+#endif
+	}
+
 	// Done initializing, unmark owner information
 	hdr->lhb_active_owner = 0;
 
@@ -2435,7 +3668,7 @@ void LockManager::insert_data_que(lbl* lock)
 }
 
 
-void LockManager::insert_tail(SRQ lock_srq, SRQ node)
+void LockManager::insert_tail(SRQ lock_srq, SRQ node, lst* stripe)
 {
 /**************************************
  *
@@ -2455,13 +3688,30 @@ void LockManager::insert_tail(SRQ lock_srq, SRQ node)
  *	eg: it will put the queue back to the state
  *	prior to the insertion being started.
  *
+ *	Fast path operations use the stripe they hold
+ *	instead of the shb.
+ *
  **************************************/
-	ASSERT_ACQUIRED;
-	shb* const recover = (shb*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_secondary);
+	SRQ_PTR* insert_que;
+	SRQ_PTR* insert_prior;
+
+	if (stripe)
+	{
+		insert_que = &stripe->lst_insert_que;
+		insert_prior = &stripe->lst_insert_prior;
+	}
+	else
+	{
+		ASSERT_ACQUIRED;
+		shb* const recover = (shb*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_secondary);
+		insert_que = &recover->shb_insert_que;
+		insert_prior = &recover->shb_insert_prior;
+	}
+
 	DEBUG_DELAY;
-	recover->shb_insert_que = SRQ_REL_PTR(lock_srq);
+	*insert_que = SRQ_REL_PTR(lock_srq);
 	DEBUG_DELAY;
-	recover->shb_insert_prior = lock_srq->srq_backward;
+	*insert_prior = lock_srq->srq_backward;
 	DEBUG_DELAY;
 
 	node->srq_forward = SRQ_REL_PTR(lock_srq);
@@ -2476,9 +3726,9 @@ void LockManager::insert_tail(SRQ lock_srq, SRQ node)
 	lock_srq->srq_backward = SRQ_REL_PTR(node);
 	DEBUG_DELAY;
 
-	recover->shb_insert_que = 0;
+	*insert_que = 0;
 	DEBUG_DELAY;
-	recover->shb_insert_prior = 0;
+	*insert_prior = 0;
 	DEBUG_DELAY;
 }
 
@@ -2600,6 +3850,30 @@ void LockManager::internal_dequeue(SRQ_PTR request_offset)
 }
 
 
+#ifdef USE_LOCK_STRIPES
+void LockManager::leave_stripe(USHORT number)
+{
+/**************************************
+ *
+ *	l e a v e _ s t r i p e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release the lock table stripe acquired
+ *	by enter_stripe().
+ *
+ **************************************/
+	get_stripe(number)->lst_active_owner = 0;
+
+	lst* const view = (lst*) (m_stripes + number * LST_SIZE);
+	const int state = pthread_mutex_unlock(view->lst_mutex.mtx_mutex);
+	if (state)
+		mutexBug(state, "pthread_mutex_unlock");
+}
+#endif
+
+
 USHORT LockManager::lock_state(const lbl* lock)
 {
 /**************************************
@@ -2630,6 +3904,31 @@ USHORT LockManager::lock_state(const lbl* lock)
 }
 
 
+#ifdef USE_LOCK_STRIPES
+bool LockManager::map_stripes(CheckStatusWrapper* statusVector)
+{
+/**************************************
+ *
+ *	m a p _ s t r i p e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Map the lock table stripes separately, like the lock
+ *	table mutex itself: address of robust mutex should not
+ *	change when the lock table is remapped.
+ *
+ **************************************/
+	fb_assert(!m_stripes);
+
+	const SRQ_PTR offset = m_sharedMemory->getHeader()->lhb_stripes;
+	m_stripes = m_sharedMemory->SharedMemoryBase::mapObject(statusVector, offset, LCK_STRIPES * LST_SIZE);
+
+	return m_stripes != NULL;
+}
+#endif
+
+
 void LockManager::post_blockage(thread_db* tdbb, lrq* request, lbl* lock)
 {
 /**************************************
@@ -2912,10 +4211,13 @@ void LockManager::purge_owner(SRQ_PTR purging_owner_offset, own* owner)
 	// Release any locks that are active
 
 	SRQ lock_srq;
-	while ((lock_srq = SRQ_NEXT(owner->own_requests)) != &owner->own_requests)
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
 	{
-		lrq* request = (lrq*) ((UCHAR*) lock_srq - offsetof(lrq, lrq_own_requests));
-		release_request(request);
+		while ((lock_srq = SRQ_NEXT(owner->own_requests[i])) != &owner->own_requests[i])
+		{
+			lrq* request = (lrq*) ((UCHAR*) lock_srq - offsetof(lrq, lrq_own_requests));
+			release_request(request);
+		}
 	}
 
 	// Release any repost requests left dangling on blocking queue
@@ -3013,7 +4315,7 @@ void LockManager::remap_local_owners()
 }
 
 
-void LockManager::remove_que(SRQ node)
+void LockManager::remove_que(SRQ node, lst* stripe)
 {
 /**************************************
  *
@@ -3035,11 +4337,23 @@ void LockManager::remove_que(SRQ node)
  *	nodes may have changed prior to the crash, we need to redo the
  *	work only based on what is in <node>.
  *
+ *	Fast path operations use the stripe they hold
+ *	instead of the shb.
+ *
  **************************************/
-	ASSERT_ACQUIRED;
-	shb* recover = (shb*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_secondary);
+	SRQ_PTR* remove_node;
+
+	if (stripe)
+		remove_node = &stripe->lst_remove_node;
+	else
+	{
+		ASSERT_ACQUIRED;
+		shb* const recover = (shb*) SRQ_ABS_PTR(m_sharedMemory->getHeader()->lhb_secondary);
+		remove_node = &recover->shb_remove_node;
+	}
+
 	DEBUG_DELAY;
-	recover->shb_remove_node = SRQ_REL_PTR(node);
+	*remove_node = SRQ_REL_PTR(node);
 	DEBUG_DELAY;
 
 	SRQ lock_srq = (SRQ) SRQ_ABS_PTR(node->srq_forward);
@@ -3064,7 +4378,7 @@ void LockManager::remove_que(SRQ node)
 	lock_srq->srq_forward = node->srq_forward;
 
 	DEBUG_DELAY;
-	recover->shb_remove_node = 0;
+	*remove_node = 0;
 	DEBUG_DELAY;
 
 	// To prevent trying to remove this entry a second time, which could occur
@@ -3109,6 +4423,8 @@ void LockManager::release_shmem(SRQ_PTR owner_offset)
 
 	DEBUG_DELAY;
 
+	release_stripes();
+
 	m_sharedMemory->getHeader()->lhb_active_owner = 0;
 
 	m_sharedMemory->mutexUnlock();
@@ -3117,6 +4433,38 @@ void LockManager::release_shmem(SRQ_PTR owner_offset)
 }
 
 
+void LockManager::release_stripes()
+{
+/**************************************
+ *
+ *	r e l e a s e _ s t r i p e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release the lock table stripes acquired
+ *	by acquire_stripes().
+ *
+ **************************************/
+	if (!m_stripesAcquired)
+		return;
+
+	m_stripesAcquired = false;
+
+	for (USHORT i = LCK_STRIPES; i--;)
+	{
+		get_stripe(i)->lst_active_owner = 0;
+
+#ifdef USE_LOCK_STRIPES
+		mtx* const mutex = &((lst*) (m_stripes + i * LST_SIZE))->lst_mutex;
+		const int state = pthread_mutex_unlock(mutex->mtx_mutex);
+		if (state)
+			mutexBug(state, "pthread_mutex_unlock");
+#endif
+	}
+}
+
+
 void LockManager::release_request(lrq* request)
 {
 /**************************************
@@ -3137,9 +4485,11 @@ void LockManager::release_request(lrq* request)
 	remove_que(&request->lrq_lbl_requests);
 	remove_que(&request->lrq_own_requests);
 
-	request->lrq_type = type_null;
-	insert_tail(&m_sharedMemory->getHeader()->lhb_free_requests, &request->lrq_lbl_requests);
 	lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+	lst* const stripe = get_stripe(lock->lbl_hash_slot % LCK_STRIPES);
+
+	request->lrq_type = type_null;
+	insert_tail(&stripe->lst_free_requests, &request->lrq_lbl_requests);
 
 	// If the request is marked as blocking, clean it up
 
@@ -3171,7 +4521,8 @@ void LockManager::release_request(lrq* request)
 		remove_que(&lock->lbl_lhb_data);
 		lock->lbl_type = type_null;
 
-		insert_tail(&m_sharedMemory->getHeader()->lhb_free_locks, &lock->lbl_lhb_hash);
+		insert_tail(&stripe->lst_free_locks, &lock->lbl_lhb_hash);
+		--stripe->lst_locks;
 		return;
 	}
 
@@ -3256,6 +4607,29 @@ const USHORT EXPECT_freed = 1;
 const USHORT RECURSE_yes = 0;
 const USHORT RECURSE_not = 1;
 
+#ifdef USE_LOCK_STRIPES
+void LockManager::unmap_stripes()
+{
+/**************************************
+ *
+ *	u n m a p _ s t r i p e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Unmap the lock table stripes mapped by map_stripes().
+ *
+ **************************************/
+	if (m_stripes)
+	{
+		LocalStatus ls;
+		CheckStatusWrapper localStatus(&ls);
+		m_sharedMemory->SharedMemoryBase::unmapObject(&localStatus, &m_stripes, LCK_STRIPES * LST_SIZE);
+	}
+}
+#endif
+
+
 void LockManager::validate_history(const SRQ_PTR history_header)
 {
 /**************************************
@@ -3356,6 +4730,35 @@ void LockManager::validate_lhb(const lhb* alhb)
 		validate_request(SRQ_REL_PTR(request), EXPECT_freed, RECURSE_not);
 	}
 
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+		const lst* const stripe =
+			(lst*) ((UCHAR*) SRQ_ABS_PTR(alhb->lhb_stripes) + i * LST_SIZE);
+
+		if (stripe->lst_active_owner > 0)
+			validate_owner(stripe->lst_active_owner, EXPECT_inuse);
+
+		SRQ_LOOP(stripe->lst_free_locks, lock_srq)
+		{
+			// Validate that the next backpointer points back to us
+			const srq* const que_next = SRQ_NEXT((*lock_srq));
+			CHECK(que_next->srq_backward == SRQ_REL_PTR(lock_srq));
+
+			const lbl* const lock = (lbl*) ((UCHAR*) lock_srq - offsetof(lbl, lbl_lhb_hash));
+			validate_lock(SRQ_REL_PTR(lock), EXPECT_freed, (SRQ_PTR) 0);
+		}
+
+		SRQ_LOOP(stripe->lst_free_requests, lock_srq)
+		{
+			// Validate that the next backpointer points back to us
+			const srq* const que_next = SRQ_NEXT((*lock_srq));
+			CHECK(que_next->srq_backward == SRQ_REL_PTR(lock_srq));
+
+			const lrq* const request = (lrq*) ((UCHAR*) lock_srq - offsetof(lrq, lrq_lbl_requests));
+			validate_request(SRQ_REL_PTR(request), EXPECT_freed, RECURSE_not);
+		}
+	}
+
 	CHECK(alhb->lhb_used <= alhb->lhb_length);
 
 	validate_history(alhb->lhb_history);
@@ -3492,84 +4895,87 @@ void LockManager::validate_owner(const SRQ_PTR own_ptr, USHORT freed)
 	CHECK(!(owner->own_flags & ~(OWN_scanned | OWN_wakeup | OWN_signaled)));
 
 	const srq* lock_srq;
-	SRQ_LOOP(owner->own_requests, lock_srq)
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
 	{
-		// Validate that the next backpointer points back to us
-		const srq* const que_next = SRQ_NEXT((*lock_srq));
-		CHECK(que_next->srq_backward == SRQ_REL_PTR(lock_srq));
+		SRQ_LOOP(owner->own_requests[i], lock_srq)
+		{
+			// Validate that the next backpointer points back to us
+			const srq* const que_next = SRQ_NEXT((*lock_srq));
+			CHECK(que_next->srq_backward == SRQ_REL_PTR(lock_srq));
 
-		CHECK(freed == EXPECT_inuse);	// should not be in loop for freed owner
+			CHECK(freed == EXPECT_inuse);	// should not be in loop for freed owner
 
-		const lrq* const request = (lrq*) ((UCHAR*) lock_srq - offsetof(lrq, lrq_own_requests));
-		validate_request(SRQ_REL_PTR(request), EXPECT_inuse, RECURSE_not);
-		CHECK(request->lrq_owner == own_ptr);
+			const lrq* const request = (lrq*) ((UCHAR*) lock_srq - offsetof(lrq, lrq_own_requests));
+			validate_request(SRQ_REL_PTR(request), EXPECT_inuse, RECURSE_not);
+			CHECK(request->lrq_owner == own_ptr);
 
-		// Make sure that request marked as blocking also exists in the blocking list
+			// Make sure that request marked as blocking also exists in the blocking list
 
-		if (request->lrq_flags & LRQ_blocking)
-		{
-			ULONG found = 0;
-			const srq* que2;
-			SRQ_LOOP(owner->own_blocks, que2)
+			if (request->lrq_flags & LRQ_blocking)
 			{
-				// Validate that the next backpointer points back to us
-				const srq* const que2_next = SRQ_NEXT((*que2));
-				CHECK(que2_next->srq_backward == SRQ_REL_PTR(que2));
+				ULONG found = 0;
+				const srq* que2;
+				SRQ_LOOP(owner->own_blocks, que2)
+				{
+					// Validate that the next backpointer points back to us
+					const srq* const que2_next = SRQ_NEXT((*que2));
+					CHECK(que2_next->srq_backward == SRQ_REL_PTR(que2));
 
-				const lrq* const request2 = (lrq*) ((UCHAR*) que2 - offsetof(lrq, lrq_own_blocks));
-				CHECK(request2->lrq_owner == own_ptr);
+					const lrq* const request2 = (lrq*) ((UCHAR*) que2 - offsetof(lrq, lrq_own_blocks));
+					CHECK(request2->lrq_owner == own_ptr);
 
-				if (SRQ_REL_PTR(request2) == SRQ_REL_PTR(request))
-					found++;
+					if (SRQ_REL_PTR(request2) == SRQ_REL_PTR(request))
+						found++;
 
-				CHECK(found <= 1);	// watch for loops in queue
+					CHECK(found <= 1);	// watch for loops in queue
+				}
+				CHECK(found == 1);	// request marked as blocking must be in blocking queue
 			}
-			CHECK(found == 1);	// request marked as blocking must be in blocking queue
-		}
 
-		// Make sure that request marked as pending also exists in the pending list,
-		// as well as in the queue for the lock
+			// Make sure that request marked as pending also exists in the pending list,
+			// as well as in the queue for the lock
 
-		if (request->lrq_flags & LRQ_pending)
-		{
-			ULONG found = 0;
-			const srq* que2;
-			SRQ_LOOP(owner->own_pending, que2)
+			if (request->lrq_flags & LRQ_pending)
 			{
-				// Validate that the next backpointer points back to us
-				const srq* const que2_next = SRQ_NEXT((*que2));
-				CHECK(que2_next->srq_backward == SRQ_REL_PTR(que2));
-
-				const lrq* const request2 = (lrq*) ((UCHAR*) que2 - offsetof(lrq, lrq_own_pending));
-				CHECK(request2->lrq_owner == own_ptr);
+				ULONG found = 0;
+				const srq* que2;
+				SRQ_LOOP(owner->own_pending, que2)
+				{
+					// Validate that the next backpointer points back to us
+					const srq* const que2_next = SRQ_NEXT((*que2));
+					CHECK(que2_next->srq_backward == SRQ_REL_PTR(que2));
 
-				if (SRQ_REL_PTR(request2) == SRQ_REL_PTR(request))
-					found++;
+					const lrq* const request2 = (lrq*) ((UCHAR*) que2 - offsetof(lrq, lrq_own_pending));
+					CHECK(request2->lrq_owner == own_ptr);
 
-				CHECK(found <= 1);	// watch for loops in queue
-			}
-			CHECK(found == 1);	// request marked as pending must be in pending queue
+					if (SRQ_REL_PTR(request2) == SRQ_REL_PTR(request))
+						found++;
 
-			// Make sure the pending request is on the list of requests for the lock
+					CHECK(found <= 1);	// watch for loops in queue
+				}
+				CHECK(found == 1);	// request marked as pending must be in pending queue
 
-			const lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+				// Make sure the pending request is on the list of requests for the lock
 
-			bool found_pending = false;
-			const srq* que_of_lbl_requests;
-			SRQ_LOOP(lock->lbl_requests, que_of_lbl_requests)
-			{
-				const lrq* const pending =
-					(lrq*) ((UCHAR*) que_of_lbl_requests - offsetof(lrq, lrq_lbl_requests));
+				const lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
 
-				if (SRQ_REL_PTR(pending) == SRQ_REL_PTR(request))
+				bool found_pending = false;
+				const srq* que_of_lbl_requests;
+				SRQ_LOOP(lock->lbl_requests, que_of_lbl_requests)
 				{
-					found_pending = true;
-					break;
+					const lrq* const pending =
+						(lrq*) ((UCHAR*) que_of_lbl_requests - offsetof(lrq, lrq_lbl_requests));
+
+					if (SRQ_REL_PTR(pending) == SRQ_REL_PTR(request))
+					{
+						found_pending = true;
+						break;
+					}
 				}
-			}
 
-			// pending request must exist in the lock's request queue
-			CHECK(found_pending);
+				// pending request must exist in the lock's request queue
+				CHECK(found_pending);
+			}
 		}
 	}
 
@@ -3597,9 +5003,11 @@ void LockManager::validate_owner(const SRQ_PTR own_ptr, USHORT freed)
 
 		// Make sure that each block also exists in the request list
 
+		const lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+
 		ULONG found = 0;
 		const srq* que2;
-		SRQ_LOOP(owner->own_requests, que2)
+		SRQ_LOOP(owner->own_requests[lock->lbl_hash_slot % LCK_STRIPES], que2)
 		{
 			// Validate that the next backpointer points back to us
 			const srq* const que2_next = SRQ_NEXT((*que2));
@@ -3639,9 +5047,11 @@ void LockManager::validate_owner(const SRQ_PTR own_ptr, USHORT freed)
 
 		// Make sure that each pending request also exists in the request list
 
+		const lbl* const lock = (lbl*) SRQ_ABS_PTR(request->lrq_lock);
+
 		ULONG found = 0;
 		const srq* que2;
-		SRQ_LOOP(owner->own_requests, que2)
+		SRQ_LOOP(owner->own_requests[lock->lbl_hash_slot % LCK_STRIPES], que2)
 		{
 			// Validate that the next backpointer points back to us
 			const srq* const que2_next = SRQ_NEXT((*que2));
@@ -3808,6 +5218,10 @@ void LockManager::wait_for_request(thread_db* tdbb, lrq* request, SSHORT lck_wai
 	const time_t lock_timeout = (lck_wait < 0) ? current_time + (-lck_wait) : 0;
 	time_t deadlock_timeout = current_time + scan_interval;
 
+	// Deadlock detector thread will not look at us before
+
+	owner->own_scan_time = deadlock_timeout;
+
 	// Wait in a loop until the lock becomes available
 
 #ifdef DEV_BUILD
@@ -3953,64 +5367,32 @@ void LockManager::wait_for_request(thread_db* tdbb, lrq* request, SSHORT lck_wai
 		if (probe_processes() && !(request->lrq_flags & LRQ_pending))
 			break;
 
-		// If we've not previously been scanned for a deadlock and going to wait
-		// forever, go do a deadlock scan
-
-		lrq* blocking_request;
-		if (!(owner->own_flags & OWN_scanned) &&
-			!(request->lrq_flags & LRQ_wait_timeout) &&
-			(blocking_request = deadlock_scan(owner, request)))
+		// Our request is not resolved and all the owners are alive. Deadlocks
+		// are detected by the deadlock detector thread which wakes us up if
+		// our request is rejected -- there's nothing else to do.  Let's
+		// make sure our request hasn't been forgotten by reminding
+		// all the owners we're waiting - some plaforms under CLASSIC
+		// architecture had problems with "missing signals" - which is
+		// another reason to repost the blockage.
+		// Also, the ownership of the lock could have changed, and we
+		// weren't woken up because we weren't next in line for the lock.
+		// We need to inform the new owner.
+
+		DEBUG_MSG(0, ("wait_for_request: forcing a resignal of blockers\n"));
+		post_blockage(tdbb, request, lock);
+#ifdef DEV_BUILD
+		repost_counter++;
+		if (repost_counter % 50 == 0)
 		{
-			// Something has been selected for rejection to prevent a
-			// deadlock. Clean things up and go on. We still have to
-			// wait for our request to be resolved.
-
-			DEBUG_MSG(0, ("wait_for_request: selecting something for deadlock kill\n"));
-
-			++(m_sharedMemory->getHeader()->lhb_deadlocks);
-			blocking_request->lrq_flags |= LRQ_rejected;
-			remove_que(&blocking_request->lrq_own_pending);
-			blocking_request->lrq_flags &= ~LRQ_pending;
-			lbl* const blocking_lock = (lbl*) SRQ_ABS_PTR(blocking_request->lrq_lock);
-			blocking_lock->lbl_pending_lrq_count--;
-
-			own* const blocking_owner = (own*) SRQ_ABS_PTR(blocking_request->lrq_owner);
-			blocking_owner->own_flags &= ~OWN_scanned;
-			if (blocking_request != request)
-				post_wakeup(blocking_owner);
-			// else
-			// We rejected our own request to avoid a deadlock.
-			// When we get back to the top of the master loop we
-			// fall out and start cleaning up.
+			gds__log("wait_for_request: owner %d reposted %ld times for lock %d",
+					owner_offset,
+					repost_counter,
+					lock_offset);
+			DEBUG_MSG(0,
+					  ("wait_for_request: reposted %ld times for this lock!\n",
+					   repost_counter));
 		}
-		else
-		{
-			// Our request is not resolved, all the owners are alive, there's
-			// no deadlock -- there's nothing else to do.  Let's
-			// make sure our request hasn't been forgotten by reminding
-			// all the owners we're waiting - some plaforms under CLASSIC
-			// architecture had problems with "missing signals" - which is
-			// another reason to repost the blockage.
-			// Also, the ownership of the lock could have changed, and we
-			// weren't woken up because we weren't next in line for the lock.
-			// We need to inform the new owner.
-
-			DEBUG_MSG(0, ("wait_for_request: forcing a resignal of blockers\n"));
-			post_blockage(tdbb, request, lock);
-#ifdef DEV_BUILD
-			repost_counter++;
-			if (repost_counter % 50 == 0)
-			{
-				gds__log("wait_for_request: owner %d reposted %ld times for lock %d",
-						owner_offset,
-						repost_counter,
-						lock_offset);
-				DEBUG_MSG(0,
-						  ("wait_for_request: reposted %ld times for this lock!\n",
-						   repost_counter));
-			}
 #endif
-		}
 	}
 
 	CHECK(!(request->lrq_flags & LRQ_pending));
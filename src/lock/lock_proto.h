@@ -48,6 +48,13 @@
 #include "../common/file_params.h"
 #include "../jrd/que.h"
 
+// Lock table stripes need a process-shared pthread mutex which lives in the lock
+// table and could be mapped at the fixed address (the table itself may be remapped)
+
+#if defined(USE_SHARED_FUTEX) && defined(HAVE_OBJECT_MAP) && !defined(USE_SHMEM_EXT) && !defined(WIN_NT)
+#define USE_LOCK_STRIPES
+#endif
+
 typedef FB_UINT64 LOCK_OWNER_T; // Data type for the Owner ID
 typedef SINT64 LOCK_DATA_T;
 
@@ -55,6 +62,10 @@ typedef SINT64 LOCK_DATA_T;
 
 const int LCK_MAX_SERIES	= 7;
 
+// Number of lock table stripes, hash slot N belongs to stripe N % LCK_STRIPES
+
+const USHORT LCK_STRIPES	= 32;
+
 // Lock query data aggregates
 
 const int LCK_MIN		= 1;
@@ -93,7 +104,7 @@ const UCHAR type_lpr	= 7;
 
 // Version number of the lock table.
 // Must be increased every time the shmem layout is changed.
-const USHORT BASE_LHB_VERSION = 18;
+const USHORT BASE_LHB_VERSION = 21;
 
 #if SIZEOF_VOID_P == 8
 const USHORT PLATFORM_LHB_VERSION = 128;	// 64-bit target
@@ -118,7 +129,13 @@ struct lhb : public Firebird::MemoryHeader
 	srq lhb_free_requests;			// Free lock requests
 	ULONG lhb_length;				// Size of lock table
 	ULONG lhb_used;					// Bytes of lock table in use
-	USHORT lhb_hash_slots;			// Number of hash slots allocated
+	ULONG lhb_hash_slots;			// Number of hash slots allocated
+	SRQ_PTR lhb_hash;				// Hash table
+	ULONG lhb_hash_limit;			// Number of locks to grow the hash table at
+	ULONG lhb_hash_resizes;			// Number of times the hash table was grown
+	ULONG lhb_hash_prior_slots;		// Hash slots before the last growth
+	ULONG lhb_hash_resize_locks;	// Number of locks at the last growth
+	SRQ_PTR lhb_stripes;			// Lock table stripes
 
 	SRQ_PTR lhb_history;
 	ULONG lhb_scan_interval;		// Deadlock scan interval (secs)
@@ -143,7 +160,6 @@ struct lhb : public Firebird::MemoryHeader
 	FB_UINT64 lhb_scans;
 	FB_UINT64 lhb_deadlocks;
 	srq lhb_data[LCK_MAX_SERIES];
-	srq lhb_hash[1];			// Hash table
 };
 
 // Secondary header block -- exists only in V3.3 and later lock managers.
@@ -158,6 +174,37 @@ struct shb
 	SRQ_PTR shb_insert_prior;		// Prior of inserting queue
 };
 
+// Lock table stripe -- hash slots of the stripe, their locks and requests could be
+// changed by an operation which holds the stripe mutex only, as long as it neither
+// waits nor affects other owners. Everything else holds the lock table mutex and
+// all the stripe mutexes.
+
+struct lst
+{
+#ifdef USE_LOCK_STRIPES
+	Firebird::mtx lst_mutex;		// Stripe mutex
+#endif
+	SRQ_PTR lst_active_owner;		// Active owner, if any
+	SRQ_PTR lst_remove_node;		// Node removing itself
+	SRQ_PTR lst_insert_que;			// Queue inserting into
+	SRQ_PTR lst_insert_prior;		// Prior of inserting queue
+	srq lst_free_locks;				// Free lock blocks
+	srq lst_free_requests;			// Free lock requests
+	ULONG lst_locks;				// Number of locks in the hash slots of the stripe
+	FB_UINT64 lst_hash_lookups;		// Lock lookups in the hash slots of the stripe
+	FB_UINT64 lst_hash_steps;		// Locks visited by these lookups
+	FB_UINT64 lst_acquires;
+	FB_UINT64 lst_acquire_blocks;
+	FB_UINT64 lst_enqs;
+	FB_UINT64 lst_converts;
+	FB_UINT64 lst_deqs;
+	FB_UINT64 lst_operations[LCK_MAX_SERIES];
+};
+
+// Stripes are cache line aligned to not disturb each other
+
+const ULONG LST_SIZE = (sizeof(lst) + 63) & ~63;
+
 // Lock block
 
 struct lbl
@@ -173,6 +220,7 @@ struct lbl
 	UCHAR lbl_series;				// Lock series
 	UCHAR lbl_flags;				// Unused. Misc flags
 	USHORT lbl_pending_lrq_count;	// count of lbl_requests with LRQ_pending
+	ULONG lbl_hash_slot;			// Hash slot the lock is chained into
 	USHORT lbl_counts[LCK_max];		// Counts of granted locks
 	UCHAR lbl_key[1];				// Key value
 };
@@ -229,12 +277,13 @@ struct own
 	LOCK_OWNER_T own_owner_id;		// Owner ID
 	srq own_lhb_owners;				// Owner que (global)
 	srq own_prc_owners;				// Owner que (process wide)
-	srq own_requests;				// Lock requests granted
+	srq own_requests[LCK_STRIPES];	// Lock requests granted, by stripe of the lock
 	srq own_blocks;					// Lock requests blocking
 	srq own_pending;				// Lock requests pending
 	SRQ_PTR own_process;			// Process we belong to
 	ThreadId own_thread_id;			// Last thread attached to the owner
 	FB_UINT64 own_acquire_time;		// lhb_acquires when owner last tried acquire()
+	SINT64 own_scan_time;			// When the waiting owner is due for a deadlock scan
 	USHORT own_waits;				// Number of requests we are waiting on
 	USHORT own_ast_count;			// Number of ASTs being delivered
 	Firebird::event_t own_wakeup;	// Wakeup event block
@@ -292,6 +341,7 @@ class Config;
 namespace Jrd {
 
 class thread_db;
+class LocalLockManager;
 
 class LockManager : private Firebird::RefCounted,
 					public Firebird::GlobalStorage,
@@ -391,6 +441,54 @@ class LockManager : private Firebird::RefCounted,
 	};
 #undef FB_LOCKED_FROM
 
+#ifdef USE_LOCK_STRIPES
+	// Fast path guard -- holds single lock table stripe and prevents remapping of
+	// the lock table by this process meanwhile
+
+	class StripeGuard
+	{
+	public:
+		StripeGuard(LockManager* lm, const char* f)
+			: m_lm(lm), m_remapGuard(lm->m_remapSync, f), m_number(0), m_stripe(NULL)
+		{
+		}
+
+		~StripeGuard()
+		{
+			try
+			{
+				if (m_stripe)
+					m_lm->leave_stripe(m_number);
+			}
+			catch (const Firebird::Exception&)
+			{
+				DtorException::devHalt();
+			}
+		}
+
+		lst* enter(USHORT number, SRQ_PTR owner, bool wait = false)
+		{
+			fb_assert(!m_stripe);
+			m_number = number;
+			m_stripe = m_lm->enter_stripe(number, owner, wait);
+			return m_stripe;
+		}
+
+	private:
+		// Forbid copying
+		StripeGuard(const StripeGuard&);
+		StripeGuard& operator=(const StripeGuard&);
+
+		LockManager* m_lm;
+		Firebird::ReadLockGuard m_remapGuard;
+		USHORT m_number;
+		lst* m_stripe;
+	};
+#endif
+
+	// Pending request in the copy of the wait-for graph made by the deadlock detector
+	struct WaitNode;
+
 	typedef Firebird::GenericMap<Firebird::Pair<Firebird::Left<Firebird::string, LockManager*> > > DbLockMgrMap;
 
 	static Firebird::GlobalPtr<DbLockMgrMap> g_lmMap;
@@ -399,7 +497,7 @@ class LockManager : private Firebird::RefCounted,
 	const int PID;
 
 public:
-	static LockManager* create(const Firebird::string&, Firebird::RefPtr<const Config>);
+	static LockManager* create(const Firebird::string&, Firebird::RefPtr<const Config>, bool);
 	static void destroy(LockManager*);
 
 	bool initializeOwner(Firebird::CheckStatusWrapper*, LOCK_OWNER_T, UCHAR, SRQ_PTR*);
@@ -422,12 +520,14 @@ public:
 	void exceptionHandler(const Firebird::Exception& ex, ThreadFinishSync<LockManager*>::ThreadRoutine* routine);
 
 private:
-	explicit LockManager(const Firebird::string&, Firebird::RefPtr<const Config>);
+	LockManager(const Firebird::string&, Firebird::RefPtr<const Config>, bool);
 	~LockManager();
 
 	void acquire_shmem(SRQ_PTR);
-	UCHAR* alloc(USHORT, Firebird::CheckStatusWrapper*);
-	lbl* alloc_lock(USHORT, Firebird::CheckStatusWrapper*);
+	void acquire_stripes(SRQ_PTR);
+	UCHAR* alloc(ULONG, Firebird::CheckStatusWrapper*);
+	lbl* alloc_lock(USHORT, USHORT, Firebird::CheckStatusWrapper*);
+	lrq* alloc_request(USHORT, Firebird::CheckStatusWrapper*);
 	void blocking_action(thread_db*, SRQ_PTR);
 	void blocking_action_thread();
 	void bug(Firebird::CheckStatusWrapper*, const TEXT*);
@@ -437,14 +537,24 @@ private:
 	void deadlock_clear();
 	lrq* deadlock_scan(own*, lrq*);
 	lrq* deadlock_walk(lrq*, bool*);
+	void deadlock_thread();
+	void detect_deadlocks();
+	bool snapshot_waits(Firebird::Array<WaitNode>&, Firebird::Array<SRQ_PTR>&);
+	void snapshot_stripe(USHORT, Firebird::Array<WaitNode>&, Firebird::Array<SRQ_PTR>&);
+	static FB_SIZE_T snapshot_walk(const Firebird::Array<WaitNode>&, const Firebird::Array<SRQ_PTR>&,
+		UCHAR*, FB_SIZE_T);
 	void debug_delay(ULONG);
-	lbl* find_lock(USHORT, const UCHAR*, USHORT, USHORT*);
+	lbl* find_lock(USHORT, const UCHAR*, USHORT, ULONG*);
+	lbl* find_lock_in_slot(ULONG, USHORT, const UCHAR*, USHORT);
+	srq* get_hash_slot(ULONG);
 	lrq* get_request(SRQ_PTR);
+	lst* get_stripe(USHORT);
 	void grant(lrq*, lbl*);
 	bool grant_or_que(thread_db*, lrq*, lbl*, SSHORT);
+	void grow_hash(ULONG);
 	bool init_owner_block(Firebird::CheckStatusWrapper*, own*, UCHAR, LOCK_OWNER_T);
 	void insert_data_que(lbl*);
-	void insert_tail(SRQ, SRQ);
+	void insert_tail(SRQ, SRQ, lst* = NULL);
 	bool internal_convert(thread_db* database, Firebird::CheckStatusWrapper*, SRQ_PTR, UCHAR, SSHORT,
 		lock_ast_t, void*);
 	void internal_dequeue(SRQ_PTR);
@@ -457,8 +567,10 @@ private:
 	void purge_owner(SRQ_PTR, own*);
 	void purge_process(prc*);
 	void remap_local_owners();
-	void remove_que(SRQ);
+	void recover_queue(SRQ_PTR*, SRQ_PTR*, SRQ_PTR*, lst*);
+	void remove_que(SRQ, lst* = NULL);
 	void release_shmem(SRQ_PTR);
+	void release_stripes();
 	void release_request(lrq*);
 	bool signal_owner(thread_db*, own*);
 
@@ -470,6 +582,16 @@ private:
 	void validate_shb(const SRQ_PTR);
 
 	void wait_for_request(thread_db*, lrq*, SSHORT);
+
+#ifdef USE_LOCK_STRIPES
+	lst* enter_stripe(USHORT, SRQ_PTR, bool);
+	void leave_stripe(USHORT);
+	SRQ_PTR fast_enqueue(USHORT, const UCHAR*, USHORT, UCHAR, lock_ast_t, void*, SRQ_PTR);
+	bool fast_convert(SRQ_PTR, UCHAR, lock_ast_t, void*);
+	bool fast_dequeue(SRQ_PTR);
+	bool map_stripes(Firebird::CheckStatusWrapper*);
+	void unmap_stripes();
+#endif
 	bool init_shared_file(Firebird::CheckStatusWrapper*);
 	void get_shared_file_name(Firebird::PathName&, ULONG extend = 0) const;
 
@@ -478,6 +600,11 @@ private:
 		lockMgr->blocking_action_thread();
 	}
 
+	static void deadlock_thread(LockManager* lockMgr)
+	{
+		lockMgr->deadlock_thread();
+	}
+
 	bool initialize(Firebird::SharedMemoryBase* sm, bool init);
 	void mutexBug(int osErrorCode, const char* text);
 
@@ -492,18 +619,33 @@ private:
 	ThreadFinishSync<LockManager*> m_cleanupSync;
 	Firebird::Semaphore m_startupSemaphore;
 
+	// Deadlock detector of the owners of this process
+	ThreadFinishSync<LockManager*> m_deadlockSync;
+	Firebird::Semaphore m_deadlockSemaphore;
+	bool m_deadlockThread;
+
 public:
 	Firebird::AutoPtr<Firebird::SharedMemory<lhb> > m_sharedMemory;
 
 private:
 	bool m_blockage;
+	bool m_stripesAcquired;
+
+#ifdef USE_LOCK_STRIPES
+	// Stripes mapped at the fixed address, used for their mutexes only
+	UCHAR* m_stripes;
+#endif
 
 	Firebird::string m_dbId;
 	Firebird::RefPtr<const Config> m_config;
 
+	// Lock table private to this process, used instead of the shared one
+	Firebird::AutoPtr<LocalLockManager> m_localTable;
+
 	// configurations parameters - cached values
 	const ULONG m_acquireSpins;
 	const ULONG m_memorySize;
+	const ULONG m_hashMaxChain;
 	const bool m_useBlockingThread;
 
 #ifdef USE_SHMEM_EXT
@@ -175,6 +175,7 @@ static void prt_owner_wait_cycle(OUTFILE, const lhb*, const own*, USHORT, waitqu
 static void prt_request(OUTFILE, const lhb*, const lrq*);
 static void prt_que(OUTFILE, const lhb*, const SCHAR*, const srq*, USHORT, const TEXT* prefix = NULL);
 static void prt_que2(OUTFILE, const lhb*, const SCHAR*, const srq*, USHORT, const TEXT* prefix = NULL);
+static void sum_stripes(const lhb*, lhb*);
 
 // HTML print functions
 bool sw_html_format = false;
@@ -821,10 +822,15 @@ int CLIB_ROUTINE main( int argc, char *argv[])
 			(const TEXT*)HtmlLink(preOwn, LOCK_header->lhb_active_owner),
 			LOCK_header->lhb_length, LOCK_header->lhb_used);
 
+	// Operations done holding the lock table stripes only are counted there
+
+	lhb totals;
+	sum_stripes(LOCK_header, &totals);
+
 	FPRINTF(outfile,
 			"\tEnqs: %6" UQUADFORMAT", Converts: %6" UQUADFORMAT
 			", Rejects: %6" UQUADFORMAT", Blocks: %6" UQUADFORMAT"\n",
-			LOCK_header->lhb_enqs, LOCK_header->lhb_converts,
+			totals.lhb_enqs, totals.lhb_converts,
 			LOCK_header->lhb_denies, LOCK_header->lhb_blocks);
 
 	FPRINTF(outfile,
@@ -848,16 +854,29 @@ int CLIB_ROUTINE main( int argc, char *argv[])
 	else
 		FPRINTF(outfile, "\tMutex wait: 0.0%%\n");
 
-	SLONG hash_total_count = 0;
-	SLONG hash_max_count = 0;
-	SLONG hash_min_count = 10000000;
-	USHORT i = 0;
-	static const int MAX_MAX_COUNT_STATS = 21;
-	static const int LAST_MAX_COUNT_INDEX = MAX_MAX_COUNT_STATS - 1;
-	unsigned int distribution[MAX_MAX_COUNT_STATS] = {0}; // C++11 default brace initialization to zero
-	for (const srq* slot = LOCK_header->lhb_hash; i < LOCK_header->lhb_hash_slots; slot++, i++)
+	const FB_UINT64 stripe_acquires = totals.lhb_acquires - LOCK_header->lhb_acquires;
+	const FB_UINT64 stripe_blocks = totals.lhb_acquire_blocks - LOCK_header->lhb_acquire_blocks;
+
+	FPRINTF(outfile,
+			"\tStripes: %3d, Stripe acquires: %6" UQUADFORMAT", Stripe acquire blocks: %6" UQUADFORMAT
+			", Stripe wait: %3.1f%%\n",
+			LCK_STRIPES, stripe_acquires, stripe_blocks,
+			stripe_acquires ? (float) ((100. * stripe_blocks) / stripe_acquires) : 0.);
+
+	// Chain lengths are grouped by powers of two: 0, 1, 2-3, 4-7 and so on
+
+	static const int HASH_HISTOGRAM_SIZE = 33;
+	ULONG hash_slots_histogram[HASH_HISTOGRAM_SIZE] = {0};
+	ULONG hash_locks_histogram[HASH_HISTOGRAM_SIZE] = {0};
+
+	ULONG hash_total_count = 0;
+	ULONG hash_max_count = 0;
+	ULONG hash_min_count = MAX_ULONG;
+	const srq* const hash_table = (const srq*) SRQ_ABS_PTR(LOCK_header->lhb_hash);
+	for (ULONG i = 0; i < LOCK_header->lhb_hash_slots; i++)
 	{
-		SLONG hash_lock_count = 0;
+		const srq* const slot = &hash_table[i];
+		ULONG hash_lock_count = 0;
 		for (const srq* que_inst = (SRQ) SRQ_ABS_PTR(slot->srq_forward); que_inst != slot;
 			 que_inst = (SRQ) SRQ_ABS_PTR(que_inst->srq_forward))
 		{
@@ -868,27 +887,66 @@ int CLIB_ROUTINE main( int argc, char *argv[])
 			hash_min_count = hash_lock_count;
 		if (hash_lock_count > hash_max_count)
 			hash_max_count = hash_lock_count;
-		if (hash_lock_count > LAST_MAX_COUNT_INDEX)
-			hash_lock_count = LAST_MAX_COUNT_INDEX;
-		++distribution[hash_lock_count];
+
+		int bucket = 0;
+		for (ULONG n = hash_lock_count; n; n >>= 1)
+			bucket++;
+
+		++hash_slots_histogram[bucket];
+		hash_locks_histogram[bucket] += hash_lock_count;
 	}
 
-	FPRINTF(outfile, "\tHash slots: %4d, ", LOCK_header->lhb_hash_slots);
+	FPRINTF(outfile, "\tHash slots: %4" ULONGFORMAT", ", LOCK_header->lhb_hash_slots);
 
-	FPRINTF(outfile, "Hash lengths (min/avg/max): %4" SLONGFORMAT"/%4" SLONGFORMAT"/%4" SLONGFORMAT"\n",
+	FPRINTF(outfile, "Hash lengths (min/avg/max): %4" ULONGFORMAT"/%4" ULONGFORMAT"/%4" ULONGFORMAT"\n",
 			hash_min_count, (hash_total_count / LOCK_header->lhb_hash_slots),
 			hash_max_count);
 
-	// Hash distribution testing output. To be removed unless is considered useful for end users.
-	FPRINTF(outfile, "\tHash lengths distribution:\n");
-	if (hash_max_count >= LAST_MAX_COUNT_INDEX)
-		hash_max_count = LAST_MAX_COUNT_INDEX - 1;
-	for (int i = hash_min_count; i<=hash_max_count; ++i)
+	FPRINTF(outfile, "\tHash resizes: %4" ULONGFORMAT, LOCK_header->lhb_hash_resizes);
+	if (LOCK_header->lhb_hash_resizes)
 	{
-		FPRINTF(outfile, "\t\t%-2d : %8u\t(%d%%)\n", i, distribution[i], distribution[i] * 100 / LOCK_header->lhb_hash_slots);
+		FPRINTF(outfile, ", last from %" ULONGFORMAT" to %" ULONGFORMAT" slots at %" ULONGFORMAT" locks",
+				LOCK_header->lhb_hash_prior_slots, LOCK_header->lhb_hash_slots,
+				LOCK_header->lhb_hash_resize_locks);
+	}
+	if (LOCK_header->lhb_hash_limit)
+		FPRINTF(outfile, ", next at %" ULONGFORMAT" locks\n", LOCK_header->lhb_hash_limit);
+	else
+		FPRINTF(outfile, ", growth disabled\n");
+
+	FB_UINT64 hash_lookups = 0, hash_steps = 0;
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+		const lst* const stripe =
+			(lst*) ((UCHAR*) SRQ_ABS_PTR(LOCK_header->lhb_stripes) + i * LST_SIZE);
+
+		hash_lookups += stripe->lst_hash_lookups;
+		hash_steps += stripe->lst_hash_steps;
+	}
+
+	FPRINTF(outfile, "\tHash lookups: %6" UQUADFORMAT", Steps per lookup: %3.1f\n",
+			hash_lookups, hash_lookups ? (float) ((double) hash_steps / hash_lookups) : 0.);
+
+	FPRINTF(outfile, "\tHash lengths histogram:\n");
+	for (int i = 0; i < HASH_HISTOGRAM_SIZE; i++)
+	{
+		const FB_UINT64 low = i ? (FB_UINT64) 1 << (i - 1) : 0;
+		if (low > hash_max_count)
+			break;
+
+		char range[48];
+		if (i < 2)
+			sprintf(range, "%" UQUADFORMAT, low);
+		else
+			sprintf(range, "%" UQUADFORMAT"-%" UQUADFORMAT, low, ((FB_UINT64) 1 << i) - 1);
+
+		FPRINTF(outfile, "\t\t%-13s : %8" ULONGFORMAT" slots (%3d%%), %8" ULONGFORMAT" locks (%3d%%)\n",
+				range, hash_slots_histogram[i],
+				(int) ((FB_UINT64) hash_slots_histogram[i] * 100 / LOCK_header->lhb_hash_slots),
+				hash_locks_histogram[i],
+				hash_total_count ?
+					(int) ((FB_UINT64) hash_locks_histogram[i] * 100 / hash_total_count) : 0);
 	}
-	if (hash_max_count == LAST_MAX_COUNT_INDEX - 1)
-		FPRINTF(outfile, "\t\t>  : %8u\t(%d%%)\n", distribution[LAST_MAX_COUNT_INDEX], distribution[LAST_MAX_COUNT_INDEX] * 100 / LOCK_header->lhb_hash_slots);
 
 	const shb* a_shb = (shb*) SRQ_ABS_PTR(LOCK_header->lhb_secondary);
 	FPRINTF(outfile,
@@ -925,9 +983,9 @@ int CLIB_ROUTINE main( int argc, char *argv[])
 
 	if (sw_locks || sw_series)
 	{
-		USHORT i2 = 0;
-		for (const srq* slot = LOCK_header->lhb_hash; i2 < LOCK_header->lhb_hash_slots; slot++, i2++)
+		for (ULONG i2 = 0; i2 < LOCK_header->lhb_hash_slots; i2++)
 		{
+			const srq* const slot = &hash_table[i2];
 			for (const srq* que_inst = (SRQ) SRQ_ABS_PTR(slot->srq_forward); que_inst != slot;
 				 que_inst = (SRQ) SRQ_ABS_PTR(que_inst->srq_forward))
 			{
@@ -985,8 +1043,9 @@ static void prt_lock_activity(OUTFILE outfile,
 
 	FPRINTF(outfile, "\n");
 
-	lhb base = *header;
-	lhb prior = *header;
+	lhb base, prior;
+	sum_stripes(header, &base);
+	prior = base;
 
 	if (intervals == 0)
 	{
@@ -1004,26 +1063,29 @@ static void prt_lock_activity(OUTFILE outfile,
 		clock = time(NULL);
 		d = *localtime(&clock);
 
+		lhb current;
+		sum_stripes(header, &current);
+
 		FPRINTF(outfile, "%02d:%02d:%02d ", d.tm_hour, d.tm_min, d.tm_sec);
 
 		if (flag & SW_I_ACQUIRE)
 		{
 			FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" %9" UQUADFORMAT" ",
-					(header->lhb_acquires - prior.lhb_acquires) / seconds,
-					(header->lhb_acquire_blocks - prior.lhb_acquire_blocks) / seconds,
-					(header->lhb_acquires - prior.lhb_acquires) ?
-					 	(100 * (header->lhb_acquire_blocks - prior.lhb_acquire_blocks)) /
-							(header->lhb_acquires - prior.lhb_acquires) : 0,
-					(header->lhb_acquire_retries -
+					(current.lhb_acquires - prior.lhb_acquires) / seconds,
+					(current.lhb_acquire_blocks - prior.lhb_acquire_blocks) / seconds,
+					(current.lhb_acquires - prior.lhb_acquires) ?
+					 	(100 * (current.lhb_acquire_blocks - prior.lhb_acquire_blocks)) /
+							(current.lhb_acquires - prior.lhb_acquires) : 0,
+					(current.lhb_acquire_retries -
 					 prior.lhb_acquire_retries) / seconds,
-					(header->lhb_retry_success -
+					(current.lhb_retry_success -
 					 prior.lhb_retry_success) / seconds);
 
-			prior.lhb_acquires = header->lhb_acquires;
-			prior.lhb_acquire_blocks = header->lhb_acquire_blocks;
-			prior.lhb_acquire_retries = header->lhb_acquire_retries;
-			prior.lhb_retry_success = header->lhb_retry_success;
+			prior.lhb_acquires = current.lhb_acquires;
+			prior.lhb_acquire_blocks = current.lhb_acquire_blocks;
+			prior.lhb_acquire_retries = current.lhb_acquire_retries;
+			prior.lhb_retry_success = current.lhb_retry_success;
 		}
 
 		if (flag & SW_I_OPERATION)
@@ -1031,21 +1093,21 @@ static void prt_lock_activity(OUTFILE outfile,
 			FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" ",
-					(header->lhb_enqs - prior.lhb_enqs) / seconds,
-					(header->lhb_converts - prior.lhb_converts) / seconds,
-					(header->lhb_downgrades - prior.lhb_downgrades) / seconds,
-					(header->lhb_deqs - prior.lhb_deqs) / seconds,
-					(header->lhb_read_data - prior.lhb_read_data) / seconds,
-					(header->lhb_write_data - prior.lhb_write_data) / seconds,
-					(header->lhb_query_data - prior.lhb_query_data) / seconds);
-
-			prior.lhb_enqs = header->lhb_enqs;
-			prior.lhb_converts = header->lhb_converts;
-			prior.lhb_downgrades = header->lhb_downgrades;
-			prior.lhb_deqs = header->lhb_deqs;
-			prior.lhb_read_data = header->lhb_read_data;
-			prior.lhb_write_data = header->lhb_write_data;
-			prior.lhb_query_data = header->lhb_query_data;
+					(current.lhb_enqs - prior.lhb_enqs) / seconds,
+					(current.lhb_converts - prior.lhb_converts) / seconds,
+					(current.lhb_downgrades - prior.lhb_downgrades) / seconds,
+					(current.lhb_deqs - prior.lhb_deqs) / seconds,
+					(current.lhb_read_data - prior.lhb_read_data) / seconds,
+					(current.lhb_write_data - prior.lhb_write_data) / seconds,
+					(current.lhb_query_data - prior.lhb_query_data) / seconds);
+
+			prior.lhb_enqs = current.lhb_enqs;
+			prior.lhb_converts = current.lhb_converts;
+			prior.lhb_downgrades = current.lhb_downgrades;
+			prior.lhb_deqs = current.lhb_deqs;
+			prior.lhb_read_data = current.lhb_read_data;
+			prior.lhb_write_data = current.lhb_write_data;
+			prior.lhb_query_data = current.lhb_query_data;
 		}
 
 		if (flag & SW_I_TYPE)
@@ -1053,27 +1115,27 @@ static void prt_lock_activity(OUTFILE outfile,
 			FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" ",
-					(header->lhb_operations[Jrd::LCK_database] -
+					(current.lhb_operations[Jrd::LCK_database] -
 					 	prior.lhb_operations[Jrd::LCK_database]) / seconds,
-					(header->lhb_operations[Jrd::LCK_relation] -
+					(current.lhb_operations[Jrd::LCK_relation] -
 					 	prior.lhb_operations[Jrd::LCK_relation]) / seconds,
-					(header->lhb_operations[Jrd::LCK_bdb] -
+					(current.lhb_operations[Jrd::LCK_bdb] -
 					 	prior.lhb_operations[Jrd::LCK_bdb]) / seconds,
-					(header->lhb_operations[Jrd::LCK_tra] -
+					(current.lhb_operations[Jrd::LCK_tra] -
 					 	prior.lhb_operations[Jrd::LCK_tra]) / seconds,
-					(header->lhb_operations[Jrd::LCK_rel_exist] -
+					(current.lhb_operations[Jrd::LCK_rel_exist] -
 					 	prior.lhb_operations[Jrd::LCK_rel_exist]) / seconds,
-					(header->lhb_operations[Jrd::LCK_idx_exist] -
+					(current.lhb_operations[Jrd::LCK_idx_exist] -
 					 	prior.lhb_operations[Jrd::LCK_idx_exist]) / seconds,
-					(header->lhb_operations[0] - prior.lhb_operations[0]) / seconds);
-
-			prior.lhb_operations[Jrd::LCK_database] = header->lhb_operations[Jrd::LCK_database];
-			prior.lhb_operations[Jrd::LCK_relation] = header->lhb_operations[Jrd::LCK_relation];
-			prior.lhb_operations[Jrd::LCK_bdb] = header->lhb_operations[Jrd::LCK_bdb];
-			prior.lhb_operations[Jrd::LCK_tra] = header->lhb_operations[Jrd::LCK_tra];
-			prior.lhb_operations[Jrd::LCK_rel_exist] = header->lhb_operations[Jrd::LCK_rel_exist];
-			prior.lhb_operations[Jrd::LCK_idx_exist] = header->lhb_operations[Jrd::LCK_idx_exist];
-			prior.lhb_operations[0] = header->lhb_operations[0];
+					(current.lhb_operations[0] - prior.lhb_operations[0]) / seconds);
+
+			prior.lhb_operations[Jrd::LCK_database] = current.lhb_operations[Jrd::LCK_database];
+			prior.lhb_operations[Jrd::LCK_relation] = current.lhb_operations[Jrd::LCK_relation];
+			prior.lhb_operations[Jrd::LCK_bdb] = current.lhb_operations[Jrd::LCK_bdb];
+			prior.lhb_operations[Jrd::LCK_tra] = current.lhb_operations[Jrd::LCK_tra];
+			prior.lhb_operations[Jrd::LCK_rel_exist] = current.lhb_operations[Jrd::LCK_rel_exist];
+			prior.lhb_operations[Jrd::LCK_idx_exist] = current.lhb_operations[Jrd::LCK_idx_exist];
+			prior.lhb_operations[0] = current.lhb_operations[0];
 		}
 
 		if (flag & SW_I_WAIT)
@@ -1081,26 +1143,29 @@ static void prt_lock_activity(OUTFILE outfile,
 			FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 					" %9" UQUADFORMAT" ",
-					(header->lhb_waits - prior.lhb_waits) / seconds,
-					(header->lhb_denies - prior.lhb_denies) / seconds,
-					(header->lhb_timeouts - prior.lhb_timeouts) / seconds,
-					(header->lhb_blocks - prior.lhb_blocks) / seconds,
-					(header->lhb_wakeups - prior.lhb_wakeups) / seconds,
-					(header->lhb_scans - prior.lhb_scans) / seconds,
-					(header->lhb_deadlocks - prior.lhb_deadlocks) / seconds);
-
-			prior.lhb_waits = header->lhb_waits;
-			prior.lhb_denies = header->lhb_denies;
-			prior.lhb_timeouts = header->lhb_timeouts;
-			prior.lhb_blocks = header->lhb_blocks;
-			prior.lhb_wakeups = header->lhb_wakeups;
-			prior.lhb_scans = header->lhb_scans;
-			prior.lhb_deadlocks = header->lhb_deadlocks;
+					(current.lhb_waits - prior.lhb_waits) / seconds,
+					(current.lhb_denies - prior.lhb_denies) / seconds,
+					(current.lhb_timeouts - prior.lhb_timeouts) / seconds,
+					(current.lhb_blocks - prior.lhb_blocks) / seconds,
+					(current.lhb_wakeups - prior.lhb_wakeups) / seconds,
+					(current.lhb_scans - prior.lhb_scans) / seconds,
+					(current.lhb_deadlocks - prior.lhb_deadlocks) / seconds);
+
+			prior.lhb_waits = current.lhb_waits;
+			prior.lhb_denies = current.lhb_denies;
+			prior.lhb_timeouts = current.lhb_timeouts;
+			prior.lhb_blocks = current.lhb_blocks;
+			prior.lhb_wakeups = current.lhb_wakeups;
+			prior.lhb_scans = current.lhb_scans;
+			prior.lhb_deadlocks = current.lhb_deadlocks;
 		}
 
 		FPRINTF(outfile, "\n");
 	}
 
+	lhb current;
+	sum_stripes(header, &current);
+
 	FB_UINT64 factor = seconds * intervals;
 
 	if (factor < 1)
@@ -1111,13 +1176,13 @@ static void prt_lock_activity(OUTFILE outfile,
 	{
 		FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" %9" UQUADFORMAT" ",
-				(header->lhb_acquires - base.lhb_acquires) / factor,
-				(header->lhb_acquire_blocks - base.lhb_acquire_blocks) / factor,
-				(header->lhb_acquires - base.lhb_acquires) ?
-				 	(100 * (header->lhb_acquire_blocks - base.lhb_acquire_blocks)) /
-						(header->lhb_acquires - base.lhb_acquires) : 0,
-				(header->lhb_acquire_retries - base.lhb_acquire_retries) / factor,
-				(header->lhb_retry_success - base.lhb_retry_success) / factor);
+				(current.lhb_acquires - base.lhb_acquires) / factor,
+				(current.lhb_acquire_blocks - base.lhb_acquire_blocks) / factor,
+				(current.lhb_acquires - base.lhb_acquires) ?
+				 	(100 * (current.lhb_acquire_blocks - base.lhb_acquire_blocks)) /
+						(current.lhb_acquires - base.lhb_acquires) : 0,
+				(current.lhb_acquire_retries - base.lhb_acquire_retries) / factor,
+				(current.lhb_retry_success - base.lhb_retry_success) / factor);
 	}
 
 	if (flag & SW_I_OPERATION)
@@ -1125,13 +1190,13 @@ static void prt_lock_activity(OUTFILE outfile,
 		FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT" %9"
 				UQUADFORMAT" ",
-				(header->lhb_enqs - base.lhb_enqs) / factor,
-				(header->lhb_converts - base.lhb_converts) / factor,
-				(header->lhb_downgrades - base.lhb_downgrades) / factor,
-				(header->lhb_deqs - base.lhb_deqs) / factor,
-				(header->lhb_read_data - base.lhb_read_data) / factor,
-				(header->lhb_write_data - base.lhb_write_data) / factor,
-				(header->lhb_query_data - base.lhb_query_data) / factor);
+				(current.lhb_enqs - base.lhb_enqs) / factor,
+				(current.lhb_converts - base.lhb_converts) / factor,
+				(current.lhb_downgrades - base.lhb_downgrades) / factor,
+				(current.lhb_deqs - base.lhb_deqs) / factor,
+				(current.lhb_read_data - base.lhb_read_data) / factor,
+				(current.lhb_write_data - base.lhb_write_data) / factor,
+				(current.lhb_query_data - base.lhb_query_data) / factor);
 	}
 
 	if (flag & SW_I_TYPE)
@@ -1139,19 +1204,19 @@ static void prt_lock_activity(OUTFILE outfile,
 		FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" ",
-				(header->lhb_operations[Jrd::LCK_database] -
+				(current.lhb_operations[Jrd::LCK_database] -
 				 	base.lhb_operations[Jrd::LCK_database]) / factor,
-				(header->lhb_operations[Jrd::LCK_relation] -
+				(current.lhb_operations[Jrd::LCK_relation] -
 				 	base.lhb_operations[Jrd::LCK_relation]) / factor,
-				(header->lhb_operations[Jrd::LCK_bdb] -
+				(current.lhb_operations[Jrd::LCK_bdb] -
 				 	base.lhb_operations[Jrd::LCK_bdb]) / factor,
-				(header->lhb_operations[Jrd::LCK_tra] -
+				(current.lhb_operations[Jrd::LCK_tra] -
 				 	base.lhb_operations[Jrd::LCK_tra]) / factor,
-				(header->lhb_operations[Jrd::LCK_rel_exist] -
+				(current.lhb_operations[Jrd::LCK_rel_exist] -
 				 	base.lhb_operations[Jrd::LCK_rel_exist]) / factor,
-				(header->lhb_operations[Jrd::LCK_idx_exist] -
+				(current.lhb_operations[Jrd::LCK_idx_exist] -
 				 	base.lhb_operations[Jrd::LCK_idx_exist]) / factor,
-				(header->lhb_operations[0] - base.lhb_operations[0]) / factor);
+				(current.lhb_operations[0] - base.lhb_operations[0]) / factor);
 	}
 
 	if (flag & SW_I_WAIT)
@@ -1159,13 +1224,13 @@ static void prt_lock_activity(OUTFILE outfile,
 		FPRINTF(outfile, "%9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" %9" UQUADFORMAT" %9" UQUADFORMAT
 				" %9" UQUADFORMAT" ",
-				(header->lhb_waits - base.lhb_waits) / factor,
-				(header->lhb_denies - base.lhb_denies) / factor,
-				(header->lhb_timeouts - base.lhb_timeouts) / factor,
-				(header->lhb_blocks - base.lhb_blocks) / factor,
-				(header->lhb_wakeups - base.lhb_wakeups) / factor,
-				(header->lhb_scans - base.lhb_scans) / factor,
-				(header->lhb_deadlocks - base.lhb_deadlocks) / factor);
+				(current.lhb_waits - base.lhb_waits) / factor,
+				(current.lhb_denies - base.lhb_denies) / factor,
+				(current.lhb_timeouts - base.lhb_timeouts) / factor,
+				(current.lhb_blocks - base.lhb_blocks) / factor,
+				(current.lhb_wakeups - base.lhb_wakeups) / factor,
+				(current.lhb_scans - base.lhb_scans) / factor,
+				(current.lhb_deadlocks - base.lhb_deadlocks) / factor);
 	}
 
 	FPRINTF(outfile, "\n");
@@ -1408,8 +1473,22 @@ static void prt_owner(OUTFILE outfile,
 	FPRINTF(outfile, " %s", (flags & OWN_signaled) ? "sgnl" : "    ");
 	FPRINTF(outfile, "\n");
 
-	prt_que(outfile, LOCK_header, "\tRequests", &owner->own_requests,
-			offsetof(lrq, lrq_own_requests), preRequest);
+	bool requests = false;
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+		if (SRQ_EMPTY(owner->own_requests[i]))
+			continue;
+
+		TEXT label[32];
+		sprintf(label, "\tRequests [%d]", i);
+		prt_que(outfile, LOCK_header, label, &owner->own_requests[i],
+				offsetof(lrq, lrq_own_requests), preRequest);
+		requests = true;
+	}
+
+	if (!requests)
+		FPRINTF(outfile, "\tRequests: *empty*\n");
+
 	prt_que(outfile, LOCK_header, "\tBlocks", &owner->own_blocks,
 			offsetof(lrq, lrq_own_blocks), preRequest);
 	prt_que(outfile, LOCK_header, "\tPending", &owner->own_pending,
@@ -1435,10 +1514,13 @@ static void prt_owner(OUTFILE outfile,
 		}
 		else
 		{
-			const srq* que_inst;
-			SRQ_LOOP(owner->own_requests, que_inst)
-				prt_request(outfile, LOCK_header,
-							(lrq*) ((UCHAR*) que_inst - offsetof(lrq, lrq_own_requests)));
+			for (USHORT i = 0; i < LCK_STRIPES; i++)
+			{
+				const srq* que_inst;
+				SRQ_LOOP(owner->own_requests[i], que_inst)
+					prt_request(outfile, LOCK_header,
+								(lrq*) ((UCHAR*) que_inst - offsetof(lrq, lrq_own_requests)));
+			}
 		}
 	}
 }
@@ -1654,6 +1736,38 @@ static void prt_que2(OUTFILE outfile,
 			(const TEXT*) HtmlLink(prefix, que_inst->srq_backward - que_offset));
 }
 
+static void sum_stripes(const lhb* LOCK_header, lhb* totals)
+{
+/**************************************
+ *
+ *      s u m _ s t r i p e s
+ *
+ **************************************
+ *
+ * Functional description
+ *      Copy the lock header adding the counters
+ *      of the lock table stripes to its own ones.
+ *
+ **************************************/
+	*totals = *LOCK_header;
+
+	for (USHORT i = 0; i < LCK_STRIPES; i++)
+	{
+		const lst* const stripe =
+			(lst*) ((UCHAR*) SRQ_ABS_PTR(LOCK_header->lhb_stripes) + i * LST_SIZE);
+
+		totals->lhb_acquires += stripe->lst_acquires;
+		totals->lhb_acquire_blocks += stripe->lst_acquire_blocks;
+		totals->lhb_enqs += stripe->lst_enqs;
+		totals->lhb_converts += stripe->lst_converts;
+		totals->lhb_deqs += stripe->lst_deqs;
+
+		for (USHORT j = 0; j < LCK_MAX_SERIES; j++)
+			totals->lhb_operations[j] += stripe->lst_operations[j];
+	}
+}
+
+
 static void prt_html_begin(OUTFILE outfile)
 {
 /**************************************
@@ -10,10 +10,10 @@ set bulk_insert INSERT INTO FACILITIES (LAST_CHANGE, FACILITY, FAC_CODE, MAX_NUM
 ('1996-11-07 13:39:40', 'INSTALL', 10, 1)
 ('1996-11-07 13:38:41', 'TEST', 11, 4)
 ('2019-12-27 20:10:00', 'GBAK', 12, 396)
-('2019-04-13 21:10:00', 'SQLERR', 13, 1047)
+('2019-04-13 21:10:00', 'SQLERR', 13, 1048)
 ('1996-11-07 13:38:42', 'SQLWARN', 14, 613)
 ('2018-02-27 14:50:31', 'JRD_BUGCHK', 15, 308)
-('2016-05-26 13:53:45', 'ISQL', 17, 197)
+('2016-05-26 13:53:45', 'ISQL', 17, 198)
 ('2010-07-10 10:50:30', 'GSEC', 18, 105)
 ('2019-10-19 12:52:29', 'GSTAT', 21, 63)
 ('2019-12-10 17:55:05', 'FBSVCMGR', 22, 61)
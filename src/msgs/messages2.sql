@@ -2848,6 +2848,7 @@ ERROR: Backup incomplete', NULL, NULL);
 ('dsql_string_char_length', NULL, 'Parser.cpp', NULL, 13, 1044, NULL, 'String literal with @1 characters exceeds the maximum length of @2 characters for the @3 character set', NULL, NULL);
 ('dsql_max_nesting', NULL, 'StmtNodes.cpp', NULL, 13, 1045, NULL, 'Too many BEGIN...END nesting. Maximum level is @1', NULL, NULL);
 ('dsql_recreate_user_failed', 'getMainErrorCode', 'DdlNodes.h', NULL, 13, 1046, NULL, 'RECREATE USER @1 failed', NULL, NULL);
+('dsql_analyze_table_failed', 'getMainErrorCode', 'DdlNodes.h', NULL, 13, 1047, NULL, 'ANALYZE TABLE @1 failed', NULL, NULL);
 -- SQLWARN
 (NULL, NULL, NULL, NULL, 14, 100, NULL, 'Row not found for fetch, update or delete, or the result of a query is an empty table.', NULL, NULL);
 (NULL, NULL, NULL, NULL, 14, 101, NULL, 'segment buffer length shorter than expected', NULL, NULL);
@@ -3258,6 +3259,7 @@ Fetches = !', NULL, NULL);
 ('DATABASE_CRYPT_PROCESS', 'SHOW_dbb_parameters', 'show.epp', NULL, 17, 194, NULL, 'crypt thread not complete', NULL, NULL);
 ('MSG_ROLES', 'SHOW_metadata', 'show.epp', NULL, 17, 195, NULL, 'Roles:', NULL, NULL);
 ('NO_TIMEOUTS', 'process_statement', 'isql.epp', NULL, 17, 196, NULL, 'Timeouts are not supported by server', NULL, NULL);
+('HLP_SETEXPLAINANALYZE', 'help', 'isql.epp', NULL, 17, 197, NULL, '    SET EXPLAIN ANALYZE {ON | OFF} -- toggle display of query access plan with the actual figures after execution', NULL, NULL);
 -- GSEC
 ('GsecMsg1', 'get_line', 'gsec.e', NULL, 18, 1, NULL, 'GSEC>', NULL, NULL);
 ('GsecMsg2', 'printhelp', 'gsec.e', 'This message is used in the Help display. It should be the same as number 1 (but in lower case).', 18, 2, NULL, 'gsec', NULL, NULL);
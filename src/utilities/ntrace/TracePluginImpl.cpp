@@ -506,6 +506,42 @@ void TracePluginImpl::appendGlobalCounts(const PerformanceInfo* info)
 		record.append(temp);
 	}
 
+	if ((cnt = info->pin_counters[RuntimeStatistics::SORT_RECORDS]) != 0)
+	{
+		temp.printf(", %" QUADFORMAT"d sorted record(s)", cnt);
+		record.append(temp);
+
+		if ((cnt = info->pin_counters[RuntimeStatistics::SORT_PARALLEL]) != 0)
+		{
+			temp.printf(", %" QUADFORMAT"d parallel sort(s)", cnt);
+			record.append(temp);
+		}
+
+		if ((cnt = info->pin_counters[RuntimeStatistics::SORT_RUNS]) != 0)
+		{
+			temp.printf(", %" QUADFORMAT"d sort run(s)", cnt);
+			record.append(temp);
+		}
+
+		if ((cnt = info->pin_counters[RuntimeStatistics::SORT_MERGES]) != 0)
+		{
+			temp.printf(", %" QUADFORMAT"d sort merge(s)", cnt);
+			record.append(temp);
+		}
+	}
+
+	if ((cnt = info->pin_counters[RuntimeStatistics::TEMP_GRANTED]) != 0)
+	{
+		temp.printf(", %" QUADFORMAT"d temp cache byte(s)", cnt);
+		record.append(temp);
+	}
+
+	if ((cnt = info->pin_counters[RuntimeStatistics::TEMP_SPILLED]) != 0)
+	{
+		temp.printf(", %" QUADFORMAT"d temp file byte(s)", cnt);
+		record.append(temp);
+	}
+
 	record.append(NEWLINE);
 }
 